@@ -123,11 +123,19 @@ typedef enum {
 #define ROBOT_CURRENT_50A_GAIN                                            0.0225
 #define ROBOT_CURRENT_600A_GAIN                                        0.7536839
 
-// Loop period for main RT operations
+// Default loop period for main RT operations. The period actually used is
+// RT Ops's controlPeriod property; components get it from RT Ops.
 #define CONTROLLER_LOOP_PERIOD_NS                                      1000000LL
-/** @brief The offset between the DC and our code loop.
+/** @brief The offset between the DC and our code loop, at the default period.
+  * This is scaled proportionally for other periods.
   */
 #define CONTROLLER_LOOP_OFFSET_NS                                       300000LL
+/** @brief The shortest loop period RT Ops will accept (4 kHz).
+  */
+#define MIN_CONTROLLER_LOOP_PERIOD_NS                                   250000LL
+/** @brief The longest loop period RT Ops will accept (100 Hz).
+  */
+#define MAX_CONTROLLER_LOOP_PERIOD_NS                                 10000000LL
 
 //Loop period for the GUI
 #define GUI_LOOP_PERIOD_NS                                            20000000LL
@@ -205,6 +213,13 @@ typedef enum {
   */
 #define MEDULLA_TIMER_FREQ                                            32000000.0
 
+/** @brief How many samples the encoder velocities are fit over, by default.
+  * 2 is a plain difference between cycles, as the drivers have always used;
+  * each sample past that adds half a cycle of lag and takes out some
+  * quantization noise, so widening it is left to the controllers' owners.
+  */
+#define VELOCITY_ESTIMATOR_DEFAULT_WINDOW                                      2
+
 /** @brief The number of bits reported by the boom encoders.
   * For rollover compensation
   */
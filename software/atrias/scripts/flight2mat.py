@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+
+usage_text = \
+"""
+flight2mat.py: converts an RT Ops flight recorder dump to a MATLAB .mat file.
+
+The variables have the same names as the fields of atrias_msgs/log_data
+(header.stamp becomes 'time', in seconds), plus the rest of the
+robot_state_timing fields and an N x 9 'stageTimes' matrix of per-stage
+durations, in nanoseconds, indexed by CycleStage.
+
+Usage:
+
+flight2mat.py flight_dump.bin matfile.mat
+flight2mat.py -h # display this message
+"""
+
+import sys
+import numpy as np
+
+# Keep these in sync with atrias_rt_ops/FlightRecord.h
+FLIGHT_RECORD_MAGIC   = 'ATRFLTR'
+FLIGHT_RECORD_VERSION = 3
+NUM_STAGES            = 10
+
+file_header_dtype = np.dtype([
+  ('magic', 'S8'), ('version', '<u4'), ('recordSize', '<u4'), ('numRecords', '<u4'),
+  ('event', '<i4'), ('metadata', '<i4'), ('triggerTime', '<u8')])
+
+def _fields(type_code, names):
+  return [(name, type_code) for name in names.split()]
+
+record_dtype = np.dtype(
+  _fields('<u4', 'seq sec nsec') +
+  _fields('<f4', 'currentPositive currentNegative') +
+  _fields('<f4', 'lAClampedCmd lBClampedCmd lHipClampedCmd rAClampedCmd rBClampedCmd rHipClampedCmd') +
+  _fields('<f4', 'lARawCmd lBRawCmd lHipRawCmd rARawCmd rBRawCmd rHipRawCmd') +
+  _fields('<i4', 'lKneeForce rKneeForce') +
+  _fields('<f8', 'lALegAngle lBLegAngle rALegAngle rBLegAngle') +
+  _fields('<f4', 'lALegVelocity lBLegVelocity rALegVelocity rBLegVelocity') +
+  _fields('<f8', 'lAMotorAngle lBMotorAngle rAMotorAngle rBMotorAngle') +
+  _fields('<f4', 'lAMotorVelocity lBMotorVelocity rAMotorVelocity rBMotorVelocity') +
+  _fields('<f8', 'lARotorAngle lBRotorAngle rARotorAngle rBRotorAngle') +
+  _fields('<f4', 'lARotorVelocity lBRotorVelocity rARotorVelocity rBRotorVelocity') +
+  _fields('<f4', 'lLegBodyAngle rLegBodyAngle lLegBodyVelocity rLegBodyVelocity') +
+  _fields('<f4', 'xPosition xVelocity yPosition yVelocity zPosition zVelocity xAngle xAngleVelocity') +
+  _fields('<f4', 'bodyPitch bodyPitchVelocity boomAngle boomAngleVelocity') +
+  _fields('<u2', 'lToeSwitch rToeSwitch') +
+  _fields('u1',  'rtOpsState') +
+  _fields('<u8', 'controllerTime') +
+  _fields('<f4', ' '.join(['%s%sMotorTherm%d' % (leg, half, i)
+                           for leg in 'lr' for half in 'AB' for i in range(6)])) +
+  _fields('<f4', 'lAMotorVoltage lBMotorVoltage lHipMotorVoltage rAMotorVoltage rBMotorVoltage rHipMotorVoltage') +
+  _fields('<u8', 'receiveDCTime lastTransmitDCTime') +
+  _fields('<i4', 'transmitLatency actuationLatency overshoot dcCorrection sleepTime') +
+  _fields('<u8', 'targetTime') +
+  _fields('<i4', 'phaseError phaseJitter') +
+  _fields('u1',  'dcLocked') +
+  [('stageTimes', '<i4', (NUM_STAGES,))])
+
+def load_flight(filename):
+  """
+  Reads a flight recorder dump.
+  Returns (header, records): header is a dict of the file header's fields,
+  and records is a numpy structured array with one entry per cycle, oldest first.
+  """
+  with open(filename, 'rb') as f:
+    data = f.read()
+
+  header = np.frombuffer(data, file_header_dtype, 1)[0]
+  if header['magic'].rstrip(b'\0') != FLIGHT_RECORD_MAGIC.encode('ascii'):
+    raise ValueError('%s is not a flight recorder dump' % filename)
+  if header['version'] != FLIGHT_RECORD_VERSION or header['recordSize'] != record_dtype.itemsize:
+    raise ValueError('%s has record version %d (size %d); this script reads version %d (size %d)' %
+      (filename, header['version'], header['recordSize'], FLIGHT_RECORD_VERSION, record_dtype.itemsize))
+
+  records = np.frombuffer(data, record_dtype, int(header['numRecords']), file_header_dtype.itemsize)
+  return dict((name, header[name]) for name in file_header_dtype.names), records
+
+def to_columns(records):
+  """
+  Turns the records into a dict of log_data-style columns.
+  """
+  columns = dict((name, records[name]) for name in record_dtype.names
+                 if name not in ('sec', 'nsec'))
+  columns['time'] = records['sec'] + records['nsec'] * 1e-9
+  return columns
+
+if __name__ == '__main__':
+  if '-h' in sys.argv or len(sys.argv) < 3:
+    print(usage_text)
+  else:
+    import scipy.io as sio
+    dumpfile, matfile = sys.argv[1:3]
+    print("Converting %s -> %s" % (dumpfile, matfile))
+    header, records = load_flight(dumpfile)
+    columns = to_columns(records)
+    columns['triggerEvent'] = header['event']
+    columns['triggerMetadata'] = header['metadata']
+    columns['triggerTime'] = header['triggerTime'] * 1e-9
+    sio.savemat(matfile, columns, oned_as='column')
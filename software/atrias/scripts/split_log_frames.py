@@ -0,0 +1,142 @@
+#!/usr/bin/env python2
+
+usage_text = \
+"""
+split_log_frames.py: splits the controllers' log frames back into per-subcontroller topics.
+
+Top-level controllers send all their subcontrollers' log data as one
+atrias_msgs/log_frame per cycle, on /<controller>_log_frame, with its layout on
+/<controller>_log_layout. This writes a copy of the bag in which each frame is
+replaced by the messages it carries, on the topics they'd have had otherwise
+(/<subcontroller>_log, etc.). Every other message is copied unchanged.
+
+Ports that were limited to some of their fields (see the controllers'
+setLogPort operation) come out with the other fields zeroed.
+
+The subcontrollers' message packages need to be built, so their types can be
+found.
+
+Usage:
+
+split_log_frames.py infile.bag outfile.bag
+split_log_frames.py -h # display this message
+"""
+
+import struct
+import sys
+from cStringIO import StringIO
+
+import genpy
+import rosbag
+import roslib.message
+
+# Keep this in sync with atrias_control_lib/LogFrame.hpp
+LOG_FRAME_VERSION = 2
+ALL_FIELDS        = (1 << 64) - 1
+
+# The field types a message can be masked by; keep this in sync with
+# LogFrame::parseFields().
+field_formats = {
+	'bool': '<B', 'int8': '<b', 'uint8': '<B', 'byte': '<b', 'char': '<B',
+	'int16': '<h', 'uint16': '<H', 'int32': '<i', 'uint32': '<I', 'float32': '<f',
+	'int64': '<q', 'uint64': '<Q', 'float64': '<d', 'time': '<II', 'duration': '<ii'}
+
+if len(sys.argv) != 3 or sys.argv[1] == '-h':
+	print(usage_text)
+	exit()
+
+# The frame and layout message types, as written by atrias_control_lib
+frame_type  = 'atrias_msgs/log_frame'
+layout_type = 'atrias_msgs/log_frame_layout'
+
+def deserialize(msg):
+	(datatype, data, md5sum, pos, pytype) = msg
+	return pytype().deserialize(data)
+
+# Rebuilds a message that only some fields were kept of, returning it serialized.
+def unmask(pytype, data, mask):
+	msg = pytype()
+
+	# The header's always kept.
+	(msg.header.seq, secs, nsecs, length) = struct.unpack('<IIII', data[:16])
+	msg.header.stamp    = genpy.Time(secs, nsecs)
+	msg.header.frame_id = data[16:16 + length]
+	pos = 16 + length
+
+	for i, (name, type) in enumerate(zip(msg.__slots__[1:], msg._slot_types[1:])):
+		if i < 64 and not (mask >> i) & 1:
+			continue
+		fmt    = field_formats[type]
+		size   = struct.calcsize(fmt)
+		values = struct.unpack(fmt, data[pos:pos + size])
+		pos   += size
+		if type == 'time':
+			setattr(msg, name, genpy.Time(*values))
+		elif type == 'duration':
+			setattr(msg, name, genpy.Duration(*values))
+		else:
+			setattr(msg, name, values[0])
+
+	buff = StringIO()
+	msg.serialize(buff)
+	return buff.getvalue()
+
+inbag = rosbag.Bag(sys.argv[1])
+
+# The layouts may be recorded after the first frames, so find them all first.
+layouts = {}
+for topic, msg, t in inbag.read_messages(raw=True):
+	if msg[0] != layout_type:
+		continue
+
+	layout = deserialize(msg)
+	if layout.version != LOG_FRAME_VERSION:
+		print("Skipping version " + str(layout.version) + " layout on " + topic +
+		      "; this script reads version " + str(LOG_FRAME_VERSION) + ".")
+		continue
+
+	if layout.layoutId in layouts:
+		continue
+
+	slots = []
+	for i in range(len(layout.topics)):
+		pytype = roslib.message.get_message_class(layout.types[i])
+		if pytype is None or pytype._md5sum != layout.md5sums[i]:
+			print("Can't find type " + layout.types[i] + " (for " + layout.topics[i] +
+			      ") with MD5 sum " + layout.md5sums[i] + "; has its package been built?")
+			exit(1)
+		slots.append((layout.topics[i], layout.types[i], layout.md5sums[i], pytype))
+	layouts[layout.layoutId] = slots
+
+frames  = 0
+skipped = 0
+with rosbag.Bag(sys.argv[2], 'w') as outbag:
+	for topic, msg, t in inbag.read_messages(raw=True):
+		if msg[0] == layout_type:
+			continue
+
+		if msg[0] != frame_type:
+			outbag.write(topic, msg, t, raw=True)
+			continue
+
+		frame = deserialize(msg)
+		if frame.version != LOG_FRAME_VERSION or frame.layoutId not in layouts:
+			skipped += 1
+			continue
+
+		# The messages are packed back to back.
+		offset = 0
+		for slot, length, mask in zip(frame.slots, frame.lengths, frame.masks):
+			(slot_topic, datatype, md5sum, pytype) = layouts[frame.layoutId][slot]
+			data    = frame.data[offset:offset + length]
+			offset += length
+			if mask != ALL_FIELDS:
+				data = unmask(pytype, data, mask)
+			outbag.write(slot_topic, (datatype, data, md5sum, None, pytype), t, raw=True)
+		frames += 1
+
+print("Split " + str(frames) + " frames.")
+if skipped:
+	print("Skipped " + str(skipped) + " frames with no matching layout.")
+
+inbag.close()
@@ -8,6 +8,13 @@
   * This provides interfaces to make writing controllers easier.
   */
 
+// Standard library
+#include <algorithm> // For std::max
+#include <atomic>    // For our own log port's settings
+#include <math.h>    // For lround()
+#include <new>       // For std::bad_alloc
+#include <sstream>   // For listing the log ports
+
 // Orocos includes
 #include <rtt/Component.hpp>       // We need this since we're a component.
 #include <rtt/ConnPolicy.hpp>      // Allows us to establish ROS connections.
@@ -19,6 +26,7 @@
 // Robot state and controller output
 #include <atrias_msgs/controller_output.h>
 #include <atrias_msgs/robot_state.h>
+#include <atrias_msgs/rt_msg_pool.h>
 #include <atrias_msgs/unused.h>
 
 // For the medulla state enum
@@ -31,9 +39,19 @@
 #include <atrias_shared/GuiPublishTimer.h>
 // To let us register typekits for the messages
 #include <atrias_shared/RtMsgTypekits.hpp>
+// So RT Ops can call us directly
+#include <atrias_shared/ControllerInterface.hpp>
 
 // We subclass this, so let's include it
 #include "atrias_control_lib/AtriasController.hpp"
+// Runs the controllers' slow tasks off the control loop
+#include "atrias_control_lib/AsyncTaskRunner.hpp"
+// Sends all the LogPorts' data together
+#include "atrias_control_lib/LogFrame.hpp"
+// Realtime memory for our messages
+#include "atrias_control_lib/RtMsgPool.hpp"
+// Times us and our subcontrollers
+#include "atrias_control_lib/Profiler.hpp"
 
 // Our namespaces
 namespace atrias {
@@ -55,12 +73,13 @@ inline bool notUnused<atrias_msgs::unused_>() {
 }
 
 // This is a component, so we subclass TaskContext;
-// as a controller, this subclasses AtriasController
-// Also, we're a template...
+// as a controller, this subclasses AtriasController.
+// ControllerInterface lets RT Ops call runController() without going
+// through RTT. Also, we're a template...
 template <template <class> class logType    = atrias_msgs::unused_,
           template <class> class guiInType  = atrias_msgs::unused_,
           template <class> class guiOutType = atrias_msgs::unused_>
-class ATC : public RTT::TaskContext, public AtriasController {
+class ATC : public RTT::TaskContext, public AtriasController, public shared::ControllerInterface {
 	public:
 		/**
 		  * @brief The constructor for this class.
@@ -74,9 +93,14 @@ class ATC : public RTT::TaskContext, public AtriasController {
 		  * @brief Returns a ROS header with the current timestamp.
 		  * @return A ROS header for logging purposes.
 		  */
-		//const std_msgs::Header_<RTT::os::rt_allocator<uint8_t>>& getROSHeader() const;
 		const std_msgs::Header& getROSHeader() const;
 
+		/**
+		  * @brief Returns the control loop period.
+		  * @return The period RT Ops runs us at, in seconds.
+		  */
+		double getPeriod() const;
+
 		/**
 		  * @brief This returns the TaskContext
 		  * @return A reference to the TaskContext.
@@ -84,6 +108,27 @@ class ATC : public RTT::TaskContext, public AtriasController {
 		  */
 		RTT::TaskContext& getTaskContext() const;
 
+		/**
+		  * @brief This returns the runner for our (and our subcontrollers') AsyncTasks.
+		  * @return A reference to the runner.
+		  * This should only be overridden by the ATC class
+		  */
+		AsyncTaskRunner& getAsyncTaskRunner() const;
+
+		/**
+		  * @brief This returns the frame our (and our subcontrollers') LogPorts send in.
+		  * @return A reference to the log frame.
+		  * This should only be overridden by the ATC class
+		  */
+		LogFrame& getLogFrame() const;
+
+		/**
+		  * @brief This returns the profiler our (and our subcontrollers') ProfilePoints record in.
+		  * @return A reference to the profiler.
+		  * This should only be overridden by the ATC class
+		  */
+		Profiler& getProfiler() const;
+
 	protected:
 		/**
 		  * @brief This may be used by controller to command an EStop
@@ -115,13 +160,11 @@ class ATC : public RTT::TaskContext, public AtriasController {
 		bool isStarting() const;
 
 		// These member variables should be set/read from by
-		// the controllers themselves.
-		/*logType<RTT::os::rt_allocator<uint8_t>>    logOut;
-		guiInType<RTT::os::rt_allocator<uint8_t>>  guiIn;
-		guiOutType<RTT::os::rt_allocator<uint8_t>> guiOut;*/
-		logType<std::allocator<void>>    logOut;
-		guiInType<std::allocator<void>>  guiIn;
-		guiOutType<std::allocator<void>> guiOut;
+		// the controllers themselves. Their strings and arrays
+		// are allocated from the RtMsgPool.
+		logType<RtMsgAllocator<void>>    logOut;
+		guiInType<RtMsgAllocator<void>>  guiIn;
+		guiOutType<RtMsgAllocator<void>> guiOut;
 
 		// Here is the robot state
 		atrias_msgs::robot_state rs;
@@ -150,21 +193,37 @@ class ATC : public RTT::TaskContext, public AtriasController {
 		//RTT::TaskContext& getTaskContext() const;
 
 		// Port for input data from the GUI
-		//RTT::InputPort<guiInType<RTT::os::rt_allocator<uint8_t>>>   guiInPort;
-		RTT::InputPort<guiInType<std::allocator<void>>>   guiInPort;
+		RTT::InputPort<guiInType<RtMsgAllocator<void>>>   guiInPort;
 
 		// Port to send data to the GUI
-		//RTT::OutputPort<guiOutType<RTT::os::rt_allocator<uint8_t>>> guiOutPort;
-		RTT::OutputPort<guiOutType<std::allocator<void>>> guiOutPort;
+		RTT::OutputPort<guiOutType<RtMsgAllocator<void>>> guiOutPort;
 
 		// Temporary header copy, so getROSHeader() can return a reference
 		// In the new event system, everything will be RT-safe, so this won't be necessary
-		//std_msgs::Header_<RTT::os::rt_allocator<uint8_t>> header;
 		std_msgs::Header header;
 
 		// Port for logging controller data
-		//RTT::OutputPort<logType<RTT::os::rt_allocator<uint8_t>>>    logOutPort;
-		RTT::OutputPort<logType<std::allocator<void>>>    logOutPort;
+		RTT::OutputPort<logType<RtMsgAllocator<void>>>    logOutPort;
+
+		// Port for the RtMsgPool's usage statistics, and how often
+		// (in cycles) they're sent
+		RTT::OutputPort<atrias_msgs::rt_msg_pool>         rtPoolPort;
+		atrias_msgs::rt_msg_pool                          rtPoolStats;
+		uint32_t                                          rtPoolPeriod;
+		uint32_t                                          cyclesSinceRtPool;
+
+		// Property: how big the RtMsgPool should be, in bytes
+		int rtPoolSize;
+
+		/**
+		  * @brief Sends a message, unless the RtMsgPool is too full to copy it.
+		  * Messages that can't be sent are dropped (and counted), never
+		  * allocated from the heap.
+		  * @param port The port to send it on.
+		  * @param msg  The message.
+		  */
+		template <class Msg>
+		void writeRt(RTT::OutputPort<Msg> &port, const Msg &msg);
 
 		/**
 		  * @brief This callback is executed when data is received from the GUI
@@ -176,15 +235,77 @@ class ATC : public RTT::TaskContext, public AtriasController {
 
 		/**
 		  * @brief This is the operation called cyclically by RT Ops
-		  * This runs the controller.
+		  * This runs the controller. RT Ops calls this through
+		  * ControllerInterface when it can, and through the "atc" service otherwise.
 		  * @param robotState The new robot state
 		  * @return           The new controller output.
 		  */
-		atrias_msgs::controller_output& runController(atrias_msgs::robot_state& robotState);
+		atrias_msgs::controller_output& runController(const atrias_msgs::robot_state& robotState);
 
 		// This lets us send RT Ops events
 		RTT::OperationCaller<void(rtOps::RtOpsEvent, rtOps::RtOpsEventMetadata_t)> sendEventOp;
 
+		// This gets the control loop period from RT Ops
+		RTT::OperationCaller<RTT::os::TimeService::nsecs(void)> getControlPeriodOp;
+
+		// The control loop period, in seconds. Fetched from RT Ops in configureHook()
+		double period;
+
+		// Runs our AsyncTasks
+		AsyncTaskRunner asyncTasks;
+
+		// Property: how many worker threads run our AsyncTasks
+		int asyncWorkers;
+
+		// Collects our LogPorts' data, sent once per cycle
+		LogFrame logFrame;
+
+		// How often our own log port sends, in cycles; 0 if it's switched off
+		std::atomic<uint32_t> logOutDivisor;
+
+		// Times our ProfilePoints (and our subcontrollers'), and our point for controller()
+		Profiler profiler;
+		size_t   controllerPoint;
+
+		/**
+		  * @brief This switches profiling on or off.
+		  * Called by the "setProfiling" operation.
+		  * @param enabled Whether to time the ProfilePoints.
+		  */
+		void setProfiling(bool enabled);
+
+		/**
+		  * @brief This describes each ProfilePoint's timing.
+		  * Called by the "getProfile" operation.
+		  * @return One line per point.
+		  */
+		std::string getProfile();
+
+		/**
+		  * @brief This clears the profiling statistics.
+		  * Called by the "resetProfile" operation.
+		  */
+		void resetProfile();
+
+		/**
+		  * @brief This changes what one of our log ports (or a subcontroller's) logs.
+		  * Called by the "setLogPort" operation; applied at the start of the next cycle.
+		  * @param port    The port's topic, or "*" for all the subcontrollers' ports.
+		  * @param enabled Whether to log it at all.
+		  * @param divisor Log it every this many cycles.
+		  * @param fields  The fields to log, separated by commas, or "" for all of them.
+		  *                Our own log port can't be limited to some fields.
+		  * @return True if the settings were valid and applied.
+		  */
+		bool setLogPort(std::string port, bool enabled, uint32_t divisor, std::string fields);
+
+		/**
+		  * @brief This lists our log ports and their settings.
+		  * Called by the "listLogPorts" operation.
+		  * @return One line per port.
+		  */
+		std::string listLogPorts();
+
 		/**
 		  * @brief This is the state enum for the startup/shutdown state machine.
 		  */
@@ -209,8 +330,15 @@ class ATC : public RTT::TaskContext, public AtriasController {
 
 		/**
 		  * @brief This connects to RT Ops, so it can call this controller.
+		  * This also sizes the RtMsgPool, connects the log frame, and
+		  * starts the AsyncTask workers.
 		  */
 		bool configureHook();
+
+		/**
+		  * @brief This stops the AsyncTask workers, and reports how much of the RtMsgPool was used.
+		  */
+		void cleanupHook();
 };
 
 template <template <class> class logType,
@@ -219,22 +347,64 @@ template <template <class> class logType,
 ATC<logType, guiInType, guiOutType>::ATC(const std::string &name) :
 	RTT::TaskContext(name),
 	AtriasController(name),
+	rtPoolPeriod(1),
+	cyclesSinceRtPool(0),
+	rtPoolSize(RT_MSG_POOL_DEFAULT_SIZE),
 	publishTimer(50), // The parameter is the transmit period in ms
-	sendEventOp("sendEvent")
+	sendEventOp("sendEvent"),
+	getControlPeriodOp("getControlPeriod"),
+	period(((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS)),
+	asyncWorkers(1),
+	logOutDivisor(1)
 {
+	// Time the whole controller, so its subcontrollers can be compared against it
+	this->controllerPoint = this->profiler.addPoint(this->AtriasController::getName() + "::controller");
+
 	// We initialize to run mode
 	this->mode = State::RUN;
 
 	// By default, the startup controller is disabled
 	this->startupEnabled = false;
 
+	// Our messages' ports copy them as soon as they're connected, so the
+	// pool needs to exist now. configureHook() grows it if asked to.
+	RtMsgPool::reserve(RT_MSG_POOL_DEFAULT_SIZE);
+
 	// Register the operation runController()
 	this->provides("atc")
 		->addOperation("runController", &ATC<logType, guiInType, guiOutType>::runController, this, RTT::ClientThread)
 		.doc("Run the controller. Takes in the robot state and returns a controller output.");
 
-	// Connect with the sendEvent operation
+	// Let the deployer size the AsyncTask worker pool
+	this->addProperty("asyncWorkers", this->asyncWorkers)
+		.doc("How many worker threads run this controller's AsyncTasks. Set before configuring.");
+
+	// And size the realtime message pool
+	this->addProperty("rtPoolSize", this->rtPoolSize)
+		.doc("The least size, in bytes, of the realtime pool messages are allocated from. Set before configuring. The pool is shared by the whole process, and never shrinks.");
+
+	// Let the controller manager (or anyone else) turn logging down while we run
+	this->addOperation("setLogPort", &ATC<logType, guiInType, guiOutType>::setLogPort, this, RTT::ClientThread)
+		.doc("Switch a log port on or off, decimate it, or limit it to some fields. Applied at the next cycle.")
+		.arg("port",    "The port's topic, or \"*\" for all the subcontrollers' ports.")
+		.arg("enabled", "Whether to log it at all.")
+		.arg("divisor", "Log it every this many cycles (at least 1).")
+		.arg("fields",  "The fields to log, separated by commas, or \"\" for all of them.");
+	this->addOperation("listLogPorts", &ATC<logType, guiInType, guiOutType>::listLogPorts, this, RTT::ClientThread)
+		.doc("List this controller's log ports and their settings.");
+
+	// And let them see which subcontrollers take the time
+	this->addOperation("setProfiling", &ATC<logType, guiInType, guiOutType>::setProfiling, this, RTT::ClientThread)
+		.doc("Switch timing of this controller's (and its subcontrollers') ProfilePoints on or off.")
+		.arg("enabled", "Whether to time them.");
+	this->addOperation("getProfile", &ATC<logType, guiInType, guiOutType>::getProfile, this, RTT::ClientThread)
+		.doc("Report each ProfilePoint's call count and min, mean, p99, and max time.");
+	this->addOperation("resetProfile", &ATC<logType, guiInType, guiOutType>::resetProfile, this, RTT::ClientThread)
+		.doc("Clear the profiling statistics.");
+
+	// Connect with the sendEvent and getControlPeriod operations
 	this->requires("rtOps")->addOperationCaller(this->sendEventOp);
+	this->requires("rtOps")->addOperationCaller(this->getControlPeriodOp);
 
 	// Set up the event port for incoming GUI data (if there is incoming GUI data)
 	if (notUnused<guiInType>()) {
@@ -242,7 +412,7 @@ ATC<logType, guiInType, guiOutType>::ATC(const std::string &name) :
 		               << "] Setting up GUI input port." << RTT::endlog();
 
 		// Add typekits for this message type
-		//shared::RtMsgTypekits::registerType<guiInType>(this->AtriasController::getName() + "_input");
+		shared::RtMsgTypekits::registerType<guiInType, RtMsgAllocator<void>>();
 
 		this->addEventPort("guiInput", guiInPort, boost::bind(&ATC<logType, guiInType, guiOutType>::guiInCallback, this, _1));
 
@@ -266,7 +436,7 @@ ATC<logType, guiInType, guiOutType>::ATC(const std::string &name) :
 		               << "] Setting up GUI output port." << RTT::endlog();
 
 		// Add typekits for this message type
-		//shared::RtMsgTypekits::registerType<guiOutType>(this->AtriasController::getName() + "_status");
+		shared::RtMsgTypekits::registerType<guiOutType, RtMsgAllocator<void>>();
 
 		this->addPort("guiOutput", guiOutPort);
 
@@ -292,8 +462,8 @@ ATC<logType, guiInType, guiOutType>::ATC(const std::string &name) :
 		               << "] Setting up logging port." << RTT::endlog();
 
 		// Add typekits for this message type
-		//shared::RtMsgTypekits::registerType<logType>(this->AtriasController::getName() + "_log");
-		
+		shared::RtMsgTypekits::registerType<logType, RtMsgAllocator<void>>();
+
 		this->addPort("log", logOutPort);
 
 		// Let's connect this port to ROS
@@ -311,16 +481,30 @@ ATC<logType, guiInType, guiOutType>::ATC(const std::string &name) :
 		// Set the policy
 		this->logOutPort.createStream(policy);
 	}
+
+	// Report how full the realtime message pool is
+	this->addPort("rtPool", this->rtPoolPort);
+	this->rtPoolPort.setDataSample(this->rtPoolStats);
+	RTT::ConnPolicy rtPoolPolicy = RTT::ConnPolicy();
+	rtPoolPolicy.transport = 3;
+	rtPoolPolicy.name_id   = "/" + this->AtriasController::getName() + "_rt_pool";
+	this->rtPoolPort.createStream(rtPoolPolicy);
 }
 
 template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
-//const std_msgs::Header_<RTT::os::rt_allocator<uint8_t>>& ATC<logType, guiInType, guiOutType>::getROSHeader() const {
 const std_msgs::Header& ATC<logType, guiInType, guiOutType>::getROSHeader() const {
 	return this->header;
 }
 
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+double ATC<logType, guiInType, guiOutType>::getPeriod() const {
+	return this->period;
+}
+
 template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
@@ -353,6 +537,27 @@ RTT::TaskContext& ATC<logType, guiInType, guiOutType>::getTaskContext() const {
 	return *((RTT::TaskContext*) this);
 }
 
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+AsyncTaskRunner& ATC<logType, guiInType, guiOutType>::getAsyncTaskRunner() const {
+	return const_cast<AsyncTaskRunner&>(this->asyncTasks);
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+LogFrame& ATC<logType, guiInType, guiOutType>::getLogFrame() const {
+	return const_cast<LogFrame&>(this->logFrame);
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+Profiler& ATC<logType, guiInType, guiOutType>::getProfiler() const {
+	return const_cast<Profiler&>(this->profiler);
+}
+
 template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
@@ -364,13 +569,42 @@ template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
 void ATC<logType, guiInType, guiOutType>::guiInCallback(RTT::base::PortInterface* portInterface) {
-	this->guiInPort.read(this->guiIn);
+	// If the pool's too full to copy the new input, keep the old.
+	try {
+		this->guiInPort.read(this->guiIn);
+	} catch (std::bad_alloc&) {
+		RtMsgPool::noteDrop();
+	}
 }
 
 template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
-atrias_msgs::controller_output& ATC<logType, guiInType, guiOutType>::runController(atrias_msgs::robot_state &robotState) {
+template <class Msg>
+void ATC<logType, guiInType, guiOutType>::writeRt(RTT::OutputPort<Msg> &port, const Msg &msg) {
+	// Writing copies the message into the connection's buffer, allocating
+	// each string and array in turn. If there's a free block as big as all
+	// of them together, every one fits. Checking first matters: a copy that
+	// throws partway through may lose one of the buffer's slots.
+	RtMsgFootprint footprint;
+	footprint.next(msg);
+	if (!RtMsgPool::hasRoom(footprint.getTotal())) {
+		RtMsgPool::noteDrop();
+		return;
+	}
+
+	// Another thread may have taken the room since.
+	try {
+		port.write(msg);
+	} catch (std::bad_alloc&) {
+		RtMsgPool::noteDrop();
+	}
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+atrias_msgs::controller_output& ATC<logType, guiInType, guiOutType>::runController(const atrias_msgs::robot_state &robotState) {
 	// Check for change in state (to trigger the change to startup mode).
 	if (this->startupEnabled                         &&
 	    this->rs.rtOpsState != robotState.rtOpsState &&
@@ -401,32 +635,50 @@ atrias_msgs::controller_output& ATC<logType, guiInType, guiOutType>::runControll
 	co.rLeg.motorCurrentHip = 0.0;
 
 	// Run the controller
-	this->controller();
+	{
+		ProfileScope profileScope(this->profiler, this->controllerPoint);
+		this->controller();
+	}
 
 	// Transmit the status to the GUI, if it's time.
 	if (notUnused<guiOutType>()) {
 		if (publishTimer.readyToSend()) {
 			// Set the header (for timestamping)
-			this->guiOut.header = this->getROSHeader();
+			copyHeader(this->getROSHeader(), this->guiOut.header);
 
 			// Send the status
-			this->guiOutPort.write(this->guiOut);
+			this->writeRt(this->guiOutPort, this->guiOut);
 		}
 	}
 
-	// Send the controller's logging data
-	if (notUnused<logType>()) {
+	// Send the controller's logging data, unless it's switched off or decimated this cycle
+	uint32_t logOutDivisor = this->logOutDivisor.load(std::memory_order_relaxed);
+	if (notUnused<logType>() && logOutDivisor && this->logFrame.getCycle() % logOutDivisor == 0) {
 		// Set the header
-		this->logOut.header = this->getROSHeader();
+		copyHeader(this->getROSHeader(), this->logOut.header);
 
 		// And actually send it out
-		this->logOutPort.write(this->logOut);
+		this->writeRt(this->logOutPort, this->logOut);
+	}
+
+	// And the subcontrollers' (and any extra LogPorts'), all in one frame
+	this->logFrame.send(this->getROSHeader());
+
+	// Report the realtime message pool's usage every so often
+	if (++this->cyclesSinceRtPool >= this->rtPoolPeriod) {
+		this->cyclesSinceRtPool   = 0;
+		this->rtPoolStats.header  = this->getROSHeader();
+		RtMsgPool::getStats(this->rtPoolStats);
+		this->rtPoolPort.write(this->rtPoolStats);
 	}
 
 	// Run the startup controller, if in the startup state
 	if (this->mode == State::STARTUP)
 		this->startupController();
 
+	// Hand this cycle's robot state to any AsyncTasks that are due
+	this->asyncTasks.cycle(this->rs);
+
 	// Finally, return the controller output
 	return this->co;
 }
@@ -456,7 +708,7 @@ void ATC<logType, guiInType, guiOutType>::startupController() {
 	this->co.rLeg.motorCurrentHip *= scale;
 
 	// End the controller after the specified amount of time
-	this->startupTimeRem -= ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS);
+	this->startupTimeRem -= this->period;
 	if (this->startupTimeRem <= 0.0)
 		this->mode = State::RUN;
 }
@@ -475,13 +727,116 @@ bool ATC<logType, guiInType, guiOutType>::isStarting() const {
 	return (this->mode == State::STARTUP);
 }
 
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+bool ATC<logType, guiInType, guiOutType>::setLogPort(std::string port, bool enabled, uint32_t divisor, std::string fields) {
+	bool success;
+	std::string ownTopic = "/" + this->AtriasController::getName() + "_log";
+	if (notUnused<logType>() && (port == ownTopic || "/" + port == ownTopic)) {
+		// Our own port sends whole messages on its own topic
+		success = (divisor >= 1 && fields.empty());
+		if (success)
+			this->logOutDivisor.store(enabled ? divisor : 0, std::memory_order_relaxed);
+	} else {
+		success = this->logFrame.configureSlot(port, enabled, divisor, fields);
+	}
+
+	if (success) {
+		log(RTT::Info) << "[" << this->AtriasController::getName() << "] Logging " << port << ": "
+		               << (enabled ? "on" : "off") << ", every " << divisor << " cycle(s), "
+		               << (fields.empty() ? std::string("all fields") : "fields " + fields) << RTT::endlog();
+	} else {
+		log(RTT::Warning) << "[" << this->AtriasController::getName() << "] Invalid log settings for "
+		                  << port << "; see listLogPorts()" << RTT::endlog();
+	}
+	return success;
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+std::string ATC<logType, guiInType, guiOutType>::listLogPorts() {
+	std::ostringstream out;
+	if (notUnused<logType>()) {
+		uint32_t divisor = this->logOutDivisor.load(std::memory_order_relaxed);
+		out << "/" << this->AtriasController::getName() << "_log (own port): ";
+		if (divisor)
+			out << "every " << divisor << " cycle(s), all fields\n";
+		else
+			out << "off\n";
+	}
+	out << this->logFrame.describe();
+	return out.str();
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+void ATC<logType, guiInType, guiOutType>::setProfiling(bool enabled) {
+	this->profiler.setEnabled(enabled);
+	log(RTT::Info) << "[" << this->AtriasController::getName() << "] Profiling "
+	               << (enabled ? "on" : "off") << RTT::endlog();
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+std::string ATC<logType, guiInType, guiOutType>::getProfile() {
+	return this->profiler.report();
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+void ATC<logType, guiInType, guiOutType>::resetProfile() {
+	this->profiler.reset();
+}
+
 template <template <class> class logType,
           template <class> class guiInType,
           template <class> class guiOutType>
 bool ATC<logType, guiInType, guiOutType>::configureHook() {
 	// Connect services with RT Ops so it can see our "atc" service
 	this->connectServices(this->getPeer("atrias_rt"));
-	return true;
+
+	// Run at whatever rate RT Ops is configured for
+	if (this->getControlPeriodOp.ready())
+		this->period = ((double) this->getControlPeriodOp()) / ((double) SECOND_IN_NANOSECONDS);
+
+	// Grow the realtime message pool, if we've been asked for a bigger one
+	if (this->rtPoolSize > 0 && !RtMsgPool::reserve(this->rtPoolSize)) {
+		log(RTT::Error) << "[" << this->AtriasController::getName() << "] Couldn't grow the realtime message pool to "
+		                << this->rtPoolSize << " bytes." << RTT::endlog();
+		return false;
+	}
+
+	// Send the pool's statistics about once a second
+	this->rtPoolPeriod = std::max(1, (int) lround(1.0 / this->period));
+
+	// All our LogPorts exist by now, so the log frame can be sized and connected
+	if (!this->logFrame.empty()) {
+		this->logFrame.addPorts(*this, this->period);
+		this->logFrame.stream(this->AtriasController::getName());
+	}
+
+	// Start running our AsyncTasks (if we have any)
+	return this->asyncTasks.start(this->period, (this->asyncWorkers > 0) ? this->asyncWorkers : 1);
+}
+
+template <template <class> class logType,
+          template <class> class guiInType,
+          template <class> class guiOutType>
+void ATC<logType, guiInType, guiOutType>::cleanupHook() {
+	// Our tasks may be destroyed after this, so stop running them.
+	this->asyncTasks.stop();
+
+	// Say how much of the pool was used, so it can be sized
+	atrias_msgs::rt_msg_pool stats;
+	RtMsgPool::getStats(stats);
+	log(RTT::Info) << "[" << this->AtriasController::getName() << "] Realtime message pool: "
+	               << stats.peakUsed << " of " << stats.capacity << " bytes used at most; "
+	               << stats.failures << " failed allocation(s), " << stats.dropped << " dropped sample(s)." << RTT::endlog();
 }
 
 }
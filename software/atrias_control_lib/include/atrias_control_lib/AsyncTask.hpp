@@ -0,0 +1,212 @@
+#ifndef ASYNCTASK_HPP
+#define ASYNCTASK_HPP
+
+/**
+  * @file AsyncTask.hpp
+  * @brief Lets controllers run slow work (planners, step-to-step updates)
+  * off the control loop's thread.
+  * A task is run on the top-level controller's worker threads, either
+  * periodically or when triggered, with a snapshot of the robot state taken
+  * at the end of the control cycle that queued it. Results come back to the
+  * control loop through a lock-free mailbox. Nothing here ever blocks the
+  * control loop; if a task is still running when it's due again, that run
+  * is skipped and counted as an overrun.
+  *
+  * Usage: subclass AsyncTask<Result>, implement run(), and make the task a
+  * member of your controller. Each cycle, call update() and getResult() to
+  * use the newest result.
+  */
+
+// Standard library
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+// Robot state
+#include <atrias_msgs/robot_state.h>
+
+// The result mailbox
+#include <atrias_shared/TripleBuffer.hpp>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class AtriasController;
+class AsyncTaskRunner;
+
+class AsyncTaskBase {
+	public:
+		/**
+		  * @brief Registers this task with the top-level controller.
+		  * @param owner  The controller this task belongs to.
+		  * @param name   This task's name, for diagnostics.
+		  * @param period How often to run, in seconds. 0 means only when triggered.
+		  * This must be constructed along with the controller, not while it's running.
+		  */
+		AsyncTaskBase(AtriasController *owner, const std::string &name, double period);
+
+		/**
+		  * @brief Waits for any run of this task in progress to finish.
+		  */
+		virtual ~AsyncTaskBase();
+
+		/**
+		  * @brief Runs this task at the end of this cycle, regardless of its period.
+		  * Realtime safe. Call from the control loop only.
+		  */
+		void trigger();
+
+		/**
+		  * @brief Returns how many runs were skipped because the previous one
+		  * was still going.
+		  * @return The overrun count.
+		  */
+		uint32_t getOverruns() const;
+
+		/**
+		  * @brief Returns this task's name.
+		  * @return The name, including the owning controller's name.
+		  */
+		const std::string& getName() const;
+
+	protected:
+		/**
+		  * @brief The task itself. Runs on a worker thread.
+		  * @param robotState The robot state at the end of the cycle this was queued in.
+		  * This may take as long as it needs, but only one run of a given
+		  * task happens at a time.
+		  */
+		virtual void run(const atrias_msgs::robot_state &robotState) = 0;
+
+	private:
+		// The runner does the scheduling.
+		friend class AsyncTaskRunner;
+
+		enum class Status : uint8_t {
+			IDLE = 0, // Waiting to be queued
+			QUEUED,   // Waiting for a worker
+			RUNNING   // A worker is running it
+		};
+
+		/**
+		  * @brief Called by the runner every control cycle.
+		  * @param robotState This cycle's robot state.
+		  * @return True if this task was queued.
+		  */
+		bool cycle(const atrias_msgs::robot_state &robotState);
+
+		/**
+		  * @brief Called by a worker: runs this task if it's queued.
+		  * @return True if this task was run.
+		  */
+		bool runIfQueued();
+
+		/**
+		  * @brief Sets how many control cycles are between runs.
+		  * @param controlPeriod The control loop period, in seconds.
+		  */
+		void setControlPeriod(double controlPeriod);
+
+		// The runner this task is registered with
+		AsyncTaskRunner                     *runner;
+
+		// This task's name
+		std::string                          name;
+
+		// The requested period, in seconds
+		double                               period;
+
+		// The period in control cycles (0 for triggered-only),
+		// and the cycles left until the next run
+		uint32_t                             periodCycles;
+		uint32_t                             countdown;
+
+		// Set by trigger()
+		bool                                 triggered;
+
+		// Runs skipped because the task was busy
+		uint32_t                             overruns;
+
+		// Where the task is in its life cycle
+		std::atomic<Status>                  status;
+
+		// The robot state handed to run(). Only written by the control
+		// loop while IDLE, and only read by a worker while RUNNING.
+		atrias_msgs::robot_state             snapshot;
+};
+
+template <class Result>
+class AsyncTask : public AsyncTaskBase {
+	public:
+		/**
+		  * @brief Registers this task with the top-level controller.
+		  * @param owner  The controller this task belongs to.
+		  * @param name   This task's name, for diagnostics.
+		  * @param period How often to run, in seconds. 0 means only when triggered.
+		  */
+		AsyncTask(AtriasController *owner, const std::string &name, double period);
+
+		/**
+		  * @brief Latches the newest published result. Call from the control loop.
+		  * @return True if there's a result that hasn't been latched before.
+		  */
+		bool          update();
+
+		/**
+		  * @brief Returns the result latched by the last \a update().
+		  * @return The result. Default-constructed until the first run finishes.
+		  */
+		const Result& getResult() const;
+
+	protected:
+		/**
+		  * @brief Returns the result for \a run() to fill in.
+		  * @return The mailbox's write slot.
+		  */
+		Result&       getResultBuffer();
+
+		/**
+		  * @brief Hands the result filled in by \a run() to the control loop.
+		  */
+		void          publishResult();
+
+	private:
+		// Carries results from the worker to the control loop
+		shared::TripleBuffer<Result> mailbox;
+};
+
+template <class Result>
+AsyncTask<Result>::AsyncTask(AtriasController *owner, const std::string &name, double period) :
+	AsyncTaskBase(owner, name, period)
+{
+	// Nothing else to do.
+}
+
+template <class Result>
+bool AsyncTask<Result>::update() {
+	return this->mailbox.update();
+}
+
+template <class Result>
+const Result& AsyncTask<Result>::getResult() const {
+	return this->mailbox.read();
+}
+
+template <class Result>
+Result& AsyncTask<Result>::getResultBuffer() {
+	return this->mailbox.getWriteBuffer();
+}
+
+template <class Result>
+void AsyncTask<Result>::publishResult() {
+	this->mailbox.publish();
+}
+
+// End namespaces
+}
+}
+
+#endif // ASYNCTASK_HPP
+
+// vim: noexpandtab
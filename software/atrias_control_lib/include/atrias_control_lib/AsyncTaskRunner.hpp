@@ -0,0 +1,109 @@
+#ifndef ASYNCTASKRUNNER_HPP
+#define ASYNCTASKRUNNER_HPP
+
+/**
+  * @file AsyncTaskRunner.hpp
+  * @brief Schedules a top-level controller's AsyncTasks and owns the worker
+  * threads that run them.
+  */
+
+// Standard library
+#include <vector>
+
+// Orocos
+#include <rtt/Activity.hpp>
+#include <rtt/Logger.hpp>
+#include <rtt/os/Semaphore.hpp>
+
+// Robot state
+#include <atrias_msgs/robot_state.h>
+
+#include "atrias_control_lib/AsyncTask.hpp"
+
+// The workers' priority. They run under the normal (SCHED_OTHER) scheduler,
+// so they can never delay a control cycle, and a long task can't starve
+// the other non-realtime threads (logging, ROS, the controller manager).
+#define ASYNC_TASK_PRIORITY 0
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class AsyncTaskRunner {
+	public:
+		/**
+		  * @brief Initializes the runner with no tasks and no workers.
+		  */
+		AsyncTaskRunner();
+
+		/**
+		  * @brief Stops the workers.
+		  */
+		~AsyncTaskRunner();
+
+		/**
+		  * @brief Adds a task. Not realtime safe; only call while stopped.
+		  * @param task The task.
+		  */
+		void addTask(AsyncTaskBase *task);
+
+		/**
+		  * @brief Removes a task. Not realtime safe; only call while stopped.
+		  * @param task The task.
+		  */
+		void removeTask(AsyncTaskBase *task);
+
+		/**
+		  * @brief Starts the worker threads, if there are any tasks.
+		  * @param controlPeriod The control loop period, in seconds.
+		  * @param numWorkers    How many worker threads to start.
+		  * @return Success.
+		  */
+		bool start(double controlPeriod, unsigned int numWorkers = 1);
+
+		/**
+		  * @brief Stops the worker threads, letting any running tasks finish.
+		  */
+		void stop();
+
+		/**
+		  * @brief Queues every task that's due. Call once at the end of each cycle.
+		  * @param robotState This cycle's robot state.
+		  * Realtime safe: this only copies the state and posts a semaphore.
+		  */
+		void cycle(const atrias_msgs::robot_state &robotState);
+
+	private:
+		// One worker thread. Waits on \a wake, then runs whatever's queued.
+		struct Worker : public RTT::Activity {
+			Worker(AsyncTaskRunner *runner, const std::string &name);
+			void loop();
+			bool breakLoop();
+			bool initialize();
+
+			AsyncTaskRunner *runner;
+			volatile bool    done;
+		};
+
+		/**
+		  * @brief Runs queued tasks until there are none left. Run by the workers.
+		  */
+		void runQueued();
+
+		// The registered tasks. Only changed while the workers are stopped.
+		std::vector<AsyncTaskBase*> tasks;
+
+		// The worker threads
+		std::vector<Worker*>        workers;
+
+		// Posted once for each task queued (and once per worker to stop it)
+		RTT::os::Semaphore          wake;
+};
+
+// End namespaces
+}
+}
+
+#endif // ASYNCTASKRUNNER_HPP
+
+// vim: noexpandtab
@@ -23,6 +23,10 @@
 namespace atrias {
 namespace controller {
 
+class AsyncTaskRunner;
+class LogFrame;
+class Profiler;
+
 // Subcontrollers do not need to be components, so this is not a TaskContext.
 class AtriasController {
 	protected:
@@ -66,6 +70,13 @@ class AtriasController {
 		//virtual const std_msgs::Header_<RTT::os::rt_allocator<uint8_t>>& getROSHeader() const;
 		virtual const std_msgs::Header& getROSHeader() const;
 
+		/**
+		  * @brief Returns the control loop period.
+		  * @return The time between runs of the controller, in seconds.
+		  * Use this instead of a hard-coded timestep.
+		  */
+		virtual double getPeriod() const;
+
 		/**
 		  * @brief This returns the TaskContext
 		  * @return A reference to the TaskContext.
@@ -73,6 +84,27 @@ class AtriasController {
 		  */
 		virtual RTT::TaskContext& getTaskContext() const;
 
+		/**
+		  * @brief This returns the runner for this controller's AsyncTasks.
+		  * @return A reference to the top-level controller's runner.
+		  * This should only be overridden by the ATC class
+		  */
+		virtual AsyncTaskRunner& getAsyncTaskRunner() const;
+
+		/**
+		  * @brief This returns the frame this controller's LogPorts send in.
+		  * @return A reference to the top-level controller's log frame.
+		  * This should only be overridden by the ATC class
+		  */
+		virtual LogFrame& getLogFrame() const;
+
+		/**
+		  * @brief This returns the profiler this controller's ProfilePoints record in.
+		  * @return A reference to the top-level controller's profiler.
+		  * This should only be overridden by the ATC class
+		  */
+		virtual Profiler& getProfiler() const;
+
 		/**
 		  * @brief This returns the TLC as an AtriasController
 		  * @return A reference to the top-level controller.
@@ -0,0 +1,234 @@
+#ifndef LOGFRAME_HPP
+#define LOGFRAME_HPP
+
+/**
+  * @file LogFrame.hpp
+  * @brief Collects a top-level controller's LogPort data into one message per cycle.
+  * Each LogPort gets a slot in the frame and packs its message into
+  * it when it sends; the ATC then sends the whole frame over one port
+  * at the end of the cycle. Only the slots sent that cycle take up space
+  * in the frame, and cycles where nothing was sent send no frame. An
+  * atrias_msgs::log_frame_layout, sent on a second port, says which slot
+  * belongs to which topic, so atrias/scripts/split_log_frames.py can turn
+  * a bag of frames back into the per-subcontroller topics.
+  *
+  * Each slot can be switched off, decimated, or limited to some of its
+  * message's fields while the controller runs (see configureSlot()). The
+  * new settings take effect together, at the start of the next cycle.
+  */
+
+// Standard library
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Orocos
+#include <rtt/OutputPort.hpp>  // The frame and layout ports
+#include <rtt/TaskContext.hpp> // Which they're added to
+#include <rtt/os/Mutex.hpp>    // Serializes setting changes
+
+// ROS
+#include <std_msgs/Header.h>
+
+// Our messages
+#include <atrias_msgs/log_frame.h>
+#include <atrias_msgs/log_frame_layout.h>
+
+// Hands the settings to the control loop
+#include <atrias_shared/TripleBuffer.hpp>
+
+/** @brief The log_frame format version. Bump this when the meaning of
+  * log_frame's or log_frame_layout's fields changes.
+  */
+#define LOG_FRAME_VERSION 2
+
+/** @brief A field mask selecting every field.
+  */
+#define LOG_FRAME_ALL_FIELDS (~((uint64_t) 0))
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class LogFrame {
+	public:
+		/**
+		  * @brief Initializes an empty frame.
+		  */
+		LogFrame();
+
+		/**
+		  * @brief Adds a slot for a LogPort. Not realtime safe; call while
+		  * the controllers are being constructed.
+		  * @param topic      The topic the LogPort's messages belong on.
+		  * @param type       Their ROS datatype.
+		  * @param md5sum     Their type's MD5 sum.
+		  * @param definition Their type's full definition, which says which
+		  *                   fields can be masked.
+		  * @param size       The most bytes one of its messages serializes to.
+		  * @return The slot's index.
+		  */
+		size_t addSlot(const std::string &topic, const std::string &type,
+		               const std::string &md5sum, const std::string &definition,
+		               uint32_t size);
+
+		/**
+		  * @brief Returns whether any LogPorts have slots.
+		  * @return True if there are no slots.
+		  */
+		bool empty() const;
+
+		/**
+		  * @brief Adds the frame and layout ports to a controller, and
+		  * preallocates their samples. Not realtime safe; call once all
+		  * the slots have been added.
+		  * @param taskContext The top-level controller's TaskContext.
+		  * @param period      The control loop period, in seconds. The layout
+		  *                    is re-sent about once a second.
+		  */
+		void addPorts(RTT::TaskContext &taskContext, double period);
+
+		/**
+		  * @brief Connects the ports to ROS and sends the layout.
+		  * @param name The controller's name; the topics are /name_log_frame
+		  *             and /name_log_layout.
+		  * @return True if both connected.
+		  */
+		bool stream(const std::string &name);
+
+		/**
+		  * @brief Changes what a slot logs. Not realtime safe, but may be
+		  * called while the control loop runs; the change is applied at
+		  * the start of the next cycle.
+		  * @param topic   The slot's topic (the leading '/' is optional), or
+		  *                "*" for every slot.
+		  * @param enabled Whether to log it at all.
+		  * @param divisor Log it every this many cycles. Must be at least 1.
+		  * @param fields  The fields to log, separated by commas or spaces,
+		  *                or "" for all of them. The header is always logged.
+		  * @return False if the topic, divisor, or a field is invalid, in
+		  *         which case nothing is changed.
+		  */
+		bool configureSlot(const std::string &topic, bool enabled,
+		                   uint32_t divisor, const std::string &fields);
+
+		/**
+		  * @brief Describes every slot and its settings, one per line.
+		  * Not realtime safe.
+		  * @return The description.
+		  */
+		std::string describe();
+
+		/**
+		  * @brief Returns whether a slot should be sent this cycle.
+		  * Realtime safe, and cheap enough to call before doing any work.
+		  * @param slot The slot, from addSlot().
+		  * @return True if it's enabled and not decimated this cycle.
+		  */
+		bool due(size_t slot) const;
+
+		/**
+		  * @brief Returns where to serialize a slot's message this cycle.
+		  * Realtime safe. Follow with commit().
+		  * @param slot   The slot, from addSlot().
+		  * @param length The message's serialized length.
+		  * @return Where to write it, or NULL if it's bigger than the slot.
+		  */
+		uint8_t* reserve(size_t slot, uint32_t length);
+
+		/**
+		  * @brief Packs the message serialized at reserve() into the frame,
+		  * keeping only the slot's selected fields. Realtime safe.
+		  * Only the last message a slot is given in a cycle is sent.
+		  * @param slot         The slot, from addSlot().
+		  * @param headerLength The serialized length of the message's header.
+		  */
+		void commit(size_t slot, uint32_t headerLength);
+
+		/**
+		  * @brief Sends this cycle's frame, if any slots were filled, empties
+		  * it for the next, and applies any new settings. Realtime safe.
+		  * @param header The header to send the frame (and layout) with.
+		  */
+		void send(const std_msgs::Header &header);
+
+		/**
+		  * @brief Returns how many messages didn't fit in their slots.
+		  * @return The number of messages dropped.
+		  */
+		uint64_t getDropped() const;
+
+		/**
+		  * @brief Returns how many cycles the frame has been sent for, which
+		  * decimation counts against.
+		  * @return The cycle count.
+		  */
+		uint64_t getCycle() const;
+
+	private:
+		// One slot's settings
+		struct SlotSettings {
+			bool     enabled;
+			uint32_t divisor;
+			uint64_t mask;
+		};
+
+		// Reads a message definition's top-level fields, which can be masked
+		// if the message is a Header followed by fixed-size fields only.
+		// Returns false (with no fields) otherwise.
+		static bool parseFields(const std::string &definition,
+		                        std::vector<std::string> &names,
+		                        std::vector<uint32_t> &sizes);
+
+		// The frame being filled in, with room for every slot
+		atrias_msgs::log_frame                         frame;
+
+		// What's in it
+		atrias_msgs::log_frame_layout                  layout;
+
+		// Each slot's maskable fields (after the header); empty if it
+		// can't be masked
+		std::vector<std::vector<std::string>>          fieldNames;
+		std::vector<std::vector<uint32_t>>             fieldSizes;
+
+		// Which of this cycle's messages each slot is (or -1), and where
+		// it starts in the data
+		std::vector<int32_t>                           packed;
+		std::vector<uint32_t>                          packedOffsets;
+
+		// Where reserve() has messages serialized, and their length
+		std::vector<uint8_t>                           scratch;
+		uint32_t                                       scratchLength;
+
+		// The settings: the latest requested, and the ones in use
+		std::vector<SlotSettings>                      requested;
+		shared::TripleBuffer<std::vector<SlotSettings>> settings;
+		RTT::os::Mutex                                 settingsLock;
+
+		// How many messages didn't fit
+		uint64_t                                       dropped;
+
+		// How many cycles have gone by
+		uint64_t                                       cycle;
+
+		// How many cycles between sends of the layout, and since the last one
+		uint32_t                                       layoutPeriod;
+		uint32_t                                       cyclesSinceLayout;
+
+		// Our ports
+		RTT::OutputPort<atrias_msgs::log_frame>        framePort;
+		RTT::OutputPort<atrias_msgs::log_frame_layout> layoutPort;
+};
+
+inline bool LogFrame::due(size_t slot) const {
+	const SlotSettings &slotSettings = this->settings.read()[slot];
+	return slotSettings.enabled && this->cycle % slotSettings.divisor == 0;
+}
+
+// End namespaces
+}
+}
+
+#endif // LOGFRAME_HPP
+
+// vim: noexpandtab
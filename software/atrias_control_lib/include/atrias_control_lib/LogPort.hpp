@@ -6,17 +6,16 @@
   * @author Ryan Van Why
   * @brief This class allows subcontrollers to log data.
   * This may also be utilized by top-level controllers
-  * for additional log ports.
+  * for additional log ports. Rather than each having its own ROS
+  * port, they're all sent together once per cycle by LogFrame.
   */
 
-// Orocos includes
-#include <rtt/ConnPolicy.hpp>       // Allows for connecting the output port to ROS
-#include <rtt/OutputPort.hpp>       // This allows the creation of an output port
-#include <rtt/os/oro_allocator.hpp> // Lets us send messages in HRT
+// ROS
+#include <ros/serialization.h> // Packs the data into the log frame
 
 // ATRIAS
-#include <atrias_shared/RtMsgTypekits.hpp>         // Lets us register a typekit for this message.
 #include "atrias_control_lib/AtriasController.hpp" // This allows us to access the name and TaskContext
+#include "atrias_control_lib/LogFrame.hpp"         // Where the data goes
 
 namespace atrias {
 namespace controller {
@@ -28,57 +27,70 @@ class LogPort {
 		  * @brief The constructor for this logging port.
 		  * @param controller A reference to this controller
 		  * @param name       The name for this log port.
+		  * This reserves a slot in the top-level controller's log frame;
+		  * the data ends up on the /<controller name>_<name> topic once the
+		  * frames are split (see LogFrame).
 		  */
 		LogPort(const AtriasController* const controller, const std::string name = "log");
 
 		/**
 		  * @brief This allows controllers to access the data to be logged.
 		  */
-		//logType<RTT::os::rt_allocator<uint8_t>> data;
 		logType<std::allocator<void>> data;
 
 		/**
-		  * @brief This transmits the data for logging.
+		  * @brief This stages the data for logging.
+		  * It goes out with the rest of the cycle's log frame, unless this
+		  * port's been switched off or decimated (see LogFrame::configureSlot()).
+		  * If this is called more than once in a cycle, only the last data is sent.
 		  * This will not alter the data itself.
 		  */
 		void send();
 	
 	private:
-		// Our output port
-		//RTT::OutputPort<logType<RTT::os::rt_allocator<uint8_t>>> port;
-		RTT::OutputPort<logType<std::allocator<void>>> port;
-
 		// Allows us to access the top-level controller.
 		const AtriasController &tlc;
+
+		// The top-level controller's log frame, and our slot in it
+		LogFrame &frame;
+		size_t    slot;
 };
 
 template <template <class> class logType>
 LogPort<logType>::LogPort(const AtriasController* const controller, const std::string name) :
-	port(controller->getName() + "_" + name),
-	tlc(controller->getTLC())
+	tlc(controller->getTLC()),
+	frame(controller->getTLC().getLogFrame())
 {
-	// Register typekit
-	//shared::RtMsgTypekits::registerType<logType>(controller->getName() + "_" + name);
-
-	// Setup our port
-	this->tlc.getTaskContext().addPort(this->port);
-
-	RTT::ConnPolicy policy = RTT::ConnPolicy::buffer(10000);
-	// Transport 3 is ROS
-	policy.transport = 3;
-	// Set the topic name
-	policy.name_id = "/" + controller->getName() + "_" + name;
-	// And actually initiate the connection
-	this->port.createStream(policy);
+	typedef logType<std::allocator<void>> Message;
+
+	// Our messages are fixed-size, so an empty one is as big as any.
+	this->slot = this->frame.addSlot("/" + controller->getName() + "_" + name,
+	                                 ros::message_traits::datatype<Message>(),
+	                                 ros::message_traits::md5sum<Message>(),
+	                                 ros::message_traits::definition<Message>(),
+	                                 ros::serialization::serializationLength(this->data));
 }
 
 template <template <class> class logType>
 void LogPort<logType>::send() {
+	// Skip all the work if we're switched off or decimated this cycle
+	if (!this->frame.due(this->slot))
+		return;
+
 	// Set the timestamp
 	this->data.header = this->tlc.getROSHeader();
 
-	// Send the data
-	this->port.write(this->data);
+	// Pack the data into our slot
+	uint32_t length = ros::serialization::serializationLength(this->data);
+	uint8_t* buffer = this->frame.reserve(this->slot, length);
+	if (!buffer)
+		return;
+
+	ros::serialization::OStream stream(buffer, length);
+	ros::serialization::serialize(stream, this->data);
+
+	// And keep the fields that are being logged
+	this->frame.commit(this->slot, ros::serialization::serializationLength(this->data.header));
 }
 
 }
@@ -0,0 +1,224 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+/**
+  * @file Profiler.hpp
+  * @brief Times parts of a top-level controller and its subcontrollers.
+  * Each ProfilePoint names something to be timed, such as a subcontroller's
+  * operator() or iKine(); a ProfileScope around the call times it with the
+  * CPU's cycle counter. The top-level controller's Profiler keeps each
+  * point's call count and min, mean, p99, and max duration, and reports
+  * them through the ATC's "getProfile" operation.
+  *
+  * Profiling is off until the ATC's "setProfiling" operation turns it on;
+  * while off, a ProfileScope costs one relaxed atomic load.
+  */
+
+// Standard library
+#include <atomic>
+#include <deque>
+#include <stdint.h>
+#include <string>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h> // __rdtsc()
+#else
+#include <time.h>
+#endif
+
+// Recording never allocates
+#include <atrias_shared/LatencyHistogram.hpp>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class AtriasController;
+
+class Profiler {
+	public:
+		/**
+		  * @brief Initializes a profiler with no points, switched off.
+		  */
+		Profiler();
+
+		/**
+		  * @brief Adds a point to be timed. Not realtime safe; call while
+		  * the controllers are being constructed.
+		  * @param name The point's name, as shown in the report.
+		  * @return The point's index.
+		  */
+		size_t addPoint(const std::string &name);
+
+		/**
+		  * @brief Switches timing on or off. May be called while the
+		  * control loop runs.
+		  * @param enabled Whether to time the points.
+		  */
+		void setEnabled(bool enabled);
+
+		/**
+		  * @brief Returns whether timing is on. Realtime safe.
+		  * @return True if the points are being timed.
+		  */
+		bool isEnabled() const;
+
+		/**
+		  * @brief Adds one call's duration to a point. Realtime safe.
+		  * Each point may only be recorded from one thread at a time.
+		  * @param point The point, from addPoint().
+		  * @param ticks How long the call took, in cycle counter ticks.
+		  */
+		void record(size_t point, uint64_t ticks);
+
+		/**
+		  * @brief Describes every point's timing, one per line, in
+		  * microseconds. Not realtime safe.
+		  * @return The report.
+		  */
+		std::string report();
+
+		/**
+		  * @brief Clears every point's statistics. May be called while the
+		  * control loop runs; each point is cleared at its next record().
+		  */
+		void reset();
+
+		/**
+		  * @brief Reads the cycle counter. Realtime safe.
+		  * @return The time, in ticks. Only differences are meaningful.
+		  */
+		static uint64_t ticks();
+
+		/**
+		  * @brief Measures how fast the cycle counter runs. Not realtime
+		  * safe; the first call takes about 20 ms.
+		  * @return The counter's rate, in ticks per second.
+		  */
+		static double ticksPerSecond();
+
+	private:
+		// One point's statistics. The histogram takes ticks in place of
+		// nanoseconds, so its p99 is exact to about 6%, up to 2^25 ticks.
+		struct Point {
+			Point(const std::string &name);
+
+			std::string              name;
+			shared::LatencyHistogram histogram;
+			uint64_t                 minTicks;
+			uint64_t                 totalTicks;
+			std::atomic<bool>        resetRequested;
+		};
+
+		// A deque, so the points never move once added
+		std::deque<Point> points;
+		std::atomic<bool> enabled;
+};
+
+/**
+  * @brief Something a controller times, such as one of its functions.
+  * Make it a member, constructed alongside the controller's LogPorts, and
+  * put a ProfileScope at the top of the function.
+  */
+class ProfilePoint {
+	public:
+		/**
+		  * @brief Adds this point to the top-level controller's profiler.
+		  * @param controller The controller this belongs to.
+		  * @param name       What's being timed, such as "iKine". The report
+		  *                   shows it as <controller name>::<name>.
+		  */
+		ProfilePoint(const AtriasController* const controller, const std::string &name);
+
+	private:
+		friend class ProfileScope;
+
+		// The top-level controller's profiler, and our point in it
+		Profiler &profiler;
+		size_t    point;
+};
+
+/**
+  * @brief Times from its construction until it goes out of scope.
+  */
+class ProfileScope {
+	public:
+		/**
+		  * @brief Starts timing, if profiling is on.
+		  * @param point What's being timed.
+		  */
+		ProfileScope(ProfilePoint &point);
+
+		/**
+		  * @brief Starts timing a point without a ProfilePoint, if
+		  * profiling is on. Used by the ATC for its own points.
+		  * @param profiler The profiler.
+		  * @param point    The point, from Profiler::addPoint().
+		  */
+		ProfileScope(Profiler &profiler, size_t point);
+
+		/**
+		  * @brief Records the time since construction.
+		  */
+		~ProfileScope();
+
+	private:
+		Profiler &profiler;
+		size_t    point;
+
+		// When we started, or 0 if profiling was off
+		uint64_t  start;
+};
+
+inline bool Profiler::isEnabled() const {
+	return this->enabled.load(std::memory_order_relaxed);
+}
+
+inline uint64_t Profiler::ticks() {
+#if defined(__i386__) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t) now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+}
+
+inline void Profiler::record(size_t point, uint64_t ticks) {
+	Point &entry = this->points[point];
+	if (entry.resetRequested.load(std::memory_order_acquire)) {
+		entry.minTicks   = UINT64_MAX;
+		entry.totalTicks = 0;
+		entry.resetRequested.store(false, std::memory_order_release);
+	}
+
+	entry.histogram.record(ticks);
+	entry.totalTicks += ticks;
+	if (ticks < entry.minTicks)
+		entry.minTicks = ticks;
+}
+
+inline ProfileScope::ProfileScope(ProfilePoint &point) :
+	profiler(point.profiler),
+	point(point.point),
+	start(point.profiler.isEnabled() ? Profiler::ticks() : 0)
+{ }
+
+inline ProfileScope::ProfileScope(Profiler &profiler, size_t point) :
+	profiler(profiler),
+	point(point),
+	start(profiler.isEnabled() ? Profiler::ticks() : 0)
+{ }
+
+inline ProfileScope::~ProfileScope() {
+	if (this->start)
+		this->profiler.record(this->point, Profiler::ticks() - this->start);
+}
+
+// End namespaces
+}
+}
+
+#endif // PROFILER_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,302 @@
+#ifndef RTMSGPOOL_HPP
+#define RTMSGPOOL_HPP
+
+/**
+  * @file RtMsgPool.hpp
+  * @brief A realtime memory pool for ROS messages, and an allocator using it.
+  * Messages whose strings and arrays are allocated with RtMsgAllocator get
+  * their memory from a TLSF (two-level segregated fit) pool: allocating and
+  * freeing take constant time, and never touch the system heap. The pool
+  * is sized before the control loop starts (see reserve()); if it runs out,
+  * allocation throws std::bad_alloc rather than falling back to the heap,
+  * and callers drop the sample they were copying.
+  *
+  * The pool is shared by the whole process, since the allocator has no
+  * state (ROS and RTT default-construct messages). It's safe to use from
+  * any thread. A priority-inheriting mutex protects it, held for a handful
+  * of pointer operations at a time. Realtime (SCHED_FIFO or SCHED_RR)
+  * threads never wait for it: if another thread has it, their allocations
+  * fail (and the sample is dropped), and their frees are left for the next
+  * thread to take the lock.
+  */
+
+// Standard library
+#include <algorithm>
+#include <new>         // std::bad_alloc, placement new
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <type_traits> // std::is_arithmetic
+#include <utility>     // std::forward
+#include <vector>
+
+// Boost
+#include <boost/array.hpp>
+
+// ROS
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+#include <std_msgs/Header.h>
+
+// Our statistics message
+#include <atrias_msgs/rt_msg_pool.h>
+
+/** @brief The pool's size until a controller asks for more, in bytes.
+  */
+#define RT_MSG_POOL_DEFAULT_SIZE (256 * 1024)
+
+/** @brief The biggest single allocation the pool can make, in bytes.
+  */
+#define RT_MSG_POOL_MAX_BLOCK    (1 << 30)
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class RtMsgPool {
+	public:
+		/**
+		  * @brief Grows the pool to at least this many bytes. Not realtime
+		  * safe; call while configuring. The memory is touched here, so
+		  * the control loop doesn't page fault on it. The pool never shrinks.
+		  * @param bytes The smallest size the pool should have.
+		  * @return False if the memory couldn't be allocated.
+		  */
+		static bool     reserve(size_t bytes);
+
+		/**
+		  * @brief Allocates from the pool. Realtime safe, constant time.
+		  * @param bytes How much to allocate.
+		  * @return The memory (aligned to 16 bytes), or NULL if the pool
+		  *         has no block that big free, or (on a realtime thread)
+		  *         another thread is using the pool.
+		  */
+		static void*    allocate(size_t bytes);
+
+		/**
+		  * @brief Returns memory to the pool. Realtime safe, constant time.
+		  * @param ptr Memory from allocate(), or NULL.
+		  */
+		static void     deallocate(void *ptr);
+
+		/**
+		  * @brief Returns the most of the pool one allocation can take up.
+		  * Realtime safe.
+		  * @param bytes The allocation's size.
+		  * @return Its size, rounded up, plus the pool's per-block overhead.
+		  */
+		static size_t   footprint(size_t bytes);
+
+		/**
+		  * @brief Returns whether there's a free block this big now.
+		  * If there is, allocations whose footprint()s add up to no more
+		  * than that all succeed, barring other threads. Realtime safe.
+		  * @param bytes The block's size.
+		  * @return True if there's a free block that big. False if not, or
+		  *         if (on a realtime thread) another thread is using the pool.
+		  */
+		static bool     hasRoom(size_t bytes);
+
+		/**
+		  * @brief Counts a sample dropped because the pool was too full.
+		  * Realtime safe.
+		  */
+		static void     noteDrop();
+
+		/**
+		  * @brief Fills in the pool's usage statistics. Realtime safe.
+		  * On a realtime thread, only the atomic counters are updated if
+		  * another thread is using the pool.
+		  * @param stats The message to fill in (all but its header).
+		  */
+		static void     getStats(atrias_msgs::rt_msg_pool &stats);
+};
+
+/**
+  * @brief An STL (and ROS message) allocator using the RtMsgPool.
+  * Throws std::bad_alloc when the pool is out of memory.
+  */
+template <class T>
+class RtMsgAllocator {
+	public:
+		typedef T              value_type;
+		typedef T*             pointer;
+		typedef const T*       const_pointer;
+		typedef T&             reference;
+		typedef const T&       const_reference;
+		typedef size_t         size_type;
+		typedef ptrdiff_t      difference_type;
+
+		template <class U>
+		struct rebind {
+			typedef RtMsgAllocator<U> other;
+		};
+
+		RtMsgAllocator() { }
+
+		template <class U>
+		RtMsgAllocator(const RtMsgAllocator<U>&) { }
+
+		pointer address(reference x) const {
+			return &x;
+		}
+
+		const_pointer address(const_reference x) const {
+			return &x;
+		}
+
+		pointer allocate(size_type n, const void* = 0) {
+			void *ptr = RtMsgPool::allocate(n * sizeof(T));
+			if (!ptr)
+				throw std::bad_alloc();
+			return static_cast<pointer>(ptr);
+		}
+
+		void deallocate(pointer ptr, size_type) {
+			RtMsgPool::deallocate(ptr);
+		}
+
+		size_type max_size() const {
+			return RT_MSG_POOL_MAX_BLOCK / sizeof(T);
+		}
+
+		template <class... Args>
+		void construct(pointer ptr, Args&&... args) {
+			::new ((void*) ptr) T(std::forward<Args>(args)...);
+		}
+
+		void destroy(pointer ptr) {
+			ptr->~T();
+		}
+};
+
+template <>
+class RtMsgAllocator<void> {
+	public:
+		typedef void           value_type;
+		typedef void*          pointer;
+		typedef const void*    const_pointer;
+		typedef size_t         size_type;
+		typedef ptrdiff_t      difference_type;
+
+		template <class U>
+		struct rebind {
+			typedef RtMsgAllocator<U> other;
+		};
+
+		RtMsgAllocator() { }
+
+		template <class U>
+		RtMsgAllocator(const RtMsgAllocator<U>&) { }
+};
+
+// The allocator has no state, so any two are interchangeable.
+template <class T, class U>
+inline bool operator==(const RtMsgAllocator<T>&, const RtMsgAllocator<U>&) {
+	return true;
+}
+
+template <class T, class U>
+inline bool operator!=(const RtMsgAllocator<T>&, const RtMsgAllocator<U>&) {
+	return false;
+}
+
+/**
+  * @brief Adds up how much of the RtMsgPool copying a message can take.
+  * Walks the message like ROS's serializers do, counting each non-empty
+  * string and array as one allocation. Check the total with
+  * RtMsgPool::hasRoom() to know the whole copy will fit.
+  */
+class RtMsgFootprint {
+	size_t total;
+
+	// Messages are walked through their generated serializers. Anything
+	// else that isn't a string or an array has a fixed size, and doesn't
+	// allocate.
+	template <class T, bool isMessage = ros::message_traits::IsMessage<T>::value>
+	struct Field {
+		static void next(RtMsgFootprint&, const T&) { }
+	};
+
+	template <class T>
+	struct Field<T, true> {
+		static void next(RtMsgFootprint &footprint, const T &msg) {
+			ros::serialization::Serializer<T>::template allInOne<RtMsgFootprint, const T&>(footprint, msg);
+		}
+	};
+
+	public:
+		RtMsgFootprint() {
+			total = 0;
+		}
+
+		/**
+		  * @brief Returns the total so far.
+		  * @return The most of the pool the fields seen so far can take, in bytes.
+		  */
+		size_t getTotal() const {
+			return total;
+		}
+
+		/**
+		  * @brief Adds in a field (or a whole message).
+		  * @param field The field.
+		  */
+		template <class T>
+		void next(const T &field) {
+			Field<T>::next(*this, field);
+		}
+
+		template <class Alloc>
+		void next(const std::basic_string<char, std::char_traits<char>, Alloc> &field) {
+			// libstdc++ puts a three-word header and a terminator around the text.
+			if (!field.empty())
+				total += RtMsgPool::footprint(3 * sizeof(size_t) + field.size() + 1);
+		}
+
+		template <class T, class Alloc>
+		void next(const std::vector<T, Alloc> &field) {
+			if (field.empty())
+				return;
+
+			total += RtMsgPool::footprint(field.size() * sizeof(T));
+			if (!std::is_arithmetic<T>::value) {
+				for (typename std::vector<T, Alloc>::const_iterator it = field.begin(); it != field.end(); ++it)
+					next(*it);
+			}
+		}
+
+		template <class T, size_t N>
+		void next(const boost::array<T, N> &field) {
+			if (!std::is_arithmetic<T>::value) {
+				for (size_t i = 0; i < N; i++)
+					next(field[i]);
+			}
+		}
+};
+
+/**
+  * @brief Copies a header into one with a different allocator.
+  * The frame_id is only reassigned when it changes, so in the steady
+  * state this doesn't allocate.
+  * @param from The header to copy.
+  * @param to   Where to copy it.
+  */
+template <class Allocator>
+void copyHeader(const std_msgs::Header &from, std_msgs::Header_<Allocator> &to) {
+	to.seq   = from.seq;
+	to.stamp = from.stamp;
+	if (to.frame_id.size() != from.frame_id.size() ||
+	    !std::equal(from.frame_id.begin(), from.frame_id.end(), to.frame_id.begin()))
+	{
+		to.frame_id.assign(from.frame_id.begin(), from.frame_id.end());
+	}
+}
+
+// End namespaces
+}
+}
+
+#endif // RTMSGPOOL_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,94 @@
+#include "atrias_control_lib/AsyncTask.hpp"
+#include "atrias_control_lib/AsyncTaskRunner.hpp"
+#include "atrias_control_lib/AtriasController.hpp"
+
+#include <math.h>
+#include <unistd.h>
+
+namespace atrias {
+namespace controller {
+
+AsyncTaskBase::AsyncTaskBase(AtriasController *owner, const std::string &name, double period) :
+	runner(&owner->getAsyncTaskRunner()),
+	name(owner->getName() + "_" + name),
+	period(period),
+	periodCycles(0),
+	countdown(0),
+	triggered(false),
+	overruns(0),
+	status(Status::IDLE)
+{
+	this->runner->addTask(this);
+}
+
+AsyncTaskBase::~AsyncTaskBase() {
+	// The workers should already be stopped, but don't pull the task out
+	// from under one if they aren't.
+	while (this->status.load() == Status::RUNNING)
+		usleep(1000);
+
+	this->runner->removeTask(this);
+}
+
+void AsyncTaskBase::trigger() {
+	this->triggered = true;
+}
+
+uint32_t AsyncTaskBase::getOverruns() const {
+	return this->overruns;
+}
+
+const std::string& AsyncTaskBase::getName() const {
+	return this->name;
+}
+
+bool AsyncTaskBase::cycle(const atrias_msgs::robot_state &robotState) {
+	bool due = this->triggered;
+	if (this->periodCycles && --this->countdown == 0) {
+		this->countdown = this->periodCycles;
+		due = true;
+	}
+	if (!due)
+		return false;
+
+	this->triggered = false;
+
+	// Only we move the task out of IDLE, so if it's idle now no worker
+	// can be looking at the snapshot.
+	if (this->status.load(std::memory_order_acquire) != Status::IDLE) {
+		this->overruns++;
+		return false;
+	}
+
+	this->snapshot = robotState;
+	this->status.store(Status::QUEUED, std::memory_order_release);
+	return true;
+}
+
+bool AsyncTaskBase::runIfQueued() {
+	Status expected = Status::QUEUED;
+	if (!this->status.compare_exchange_strong(expected, Status::RUNNING, std::memory_order_acq_rel))
+		return false;
+
+	this->run(this->snapshot);
+
+	this->status.store(Status::IDLE, std::memory_order_release);
+	return true;
+}
+
+void AsyncTaskBase::setControlPeriod(double controlPeriod) {
+	if (this->period <= 0.0) {
+		this->periodCycles = 0;
+	} else {
+		long cycles = lround(this->period / controlPeriod);
+		this->periodCycles = (cycles < 1) ? 1 : cycles;
+	}
+
+	// Run on the first cycle.
+	this->countdown = 1;
+}
+
+}
+}
+
+// vim: noexpandtab
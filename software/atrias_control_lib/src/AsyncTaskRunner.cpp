@@ -0,0 +1,114 @@
+#include "atrias_control_lib/AsyncTaskRunner.hpp"
+
+#include <algorithm>
+
+namespace atrias {
+namespace controller {
+
+AsyncTaskRunner::Worker::Worker(AsyncTaskRunner *runner, const std::string &name) :
+	RTT::Activity(ORO_SCHED_OTHER, ASYNC_TASK_PRIORITY, 0.0, 0, name),
+	runner(runner),
+	done(false)
+{
+	// Nothing else to do.
+}
+
+void AsyncTaskRunner::Worker::loop() {
+	while (!this->done) {
+		this->runner->wake.wait();
+		if (this->done)
+			break;
+
+		this->runner->runQueued();
+	}
+}
+
+bool AsyncTaskRunner::Worker::breakLoop() {
+	this->done = true;
+	this->runner->wake.signal();
+	return true;
+}
+
+bool AsyncTaskRunner::Worker::initialize() {
+	this->done = false;
+	return true;
+}
+
+AsyncTaskRunner::AsyncTaskRunner() :
+	wake(0)
+{
+	// Nothing else to do.
+}
+
+AsyncTaskRunner::~AsyncTaskRunner() {
+	this->stop();
+}
+
+void AsyncTaskRunner::addTask(AsyncTaskBase *task) {
+	this->tasks.push_back(task);
+}
+
+void AsyncTaskRunner::removeTask(AsyncTaskBase *task) {
+	this->tasks.erase(std::remove(this->tasks.begin(), this->tasks.end(), task), this->tasks.end());
+}
+
+bool AsyncTaskRunner::start(double controlPeriod, unsigned int numWorkers) {
+	this->stop();
+
+	if (this->tasks.empty())
+		return true;
+
+	for (size_t i = 0; i < this->tasks.size(); i++)
+		this->tasks[i]->setControlPeriod(controlPeriod);
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+		Worker *worker = new Worker(this, "AsyncTaskWorker");
+		if (!worker->start()) {
+			log(RTT::Error) << "[AsyncTaskRunner] Failed to start a worker!" << RTT::endlog();
+			delete worker;
+			this->stop();
+			return false;
+		}
+		this->workers.push_back(worker);
+	}
+
+	log(RTT::Info) << "[AsyncTaskRunner] Running " << this->tasks.size() << " tasks on "
+	               << numWorkers << " workers." << RTT::endlog();
+	return true;
+}
+
+void AsyncTaskRunner::stop() {
+	// Flag every worker and wake them all before stopping any, since
+	// whichever worker takes a wakeup should be the one that exits.
+	for (size_t i = 0; i < this->workers.size(); i++)
+		this->workers[i]->done = true;
+	for (size_t i = 0; i < this->workers.size(); i++)
+		this->wake.signal();
+
+	for (size_t i = 0; i < this->workers.size(); i++) {
+		this->workers[i]->stop();
+		delete this->workers[i];
+	}
+	this->workers.clear();
+}
+
+void AsyncTaskRunner::cycle(const atrias_msgs::robot_state &robotState) {
+	for (size_t i = 0; i < this->tasks.size(); i++) {
+		if (this->tasks[i]->cycle(robotState))
+			this->wake.signal();
+	}
+}
+
+void AsyncTaskRunner::runQueued() {
+	bool ran;
+	do {
+		ran = false;
+		for (size_t i = 0; i < this->tasks.size(); i++)
+			ran = this->tasks[i]->runIfQueued() || ran;
+	} while (ran);
+}
+
+}
+}
+
+// vim: noexpandtab
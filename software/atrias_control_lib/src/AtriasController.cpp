@@ -41,12 +41,35 @@ const std_msgs::Header& AtriasController::getROSHeader() const {
 	return tlc.getROSHeader();
 }
 
+double AtriasController::getPeriod() const {
+	// This is overridden by the ATC class, preventing recursion.
+	return tlc.getPeriod();
+}
+
 RTT::TaskContext& AtriasController::getTaskContext() const {
 	// The ATC class overrides this function, so this is not actually
 	// recursive.
 	return tlc.getTaskContext();
 }
 
+AsyncTaskRunner& AtriasController::getAsyncTaskRunner() const {
+	// The ATC class overrides this function, so this is not actually
+	// recursive.
+	return tlc.getAsyncTaskRunner();
+}
+
+LogFrame& AtriasController::getLogFrame() const {
+	// The ATC class overrides this function, so this is not actually
+	// recursive.
+	return tlc.getLogFrame();
+}
+
+Profiler& AtriasController::getProfiler() const {
+	// The ATC class overrides this function, so this is not actually
+	// recursive.
+	return tlc.getProfiler();
+}
+
 AtriasController& AtriasController::getTLC() const {
 	return this->tlc;
 }
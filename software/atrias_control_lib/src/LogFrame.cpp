@@ -0,0 +1,390 @@
+#include "atrias_control_lib/LogFrame.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <numeric>
+#include <sstream>
+#include <string.h>
+
+#include <rtt/ConnPolicy.hpp>
+#include <rtt/Logger.hpp>
+#include <rtt/os/MutexLock.hpp>
+
+namespace atrias {
+namespace controller {
+
+LogFrame::LogFrame() :
+	scratchLength(0),
+	dropped(0),
+	cycle(0),
+	layoutPeriod(1000),
+	cyclesSinceLayout(0),
+	framePort("logFrame"),
+	layoutPort("logFrameLayout")
+{
+	this->frame.version  = LOG_FRAME_VERSION;
+	this->layout.version = LOG_FRAME_VERSION;
+}
+
+size_t LogFrame::addSlot(const std::string &topic, const std::string &type,
+                         const std::string &md5sum, const std::string &definition,
+                         uint32_t size)
+{
+	this->layout.topics.push_back(topic);
+	this->layout.types.push_back(type);
+	this->layout.md5sums.push_back(md5sum);
+	this->layout.sizes.push_back(size);
+
+	this->fieldNames.push_back(std::vector<std::string>());
+	this->fieldSizes.push_back(std::vector<uint32_t>());
+	parseFields(definition, this->fieldNames.back(), this->fieldSizes.back());
+
+	// Make room for every slot to be sent in the same cycle.
+	size_t slots = this->layout.topics.size();
+	this->frame.slots.reserve(slots);
+	this->frame.lengths.reserve(slots);
+	this->frame.masks.reserve(slots);
+	this->frame.data.reserve(std::accumulate(this->layout.sizes.begin(), this->layout.sizes.end(), 0u));
+	this->packed.push_back(-1);
+	this->packedOffsets.push_back(0);
+	if (this->scratch.size() < size)
+		this->scratch.resize(size);
+
+	// New slots log everything, every cycle. Nothing's running yet, so we
+	// can apply that right away.
+	SlotSettings slotSettings;
+	slotSettings.enabled = true;
+	slotSettings.divisor = 1;
+	slotSettings.mask    = LOG_FRAME_ALL_FIELDS;
+	{
+		RTT::os::MutexLock lock(this->settingsLock);
+		this->requested.push_back(slotSettings);
+		this->settings.getWriteBuffer() = this->requested;
+		this->settings.publish();
+		this->settings.update();
+	}
+
+	// The ID is a hash (FNV-1a) of everything in the layout, so a frame
+	// can't be matched with the wrong one.
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < slots; i++) {
+		std::string entry = this->layout.topics[i] + '\0' + this->layout.types[i] + '\0' + this->layout.md5sums[i];
+		for (size_t j = 0; j < entry.size(); j++)
+			hash = (hash ^ (uint8_t) entry[j]) * 16777619u;
+		for (int j = 0; j < 4; j++)
+			hash = (hash ^ ((this->layout.sizes[i] >> (8 * j)) & 0xFF)) * 16777619u;
+	}
+	this->frame.layoutId  = hash;
+	this->layout.layoutId = hash;
+
+	return slots - 1;
+}
+
+bool LogFrame::parseFields(const std::string &definition,
+                           std::vector<std::string> &names,
+                           std::vector<uint32_t> &sizes)
+{
+	std::istringstream lines(definition);
+	std::string line;
+	bool sawHeader = false;
+	bool maskable  = true;
+	while (maskable && std::getline(lines, line)) {
+		// The definitions of the types it uses follow this.
+		if (line.compare(0, 2, "==") == 0)
+			break;
+
+		line = line.substr(0, line.find('#'));
+		std::istringstream tokens(line);
+		std::string type, name;
+		if (!(tokens >> type >> name))
+			continue;
+
+		// Constants aren't sent.
+		if (line.find('=') != std::string::npos)
+			continue;
+
+		// The header's size varies with its frame_id, so it has to come
+		// first (and it's always sent).
+		if (!sawHeader) {
+			sawHeader = (type == "Header" || type == "std_msgs/Header");
+			maskable  = sawHeader;
+			continue;
+		}
+
+		uint32_t size = 0;
+		if (type == "bool" || type == "int8" || type == "uint8" || type == "byte" || type == "char")
+			size = 1;
+		else if (type == "int16" || type == "uint16")
+			size = 2;
+		else if (type == "int32" || type == "uint32" || type == "float32")
+			size = 4;
+		else if (type == "int64" || type == "uint64" || type == "float64" || type == "time" || type == "duration")
+			size = 8;
+
+		// Arrays, strings, and nested messages vary in size (or we'd need
+		// to look inside them), so messages with them can't be masked.
+		if (!size) {
+			maskable = false;
+			continue;
+		}
+
+		names.push_back(name);
+		sizes.push_back(size);
+	}
+
+	if (!maskable || names.empty()) {
+		names.clear();
+		sizes.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool LogFrame::empty() const {
+	return this->layout.topics.empty();
+}
+
+void LogFrame::addPorts(RTT::TaskContext &taskContext, double period) {
+	this->layoutPeriod      = std::max(1, (int) lround(1.0 / period));
+	this->cyclesSinceLayout = 0;
+
+	// We may be reconfigured; the ports only need adding once.
+	if (!taskContext.ports()->getPort(this->framePort.getName())) {
+		taskContext.addPort(this->framePort);
+		taskContext.addPort(this->layoutPort);
+	}
+
+	// Give the connections full-sized samples, so writing never allocates.
+	atrias_msgs::log_frame sample = this->frame;
+	sample.slots.resize(this->frame.slots.capacity());
+	sample.lengths.resize(this->frame.lengths.capacity());
+	sample.masks.resize(this->frame.masks.capacity());
+	sample.data.resize(std::accumulate(this->layout.sizes.begin(), this->layout.sizes.end(), 0u));
+	this->framePort.setDataSample(sample);
+	this->layoutPort.setDataSample(this->layout);
+}
+
+bool LogFrame::stream(const std::string &name) {
+	// Already streaming (we've been reconfigured); just resend the layout.
+	if (this->framePort.connected()) {
+		this->layoutPort.write(this->layout);
+		return true;
+	}
+
+	// Buffer 10 seconds worth of frames, since this is for logging.
+	RTT::ConnPolicy policy = RTT::ConnPolicy::buffer(10000);
+	// Transport 3 is ROS
+	policy.transport = 3;
+	policy.name_id   = "/" + name + "_log_frame";
+	bool success     = this->framePort.createStream(policy);
+
+	policy           = RTT::ConnPolicy::buffer(10);
+	policy.transport = 3;
+	policy.name_id   = "/" + name + "_log_layout";
+	success          = this->layoutPort.createStream(policy) && success;
+
+	uint32_t size = std::accumulate(this->layout.sizes.begin(), this->layout.sizes.end(), 0u);
+	log(RTT::Info) << "[" << name << "] Sending " << this->layout.topics.size()
+	               << " log ports as one frame of up to " << size << " bytes on /" << name << "_log_frame" << RTT::endlog();
+
+	this->layoutPort.write(this->layout);
+	return success;
+}
+
+bool LogFrame::configureSlot(const std::string &topic, bool enabled,
+                             uint32_t divisor, const std::string &fields)
+{
+	if (divisor < 1)
+		return false;
+
+	std::string name = topic;
+	if (name != "*" && name.compare(0, 1, "/") != 0)
+		name = "/" + name;
+
+	std::string list = fields;
+	std::replace(list.begin(), list.end(), ',', ' ');
+	std::istringstream tokens(list);
+	std::vector<std::string> wanted;
+	std::string field;
+	while (tokens >> field)
+		wanted.push_back(field);
+
+	RTT::os::MutexLock lock(this->settingsLock);
+	std::vector<SlotSettings> changed = this->requested;
+	bool found = false;
+	for (size_t i = 0; i < changed.size(); i++) {
+		if (name != "*" && this->layout.topics[i] != name)
+			continue;
+		found = true;
+
+		changed[i].enabled = enabled;
+		changed[i].divisor = divisor;
+		changed[i].mask    = LOG_FRAME_ALL_FIELDS;
+		if (wanted.empty())
+			continue;
+
+		const std::vector<std::string> &names = this->fieldNames[i];
+		if (names.empty())
+			return false;
+
+		// Only the first 64 fields can be masked; the rest are always sent.
+		changed[i].mask = 0;
+		for (size_t j = 0; j < wanted.size(); j++) {
+			size_t index = std::find(names.begin(), names.end(), wanted[j]) - names.begin();
+			if (index == names.size())
+				return false;
+			if (index < 64)
+				changed[i].mask |= ((uint64_t) 1) << index;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	// Hand the new settings over; send() picks them up at the end of the cycle.
+	this->requested = changed;
+	this->settings.getWriteBuffer() = this->requested;
+	this->settings.publish();
+	return true;
+}
+
+std::string LogFrame::describe() {
+	RTT::os::MutexLock lock(this->settingsLock);
+	std::ostringstream out;
+	for (size_t i = 0; i < this->requested.size(); i++) {
+		const SlotSettings &slotSettings = this->requested[i];
+		out << this->layout.topics[i] << " (" << this->layout.types[i] << "): ";
+		if (!slotSettings.enabled) {
+			out << "off\n";
+			continue;
+		}
+
+		out << "every " << slotSettings.divisor << " cycle(s), ";
+		const std::vector<std::string> &names = this->fieldNames[i];
+		if (slotSettings.mask == LOG_FRAME_ALL_FIELDS) {
+			out << (names.empty() ? "all fields (can't be masked)\n" : "all fields\n");
+			continue;
+		}
+
+		out << "fields";
+		for (size_t j = 0; j < names.size(); j++) {
+			if (j >= 64 || ((slotSettings.mask >> j) & 1))
+				out << " " << names[j];
+		}
+		out << "\n";
+	}
+	return out.str();
+}
+
+uint8_t* LogFrame::reserve(size_t slot, uint32_t length) {
+	if (length > this->layout.sizes[slot]) {
+		this->dropped++;
+		return NULL;
+	}
+
+	this->scratchLength = length;
+	return &this->scratch[0];
+}
+
+void LogFrame::commit(size_t slot, uint32_t headerLength) {
+	const std::vector<uint32_t> &sizes = this->fieldSizes[slot];
+	uint64_t mask   = sizes.empty() ? LOG_FRAME_ALL_FIELDS : this->settings.read()[slot].mask;
+	uint32_t length = this->scratchLength;
+
+	if (mask != LOG_FRAME_ALL_FIELDS) {
+		uint32_t full = headerLength;
+		length        = headerLength;
+		for (size_t i = 0; i < sizes.size(); i++) {
+			full += sizes[i];
+			if (i >= 64 || ((mask >> i) & 1))
+				length += sizes[i];
+		}
+
+		// If the message isn't laid out the way we parsed it, send it whole.
+		if (full != this->scratchLength) {
+			mask   = LOG_FRAME_ALL_FIELDS;
+			length = this->scratchLength;
+		}
+	}
+
+	uint8_t *dest;
+	int32_t  index = this->packed[slot];
+	if (index >= 0) {
+		// Sent twice this cycle; the new message replaces the old one, as
+		// long as it's packed to the same size (it is, unless the header's
+		// frame_id changed).
+		if (this->frame.lengths[index] != length) {
+			this->dropped++;
+			return;
+		}
+		this->frame.masks[index] = mask;
+		dest = &this->frame.data[this->packedOffsets[slot]];
+	} else {
+		// The data's capacity fits every slot, so this never allocates.
+		uint32_t offset = this->frame.data.size();
+		this->frame.data.resize(offset + length);
+		this->packed[slot]        = this->frame.slots.size();
+		this->packedOffsets[slot] = offset;
+		this->frame.slots.push_back(slot);
+		this->frame.lengths.push_back(length);
+		this->frame.masks.push_back(mask);
+		dest = &this->frame.data[offset];
+	}
+
+	if (mask == LOG_FRAME_ALL_FIELDS) {
+		memcpy(dest, &this->scratch[0], length);
+		return;
+	}
+
+	// The header, then just the selected fields.
+	memcpy(dest, &this->scratch[0], headerLength);
+	uint32_t in  = headerLength;
+	uint32_t out = headerLength;
+	for (size_t i = 0; i < sizes.size(); i++) {
+		if (i >= 64 || ((mask >> i) & 1)) {
+			memcpy(dest + out, &this->scratch[in], sizes[i]);
+			out += sizes[i];
+		}
+		in += sizes[i];
+	}
+}
+
+void LogFrame::send(const std_msgs::Header &header) {
+	if (++this->cyclesSinceLayout >= this->layoutPeriod) {
+		this->layout.header = header;
+		this->layoutPort.write(this->layout);
+		this->cyclesSinceLayout = 0;
+	}
+
+	if (!this->frame.slots.empty()) {
+		this->frame.header = header;
+		this->framePort.write(this->frame);
+
+		for (size_t i = 0; i < this->frame.slots.size(); i++)
+			this->packed[this->frame.slots[i]] = -1;
+
+		// These keep their capacity.
+		this->frame.slots.clear();
+		this->frame.lengths.clear();
+		this->frame.masks.clear();
+		this->frame.data.clear();
+	}
+
+	// The cycle's over; start using any new settings.
+	this->settings.update();
+	this->cycle++;
+}
+
+uint64_t LogFrame::getDropped() const {
+	return this->dropped;
+}
+
+uint64_t LogFrame::getCycle() const {
+	return this->cycle;
+}
+
+}
+}
+
+// vim: noexpandtab
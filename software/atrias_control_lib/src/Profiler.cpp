@@ -0,0 +1,102 @@
+#include "atrias_control_lib/Profiler.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+
+#include "atrias_control_lib/AtriasController.hpp"
+
+namespace atrias {
+namespace controller {
+
+Profiler::Point::Point(const std::string &name) :
+	name(name),
+	minTicks(UINT64_MAX),
+	totalTicks(0),
+	resetRequested(false)
+{ }
+
+Profiler::Profiler() :
+	enabled(false)
+{ }
+
+size_t Profiler::addPoint(const std::string &name) {
+	this->points.emplace_back(name);
+	return this->points.size() - 1;
+}
+
+void Profiler::setEnabled(bool enabled) {
+	this->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+	for (size_t i = 0; i < this->points.size(); i++) {
+		this->points[i].histogram.reset();
+		this->points[i].resetRequested.store(true, std::memory_order_release);
+	}
+}
+
+std::string Profiler::report() {
+	// Microseconds per tick
+	double scale = 1e6 / ticksPerSecond();
+
+	std::ostringstream out;
+	out << "Profiling is " << (this->isEnabled() ? "on" : "off") << ". Times in us; cycle counter at "
+	    << std::fixed << std::setprecision(3) << ticksPerSecond() / 1e9 << " GHz.\n";
+	out << std::left << std::setw(48) << "point" << std::right
+	    << std::setw(10) << "calls" << std::setw(10) << "min" << std::setw(10) << "mean"
+	    << std::setw(10) << "p99" << std::setw(10) << "max" << '\n';
+
+	for (size_t i = 0; i < this->points.size(); i++) {
+		// A point that's waiting to be cleared has no calls, as far as
+		// the caller of reset() is concerned.
+		const Point &entry = this->points[i];
+		uint32_t calls = entry.resetRequested.load(std::memory_order_acquire) ? 0 : entry.histogram.getCount();
+
+		out << std::left << std::setw(48) << entry.name << std::right << std::setw(10) << calls;
+		if (!calls) {
+			out << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(10) << "-" << '\n';
+			continue;
+		}
+
+		out << std::setw(10) << entry.minTicks * scale
+		    << std::setw(10) << ((double) entry.totalTicks) / calls * scale
+		    << std::setw(10) << entry.histogram.getPercentile(0.99) * scale
+		    << std::setw(10) << entry.histogram.getMax() * scale << '\n';
+	}
+
+	return out.str();
+}
+
+double Profiler::ticksPerSecond() {
+#if defined(__i386__) || defined(__x86_64__)
+	// Count ticks across a short sleep. Static initialization is thread
+	// safe, so this only happens once.
+	static const double rate = [] {
+		struct timespec start, end, wait = {0, 20000000};
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		uint64_t startTicks = ticks();
+		nanosleep(&wait, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		uint64_t endTicks   = ticks();
+
+		double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		return (endTicks - startTicks) / seconds;
+	}();
+	return rate;
+#else
+	// ticks() reads the monotonic clock in nanoseconds
+	return 1e9;
+#endif
+}
+
+ProfilePoint::ProfilePoint(const AtriasController* const controller, const std::string &name) :
+	profiler(controller->getTLC().getProfiler())
+{
+	this->point = this->profiler.addPoint(controller->getName() + "::" + name);
+}
+
+}
+}
+
+// vim: noexpandtab
@@ -0,0 +1,394 @@
+#include "atrias_control_lib/RtMsgPool.hpp"
+
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/MutexLock.hpp>
+
+namespace atrias {
+namespace controller {
+
+// The TLSF scheme: free blocks are kept in lists by size. The first level
+// splits sizes by powers of two, and the second splits each power of two
+// into SL_COUNT equal ranges. Bitmaps of which lists are non-empty let
+// allocate() find a big enough block with a couple of bit scans, and each
+// block's header links it to the block before it in memory, so free()
+// can merge it with free neighbours on both sides.
+namespace {
+
+const size_t   ALIGN_SHIFT = 4;
+const size_t   ALIGN       = 1 << ALIGN_SHIFT;
+const unsigned SL_BITS     = 4;
+const unsigned SL_COUNT    = 1 << SL_BITS;
+const unsigned FL_SHIFT    = SL_BITS + ALIGN_SHIFT;
+const size_t   SMALL_BLOCK = 1 << FL_SHIFT;
+const unsigned FL_COUNT    = 31 - FL_SHIFT + 1;
+
+struct Block {
+	// The block before this one in memory, or NULL if it's the first
+	Block  *prevPhys;
+
+	// The payload's size; the low bit is set if the block is free
+	size_t  size;
+
+	// The free list links. These overlap the payload, so they're only
+	// valid while the block is free.
+	Block  *nextFree;
+	Block  *prevFree;
+};
+
+const size_t HEADER      = offsetof(Block, nextFree);
+const size_t MIN_PAYLOAD = sizeof(Block) - HEADER;
+const size_t FREE        = 1;
+
+struct Pool {
+	uint32_t flBitmap;
+	uint32_t slBitmap[FL_COUNT];
+	Block   *heads[FL_COUNT][SL_COUNT];
+
+	// In bytes, headers included
+	size_t   capacity;
+	size_t   used;
+	size_t   peakUsed;
+
+	uint64_t allocations;
+	uint64_t failures;
+};
+
+Pool                  pool;
+std::atomic<uint64_t> dropped(0);
+std::atomic<uint64_t> contended(0);
+
+// Blocks freed by realtime threads while another thread held the pool's
+// lock, linked through nextFree. The next thread to get the lock frees them.
+std::atomic<Block*>   deferred(NULL);
+
+// Serializes reserve(), which allocates outside the pool's lock
+RTT::os::Mutex        reserveLock;
+
+// The pool's lock. It inherits priority, so whoever holds it runs at the
+// priority of the highest thread waiting on it.
+pthread_mutex_t* poolMutex() {
+	static struct PoolMutex {
+		pthread_mutex_t mutex;
+
+		PoolMutex() {
+			pthread_mutexattr_t attr;
+			pthread_mutexattr_init(&attr);
+			pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+			pthread_mutex_init(&mutex, &attr);
+			pthread_mutexattr_destroy(&attr);
+		}
+	} poolMutex;
+
+	return &poolMutex.mutex;
+}
+
+// Whether this thread runs under a realtime policy
+bool isRealtimeThread() {
+	int         policy;
+	sched_param param;
+	if (pthread_getschedparam(pthread_self(), &policy, &param))
+		return false;
+
+	return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+void release(Block *block);
+
+// Holds the pool's lock. Realtime threads only try for it, so they never
+// wait on another thread; check isHeld() before touching the pool.
+class PoolLock {
+	bool held;
+
+	public:
+		PoolLock() {
+			if (isRealtimeThread())
+				held = !pthread_mutex_trylock(poolMutex());
+			else
+				held = !pthread_mutex_lock(poolMutex());
+			if (!held)
+				return;
+
+			// Take care of anything freed while we were locked out.
+			Block *block = deferred.exchange(NULL, std::memory_order_acquire);
+			while (block) {
+				Block *next = block->nextFree;
+				release(block);
+				block = next;
+			}
+		}
+
+		~PoolLock() {
+			if (held)
+				pthread_mutex_unlock(poolMutex());
+		}
+
+		bool isHeld() const {
+			return held;
+		}
+};
+
+inline size_t blockSize(const Block *block) {
+	return block->size & ~FREE;
+}
+
+inline bool isFree(const Block *block) {
+	return block->size & FREE;
+}
+
+inline Block* nextPhys(Block *block) {
+	return (Block*) ((char*) block + HEADER + blockSize(block));
+}
+
+inline unsigned fls(size_t x) {
+	return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x);
+}
+
+// Which list a free block of this size goes in
+inline void mapping(size_t size, unsigned &fl, unsigned &sl) {
+	if (size < SMALL_BLOCK) {
+		fl = 0;
+		sl = size >> ALIGN_SHIFT;
+	} else {
+		unsigned bit = fls(size);
+		sl = (size >> (bit - SL_BITS)) ^ SL_COUNT;
+		fl = bit - FL_SHIFT + 1;
+	}
+}
+
+void insert(Block *block) {
+	unsigned fl, sl;
+	mapping(blockSize(block), fl, sl);
+
+	block->prevFree = NULL;
+	block->nextFree = pool.heads[fl][sl];
+	if (block->nextFree)
+		block->nextFree->prevFree = block;
+	pool.heads[fl][sl] = block;
+
+	pool.slBitmap[fl] |= 1u << sl;
+	pool.flBitmap     |= 1u << fl;
+}
+
+void remove(Block *block) {
+	unsigned fl, sl;
+	mapping(blockSize(block), fl, sl);
+
+	if (block->nextFree)
+		block->nextFree->prevFree = block->prevFree;
+	if (block->prevFree)
+		block->prevFree->nextFree = block->nextFree;
+	else
+		pool.heads[fl][sl] = block->nextFree;
+
+	if (!pool.heads[fl][sl]) {
+		pool.slBitmap[fl] &= ~(1u << sl);
+		if (!pool.slBitmap[fl])
+			pool.flBitmap &= ~(1u << fl);
+	}
+}
+
+// Finds a free block at least this big (without removing it), or NULL
+Block* findFree(size_t size) {
+	// Round up to the next list, so any block in the list we land on fits.
+	if (size >= SMALL_BLOCK)
+		size += (((size_t) 1) << (fls(size) - SL_BITS)) - 1;
+
+	unsigned fl, sl;
+	mapping(size, fl, sl);
+	if (fl >= FL_COUNT)
+		return NULL;
+
+	uint32_t slMap = pool.slBitmap[fl] & (~0u << sl);
+	if (!slMap) {
+		uint32_t flMap = (fl + 1 < FL_COUNT) ? pool.flBitmap & (~0u << (fl + 1)) : 0;
+		if (!flMap)
+			return NULL;
+		fl    = __builtin_ctz(flMap);
+		slMap = pool.slBitmap[fl];
+	}
+
+	return pool.heads[fl][__builtin_ctz(slMap)];
+}
+
+// Rounds a request up to a payload size
+inline size_t payloadSize(size_t bytes) {
+	size_t size = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+	return std::max(size, MIN_PAYLOAD);
+}
+
+// Returns an allocated block to the free lists. Must hold the pool's lock.
+void release(Block *block) {
+	pool.used -= HEADER + blockSize(block);
+
+	// Merge with the free blocks on either side.
+	Block *next = nextPhys(block);
+	if (isFree(next)) {
+		remove(next);
+		block->size = blockSize(block) + HEADER + blockSize(next);
+		nextPhys(block)->prevPhys = block;
+	}
+
+	Block *prev = block->prevPhys;
+	if (prev && isFree(prev)) {
+		remove(prev);
+		prev->size = blockSize(prev) + HEADER + blockSize(block);
+		nextPhys(prev)->prevPhys = prev;
+		block = prev;
+	}
+
+	block->size |= FREE;
+	insert(block);
+}
+
+}
+
+bool RtMsgPool::reserve(size_t bytes) {
+	RTT::os::MutexLock lock(reserveLock);
+
+	size_t capacity;
+	{
+		PoolLock poolLock;
+		capacity = pool.capacity;
+	}
+	if (capacity >= bytes)
+		return true;
+
+	// Add a new area with one free block, ended by an empty block that's
+	// never free, so nothing merges past the end.
+	size_t payload = payloadSize(bytes - capacity);
+	if (payload > RT_MSG_POOL_MAX_BLOCK)
+		return false;
+
+	size_t size = HEADER + payload + HEADER;
+	void  *area;
+	if (posix_memalign(&area, 64, size))
+		return false;
+
+	// Fault the pages in now, rather than in the control loop.
+	memset(area, 0, size);
+
+	Block *block    = (Block*) area;
+	block->prevPhys = NULL;
+	block->size     = payload | FREE;
+
+	Block *end      = nextPhys(block);
+	end->prevPhys   = block;
+	end->size       = 0;
+
+	PoolLock poolLock;
+	if (!poolLock.isHeld()) {
+		// Only a realtime thread gets here; it shouldn't be reserving.
+		free(area);
+		return false;
+	}
+	insert(block);
+	pool.capacity += HEADER + payload;
+	return true;
+}
+
+void* RtMsgPool::allocate(size_t bytes) {
+	size_t size = payloadSize(bytes);
+
+	PoolLock lock;
+	if (!lock.isHeld()) {
+		contended.fetch_add(1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	Block *block = (size <= RT_MSG_POOL_MAX_BLOCK) ? findFree(size) : NULL;
+	if (!block) {
+		pool.failures++;
+		return NULL;
+	}
+	remove(block);
+
+	// Give whatever's left over back to the pool, if it's big enough to use.
+	size_t left = blockSize(block) - size;
+	if (left >= HEADER + MIN_PAYLOAD) {
+		Block *rest     = (Block*) ((char*) block + HEADER + size);
+		rest->prevPhys  = block;
+		rest->size      = (left - HEADER) | FREE;
+		nextPhys(rest)->prevPhys = rest;
+		block->size     = size;
+		insert(rest);
+	} else {
+		block->size     = blockSize(block);
+	}
+
+	pool.used    += HEADER + blockSize(block);
+	pool.peakUsed = std::max(pool.peakUsed, pool.used);
+	pool.allocations++;
+	return (char*) block + HEADER;
+}
+
+void RtMsgPool::deallocate(void *ptr) {
+	if (!ptr)
+		return;
+
+	Block *block = (Block*) ((char*) ptr - HEADER);
+
+	PoolLock lock;
+	if (lock.isHeld()) {
+		release(block);
+		return;
+	}
+
+	// Leave it for whoever holds the lock. The block is ours until then,
+	// so its free list link is free to use.
+	Block *head = deferred.load(std::memory_order_relaxed);
+	do {
+		block->nextFree = head;
+	} while (!deferred.compare_exchange_weak(head, block, std::memory_order_release,
+	                                         std::memory_order_relaxed));
+}
+
+size_t RtMsgPool::footprint(size_t bytes) {
+	// The header, plus the payload rounded up as findFree() rounds it.
+	size_t size = payloadSize(bytes);
+	if (size >= SMALL_BLOCK)
+		size += (((size_t) 1) << (fls(size) - SL_BITS)) - 1;
+
+	return HEADER + size;
+}
+
+bool RtMsgPool::hasRoom(size_t bytes) {
+	size_t size = payloadSize(bytes);
+
+	PoolLock lock;
+	if (!lock.isHeld()) {
+		contended.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return size <= RT_MSG_POOL_MAX_BLOCK && findFree(size);
+}
+
+void RtMsgPool::noteDrop() {
+	dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RtMsgPool::getStats(atrias_msgs::rt_msg_pool &stats) {
+	stats.dropped     = dropped.load(std::memory_order_relaxed);
+	stats.contended   = contended.load(std::memory_order_relaxed);
+
+	// If another thread's using the pool, the rest can wait for next time.
+	PoolLock lock;
+	if (!lock.isHeld())
+		return;
+	stats.capacity    = pool.capacity;
+	stats.used        = pool.used;
+	stats.peakUsed    = pool.peakUsed;
+	stats.allocations = pool.allocations;
+	stats.failures    = pool.failures;
+}
+
+}
+}
+
+// vim: noexpandtab
@@ -92,6 +92,11 @@ private:
     string getUniqueName(string parentName, string childType);
     void resetControllerNames();
 
+    // These pass logging settings on to the loaded controller (see its
+    // setLogPort and listLogPorts operations)
+    bool setControllerLogging(string port, bool enabled, unsigned int divisor, string fields);
+    string listControllerLogging();
+
 public:
     /** @brief Protects access to commandPending
      */
@@ -31,6 +31,11 @@ ControllerManager::ControllerManager(std::string const& name) :
     this->addOperation("resetControllerNames", &ControllerManager::resetControllerNames, this, ClientThread)
             .doc("Free all unique names created for sub-controllers and make them re-available for assignment.");
 
+    this->addOperation("setControllerLogging", &ControllerManager::setControllerLogging, this, ClientThread)
+            .doc("Switch one of the loaded controller's log ports on or off, decimate it, or limit it to some fields.");
+    this->addOperation("listControllerLogging", &ControllerManager::listControllerLogging, this, ClientThread)
+            .doc("List the loaded controller's log ports and their settings.");
+
     this->addOperation("unloadController", &ControllerManager::unloadController, this, OwnThread)
             .doc("Unload the current controller. For debugging purposes only.");
     this->addOperation("loadController", &ControllerManager::loadController, this, OwnThread)
@@ -336,6 +341,34 @@ void ControllerManager::resetControllerNames() {
     controllerChildCounts.clear();
 }
 
+bool ControllerManager::setControllerLogging(string port, bool enabled, unsigned int divisor, string fields) {
+    // Controllers are always loaded as "controller" by their start scripts
+    TaskContext *deployer = getPeer("Deployer");
+    TaskContext *controller = (deployer && controllerLoaded) ? deployer->getPeer("controller") : NULL;
+    if (!controller)
+        return false;
+
+    OperationCaller<bool(string, bool, unsigned int, string)> setLogPort =
+            controller->provides()->getOperation("setLogPort");
+    if (!setLogPort.ready())
+        return false;
+
+    return setLogPort(port, enabled, divisor, fields);
+}
+
+string ControllerManager::listControllerLogging() {
+    TaskContext *deployer = getPeer("Deployer");
+    TaskContext *controller = (deployer && controllerLoaded) ? deployer->getPeer("controller") : NULL;
+    if (!controller)
+        return "No controller loaded.";
+
+    OperationCaller<string(void)> listLogPorts = controller->provides()->getOperation("listLogPorts");
+    if (!listLogPorts.ready())
+        return "The controller has no log ports.";
+
+    return listLogPorts();
+}
+
 ORO_CREATE_COMPONENT(ControllerManager);
 }
 }
@@ -0,0 +1,126 @@
+#ifndef BIQUAD_HPP
+#define BIQUAD_HPP
+
+/**
+  * @file Biquad.hpp
+  * @brief A second-order IIR filter section.
+  * This computes
+  *   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+  * in transposed direct form II, which keeps two state values and is
+  * the best behaved of the direct forms in floating point. lowPass()
+  * and highPass() design Butterworth-style sections (Q = 1/sqrt(2)) from
+  * a cutoff and the control loop rate, following the Audio EQ Cookbook
+  * (R. Bristow-Johnson); cascade sections for steeper rolloff.
+  */
+
+// Standard library
+#include <math.h>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class Biquad {
+	public:
+		/**
+		  * @brief Makes a filter from its coefficients, normalized so a0 is 1.
+		  * The defaults pass samples through unchanged.
+		  */
+		Biquad(double b0 = 1.0, double b1 = 0.0, double b2 = 0.0, double a1 = 0.0, double a2 = 0.0);
+
+		/**
+		  * @brief Designs a second-order low-pass filter.
+		  * @param cutoff     The cutoff frequency, in Hz.
+		  * @param sampleRate How often the filter runs, in Hz (1 / getPeriod()).
+		  * @param q          The quality factor; 1/sqrt(2) is maximally flat.
+		  * @return The filter, at rest at 0.
+		  */
+		static Biquad lowPass(double cutoff, double sampleRate, double q = M_SQRT1_2);
+
+		/**
+		  * @brief Designs a second-order high-pass filter.
+		  * @param cutoff     The cutoff frequency, in Hz.
+		  * @param sampleRate How often the filter runs, in Hz (1 / getPeriod()).
+		  * @param q          The quality factor; 1/sqrt(2) is maximally flat.
+		  * @return The filter, at rest at 0.
+		  */
+		static Biquad highPass(double cutoff, double sampleRate, double q = M_SQRT1_2);
+
+		/**
+		  * @brief Filters one sample.
+		  * @param x The input sample.
+		  * @return The output sample.
+		  */
+		double operator()(double x);
+
+		/**
+		  * @brief Returns the last output.
+		  * @return The output of the last call, or the reset() output.
+		  */
+		double output() const;
+
+		/**
+		  * @brief Puts the filter at rest, as if it had been given one input forever.
+		  * Use this when starting up, so the filter doesn't ring from 0 to
+		  * the first reading.
+		  * @param x The input to settle on.
+		  */
+		void reset(double x = 0.0);
+
+	private:
+		double b0, b1, b2, a1, a2;
+		double s1, s2;
+		double y;
+};
+
+inline Biquad::Biquad(double b0, double b1, double b2, double a1, double a2) :
+	b0(b0), b1(b1), b2(b2), a1(a1), a2(a2)
+{
+	this->reset();
+}
+
+inline Biquad Biquad::lowPass(double cutoff, double sampleRate, double q) {
+	double w     = 2.0 * M_PI * cutoff / sampleRate;
+	double alpha = sin(w) / (2.0 * q);
+	double a0    = 1.0 + alpha;
+	double c     = cos(w);
+	return Biquad((1.0 - c) / 2.0 / a0, (1.0 - c) / a0, (1.0 - c) / 2.0 / a0,
+	              -2.0 * c / a0, (1.0 - alpha) / a0);
+}
+
+inline Biquad Biquad::highPass(double cutoff, double sampleRate, double q) {
+	double w     = 2.0 * M_PI * cutoff / sampleRate;
+	double alpha = sin(w) / (2.0 * q);
+	double a0    = 1.0 + alpha;
+	double c     = cos(w);
+	return Biquad((1.0 + c) / 2.0 / a0, -(1.0 + c) / a0, (1.0 + c) / 2.0 / a0,
+	              -2.0 * c / a0, (1.0 - alpha) / a0);
+}
+
+inline double Biquad::operator()(double x) {
+	this->y  = this->b0 * x + this->s1;
+	this->s1 = this->b1 * x - this->a1 * this->y + this->s2;
+	this->s2 = this->b2 * x - this->a2 * this->y;
+	return this->y;
+}
+
+inline double Biquad::output() const {
+	return this->y;
+}
+
+inline void Biquad::reset(double x) {
+	// At rest, the output is the input times the DC gain. A filter
+	// without one (a pole at 1) settles at 0.
+	double denominator = 1.0 + this->a1 + this->a2;
+	this->y  = (denominator != 0.0) ? x * (this->b0 + this->b1 + this->b2) / denominator : 0.0;
+	this->s1 = this->y - this->b0 * x;
+	this->s2 = this->b2 * x - this->a2 * this->y;
+}
+
+// End namespaces
+}
+}
+
+#endif // BIQUAD_HPP
+
+// vim: noexpandtab
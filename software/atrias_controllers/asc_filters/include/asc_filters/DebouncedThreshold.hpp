@@ -0,0 +1,115 @@
+#ifndef DEBOUNCEDTHRESHOLD_HPP
+#define DEBOUNCEDTHRESHOLD_HPP
+
+/**
+  * @file DebouncedThreshold.hpp
+  * @brief An on/off detector with hysteresis and debouncing.
+  * The output turns on once the input has been above the on threshold
+  * for some number of samples in a row, and off once it's been below the
+  * off threshold for some number in a row. Keeping the off threshold
+  * below the on threshold stops a noisy signal near the threshold from
+  * chattering; the counts stop single-sample glitches from switching it.
+  * Useful for contact detection, such as toe switches.
+  */
+
+// Standard library
+#include <stdint.h>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class DebouncedThreshold {
+	public:
+		/**
+		  * @brief Sets the thresholds and counts, starting off.
+		  * @param onThreshold  The input must be above this to turn on.
+		  * @param offThreshold The input must be below this to turn off.
+		  * @param onCount      For this many samples in a row (at least 1).
+		  * @param offCount     For this many samples in a row (at least 1).
+		  */
+		DebouncedThreshold(double onThreshold, double offThreshold,
+		                   uint32_t onCount = 1, uint32_t offCount = 1);
+
+		/**
+		  * @brief Adds a sample.
+		  * @param x The input.
+		  * @return Whether the output is on.
+		  */
+		bool operator()(double x);
+
+		/**
+		  * @brief Returns the output.
+		  * @return Whether the output is on.
+		  */
+		bool isOn() const;
+
+		/**
+		  * @brief Forces the output, and restarts the count.
+		  * @param on The output.
+		  */
+		void reset(bool on = false);
+
+		/**
+		  * @brief Moves the thresholds, such as to follow a drifting baseline.
+		  * The count so far is kept.
+		  * @param onThreshold  The input must be above this to turn on.
+		  * @param offThreshold The input must be below this to turn off.
+		  */
+		void setThresholds(double onThreshold, double offThreshold);
+
+	private:
+		double   onThreshold, offThreshold;
+		uint32_t onCount, offCount;
+
+		// The output, and how many samples in a row have been past the
+		// threshold to change it
+		bool     on;
+		uint32_t count;
+};
+
+inline DebouncedThreshold::DebouncedThreshold(double onThreshold, double offThreshold,
+                                              uint32_t onCount, uint32_t offCount) :
+	onThreshold(onThreshold),
+	offThreshold(offThreshold),
+	onCount(onCount ? onCount : 1),
+	offCount(offCount ? offCount : 1),
+	on(false),
+	count(0)
+{ }
+
+inline bool DebouncedThreshold::operator()(double x) {
+	bool past = this->on ? (x < this->offThreshold) : (x > this->onThreshold);
+	if (!past) {
+		this->count = 0;
+		return this->on;
+	}
+
+	if (++this->count >= (this->on ? this->offCount : this->onCount)) {
+		this->on    = !this->on;
+		this->count = 0;
+	}
+	return this->on;
+}
+
+inline bool DebouncedThreshold::isOn() const {
+	return this->on;
+}
+
+inline void DebouncedThreshold::reset(bool on) {
+	this->on    = on;
+	this->count = 0;
+}
+
+inline void DebouncedThreshold::setThresholds(double onThreshold, double offThreshold) {
+	this->onThreshold  = onThreshold;
+	this->offThreshold = offThreshold;
+}
+
+// End namespaces
+}
+}
+
+#endif // DEBOUNCEDTHRESHOLD_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,123 @@
+#ifndef MEDIANFILTER_HPP
+#define MEDIANFILTER_HPP
+
+/**
+  * @file MedianFilter.hpp
+  * @brief The median of the last N samples.
+  * The window is also kept sorted; each push() swaps the new sample in
+  * for the one leaving and moves it into place. That's at most N steps,
+  * with no allocation or sorting, and usually only a few, since neighbouring
+  * samples tend to be close.
+  */
+
+// Standard library
+#include <stddef.h>
+
+#include "asc_filters/RingBuffer.hpp"
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+/**
+  * @brief A median filter.
+  * @param N How many samples to take the median of. Must be odd, so
+  *          there's one middle sample.
+  */
+template <size_t N>
+class MedianFilter {
+	static_assert(N % 2 == 1, "A MedianFilter's window must be odd.");
+
+	public:
+		/**
+		  * @brief Fills the window with one value.
+		  * @param initial The value every sample starts as.
+		  */
+		MedianFilter(double initial = 0.0);
+
+		/**
+		  * @brief Sets every sample to one value.
+		  * @param value The value.
+		  */
+		void fill(double value);
+
+		/**
+		  * @brief Adds a sample. NaNs are ignored, since they can't be ordered.
+		  * @param value The new sample.
+		  * @return The new median.
+		  */
+		double push(double value);
+
+		/**
+		  * @brief Returns the median.
+		  * @return The middle of the last N samples.
+		  */
+		double median() const;
+
+		/**
+		  * @brief Returns the window.
+		  * @return The last N samples, newest first.
+		  */
+		const RingBuffer<double, N>& history() const;
+
+	private:
+		RingBuffer<double, N> samples;
+		double                sorted[N];
+};
+
+template <size_t N>
+MedianFilter<N>::MedianFilter(double initial) :
+	samples(initial)
+{
+	this->fill(initial);
+}
+
+template <size_t N>
+void MedianFilter<N>::fill(double value) {
+	this->samples.fill(value);
+	for (size_t i = 0; i < N; i++)
+		this->sorted[i] = value;
+}
+
+template <size_t N>
+inline double MedianFilter<N>::push(double value) {
+	if (value != value)
+		return this->median();
+
+	// Put the new sample where the leaving one was...
+	double leaving = this->samples.push(value);
+	size_t i = 0;
+	while (this->sorted[i] != leaving)
+		i++;
+	this->sorted[i] = value;
+
+	// ...then move it into order.
+	for (; i > 0 && this->sorted[i - 1] > value; i--) {
+		this->sorted[i]     = this->sorted[i - 1];
+		this->sorted[i - 1] = value;
+	}
+	for (; i + 1 < N && this->sorted[i + 1] < value; i++) {
+		this->sorted[i]     = this->sorted[i + 1];
+		this->sorted[i + 1] = value;
+	}
+
+	return this->median();
+}
+
+template <size_t N>
+inline double MedianFilter<N>::median() const {
+	return this->sorted[N / 2];
+}
+
+template <size_t N>
+inline const RingBuffer<double, N>& MedianFilter<N>::history() const {
+	return this->samples;
+}
+
+// End namespaces
+}
+}
+
+#endif // MEDIANFILTER_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,161 @@
+#ifndef MOVINGAVERAGE_HPP
+#define MOVINGAVERAGE_HPP
+
+/**
+  * @file MovingAverage.hpp
+  * @brief The mean of the last N samples, optionally skipping the newest few.
+  * Each push() takes constant time: the sum is kept running, adding the
+  * sample that enters the window and subtracting the one that leaves. So
+  * rounding errors don't build up, it's recomputed from scratch once every
+  * N + Delay samples, which is still constant time on average.
+  */
+
+// Standard library
+#include <stddef.h>
+
+#include "asc_filters/RingBuffer.hpp"
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+/**
+  * @brief A moving average.
+  * @param N     How many samples to average.
+  * @param Delay How many of the newest samples to leave out. For example,
+  *              MovingAverage<100, 20> averages the 100 samples before
+  *              the newest 20, making a baseline that a sudden change
+  *              doesn't drag along with it.
+  */
+template <size_t N, size_t Delay = 0>
+class MovingAverage {
+	static_assert(N > 0, "A MovingAverage needs at least one sample.");
+
+	public:
+		/**
+		  * @brief Fills the history with one value.
+		  * @param initial The value every sample starts as.
+		  */
+		MovingAverage(double initial = 0.0);
+
+		/**
+		  * @brief Sets every sample to one value.
+		  * @param value The value.
+		  */
+		void fill(double value);
+
+		/**
+		  * @brief Adds a sample.
+		  * @param value The new sample.
+		  * @return The new average.
+		  */
+		double push(double value);
+
+		/**
+		  * @brief Returns the average.
+		  * @return The mean of the samples aged Delay to Delay + N - 1.
+		  */
+		double average() const;
+
+		/**
+		  * @brief Returns every sample kept, including the delayed ones.
+		  * @return The history, newest first.
+		  */
+		const RingBuffer<double, N + Delay>& history() const;
+
+	private:
+		/**
+		  * @brief Recomputes the sum from the history.
+		  */
+		void resum();
+
+		/**
+		  * @brief Adds up an array. Four independent sums let the adds
+		  * overlap (and vectorize), without reordering them the way
+		  * -ffast-math would.
+		  * @param values The array.
+		  * @param count  Its length.
+		  * @return The total.
+		  */
+		static double sum(const double *values, size_t count);
+
+		RingBuffer<double, N + Delay> samples;
+		double                        total;
+		size_t                        sinceResum;
+};
+
+template <size_t N, size_t Delay>
+MovingAverage<N, Delay>::MovingAverage(double initial) :
+	samples(initial)
+{
+	this->resum();
+}
+
+template <size_t N, size_t Delay>
+void MovingAverage<N, Delay>::fill(double value) {
+	this->samples.fill(value);
+	this->resum();
+}
+
+template <size_t N, size_t Delay>
+inline double MovingAverage<N, Delay>::push(double value) {
+	// The sample about to reach age Delay enters the window, and the
+	// oldest leaves it.
+	double entering = Delay ? this->samples[Delay - 1] : value;
+	double leaving  = this->samples.push(value);
+	this->total    += entering - leaving;
+
+	if (++this->sinceResum >= N + Delay)
+		this->resum();
+
+	return this->average();
+}
+
+template <size_t N, size_t Delay>
+inline double MovingAverage<N, Delay>::average() const {
+	return this->total / N;
+}
+
+template <size_t N, size_t Delay>
+inline const RingBuffer<double, N + Delay>& MovingAverage<N, Delay>::history() const {
+	return this->samples;
+}
+
+template <size_t N, size_t Delay>
+void MovingAverage<N, Delay>::resum() {
+	const size_t SIZE = N + Delay;
+
+	// The window is N samples in a row in storage, maybe wrapping around,
+	// starting from the oldest (just past the newest).
+	size_t start = (this->samples.head() + 1) % SIZE;
+	if (start + N <= SIZE) {
+		this->total = sum(this->samples.data() + start, N);
+	} else {
+		this->total = sum(this->samples.data() + start, SIZE - start) +
+		              sum(this->samples.data(), N - (SIZE - start));
+	}
+	this->sinceResum = 0;
+}
+
+template <size_t N, size_t Delay>
+inline double MovingAverage<N, Delay>::sum(const double *values, size_t count) {
+	double a = 0.0, b = 0.0, c = 0.0, d = 0.0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		a += values[i];
+		b += values[i + 1];
+		c += values[i + 2];
+		d += values[i + 3];
+	}
+	for (; i < count; i++)
+		a += values[i];
+	return (a + b) + (c + d);
+}
+
+// End namespaces
+}
+}
+
+#endif // MOVINGAVERAGE_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,149 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+/**
+  * @file RingBuffer.hpp
+  * @brief A fixed-size history of samples, newest first.
+  * The size is a template parameter, so the samples live inside the
+  * object and nothing is ever allocated. The buffer is always full:
+  * it starts out holding N copies of an initial value, and each push()
+  * drops the oldest sample.
+  */
+
+// Standard library
+#include <stddef.h>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+template <class T, size_t N>
+class RingBuffer {
+	static_assert(N > 0, "A RingBuffer needs room for at least one sample.");
+
+	public:
+		/**
+		  * @brief Fills the buffer with one value.
+		  * @param initial The value every sample starts as.
+		  */
+		RingBuffer(const T &initial = T());
+
+		/**
+		  * @brief Sets every sample to one value.
+		  * @param value The value.
+		  */
+		void fill(const T &value);
+
+		/**
+		  * @brief Adds a sample, dropping the oldest.
+		  * @param value The new sample.
+		  * @return The sample that was dropped.
+		  */
+		T push(const T &value);
+
+		/**
+		  * @brief Returns a sample by age.
+		  * @param age 0 for the newest sample, up to N - 1 for the oldest.
+		  * @return The sample.
+		  */
+		const T& operator[](size_t age) const;
+
+		/**
+		  * @brief Returns the newest sample.
+		  * @return The sample pushed last.
+		  */
+		const T& newest() const;
+
+		/**
+		  * @brief Returns the oldest sample.
+		  * @return The sample the next push() will drop.
+		  */
+		const T& oldest() const;
+
+		/**
+		  * @brief Returns how many samples the buffer holds.
+		  * @return N.
+		  */
+		static size_t size();
+
+		/**
+		  * @brief Returns the samples in storage order, for code that
+		  * works on them in bulk. The newest is at index head().
+		  * @return The N samples.
+		  */
+		const T* data() const;
+
+		/**
+		  * @brief Returns where the newest sample is stored.
+		  * @return Its index in data(); the sample aged a is at
+		  *         (head() - a) modulo N.
+		  */
+		size_t head() const;
+
+	private:
+		T      samples[N];
+		size_t newestIndex;
+};
+
+template <class T, size_t N>
+RingBuffer<T, N>::RingBuffer(const T &initial) :
+	newestIndex(0)
+{
+	this->fill(initial);
+}
+
+template <class T, size_t N>
+void RingBuffer<T, N>::fill(const T &value) {
+	for (size_t i = 0; i < N; i++)
+		this->samples[i] = value;
+}
+
+template <class T, size_t N>
+inline T RingBuffer<T, N>::push(const T &value) {
+	// The oldest sample is just past the newest.
+	this->newestIndex = (this->newestIndex + 1 < N) ? this->newestIndex + 1 : 0;
+
+	T dropped = this->samples[this->newestIndex];
+	this->samples[this->newestIndex] = value;
+	return dropped;
+}
+
+template <class T, size_t N>
+inline const T& RingBuffer<T, N>::operator[](size_t age) const {
+	// Avoid a division; N needn't be a power of two.
+	size_t index = (age <= this->newestIndex) ? this->newestIndex - age : this->newestIndex + N - age;
+	return this->samples[index];
+}
+
+template <class T, size_t N>
+inline const T& RingBuffer<T, N>::newest() const {
+	return this->samples[this->newestIndex];
+}
+
+template <class T, size_t N>
+inline const T& RingBuffer<T, N>::oldest() const {
+	return (*this)[N - 1];
+}
+
+template <class T, size_t N>
+inline size_t RingBuffer<T, N>::size() {
+	return N;
+}
+
+template <class T, size_t N>
+inline const T* RingBuffer<T, N>::data() const {
+	return this->samples;
+}
+
+template <class T, size_t N>
+inline size_t RingBuffer<T, N>::head() const {
+	return this->newestIndex;
+}
+
+// End namespaces
+}
+}
+
+#endif // RINGBUFFER_HPP
+
+// vim: noexpandtab
@@ -0,0 +1,90 @@
+#ifndef SPIKEFILTER_HPP
+#define SPIKEFILTER_HPP
+
+/**
+  * @file SpikeFilter.hpp
+  * @brief Throws out readings that can't be right.
+  * A reading is thrown out if it's at or past the sensor's rails (an ADC
+  * reading 0 or full scale usually means a bad sample or a disconnected
+  * sensor), or if it jumps further from a reference than the signal
+  * physically can in one cycle. The reference is usually the filter's
+  * last output, which takes the thrown-out reading's place.
+  */
+
+// Standard library
+#include <math.h>
+
+// Our namespaces
+namespace atrias {
+namespace controller {
+
+class SpikeFilter {
+	public:
+		/**
+		  * @brief Sets the limits.
+		  * @param low     Readings at or below this are thrown out.
+		  * @param high    Readings at or above this are thrown out.
+		  * @param maxJump Readings further than this from the reference
+		  *                are thrown out.
+		  */
+		SpikeFilter(double low, double high, double maxJump);
+
+		/**
+		  * @brief Checks one reading.
+		  * @param x         The reading.
+		  * @param reference What to compare it to and replace it with,
+		  *                  such as the last good value.
+		  * @param checkJump Whether to check for jumps. Pass false while
+		  *                  the reference isn't trustworthy yet, such as
+		  *                  during startup.
+		  * @return x if it's good, otherwise the reference.
+		  */
+		double operator()(double x, double reference, bool checkJump = true) const;
+
+		/**
+		  * @brief Returns whether a reading is inside the rails.
+		  * @param x The reading.
+		  * @return True if it's strictly between low and high.
+		  */
+		bool inRange(double x) const;
+
+		/**
+		  * @brief Returns whether a reading jumps too far.
+		  * @param x         The reading.
+		  * @param reference What to compare it to.
+		  * @return True if it's more than maxJump from the reference.
+		  */
+		bool isJump(double x, double reference) const;
+
+	private:
+		double low, high, maxJump;
+};
+
+inline SpikeFilter::SpikeFilter(double low, double high, double maxJump) :
+	low(low),
+	high(high),
+	maxJump(maxJump)
+{ }
+
+inline double SpikeFilter::operator()(double x, double reference, bool checkJump) const {
+	if (!this->inRange(x) || (checkJump && this->isJump(x, reference)))
+		return reference;
+
+	return x;
+}
+
+inline bool SpikeFilter::inRange(double x) const {
+	return x > this->low && x < this->high;
+}
+
+inline bool SpikeFilter::isJump(double x, double reference) const {
+	return fabs(reference - x) > this->maxJump;
+}
+
+// End namespaces
+}
+}
+
+#endif // SPIKEFILTER_HPP
+
+// vim: noexpandtab
@@ -13,6 +13,9 @@
 // And for the logging helper class
 #include <atrias_control_lib/LogPort.hpp>
 
+// Times iKine()
+#include <atrias_control_lib/Profiler.hpp>
+
 // Our log data
 #include "asc_hip_boom_kinematics/controller_log_data.h"
 
@@ -75,6 +78,11 @@ class ASCHipBoomKinematics : public AtriasController {
                   * You may have as many of these as you'd like of various types.
                   */
                 LogPort<asc_hip_boom_kinematics::controller_log_data_> log_out;
+
+                /**
+                  * @brief Times iKine(), when the top-level controller's profiling is on.
+                  */
+                ProfilePoint iKineProfile;
 };
 
 }
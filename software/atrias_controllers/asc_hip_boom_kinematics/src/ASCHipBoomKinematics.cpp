@@ -6,7 +6,8 @@ namespace controller {
 
 ASCHipBoomKinematics::ASCHipBoomKinematics(AtriasController *parent, string name) :
         AtriasController(parent, name),
-        log_out(this, "log")
+        log_out(this, "log"),
+        iKineProfile(this, "iKine")
 {
 	// TODO switch to robot_invariant.defs
 	// Distance from boom pivot Z axis to robot body XZ center plane along boom Y axis
@@ -24,6 +25,7 @@ ASCHipBoomKinematics::ASCHipBoomKinematics(AtriasController *parent, string name
 
 
 std::tuple<double, double> ASCHipBoomKinematics::iKine(LeftRight toePosition, atrias_msgs::robot_state_leg lLeg, atrias_msgs::robot_state_leg rLeg, atrias_msgs::robot_state_location position) {
+    ProfileScope profileScope(iKineProfile);
 
     // Define imaginary number i
     i = complex<double>(0.0, 1.0);
@@ -52,8 +52,8 @@ std::tuple<double, double> ASCLegForce::control(LegForce legForce, atrias_msgs::
     epB = tausB/KS - (qmB - qlB);
 
     // Compute integral error terms using clamping anti-windup method
-    eiA = clamp(eiA + (epA*0.001), -antiWindup, antiWindup);
-    eiB = clamp(eiB + (epB*0.001), -antiWindup, antiWindup);
+    eiA = clamp(eiA + (epA*getPeriod()), -antiWindup, antiWindup);
+    eiB = clamp(eiB + (epB*getPeriod()), -antiWindup, antiWindup);
 
     // Compute derivative error terms
     edA = dtausA/KS - (dqmA - dqlA);
@@ -28,7 +28,7 @@ double ASCRateLimit::operator()(double tgt, double posRate, double negRate) {
 	log_out.data.negRate = negRate;
 
 	// Compute the delta time
-	double dt = ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS);
+	double dt = getPeriod();
 
 	// Compute the actual output command
 	log_out.data.out = clamp(tgt, log_out.data.out + dt * negRate, log_out.data.out + dt * posRate);
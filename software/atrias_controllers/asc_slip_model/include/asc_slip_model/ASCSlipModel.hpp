@@ -13,6 +13,9 @@
 // And for the logging helper class
 #include <atrias_control_lib/LogPort.hpp>
 
+// Times the integrators
+#include <atrias_control_lib/Profiler.hpp>
+
 // Our log data
 #include "asc_slip_model/controller_log_data.h"
 
@@ -79,6 +82,12 @@ class ASCSlipModel : public AtriasController {
 		  * You may have as many of these as you'd like of various types.
 		  */
 		LogPort<asc_slip_model::controller_log_data_> log_out;
+
+		/**
+		  * @brief Time advanceRK4() and advanceRK5(), when the top-level
+		  * controller's profiling is on.
+		  */
+		ProfilePoint rk4Profile, rk5Profile;
 };
 
 }
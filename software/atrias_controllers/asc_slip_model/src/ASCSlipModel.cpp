@@ -7,7 +7,9 @@ namespace controller {
 // Controller constructor
 ASCSlipModel::ASCSlipModel(AtriasController *parent, string name) :
         AtriasController(parent, name),
-        log_out(this, "log")
+        log_out(this, "log"),
+        rk4Profile(this, "advanceRK4"),
+        rk5Profile(this, "advanceRK5")
 {
 	// Linear spring constant
 	k = 28000.0;
@@ -22,9 +24,10 @@ ASCSlipModel::ASCSlipModel(AtriasController *parent, string name) :
 
 
 SlipState ASCSlipModel::advanceRK4(SlipState slipState) {
+	ProfileScope profileScope(rk4Profile);
 
 	// Our delta time
-	h = ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS);
+	h = getPeriod();
 
 	// Unpack parameters
 	r = slipState.r;
@@ -76,9 +79,10 @@ SlipState ASCSlipModel::advanceRK4(SlipState slipState) {
 
 
 SlipState ASCSlipModel::advanceRK5(SlipState slipState) {
+	ProfileScope profileScope(rk5Profile);
 
 	// Our delta time
-	h = ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS);
+	h = getPeriod();
 
 	// Unpack parameters
 	r = slipState.r;
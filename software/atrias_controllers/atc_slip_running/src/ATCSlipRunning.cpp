@@ -246,7 +246,7 @@ void ATCSlipRunning::shutdownController() {
 void ATCSlipRunning::rightLegFlightFalling() {
 
 	// Advance time counter
-	dt = ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS); 
+	dt = getPeriod();
 	t = t + dt;
 	
 	// Redefine slip initial conditions incase we go into stance next time step
@@ -352,7 +352,7 @@ void ATCSlipRunning::rightLegStance() {
 void ATCSlipRunning::leftLegFlightRising() {
 	
 	// Advance time counter
-	dt = ((double) CONTROLLER_LOOP_PERIOD_NS) / ((double) SECOND_IN_NANOSECONDS); 
+	dt = getPeriod();
 	t = t + dt;
 
 	// Left leg control
@@ -28,17 +28,17 @@
 #include <asc_pd/ASCPD.hpp>
 #include <asc_rate_limit/ASCRateLimit.hpp>
 
+// Filters
+#include <asc_filters/MovingAverage.hpp>
+#include <asc_filters/SpikeFilter.hpp>
+
 // Datatypes
-#include <deque>
 #include <robot_invariant_defs.h>
 #include <robot_variant_defs.h>
 #include <atrias_msgs/robot_state.h>
 #include <atrias_shared/controller_structs.h>
 #include <atrias_shared/atrias_parameters.h>
 
-// Functions
-#include <numeric>  // std::accumulate
-
 // Namespaces we're using
 using namespace std;
 
@@ -73,12 +73,16 @@ class ATCSlipWalking : public ATC<
         void standingController();
         void shutdownController();
         void stanceController(atrias_msgs::robot_state_leg*, atrias_msgs::controller_output_leg*, ASCLegForce*, ASCRateLimit*);
-        void singleSupportEvents(atrias_msgs::robot_state_leg*, atrias_msgs::robot_state_leg*, std::deque<double>*);
+        // The filtered toe switch readings, newest first. The mean of all
+        // but the newest 20 is the baseline for stance detection.
+        typedef MovingAverage<100, 20> ToeFilter;
+
+        void singleSupportEvents(atrias_msgs::robot_state_leg*, atrias_msgs::robot_state_leg*, ToeFilter*);
         void legSwingController(atrias_msgs::robot_state_leg*, atrias_msgs::robot_state_leg*, atrias_msgs::controller_output_leg*, ASCPD*, ASCPD*);
         void doubleSupportEvents(atrias_msgs::robot_state_leg*, atrias_msgs::robot_state_leg*, ASCRateLimit*);
         void resetFlightLegParameters(atrias_msgs::robot_state_leg*, ASCRateLimit*);
-        bool detectStance(atrias_msgs::robot_state_leg*, std::deque<double>*);
-        void updateToeFilter(uint16_t, std::deque<double>*);
+        bool detectStance(atrias_msgs::robot_state_leg*, ToeFilter*);
+        void updateToeFilter(uint16_t, ToeFilter*);
         std::tuple<double, double> legForceControl(LegForce, atrias_msgs::robot_state_leg, atrias_msgs::robot_state_location);
 
         /**
@@ -140,8 +144,9 @@ class ATCSlipWalking : public ATC<
         bool isForwardStep, isTrigger; // Logical preventing backstepping issues
 
         // Toe switch variables
-        deque<double> rFilteredToe;
-        deque<double> lFilteredToe;
+        ToeFilter rFilteredToe;
+        ToeFilter lFilteredToe;
+        SpikeFilter toeSpikeFilter;
 
         // Misc margins, ratelimiters and other debug values
         double legRateLimit, hipRateLimit, springRateLimit;
@@ -9,10 +9,12 @@
 #include <rtt/TaskContext.hpp>
 #include <rtt/Component.hpp>
 #include <rtt/OperationCaller.hpp>
+#include <rtt/os/TimeService.hpp>
 
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/ConnectorInterface.hpp>
 #include <robot_invariant_defs.h>
 
 /** @brief This is the amount of torque (in *amps*) needed to hold a hip vertical
@@ -66,7 +68,7 @@ enum class Half: Half_t {
 	B
 };
 
-class CSimConn : public RTT::TaskContext {
+class CSimConn : public RTT::TaskContext, public shared::ConnectorInterface {
 	private:
 		/** @brief This holds the current controller output.
 		  */
@@ -77,6 +79,33 @@ class CSimConn : public RTT::TaskContext {
 		RTT::OperationCaller<void(atrias_msgs::robot_state)>
 			newStateCallback;
 
+		/** @brief Gets the control loop period from RT Ops.
+		  */
+		RTT::OperationCaller<RTT::os::TimeService::nsecs(void)>
+			getControlPeriod;
+
+		/** @brief The control loop period, in nanoseconds.
+		  */
+		RTT::os::TimeService::nsecs controlPeriod;
+
+		/** @brief The simulation time step, in seconds. Equal to \a controlPeriod.
+		  */
+		double dt;
+
+		/** @brief Lets us report our input-to-output latency.
+		  */
+		RTT::OperationCaller<void(rtOps::CycleStage, RTT::os::TimeService::nsecs)>
+			reportStageTime;
+
+		/** @brief When we last cycled RT Ops. Used to time the whole cycle.
+		  */
+		RTT::os::TimeService::nsecs cycleStartTime;
+
+		/** @brief When the last controller output came in, or 0 if it hasn't
+		  * yet this cycle. Used for the latencies in robot_state_timing.
+		  */
+		RTT::os::TimeService::nsecs transmitTime;
+
 		/** @brief This stores the current robot state.
 		  */
 		atrias_msgs::robot_state robotState;
@@ -105,7 +134,7 @@ class CSimConn : public RTT::TaskContext {
 		/** @brief Called by RT Ops w/ update controller torques.
 		  * @param controller_output The new controller output.
 		  */
-		void sendControllerOutput(atrias_msgs::controller_output controller_output);
+		void sendControllerOutput(const atrias_msgs::controller_output &controller_output);
 		
 		/** @brief Configures this component.
 		  * Run by Orocos.
@@ -6,12 +6,22 @@ namespace cSimConn {
 
 CSimConn::CSimConn(std::string name) :
          RTT::TaskContext(name),
-         newStateCallback("newStateCallback")
+         newStateCallback("newStateCallback"),
+         getControlPeriod("getControlPeriod"),
+         reportStageTime("reportStageTime")
 {
 	this->provides("connector")
 	    ->addOperation("sendControllerOutput", &CSimConn::sendControllerOutput, this, RTT::ClientThread);
 	this->requires("rtOps")
 	    ->addOperationCaller(newStateCallback);
+	this->requires("rtOps")
+	    ->addOperationCaller(getControlPeriod);
+	this->requires("rtOps")
+	    ->addOperationCaller(reportStageTime);
+
+	controlPeriod = CONTROLLER_LOOP_PERIOD_NS;
+	transmitTime  = 0;
+	dt            = ((double) controlPeriod) / SECOND_IN_NANOSECONDS;
 
 	// Initialize the state.
 	robotState.lLeg.hip.legBodyAngle = robotState.rLeg.hip.legBodyAngle = 1.5 * M_PI;
@@ -39,7 +49,7 @@ atrias_msgs::robot_state_hip CSimConn::simHip(atrias_msgs::robot_state_hip& hip,
 	// Calculate acceleration... no friction.
 	double accel = netTorque / HIP_INERTIA;
 
-	double newVel = hip.legBodyVelocity + .001 * accel;
+	double newVel = hip.legBodyVelocity + dt * accel;
 
 	// This hip's minimum position
 	double minPos = 1.5 * M_PI - ((whichHip == Hip::LEFT) ? HIP_RELAXED_POS_DIFF  : HIP_EXTENDED_POS_DIFF);
@@ -53,7 +63,7 @@ atrias_msgs::robot_state_hip CSimConn::simHip(atrias_msgs::robot_state_hip& hip,
 	
 	atrias_msgs::robot_state_hip out;
 	out.legBodyVelocity = newVel;
-	out.legBodyAngle    = oldPos + .001 * newVel;
+	out.legBodyAngle    = oldPos + dt * newVel;
 	return out;
 }
 
@@ -61,10 +71,10 @@ atrias_msgs::robot_state_legHalf CSimConn::simLegHalf(atrias_msgs::robot_state_l
 	// Acceleration.
 	double accel = ACCEL_PER_AMP * current;
 
-	double newVel = legHalf.motorVelocity + 0.001 * accel;
+	double newVel = legHalf.motorVelocity + dt * accel;
 
 	// Deceleration due to friction for one simulation step
-	double fricDecel = LEG_FRICTION_AMPS * ACCEL_PER_AMP * .001;
+	double fricDecel = LEG_FRICTION_AMPS * ACCEL_PER_AMP * dt;
 	if (newVel > fricDecel)
 		newVel -= fricDecel;
 	else if (newVel < -fricDecel)
@@ -84,7 +94,7 @@ atrias_msgs::robot_state_legHalf CSimConn::simLegHalf(atrias_msgs::robot_state_l
 		newVel = 0.0;
 	
 	// Compute new position.
-	pos += .001 * newVel;
+	pos += dt * newVel;
 	
 	atrias_msgs::robot_state_legHalf out;
 	out.rotorAngle    = out.motorAngle    = out.legAngle    = pos;
@@ -99,6 +109,13 @@ bool CSimConn::configureHook() {
 		return false;
 	}
 	newStateCallback = peer->provides("rtOps")->getOperation("newStateCallback");
+	reportStageTime  = peer->provides("rtOps")->getOperation("reportStageTime");
+	getControlPeriod = peer->provides("rtOps")->getOperation("getControlPeriod");
+
+	// Step the sim, and run, at RT Ops's rate.
+	controlPeriod = getControlPeriod();
+	dt            = ((double) controlPeriod) / SECOND_IN_NANOSECONDS;
+	this->setPeriod(dt);
 	log(RTT::Info) << "[CSimConn] Connected to RTOps." << RTT::endlog();
 	log(RTT::Info) << "[CSimConn] configured!" << RTT::endlog();
 	return true;
@@ -106,7 +123,7 @@ bool CSimConn::configureHook() {
 
 void CSimConn::updateHook() {
 	// Increment the time.
-	robotState.header.stamp.nsec += CONTROLLER_LOOP_PERIOD_NS;
+	robotState.header.stamp.nsec += controlPeriod;
 	robotState.header.stamp.sec  += robotState.header.stamp.nsec / SECOND_IN_NANOSECONDS;
 	robotState.header.stamp.nsec %= SECOND_IN_NANOSECONDS;
 
@@ -118,11 +135,29 @@ void CSimConn::updateHook() {
 	robotState.rLeg.halfA = simLegHalf(robotState.rLeg.halfA, cOut.rLeg.motorCurrentA, Half::A);
 	robotState.rLeg.halfB = simLegHalf(robotState.rLeg.halfB, cOut.rLeg.motorCurrentB, Half::B);
 
+	// Last cycle's outputs were just applied, by the step above. We have
+	// no DC clock, so these use ours.
+	RTT::os::TimeService::nsecs now = RTT::os::TimeService::Instance()->getNSecs();
+	atrias_msgs::robot_state_timing &timing = robotState.timing;
+	if (transmitTime) {
+		timing.lastTransmitDCTime = transmitTime;
+		timing.transmitLatency    = transmitTime - cycleStartTime;
+		timing.actuationLatency   = now - cycleStartTime;
+	} else {
+		timing.transmitLatency    = -1;
+		timing.actuationLatency   = -1;
+	}
+	transmitTime = 0;
+
+	cycleStartTime = now;
+	timing.receiveDCTime = now;
 	newStateCallback(robotState);
 }
 
-void CSimConn::sendControllerOutput(atrias_msgs::controller_output controller_output) {
+void CSimConn::sendControllerOutput(const atrias_msgs::controller_output &controller_output) {
 	cOut = controller_output;
+	transmitTime = RTT::os::TimeService::Instance()->getNSecs();
+	reportStageTime(rtOps::CycleStage::TOTAL, transmitTime - cycleStartTime);
 	return;
 }
 
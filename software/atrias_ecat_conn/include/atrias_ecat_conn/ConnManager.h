@@ -15,23 +15,35 @@ class ConnManager;
 #include <rtt/Logger.hpp>
 #include <rtt/os/TimeService.hpp>
 
-// SOEM
-extern "C" {
-#include <ethercattype.h>
-#include <ethercatmain.h>
-#include <ethercatconfig.h>
-#include <ethercatdc.h>
-}
-
 #include <signal.h>
 
 #include "atrias_ecat_conn/ECatConn.h"
+#include "atrias_ecat_conn/DCSync.h"
+#include "atrias_ecat_conn/ECatMaster.h"
+#include "atrias_ecat_conn/FrameMonitor.h"
+#include "atrias_ecat_conn/SlaveSupervisor.h"
 #include <atrias_msgs/controller_output.h>
+#include <atrias_msgs/ecat_bringup.h>
+#include <atrias_msgs/ecat_frame_stats.h>
 #include <robot_invariant_defs.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/GuiPublishTimer.h>
+#include <atrias_shared/RtLog.hpp>
 
+#define ECAT_INTERFACE     "rteth0"
 #define EC_TIMEOUT_US      500
-#define TIMING_FILTER_GAIN 100
+
+// How often to send the frame statistics, in milliseconds.
+#define FRAME_STATS_PERIOD_MS 1000
+
+// The DC clocks count as settled once every slave has been within
+// DC_SETTLE_THRESHOLD_NS of the reference clock for DC_SETTLE_CHECKS checks
+// in a row, one check every DC_SETTLE_FRAMES frames. We give up (and carry
+// on anyway) after DC_SETTLE_MAX_NS.
+#define DC_SETTLE_THRESHOLD_NS 1000
+#define DC_SETTLE_CHECKS       5
+#define DC_SETTLE_FRAMES       20
+#define DC_SETTLE_MAX_NS       1000000000LL
 
 namespace atrias {
 
@@ -42,6 +54,10 @@ class ConnManager : public RTT::Activity {
 	  */
 	ECatConn*      eCatConn;
 	
+	/** @brief The EtherCAT bus: real (through SOEM) or virtual.
+	  */
+	ECatMaster*    master;
+	
 	/** @brief This is where SOEM stores its data.
 	  */
 	char           IOmap[4096];
@@ -54,23 +70,142 @@ class ConnManager : public RTT::Activity {
 	  */
 	RTT::os::Mutex eCatLock;
 	
-	/** @brief Sends and receives an EtherCAT frame.
+	/** @brief Sends and receives an EtherCAT frame, re-sending lost ones
+	  * up to \a frameRetries times.
 	  * Does not grab eCatLock -- must already have it.
+	  * @return The working counter, or EC_NOFRAME if the frame was lost.
+	  */
+	int            cycleECat();
+	
+	/** @brief Accounts for a received frame, asking the supervisor to look
+	  * at the slaves if it was bad.
+	  * @param wkc            The working counter, from \a cycleECat().
+	  * @param compare_inputs See FrameMonitor::check().
+	  * Must be called with eCatLock held.
+	  */
+	void           checkFrame(int wkc, bool compare_inputs);
+	
+	/** @brief Closes out a cycle's frames, halting RT Ops if too many
+	  * cycles in a row have had bad ones.
+	  * Must be called with eCatLock held, once per cycle.
 	  */
-	void           cycleECat();
+	void           endFrameCycle();
+	
+	/** @brief Sends frames until the slaves' clocks converge on the reference clock.
+	  * The frames carry the drift compensation, so this must run before the loop.
+	  * @param first_sync0 The DC time of the first SYNC0 edge. We also wait
+	  *                    for the slaves to have run a full cycle after it.
+	  * @return Whether the clocks converged before DC_SETTLE_MAX_NS.
+	  */
+	bool           settleDC(int64_t first_sync0);
 	
 	/** @brief Used to keep the loop's phase offset constant from cycle
 	  * to cycle and to compensate for overshoots.
 	  */
 	RTT::os::TimeService::nsecs targetTime;
 	
+	/** @brief When this cycle's receive began. Used to time the whole cycle.
+	  */
+	RTT::os::TimeService::nsecs cycleStartTime;
+	
 	/** @brief Used to detect missed deadlines.
 	  */
 	bool           midCycle;
+	
+	/** @brief The control loop period, in nanoseconds.
+	  */
+	RTT::os::TimeService::nsecs controlPeriod;
+	
+	/** @brief The offset between the DC and our loop, scaled to \a controlPeriod.
+	  */
+	RTT::os::TimeService::nsecs controlOffset;
+	
+	/** @brief Whether to send the output frame without waiting for it to return.
+	  */
+	bool           pipelined;
+	
+	/** @brief How long before the SYNC0 edge to send pipelined output
+	  * frames, in nanoseconds. 0 sends them as soon as they're ready.
+	  */
+	RTT::os::TimeService::nsecs transmitLead;
+	
+	/** @brief When this cycle's input frame came back, from \a getTime().
+	  * Lets the controller's thread find where it is in the DC cycle.
+	  */
+	RTT::os::TimeService::nsecs receiveHostTime;
+	
+	/** @brief Sleeps until \a transmitLead before the next SYNC0 edge.
+	  * Returns right away if we're already closer than that.
+	  * Must not be called with eCatLock held.
+	  */
+	void           waitForTransmitSlot();
+	
+	/** @brief How long before each wakeup to stop sleeping and start spinning,
+	  * in nanoseconds. 0 disables spinning.
+	  */
+	RTT::os::TimeService::nsecs spinMargin;
+	
+	/** @brief Whether an output frame was sent but not yet received.
+	  * Only used in pipelined mode.
+	  */
+	bool           transmitPending;
+	
+	/** @brief Records when a cycle's outputs went out and the resulting latencies.
+	  * @param wkc              The output frame's working counter. If the frame
+	  *                         was lost, the latencies are set to -1.
+	  * @param transmit_dc_time The DC time of the output frame.
+	  * Must be called before \a timingInfo.receiveDCTime moves on to the next cycle.
+	  */
+	void           recordTransmit(int wkc, int64_t transmit_dc_time);
+	
+	/** @brief Reads the clock our loop is timed against.
+	  * All of ConnManager's timestamps come from here, since the absolute
+	  * sleeps below must use the same clock as the deadlines they're given.
+	  * @return The time, in nanoseconds.
+	  */
+	RTT::os::TimeService::nsecs getTime();
+	
+	/** @brief Sleeps (and spins, if \a spinMargin is set) until a deadline.
+	  * @param wake_time The deadline, from \a getTime().
+	  * @return How late we woke up, in nanoseconds.
+	  */
+	RTT::os::TimeService::nsecs sleepUntil(RTT::os::TimeService::nsecs wake_time);
 
 	/** @brief This stores our timing information.
 	  */
 	atrias_msgs::robot_state_timing timingInfo;
+	
+	/** @brief Phase-locks our loop to the DC clock.
+	  */
+	DCSync         dcSync;
+	
+	/** @brief Checks each frame's working counter. Protected by eCatLock.
+	  */
+	FrameMonitor   frameMonitor;
+	
+	/** @brief How many times to re-send a lost frame within a cycle.
+	  */
+	int            frameRetries;
+	
+	/** @brief Brings back slaves that drop out of OP, in its own thread.
+	  */
+	SlaveSupervisor supervisor;
+	
+	/** @brief Whether to run \a supervisor.
+	  */
+	bool           slaveRecovery;
+	
+	/** @brief Paces the frame statistics.
+	  */
+	shared::GuiPublishTimer frameStatsTimer;
+	
+	/** @brief The frame statistics message, kept here so sending it doesn't allocate.
+	  */
+	atrias_msgs::ecat_frame_stats frameStats;
+	
+	/** @brief How long the last bring-up took, phase by phase.
+	  */
+	atrias_msgs::ecat_bringup bringup;
 
 	public:
 		/** @brief The constructor.
@@ -82,6 +217,11 @@ class ConnManager : public RTT::Activity {
 		  */
 		~ConnManager();
 		
+		/** @brief Selects the EtherCAT bus to use. Must be called before \a configure().
+		  * @param ecat_master The bus. ConnManager takes ownership of it.
+		  */
+		void setMaster(ECatMaster* ecat_master);
+		
 		/** @brief Does most of the basic EtherCAT configuration.
 		  * @return Success
 		  */
@@ -92,6 +232,77 @@ class ConnManager : public RTT::Activity {
 		  */
 		bool initialize();
 		
+		/** @brief Sets the control loop period. Must be called before \a configure().
+		  * @param control_period The period, in nanoseconds.
+		  */
+		void setControlPeriod(RTT::os::TimeService::nsecs control_period);
+		
+		/** @brief Selects pipelined transmission.
+		  * @param pipelined_transmit Whether to enable pipelined transmission.
+		  * When enabled, \a sendControllerOutput() sends the output frame and
+		  * returns immediately; the frame is collected at the start of the next
+		  * cycle instead of being waited on in the controller's thread.
+		  * Must be called before the loop starts.
+		  */
+		void setPipelined(bool pipelined_transmit);
+		
+		/** @brief Aligns pipelined output frames to the SYNC0 edge.
+		  * @param transmit_lead How long before the edge to send, in
+		  *                      nanoseconds. 0 sends as soon as the outputs
+		  *                      are ready.
+		  * The Medullas apply outputs at the edge either way; this just puts
+		  * the frame on the wire at the same point in every cycle, however long
+		  * the controller ran. The lead must cover the frame's trip to the
+		  * last Medulla. Must be called before the loop starts.
+		  */
+		void setTransmitLead(RTT::os::TimeService::nsecs transmit_lead);
+		
+		/** @brief Sets how long before each wakeup to start spinning on the clock.
+		  * @param spin_margin The margin, in nanoseconds. 0 just sleeps.
+		  * Spinning trades CPU time for lower wakeup jitter; set the margin
+		  * to cover this machine's worst-case sleep overshoot. Must be called
+		  * before the loop starts.
+		  */
+		void setSpinMargin(RTT::os::TimeService::nsecs spin_margin);
+		
+		/** @brief Configures the frame loss handling. Must be called before the loop starts.
+		  * @param retries        How many times to re-send a lost frame within a
+		  *                       cycle. Each retry can wait up to EC_TIMEOUT_US.
+		  * @param halt_threshold How many cycles in a row with a bad frame
+		  *                       halt the robot. 0 never does.
+		  */
+		void setFrameLossHandling(int retries, int halt_threshold);
+		
+		/** @brief Enables or disables bringing back slaves that drop out of OP.
+		  * @param slave_recovery Whether to run the slave supervisor.
+		  * Must be called before the loop starts.
+		  */
+		void setSlaveRecovery(bool slave_recovery);
+		
+		/** @brief Returns the slave recovery statistics.
+		  * @return The statistics.
+		  */
+		atrias_msgs::ecat_slave_recovery getSlaveRecovery();
+		
+		/** @brief Returns the frame statistics.
+		  * @return The statistics.
+		  */
+		atrias_msgs::ecat_frame_stats getFrameStats();
+		
+		/** @brief Returns how long the last bring-up took.
+		  * @return The bring-up timing.
+		  */
+		atrias_msgs::ecat_bringup getBringup();
+		
+		/** @brief Clears the frame statistics.
+		  */
+		void resetFrameStats();
+		
+		/** @brief Lets ECatConn tune the DC synchronization.
+		  * @return The DC synchronizer.
+		  */
+		DCSync* getDCSync();
+		
 		/** @brief The main ECat receive loop.
 		  */
 		void loop();
@@ -99,7 +310,7 @@ class ConnManager : public RTT::Activity {
 		/** @brief Sends new outputs over ECat.
 		  * @param controller_output The new outputs.
 		  */
-		void sendControllerOutput(atrias_msgs::controller_output& controller_output);
+		void sendControllerOutput(const atrias_msgs::controller_output& controller_output);
 		
 		/** @brief Stops the main loop.
 		  * @return Success
@@ -0,0 +1,121 @@
+#ifndef DCSYNC_H
+#define DCSYNC_H
+
+/** @file
+  * @brief Keeps the EtherCAT loop's wakeups phase-locked to the DC clock.
+  * This is a PI controller on the phase error between our wakeup and the
+  * DC cycle. The proportional term pulls the phase in; the integral term
+  * learns the drift between our clock and the reference clock, so there's
+  * no steady-state offset. It also tracks whether we're locked and keeps
+  * running statistics of the phase error.
+  */
+
+#include <stdint.h>
+
+#include <atrias_msgs/robot_state_timing.h>
+
+// Defaults for the tunables; see the setters below.
+#define DC_SYNC_DEFAULT_KP             0.05
+#define DC_SYNC_DEFAULT_KI             0.001
+#define DC_SYNC_DEFAULT_LOCK_THRESHOLD 5000
+
+// How many cycles in a row must be within the lock threshold before we call it locked.
+#define DC_SYNC_LOCK_CYCLES            100
+
+// The weight of each new sample in the running statistics (about 1 s at 1 kHz).
+#define DC_SYNC_STATS_ALPHA            0.001
+
+namespace atrias {
+
+namespace ecatConn {
+
+class DCSync {
+	/** @brief The control loop period, in nanoseconds.
+	  */
+	int64_t period;
+
+	/** @brief The proportional gain.
+	  */
+	double  kp;
+
+	/** @brief The integral gain.
+	  */
+	double  ki;
+
+	/** @brief How close (in nanoseconds) the phase must stay to count as locked.
+	  */
+	int64_t lockThreshold;
+
+	/** @brief The integral term: our estimate of the drift, in nanoseconds per cycle.
+	  */
+	double  integral;
+
+	/** @brief How many cycles in a row we've been within \a lockThreshold.
+	  */
+	int     cyclesInLock;
+
+	/** @brief Whether we're locked.
+	  */
+	bool    locked;
+
+	/** @brief The last phase error, in nanoseconds.
+	  */
+	int64_t phaseError;
+
+	/** @brief Running mean of the phase error.
+	  */
+	double  errorMean;
+
+	/** @brief Running mean of the squared phase error.
+	  */
+	double  errorMeanSquare;
+
+	public:
+		/** @brief Initializes the synchronizer with the default gains.
+		  */
+		DCSync();
+
+		/** @brief Sets the control loop period and clears all state.
+		  * @param control_period The period, in nanoseconds.
+		  */
+		void    setControlPeriod(int64_t control_period);
+
+		/** @brief Sets the gains.
+		  * @param p_gain The proportional gain, per cycle (0 to 1).
+		  * @param i_gain The integral gain, per cycle. Should be well below \a p_gain.
+		  */
+		void    setGains(double p_gain, double i_gain);
+
+		/** @brief Sets how close the phase must stay to count as locked.
+		  * @param threshold The threshold, in nanoseconds. We unlock at twice this.
+		  */
+		void    setLockThreshold(int64_t threshold);
+
+		/** @brief Clears the integrator, the lock, and the statistics.
+		  */
+		void    reset();
+
+		/** @brief Runs one cycle of the controller.
+		  * @param dc_time The DC time at which this cycle was meant to start.
+		  * @return How far to move the next wakeup, in nanoseconds.
+		  */
+		int64_t update(int64_t dc_time);
+
+		/** @brief Returns whether we're locked.
+		  * @return True if locked.
+		  */
+		bool    isLocked();
+
+		/** @brief Copies our state and statistics into a timing message.
+		  * @param timing_info The message to fill in.
+		  */
+		void    fillTimingInfo(atrias_msgs::robot_state_timing &timing_info);
+};
+
+}
+
+}
+
+#endif // DCSYNC_H
+
+// vim: noexpandtab
@@ -16,6 +16,7 @@ class ECatConn;
 #include <rtt/TaskContext.hpp>
 #include <rtt/Component.hpp>
 #include <rtt/OperationCaller.hpp>
+#include <rtt/OutputPort.hpp>
 #include <rtt/os/TimeService.hpp>
 #include <rtt/Logger.hpp>
 
@@ -24,16 +25,21 @@ class ECatConn;
 
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
+#include <atrias_msgs/ecat_bringup.h>
+#include <atrias_msgs/ecat_frame_stats.h>
+#include <atrias_msgs/ecat_slave_recovery.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/ConnectorInterface.hpp>
 
 #include "atrias_ecat_conn/ConnManager.h"
 #include "atrias_ecat_conn/MedullaManager.h"
+#include "atrias_ecat_conn/VirtualMaster.h"
 
 namespace atrias {
 
 namespace ecatConn {
 
-class ECatConn : public RTT::TaskContext {
+class ECatConn : public RTT::TaskContext, public shared::ConnectorInterface {
 	/** @brief Handles the main operation of this component.
 	  */
 	ConnManager*   connManager;
@@ -42,6 +48,63 @@ class ECatConn : public RTT::TaskContext {
 	  */
 	MedullaManager medullaManager;
 	
+	/** @brief Property: send output frames without waiting for them to return.
+	  * See ConnManager::setPipelined(). Only read in startHook().
+	  */
+	bool           pipelinedTransmit;
+	
+	/** @brief Property: how long before the SYNC0 edge to send pipelined
+	  * output frames, in ns. See ConnManager::setTransmitLead(). Only read
+	  * in startHook().
+	  */
+	int            transmitSyncLead;
+	
+	/** @brief Property: how long before each wakeup to start spinning, in ns.
+	  * See ConnManager::setSpinMargin(). Only read in startHook().
+	  */
+	int            wakeupSpinMargin;
+	
+	/** @brief Properties: how to handle lost frames.
+	  * See ConnManager::setFrameLossHandling(). Only read in startHook().
+	  */
+	int            frameRetries;
+	int            frameLossHaltThreshold;
+	
+	/** @brief Property: bring back slaves that drop out of OP.
+	  * See SlaveSupervisor. Only read in startHook().
+	  */
+	bool           slaveRecovery;
+	
+	/** @brief Property: the topology cache file. See TopologyCache.
+	  * Only read in configureHook().
+	  */
+	std::string    topologyCache;
+	
+	/** @brief Properties: the DC synchronizer's gains and lock threshold.
+	  * See DCSync. Only read in configureHook().
+	  */
+	double         dcSyncKp;
+	double         dcSyncKi;
+	int            dcSyncLockThreshold;
+	
+	/** @brief Property: how many samples encoder velocities are fit over.
+	  * See VelocityEstimator. Only read in configureHook().
+	  */
+	int            velocityWindow;
+	
+	/** @brief Property: run against the virtual EtherCAT bus instead of the robot.
+	  * Only read in configureHook().
+	  */
+	bool           virtualMaster;
+	
+	/** @brief Properties: what the virtual bus looks like.
+	  */
+	VirtualMasterConfig virtualConfig;
+	
+	/** @brief The virtual bus, if we're using one. Owned by \a connManager.
+	  */
+	VirtualMaster* virtualBus;
+	
 	public:
 		/** @brief Initializes this Connector
 		  * @param name The name for this component.
@@ -53,16 +116,38 @@ class ECatConn : public RTT::TaskContext {
 		RTT::OperationCaller<void(atrias_msgs::robot_state)>
 			newStateCallback;
 		
+		/** @brief Sends the EtherCAT frame statistics at a low rate.
+		  */
+		RTT::OutputPort<atrias_msgs::ecat_frame_stats> frameStatsOut;
+		
+		/** @brief Sends the slave recovery statistics whenever they change.
+		  */
+		RTT::OutputPort<atrias_msgs::ecat_slave_recovery> slaveRecoveryOut;
+		
+		/** @brief Sends how long the bus took to come up, once it's up.
+		  */
+		RTT::OutputPort<atrias_msgs::ecat_bringup> bringupOut;
+		
 		/** @brief Called by RT Ops w/ updated controller torques.
 		  * @param controller_output The new controller output.
 		  */
-		void sendControllerOutput(atrias_msgs::controller_output controller_output);
+		void sendControllerOutput(const atrias_msgs::controller_output &controller_output);
 		
 		/** @brief Lets us report events, such as a missed deadline.
 		  */
 		RTT::OperationCaller<void(rtOps::RtOpsEvent, rtOps::RtOpsEventMetadata_t)>
 			sendEvent;
 		
+		/** @brief Gets the control loop period from RT Ops.
+		  */
+		RTT::OperationCaller<RTT::os::TimeService::nsecs(void)>
+			getControlPeriod;
+		
+		/** @brief Lets us report how long each of our cycle stages took.
+		  */
+		RTT::OperationCaller<void(rtOps::CycleStage, RTT::os::TimeService::nsecs)>
+			reportStageTime;
+		
 		/** @brief Configures this component.
 		  * Run by Orocos.
 		  * @return Success.
@@ -89,6 +174,31 @@ class ECatConn : public RTT::TaskContext {
 		/** @brief Lets the user disable RT Ops's safeties.
 		  */
 		void disableSafeties();
+		
+		/** @brief Returns the EtherCAT frame statistics.
+		  * @return The statistics.
+		  */
+		atrias_msgs::ecat_frame_stats getFrameStats();
+		
+		/** @brief Clears the EtherCAT frame statistics.
+		  */
+		void resetFrameStats();
+		
+		/** @brief Returns the slave recovery statistics.
+		  * @return The statistics.
+		  */
+		atrias_msgs::ecat_slave_recovery getSlaveRecovery();
+		
+		/** @brief Returns how long the bus took to come up.
+		  * @return The bring-up timing.
+		  */
+		atrias_msgs::ecat_bringup getBringup();
+		
+		/** @brief Knocks a virtual slave out of OP, to exercise recovery.
+		  * Does nothing unless we're on the virtual bus.
+		  * @param slave The 1-indexed slave.
+		  */
+		void dropVirtualSlave(int slave);
 };
 
 }
@@ -0,0 +1,120 @@
+#ifndef ECATMASTER_H
+#define ECATMASTER_H
+
+/** @file
+  * @brief The interface ConnManager uses to talk to the EtherCAT bus.
+  * SoemMaster drives the real bus through SOEM; VirtualMaster emulates it
+  * (and the Medullas on it) in software.
+  */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atrias_msgs/ecat_bringup.h>
+
+// SOEM
+extern "C" {
+#include <ethercattype.h>
+#include <ethercatmain.h>
+}
+
+namespace atrias {
+
+namespace ecatConn {
+
+class ECatMaster {
+	public:
+		virtual ~ECatMaster() {}
+
+		/** @brief Opens the bus, finds and maps the slaves, and brings them to SAFE-OP.
+		  * @param io_map      Where the process data goes.
+		  * @param io_map_size The size of \a io_map, in bytes.
+		  * @param bringup     Set to how long each phase took, through safeOpMs.
+		  * @return Success.
+		  */
+		virtual bool       configure(char* io_map, size_t io_map_size,
+		                             atrias_msgs::ecat_bringup &bringup) = 0;
+
+		/** @brief Returns the number of slaves found by \a configure().
+		  * @return The slave count.
+		  */
+		virtual int        getSlaveCount() = 0;
+
+		/** @brief Returns the slave array, SOEM-style (1-indexed).
+		  * @return The slaves.
+		  */
+		virtual ec_slavet* getSlaves() = 0;
+
+		/** @brief Requests OP for every slave and waits for it.
+		  */
+		virtual void       setOperational() = 0;
+
+		/** @brief Enables a slave's SYNC0 output.
+		  * @param slave      The 1-indexed slave.
+		  * @param cycle_time The SYNC0 period, in nanoseconds.
+		  * @param shift      The SYNC0 phase, in nanoseconds.
+		  */
+		virtual void       configureSync0(int slave, int64_t cycle_time, int64_t shift) = 0;
+
+		/** @brief Enables every slave's SYNC0 output, all starting at the same edge.
+		  * @param cycle_time The SYNC0 period, in nanoseconds.
+		  * @param shift      The SYNC0 phase, in nanoseconds.
+		  * @return The DC time of the first SYNC0 edge.
+		  */
+		virtual int64_t    configureSync0All(int64_t cycle_time, int64_t shift) = 0;
+
+		/** @brief Returns how far the slaves' clocks are from the reference clock.
+		  * Waits on the bus; not for the realtime loop.
+		  * @return The largest offset of any slave, in nanoseconds.
+		  */
+		virtual int64_t    getDCOffset() = 0;
+
+		/** @brief Sends a process data frame.
+		  */
+		virtual void       sendProcessData() = 0;
+
+		/** @brief Receives the frame sent by \a sendProcessData().
+		  * @param timeout_us How long to wait, in microseconds.
+		  * @return The working counter, or EC_NOFRAME if no frame came back.
+		  */
+		virtual int        receiveProcessData(int timeout_us) = 0;
+
+		/** @brief Returns the working counter a complete process data frame comes back with.
+		  * Only valid after \a configure().
+		  * @return The expected working counter.
+		  */
+		virtual int        getExpectedWKC() = 0;
+
+		/** @brief Returns the reference clock's time, as of the last received frame.
+		  * @return The DC time, in nanoseconds.
+		  */
+		virtual int64_t    getDCTime() = 0;
+
+		/** @brief Reads every slave's AL state into its \a state field.
+		  * Waits for a frame round trip, so this is for the supervisor thread,
+		  * not the realtime loop.
+		  * @return Whether every slave is in OP.
+		  */
+		virtual bool       readStates() = 0;
+
+		/** @brief Takes one step toward bringing a slave back to OP.
+		  * Depending on the slave's state, this acknowledges an error, requests
+		  * OP, or reconfigures (or re-finds) a lost slave. It may block on
+		  * mailbox traffic and state transitions, so it's for the supervisor
+		  * thread only. Call \a readStates() before each step.
+		  * @param slave The 1-indexed slave.
+		  */
+		virtual void       recoverSlave(int slave) = 0;
+
+		/** @brief Returns the slaves to INIT and closes the bus.
+		  */
+		virtual void       close() = 0;
+};
+
+}
+
+}
+
+#endif // ECATMASTER_H
+
+// vim: noexpandtab
@@ -0,0 +1,139 @@
+#ifndef FRAMEMONITOR_H
+#define FRAMEMONITOR_H
+
+/** @file
+  * @brief Checks each process data frame's working counter and keeps
+  * statistics on lost and incomplete frames.
+  * A lost frame means nothing came back at all; an incomplete one came back
+  * with a short working counter because some slave didn't process it. Both
+  * leave stale inputs in the IO map, so we count them to tell cabling and EMI
+  * problems apart from software overruns.
+  */
+
+#include <stdint.h>
+#include <vector>
+
+#include <atrias_msgs/ecat_frame_stats.h>
+
+#include "atrias_ecat_conn/ECatMaster.h"
+
+// How many slaves we keep individual statistics for. Must match ecat_frame_stats.msg.
+#define FRAME_MONITOR_MAX_SLAVES 8
+
+// How many run length buckets we keep. Must match ecat_frame_stats.msg.
+#define FRAME_MONITOR_RUN_BUCKETS 8
+
+namespace atrias {
+
+namespace ecatConn {
+
+class FrameMonitor {
+	/** @brief The slaves, SOEM-style (1-indexed).
+	  */
+	ec_slavet*             slaves;
+	
+	/** @brief How many slaves we watch individually.
+	  */
+	int                    slaveCount;
+	
+	/** @brief The working counter a complete frame comes back with.
+	  */
+	int                    expectedWKC;
+	
+	/** @brief How many bad cycles in a row make \a endCycle() ask for a halt. 0 never does.
+	  */
+	uint32_t               haltThreshold;
+	
+	/** @brief Whether any frame checked since the last \a endCycle() was bad.
+	  */
+	bool                   cycleBad;
+	
+	/** @brief Each slave's inputs as of the last compared frame, back to back.
+	  */
+	std::vector<uint8_t>   lastInputs;
+	
+	/** @brief Where each slave's inputs start in \a lastInputs.
+	  */
+	size_t                 inputOffsets[FRAME_MONITOR_MAX_SLAVES];
+	
+	/** @brief How many frames in a row each slave has missed.
+	  */
+	uint32_t               slaveConsecutive[FRAME_MONITOR_MAX_SLAVES];
+	
+	/** @brief Whether \a lastInputs holds anything yet.
+	  */
+	bool                   haveInputs;
+	
+	/** @brief Our statistics, kept in message form.
+	  */
+	atrias_msgs::ecat_frame_stats stats;
+	
+	/** @brief Ends a run of bad cycles, recording its length.
+	  */
+	void endRun();
+	
+	/** @brief Counts a missed frame against a slave.
+	  * @param slave The 0-indexed slave.
+	  */
+	void slaveMissed(int slave);
+	
+	public:
+		/** @brief Initializes the FrameMonitor, watching nothing.
+		  */
+		FrameMonitor();
+		
+		/** @brief Starts watching a bus. Not realtime-safe.
+		  * @param slave_array  The slaves, SOEM-style (1-indexed), with their IO mapped.
+		  * @param slave_count  How many slaves there are.
+		  * @param expected_wkc The working counter of a complete frame.
+		  */
+		void configure(ec_slavet* slave_array, int slave_count, int expected_wkc);
+		
+		/** @brief Sets how many bad cycles in a row should halt the robot.
+		  * @param threshold The number of cycles. 0 disables halting.
+		  */
+		void setHaltThreshold(uint32_t threshold);
+		
+		/** @brief Clears the statistics.
+		  */
+		void reset();
+		
+		/** @brief Checks a frame that just came back.
+		  * @param wkc            The frame's working counter, or EC_NOFRAME.
+		  * @param compare_inputs Whether to blame slaves whose inputs haven't changed.
+		  *                       Only pass true for frames one control period apart,
+		  *                       since the Medullas' inputs only change once a period.
+		  * @return True if the frame was lost or incomplete.
+		  */
+		bool check(int wkc, bool compare_inputs);
+		
+		/** @brief Closes out a control cycle. A cycle is bad if any of its
+		  * frames were, so the halt threshold counts cycles however many
+		  * frames each one exchanges.
+		  * @return True if this cycle brought the run of bad cycles up to the
+		  *         halt threshold. Only returned once per run.
+		  */
+		bool endCycle();
+		
+		/** @brief Counts a re-sent frame.
+		  */
+		void recordRetry();
+		
+		/** @brief Returns the current run of bad cycles.
+		  * @return The number of bad cycles in a row.
+		  */
+		uint32_t getConsecutiveBad();
+		
+		/** @brief Copies out the statistics.
+		  * @param frame_stats The message to fill in.
+		  */
+		void fillStats(atrias_msgs::ecat_frame_stats &frame_stats);
+};
+
+}
+
+}
+
+#endif // FRAMEMONITOR_H
+
+// vim: noexpandtab
@@ -6,6 +6,8 @@
   */
 
 // Orocos
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/MutexLock.hpp>
 #include <rtt/os/TimeService.hpp>
 #include <rtt/Logger.hpp>
 
@@ -20,26 +22,18 @@ extern "C" {
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <atrias_shared/globals.h>
-#include <atrias_medulla_drivers/BoomMedulla.h>
-#include <atrias_medulla_drivers/ImuMedulla.h>
-#include <atrias_medulla_drivers/LegMedulla.h>
-#include <atrias_medulla_drivers/HipMedulla.h>
 #include <atrias_medulla_drivers/Medulla.h>
 
+#include "atrias_ecat_conn/MedullaRegistry.h"
+
 namespace atrias {
 
 namespace ecatConn {
 
 class MedullaManager {
-	// All of our Medullas:
-	medullaDrivers::LegMedulla*  lLegA;
-	medullaDrivers::LegMedulla*  lLegB;
-	medullaDrivers::LegMedulla*  rLegA;
-	medullaDrivers::LegMedulla*  rLegB;
-	medullaDrivers::BoomMedulla* boom;
-	medullaDrivers::ImuMedulla*  imu;
-	medullaDrivers::HipMedulla*  lLegHip;
-	medullaDrivers::HipMedulla*  rLegHip;
+	/** @brief All of our Medullas, grouped by type.
+	  */
+	MedullaRegistry          medullas;
 	
 	/** @brief Holds our robot state for us.
 	  * Note: Functions using this are NOT thread-safe and should only be called
@@ -47,6 +41,10 @@ class MedullaManager {
 	  */
 	atrias_msgs::robot_state robotState;
 	
+	/** @brief The control loop period, in nanoseconds. Passed on to the Medullas.
+	  */
+	int64_t                  controlPeriod;
+	
 	/** @brief Does the slave card-specific init.
 	  */
 	void slaveCardInit(ec_slavet slave);
@@ -55,52 +53,11 @@ class MedullaManager {
 	  */
 	void medullasInit(ec_slavet slaves[], int slavecount);
 	
-	/** @brief Initialize the boom medulla.
-	  * @param slave The ECat slave for this Medulla.
-	  */
-	void initBoomMedulla(ec_slavet slave);
-	
-	/** @brief Initialize the IMU medulla.
-	  * @param slave The ECat slave for this Medulla.
-	  */
-	void initImuMedulla(ec_slavet slave);
-	
-	/** @brief Initializes a hip medulla.
-	  * @param slave The ECat slave for this hip.
-	  */
-	void initHipMedulla(ec_slavet slave);
-	
-	/** @brief Initializes a leg medulla.
-	  * @param slave The ECat slave for this Medulla.
-	  */
-	void initLegMedulla(ec_slavet slave);
-		
-	/** @brief Fills in a PDORegData struct.
-	  * @param pdo_reg_data The PDORegData struct to be filled in.
-	  * @param inputs A pointer to the slave's inputs.
-	  * @param outputs A pointer to the slave's outputs.
-	  */
-	void fillInPDORegData(medullaDrivers::PDORegData pdo_reg_data, uint8_t* outputs, uint8_t* inputs);
-	
 	/** @brief Identifies the robot's configuration from the created Medullas.
 	  * @return The robot's configuration.
 	  */
 	rtOps::RobotConfiguration calcRobotConfiguration();
 	
-	/** @brief Configures the array of pointers for a medulla's inputs[] parameter.
-	  * @param slave_inputs The address to this slave's inputs.
-	  * @param inputs_array The array in which to store the values.
-	  * @param num_entries  The number of elements in the inputs_array param.
-	  */
-	void InputsConfig(uint8_t* slave_inputs, intptr_t* inputs_array, int num_entries);
-	
-	/** @brief Configures the array of pointers for a medulla's outputs[] parameter.
-	  * @param slave_outputs The address to this slave's outputs.
-	  * @param outputs_array The array in which to store the values.
-	  * @param num_entries  The number of elements in the inputs_array param.
-	  */
-	void OutputsConfig(uint8_t* slave_outputs, intptr_t* outputs_array, int num_entries);
-	
 	public:
 		/** @brief Initializes the MedullaManager.
 		  */
@@ -114,6 +71,27 @@ class MedullaManager {
 		  */
 		void start(ec_slavet slaves[], int slavecount);
 		
+		/** @brief Re-creates the driver for a Medulla that dropped out of OP and came back.
+		  * This re-reads its initial values (timing counter, encoders) the
+		  * way \a start() does. Not realtime-safe; run it from a non-realtime
+		  * thread, without \a lock held.
+		  * @param slave    The ECat slave for this Medulla.
+		  * @param position Its (1-indexed) slave position.
+		  * @param lock     The lock the ECat loop holds while it uses the drivers.
+		  * @return Whether the Medulla was recognized.
+		  */
+		bool reinitMedulla(ec_slavet slave, int position, RTT::os::Mutex &lock);
+		
+		/** @brief Sets the control loop period. Must be called before \a start().
+		  * @param control_period The period, in nanoseconds.
+		  */
+		void setControlPeriod(int64_t control_period);
+		
+		/** @brief Sets how many samples encoder velocities are fit over. Must be called before \a start().
+		  * @param samples The window, in samples. 2 is a plain difference.
+		  */
+		void setVelocityWindow(int samples);
+		
 		/** @brief Processes our receive data into the robot state.
 		  */
 		void processReceiveData();
@@ -121,7 +99,7 @@ class MedullaManager {
 		/** @brief Processes controller outputs into SOEM's buffer.
 		  * @param controller_output The controller output.
 		  */
-		void processTransmitData(atrias_msgs::controller_output& controller_output);
+		void processTransmitData(const atrias_msgs::controller_output& controller_output);
 		
 		/** @brief Sets the timestamp in robot state.
 		  * @param timing_info The new timing information
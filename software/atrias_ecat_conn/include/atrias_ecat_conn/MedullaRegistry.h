@@ -0,0 +1,262 @@
+#ifndef MEDULLAREGISTRY_H
+#define MEDULLAREGISTRY_H
+
+/** @file
+  * @brief Holds the Medulla drivers, in flat arrays grouped by type.
+  * Each cycle is one tight loop per type, rather than a null check and a
+  * call for every Medulla we might have. Any number of each type may be on
+  * the bus (extra IMUs, say); each driver works out where its data goes in
+  * the robot state from its ID once, in postOpInit(), and Medullas whose
+  * IDs don't map anywhere are left out.
+  */
+
+// Orocos
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/MutexLock.hpp>
+#include <rtt/Logger.hpp>
+
+// SOEM
+extern "C" {
+#include <ethercattype.h>
+#include <ethercatmain.h>
+}
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <atrias_msgs/robot_state.h>
+#include <atrias_msgs/controller_output.h>
+#include <atrias_medulla_drivers/BoomMedulla.h>
+#include <atrias_medulla_drivers/ImuMedulla.h>
+#include <atrias_medulla_drivers/LegBatch.h>
+#include <atrias_medulla_drivers/LegMedulla.h>
+#include <atrias_medulla_drivers/HipMedulla.h>
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief All the drivers of one type.
+  */
+template <class Driver>
+class MedullaGroup {
+	/** @brief The drivers, in bus order.
+	  */
+	std::vector<Driver*> drivers;
+
+	/** @brief The (1-indexed) slave position of each driver.
+	  */
+	std::vector<int>     slaves;
+
+	public:
+		/** @brief Frees the drivers.
+		  */
+		~MedullaGroup() {
+			clear();
+		}
+
+		/** @brief Adds a driver. Not realtime-safe.
+		  * @param medulla The driver, already through postOpInit(). The group takes ownership.
+		  * @param slave   Its slave position.
+		  */
+		void add(Driver* medulla, int slave) {
+			drivers.push_back(medulla);
+			slaves.push_back(slave);
+		}
+
+		/** @brief Swaps a fresh driver in for the one at a slave position.
+		  * Only postOpInit() and the swap itself happen with \a lock held.
+		  * @param slave   The slave position.
+		  * @param medulla The new driver, with its PDOs filled in. The group takes ownership.
+		  * @param lock    The lock the ECat loop holds while it uses the drivers.
+		  * @return Whether there was a driver at \a slave and \a medulla
+		  *         mapped to the same place as it. If not, \a medulla is freed.
+		  */
+		bool replace(int slave, Driver* medulla, RTT::os::Mutex &lock);
+
+		/** @brief Checks whether one of the drivers has an ID.
+		  * @param id The Medulla ID.
+		  * @return True if there's a driver with that ID.
+		  */
+		bool hasID(uint8_t id) {
+			for (size_t i = 0; i < drivers.size(); i++) {
+				if (drivers[i]->getID() == id)
+					return true;
+			}
+			return false;
+		}
+
+		/** @brief Returns how many drivers there are.
+		  * @return The number of drivers.
+		  */
+		size_t size() {
+			return drivers.size();
+		}
+
+		/** @brief Returns the drivers, for decoding them all at once.
+		  * @return The drivers, in bus order, or NULL if there aren't any.
+		  */
+		Driver* const* getDrivers() {
+			return drivers.empty() ? NULL : &drivers[0];
+		}
+
+		/** @brief Frees all the drivers.
+		  */
+		void clear() {
+			for (size_t i = 0; i < drivers.size(); i++)
+				delete(drivers[i]);
+			drivers.clear();
+			slaves.clear();
+		}
+
+		/** @brief Has every driver decode its inputs into the robot state.
+		  * @param robot_state The robot state.
+		  */
+		void processReceiveData(atrias_msgs::robot_state &robot_state) {
+			for (size_t i = 0; i < drivers.size(); i++)
+				drivers[i]->processReceiveData(robot_state);
+		}
+
+		/** @brief Has every driver encode its outputs.
+		  * @param controller_output The controller output.
+		  */
+		void processTransmitData(const atrias_msgs::controller_output &controller_output) {
+			for (size_t i = 0; i < drivers.size(); i++)
+				drivers[i]->processTransmitData(controller_output);
+		}
+};
+
+class MedullaRegistry {
+	// The drivers, by type.
+	MedullaGroup<medullaDrivers::LegMedulla>  legs;
+	MedullaGroup<medullaDrivers::HipMedulla>  hips;
+	MedullaGroup<medullaDrivers::BoomMedulla> booms;
+	MedullaGroup<medullaDrivers::ImuMedulla>  imus;
+
+	/** @brief Decodes all the legs together.
+	  */
+	medullaDrivers::LegBatch                  legBatch;
+
+	/** @brief Whether the legs go through \a legBatch, rather than one at a time.
+	  */
+	bool                                      batchLegs;
+
+	/** @brief The control loop period, in nanoseconds. Passed on to the Medullas.
+	  */
+	int64_t controlPeriod;
+
+	/** @brief How many samples encoder velocities are fit over. Passed on to the Medullas.
+	  */
+	int     velocityWindow;
+
+	/** @brief Creates a driver and points it at a slave's PDOs.
+	  * @param slave The ECat slave for this Medulla.
+	  * @return The driver, not yet through postOpInit().
+	  */
+	template <class Driver>
+	Driver* createMedulla(ec_slavet &slave);
+
+	/** @brief Creates and initializes a driver, and adds it to a group if its ID maps.
+	  * @param group    The group for this type of Medulla.
+	  * @param slave    The ECat slave for this Medulla.
+	  * @param position Its (1-indexed) slave position.
+	  * @param type     The type's name, for the log.
+	  * @return Whether it was added.
+	  */
+	template <class Driver>
+	bool addMedulla(MedullaGroup<Driver> &group, ec_slavet &slave, int position, const char* type);
+
+	public:
+		/** @brief Initializes an empty registry.
+		  */
+		MedullaRegistry();
+
+		/** @brief Sets the control loop period. Must be called before \a add().
+		  * @param control_period The period, in nanoseconds.
+		  */
+		void setControlPeriod(int64_t control_period);
+
+		/** @brief Picks how the leg Medullas get decoded. The results are the same either way.
+		  * @param batch True to decode them together (the default), false for one at a time.
+		  */
+		void setLegBatching(bool batch);
+
+		/** @brief Sets how many samples encoder velocities are fit over. Must be called before \a add().
+		  * @param samples The window, in samples. 2 is a plain difference.
+		  */
+		void setVelocityWindow(int samples);
+
+		/** @brief Creates the driver for a slave and registers it. Not realtime-safe.
+		  * The robot state has one place for each leg and hip (picked by the
+		  * Medulla's ID), and just one for the boom and one for the IMU, so
+		  * a second boom or IMU Medulla is turned away with a warning.
+		  * @param slave    The ECat slave.
+		  * @param position Its (1-indexed) slave position.
+		  * @return Whether the slave is a Medulla we have a place for.
+		  */
+		bool add(ec_slavet slave, int position);
+
+		/** @brief Re-creates the driver for a slave that dropped out of OP and came back.
+		  * Not realtime-safe; run it from a non-realtime thread, without \a lock held.
+		  * @param slave    The ECat slave.
+		  * @param position Its (1-indexed) slave position.
+		  * @param lock     The lock the ECat loop holds while it uses the drivers.
+		  * @return Whether it replaced a registered driver.
+		  */
+		bool reinit(ec_slavet slave, int position, RTT::os::Mutex &lock);
+
+		/** @brief Frees all the drivers.
+		  */
+		void clear();
+
+		/** @brief Checks whether we have a leg Medulla with an ID.
+		  * @param id The Medulla ID.
+		  * @return True if we do.
+		  */
+		bool hasLeg(uint8_t id);
+
+		/** @brief Checks whether we have a hip Medulla with an ID.
+		  * @param id The Medulla ID.
+		  * @return True if we do.
+		  */
+		bool hasHip(uint8_t id);
+
+		/** @brief Returns how many drivers there are.
+		  * @return The number of drivers, of all types.
+		  */
+		size_t size();
+
+		/** @brief Decodes every Medulla's inputs into the robot state.
+		  * Runs the types in MedullaManager's original order: legs, boom, IMU, then hips.
+		  * @param robot_state The robot state.
+		  */
+		void processReceiveData(atrias_msgs::robot_state &robot_state) {
+			if (batchLegs)
+				legBatch.processReceiveData(legs.getDrivers(), legs.size(), robot_state);
+			else
+				legs.processReceiveData(robot_state);
+			booms.processReceiveData(robot_state);
+			imus.processReceiveData(robot_state);
+			hips.processReceiveData(robot_state);
+		}
+
+		/** @brief Encodes the controller output into every Medulla's outputs.
+		  * Same order as \a processReceiveData().
+		  * @param controller_output The controller output.
+		  */
+		void processTransmitData(const atrias_msgs::controller_output &controller_output) {
+			legs.processTransmitData(controller_output);
+			booms.processTransmitData(controller_output);
+			imus.processTransmitData(controller_output);
+			hips.processTransmitData(controller_output);
+		}
+};
+
+}
+
+}
+
+#endif // MEDULLAREGISTRY_H
+
+// vim: noexpandtab
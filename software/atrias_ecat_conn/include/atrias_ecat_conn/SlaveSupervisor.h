@@ -0,0 +1,129 @@
+#ifndef SLAVESUPERVISOR_H
+#define SLAVESUPERVISOR_H
+
+/** @file
+  * @brief Brings EtherCAT slaves that drop out of OP back, off the realtime loop.
+  * State reads, error acknowledgements, and reconfiguration all wait on the
+  * bus, sometimes for many milliseconds, so they run here in a non-realtime
+  * thread. The ECat loop just asks for a check when it sees a bad frame.
+  * Once a slave is back in OP, its SYNC0 is set up again and its Medulla
+  * driver is re-created, so it re-reads its initial values.
+  */
+
+#include <atomic>
+#include <stdint.h>
+
+// Orocos
+#include <rtt/Activity.hpp>
+#include <rtt/Logger.hpp>
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/MutexLock.hpp>
+#include <rtt/os/TimeService.hpp>
+
+#include <atrias_msgs/ecat_slave_recovery.h>
+
+#include "atrias_ecat_conn/ECatMaster.h"
+
+// How often the supervisor runs, in seconds. Each recovery step takes at least this long.
+#define SLAVE_SUPERVISOR_PERIOD      0.01
+
+// How often to check the slaves' states when nothing looks wrong, in nanoseconds.
+#define SLAVE_SUPERVISOR_CHECK_NS    1000000000LL
+
+// How many slaves we watch. Must match ecat_slave_recovery.msg.
+#define SLAVE_SUPERVISOR_MAX_SLAVES  8
+
+namespace atrias {
+
+namespace ecatConn {
+
+class ECatConn;
+
+class SlaveSupervisor : public RTT::Activity {
+	/** @brief Lets us reach the Medullas and our output port.
+	  */
+	ECatConn*                     eCatConn;
+	
+	/** @brief The bus.
+	  */
+	ECatMaster*                   master;
+	
+	/** @brief The lock the ECat loop holds while it uses the Medulla drivers.
+	  */
+	RTT::os::Mutex               &eCatLock;
+	
+	/** @brief Set by \a requestCheck(); makes the next step read the states.
+	  */
+	std::atomic<bool>             checkRequested;
+	
+	/** @brief When we last read the states.
+	  */
+	RTT::os::TimeService::nsecs   lastCheck;
+	
+	/** @brief The SYNC0 period and shift, to set up again after a recovery.
+	  */
+	int64_t                       syncPeriod;
+	int64_t                       syncShift;
+	
+	/** @brief Whether each slave is out of OP, and since when.
+	  */
+	bool                          recovering[SLAVE_SUPERVISOR_MAX_SLAVES];
+	RTT::os::TimeService::nsecs   dropTime[SLAVE_SUPERVISOR_MAX_SLAVES];
+	
+	/** @brief Our statistics. Protected by \a statusLock.
+	  */
+	atrias_msgs::ecat_slave_recovery status;
+	RTT::os::Mutex                statusLock;
+	
+	/** @brief Brings back a slave that's returned to OP.
+	  * @param slave The 1-indexed slave.
+	  * @param now   The current time.
+	  */
+	void slaveRecovered(int slave, RTT::os::TimeService::nsecs now);
+	
+	public:
+		/** @brief The constructor.
+		  * @param ecat_conn A pointer to the ECatConn instance.
+		  * @param ecat_lock The lock the ECat loop holds while it uses the Medulla drivers.
+		  */
+		SlaveSupervisor(ECatConn* ecat_conn, RTT::os::Mutex &ecat_lock);
+		
+		/** @brief Selects the bus to watch. Must be called while we're stopped.
+		  * @param ecat_master The bus.
+		  */
+		void setMaster(ECatMaster* ecat_master);
+		
+		/** @brief Sets the SYNC0 setup to restore on recovered slaves.
+		  * @param cycle_time The SYNC0 period, in nanoseconds.
+		  * @param shift      The SYNC0 phase, in nanoseconds.
+		  */
+		void setSync0(int64_t cycle_time, int64_t shift);
+		
+		/** @brief Asks for the slaves' states to be checked soon.
+		  * Realtime-safe; the ECat loop calls this when it sees a bad frame.
+		  */
+		void requestCheck();
+		
+		/** @brief Returns the recovery statistics.
+		  * @return The statistics.
+		  */
+		atrias_msgs::ecat_slave_recovery getStatus();
+		
+		/** @brief Clears the statistics. Run by Orocos on start().
+		  * @return Success.
+		  */
+		bool initialize();
+		
+		/** @brief Checks the slaves and takes a recovery step for any out of OP.
+		  * Run periodically by Orocos.
+		  */
+		void step();
+};
+
+}
+
+}
+
+#endif // SLAVESUPERVISOR_H
+
+// vim: noexpandtab
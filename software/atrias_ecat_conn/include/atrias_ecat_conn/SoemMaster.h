@@ -0,0 +1,82 @@
+#ifndef SOEMMASTER_H
+#define SOEMMASTER_H
+
+/** @file
+  * @brief Talks to the real EtherCAT bus through SOEM.
+  */
+
+#include <string>
+
+// SOEM
+extern "C" {
+#include <ethercattype.h>
+#include <ethercatmain.h>
+#include <ethercatconfig.h>
+#include <ethercatdc.h>
+}
+
+#include "atrias_ecat_conn/ECatMaster.h"
+#include "atrias_ecat_conn/TopologyCache.h"
+
+// How far ahead to schedule the first SYNC0 edge, in nanoseconds.
+// Long enough for the setup frames to reach every slave first.
+#define SYNC0_START_DELAY_NS 20000000LL
+
+namespace atrias {
+
+namespace ecatConn {
+
+class SoemMaster : public ECatMaster {
+	/** @brief The network interface the bus is on.
+	  */
+	std::string ifname;
+
+	/** @brief Whether \a configure() opened the interface.
+	  */
+	bool        open;
+
+	/** @brief Remembers the slaves' PDO sizes between runs.
+	  */
+	TopologyCache topologyCache;
+
+	/** @brief Finds the slaves, maps their process data, and brings them to SAFE-OP.
+	  * Leaves ec_slave[0].state holding the lowest state any slave reached.
+	  * @param io_map      Where to map the process data.
+	  * @param io_map_size The size of \a io_map.
+	  * @param use_cache   Whether to take the PDO sizes from \a topologyCache if it matches.
+	  * @param bringup     The phase timing; each phase's time is added on.
+	  * @return False if the bus couldn't be set up at all.
+	  */
+	bool        mapBus(char* io_map, size_t io_map_size, bool use_cache,
+	                   atrias_msgs::ecat_bringup &bringup);
+
+	public:
+		/** @brief The constructor.
+		  * @param interface_name The network interface the bus is on.
+		  * @param cache_path     The topology cache file. Empty disables the cache.
+		  */
+		SoemMaster(const std::string &interface_name, const std::string &cache_path = "");
+
+		bool       configure(char* io_map, size_t io_map_size, atrias_msgs::ecat_bringup &bringup);
+		int        getSlaveCount();
+		ec_slavet* getSlaves();
+		void       setOperational();
+		void       configureSync0(int slave, int64_t cycle_time, int64_t shift);
+		int64_t    configureSync0All(int64_t cycle_time, int64_t shift);
+		int64_t    getDCOffset();
+		void       sendProcessData();
+		int        receiveProcessData(int timeout_us);
+		int        getExpectedWKC();
+		int64_t    getDCTime();
+		bool       readStates();
+		void       recoverSlave(int slave);
+		void       close();
+};
+
+}
+
+}
+
+#endif // SOEMMASTER_H
+
+// vim: noexpandtab
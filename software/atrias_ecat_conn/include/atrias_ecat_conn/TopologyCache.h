@@ -0,0 +1,95 @@
+#ifndef TOPOLOGYCACHE_H
+#define TOPOLOGYCACHE_H
+
+/** @file
+  * @brief Remembers the bus's slaves and their process data sizes between runs.
+  * Reading each slave's PDO mapping from its EEPROM is the slowest part of
+  * mapping the bus. If the slaves found on the bus are the same ones (by
+  * vendor, product code, and revision, in the same order) as last time, we
+  * hand SOEM the cached sizes and it skips those reads.
+  */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// SOEM
+extern "C" {
+#include <ethercattype.h>
+#include <ethercatmain.h>
+}
+
+// Bump this if the file format changes.
+#define TOPOLOGY_CACHE_VERSION 1
+
+// What \a seed() sets each slave's configindex to. Any nonzero value does;
+// this one's well past the end of SOEM's configuration list.
+#define TOPOLOGY_CACHE_CONFIG_INDEX 0xffff
+
+namespace atrias {
+
+namespace ecatConn {
+
+class TopologyCache {
+	/** @brief What we remember about each slave.
+	  */
+	struct Entry {
+		uint32_t vendor;
+		uint32_t productCode;
+		uint32_t revision;
+		uint32_t outputBits;
+		uint32_t inputBits;
+	};
+	
+	/** @brief Where the cache lives. Empty disables it.
+	  */
+	std::string        path;
+	
+	/** @brief The cached slaves, 0-indexed.
+	  */
+	std::vector<Entry> entries;
+	
+	public:
+		/** @brief The constructor. Doesn't read anything yet.
+		  * @param cache_path The cache file. Empty disables the cache.
+		  */
+		TopologyCache(const std::string &cache_path);
+		
+		/** @brief Reads the cache file.
+		  * @return Whether there was a valid cache to read.
+		  */
+		bool load();
+		
+		/** @brief Checks whether the cache describes the slaves on the bus.
+		  * @param slaves      The slaves, SOEM-style (1-indexed), as found by ec_config_init().
+		  * @param slave_count How many slaves there are.
+		  * @return Whether every slave matches, in order.
+		  */
+		bool matches(ec_slavet* slaves, int slave_count);
+		
+		/** @brief Fills in each slave's process data sizes from the cache.
+		  * Only valid if \a matches() returned true.
+		  * @param slaves      The slaves, SOEM-style (1-indexed).
+		  * @param slave_count How many slaves there are.
+		  */
+		void seed(ec_slavet* slaves, int slave_count);
+		
+		/** @brief Deletes the cache file, e.g. because the slaves rejected its sizes.
+		  */
+		void invalidate();
+		
+		/** @brief Remembers the slaves on the bus and writes the cache file.
+		  * @param slaves      The slaves, SOEM-style (1-indexed), after ec_config_map().
+		  * @param slave_count How many slaves there are.
+		  * @return Success.
+		  */
+		bool save(ec_slavet* slaves, int slave_count);
+};
+
+}
+
+}
+
+#endif // TOPOLOGYCACHE_H
+
+// vim: noexpandtab
@@ -0,0 +1,168 @@
+#ifndef VIRTUALMASTER_H
+#define VIRTUALMASTER_H
+
+/** @file
+  * @brief A software stand-in for the EtherCAT bus, with virtual Medullas.
+  * This lets the connector's timing loop and the Medulla drivers run on any
+  * Linux machine. It emulates SOEM's slave array, IO map layout, and DC
+  * clock, including reference clock drift and frame round-trip latency.
+  */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "atrias_ecat_conn/ECatMaster.h"
+#include "atrias_ecat_conn/VirtualMedulla.h"
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief What the virtual bus looks like. Filled in from ECatConn's properties.
+  */
+struct VirtualMasterConfig {
+	/** @brief The Medullas on the bus, in bus order, comma-separated.
+	  * Names: lLegA, lLegB, lHip, rLegA, rLegB, rHip, boom, imu.
+	  */
+	std::string slaves;
+
+	/** @brief How fast the reference clock runs relative to ours, in ppm.
+	  */
+	double      driftPpm;
+
+	/** @brief The frame round-trip time, in nanoseconds.
+	  */
+	int         frameLatency;
+
+	/** @brief The most random extra round-trip time, in nanoseconds.
+	  */
+	int         frameJitter;
+
+	/** @brief The fraction of frames that never come back (0 to 1).
+	  */
+	double      frameLossRate;
+};
+
+class VirtualMaster : public ECatMaster {
+	/** @brief The bus's configuration.
+	  */
+	VirtualMasterConfig          config;
+
+	/** @brief The slaves, 1-indexed like SOEM's ec_slave[].
+	  */
+	std::vector<ec_slavet>       slaves;
+
+	/** @brief The Medullas, in the same order as \a slaves (but 0-indexed).
+	  */
+	std::vector<VirtualMedulla*> medullas;
+
+	/** @brief The working counter a complete frame comes back with.
+	  */
+	int                          expectedWKC;
+
+	/** @brief The working counter the outstanding frame comes back with.
+	  */
+	int                          frameWKC;
+
+	/** @brief Our clock when the DC clock was started.
+	  */
+	int64_t                      clockStart;
+
+	/** @brief Our clock when the bus was last configured. The slaves'
+	  * clocks start converging on the reference clock from here.
+	  */
+	int64_t                      configureTime;
+
+	/** @brief The DC time as of the last received frame.
+	  */
+	int64_t                      dcTime;
+
+	/** @brief The DC time at which the outstanding frame passed the slaves.
+	  */
+	int64_t                      frameDCTime;
+
+	/** @brief When (on our clock) the outstanding frame comes back.
+	  */
+	int64_t                      frameReturnTime;
+
+	/** @brief Whether a frame has been sent but not received.
+	  */
+	bool                         framePending;
+
+	/** @brief Whether the outstanding frame was lost on the wire.
+	  */
+	bool                         frameDropped;
+
+	/** @brief The outstanding frame's inputs, copied into the IO map on receive.
+	  */
+	std::vector<uint8_t>         frameInputs;
+
+	/** @brief Where the inputs start in the IO map.
+	  */
+	uint8_t*                     ioInputs;
+
+	/** @brief The state for our (realtime-safe) random number generator.
+	  */
+	unsigned int                 randSeed;
+
+	/** @brief Reads our clock.
+	  * @return The time, in nanoseconds.
+	  */
+	int64_t hostTime();
+
+	/** @brief Converts a time on our clock to DC time, applying the drift.
+	  * @param host_time The time on our clock.
+	  * @return The DC time.
+	  */
+	int64_t toDCTime(int64_t host_time);
+
+	/** @brief Adds a Medulla to the bus.
+	  * @param name The Medulla's name, as in VirtualMasterConfig::slaves.
+	  * @return Whether the name was recognized.
+	  */
+	bool    addMedulla(const std::string &name);
+
+	/** @brief Frees all the Medullas.
+	  */
+	void    clearMedullas();
+
+	public:
+		/** @brief The constructor.
+		  * @param master_config What the bus looks like.
+		  */
+		VirtualMaster(const VirtualMasterConfig &master_config);
+
+		/** @brief Frees the Medullas.
+		  */
+		~VirtualMaster();
+
+		bool       configure(char* io_map, size_t io_map_size, atrias_msgs::ecat_bringup &bringup);
+		int        getSlaveCount();
+		ec_slavet* getSlaves();
+		void       setOperational();
+		void       configureSync0(int slave, int64_t cycle_time, int64_t shift);
+		int64_t    configureSync0All(int64_t cycle_time, int64_t shift);
+		int64_t    getDCOffset();
+		void       sendProcessData();
+		int        receiveProcessData(int timeout_us);
+		int        getExpectedWKC();
+		int64_t    getDCTime();
+		bool       readStates();
+		void       recoverSlave(int slave);
+
+		/** @brief Knocks a slave out of OP, as if it had hit an error.
+		  * It stops processing frames until \a recoverSlave() brings it back.
+		  * @param slave The 1-indexed slave.
+		  */
+		void       dropSlave(int slave);
+		void       close();
+};
+
+}
+
+}
+
+#endif // VIRTUALMASTER_H
+
+// vim: noexpandtab
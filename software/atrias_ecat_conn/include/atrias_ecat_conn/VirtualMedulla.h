@@ -0,0 +1,95 @@
+#ifndef VIRTUALMEDULLA_H
+#define VIRTUALMEDULLA_H
+
+/** @file
+  * @brief Emulates one Medulla on the virtual EtherCAT bus.
+  * The process data layout is taken from the matching driver in
+  * atrias_medulla_drivers, so it always agrees with what MedullaManager maps.
+  * Only the fields every Medulla shares are emulated: the ID, the state
+  * (which follows the commanded state), the timing counter (which counts
+  * SYNC0 edges), and the error flags. Sensor fields read as zero.
+  */
+
+#include <stdint.h>
+#include <vector>
+
+#include <robot_invariant_defs.h>
+
+namespace atrias {
+
+namespace ecatConn {
+
+class VirtualMedulla {
+	/** @brief This Medulla's EtherCAT product code.
+	  */
+	uint32_t             productCode;
+
+	/** @brief The outputs in effect, as latched at the last SYNC0 edge.
+	  */
+	std::vector<uint8_t> latchedOutputs;
+
+	/** @brief The outputs from the last frame, waiting for a SYNC0 edge.
+	  */
+	std::vector<uint8_t> pendingOutputs;
+
+	/** @brief What the next frame will read from us.
+	  */
+	std::vector<uint8_t> inputs;
+
+	/** @brief The SYNC0 period, or 0 if SYNC0 is off.
+	  */
+	int64_t              syncPeriod;
+
+	/** @brief The DC time of the next SYNC0 edge.
+	  */
+	int64_t              nextSync;
+
+	/** @brief Latches the pending outputs and updates the inputs, as the
+	  * firmware does on each SYNC0 edge.
+	  */
+	void                 syncEdge();
+
+	public:
+		/** @brief Creates a Medulla.
+		  * @param product_code Which kind of Medulla (e.g. MEDULLA_LEG_PRODUCT_CODE).
+		  * @param id           The ID it reports (e.g. MEDULLA_LEFT_LEG_A_ID).
+		  */
+		VirtualMedulla(uint32_t product_code, uint8_t id);
+
+		/** @brief Returns this Medulla's product code.
+		  * @return The product code.
+		  */
+		uint32_t getProductCode();
+
+		/** @brief Returns the size of this Medulla's outputs (master to slave).
+		  * @return The size, in bytes.
+		  */
+		int      getOutputBytes();
+
+		/** @brief Returns the size of this Medulla's inputs (slave to master).
+		  * @return The size, in bytes.
+		  */
+		int      getInputBytes();
+
+		/** @brief Enables SYNC0.
+		  * @param cycle_time The SYNC0 period, in nanoseconds.
+		  * @param shift      The SYNC0 phase, in nanoseconds.
+		  * @param dc_time    The current DC time.
+		  */
+		void     setSync0(int64_t cycle_time, int64_t shift, int64_t dc_time);
+
+		/** @brief Passes a frame through this Medulla.
+		  * @param outputs Our part of the frame's outputs. Read.
+		  * @param inputs  Our part of the frame's inputs. Written.
+		  * @param dc_time The DC time at which the frame reaches us.
+		  */
+		void     exchange(const uint8_t* outputs, uint8_t* inputs, int64_t dc_time);
+};
+
+}
+
+}
+
+#endif // VIRTUALMEDULLA_H
+
+// vim: noexpandtab
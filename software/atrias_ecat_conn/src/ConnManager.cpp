@@ -1,4 +1,8 @@
 #include "atrias_ecat_conn/ConnManager.h"
+#include "atrias_ecat_conn/SoemMaster.h"
+
+#include <errno.h>
+#include <time.h>
 
 void sig_handler(int signum) {
 	return;
@@ -9,86 +13,289 @@ namespace atrias {
 namespace ecatConn {
 
 ConnManager::ConnManager(ECatConn* ecat_conn) :
-             RTT::Activity(80, 0, "EtherCAT") {
-	eCatConn = ecat_conn;
+             RTT::Activity(80, 0, "EtherCAT"),
+             supervisor(ecat_conn, eCatLock),
+             frameStatsTimer(FRAME_STATS_PERIOD_MS) {
+	eCatConn        = ecat_conn;
+	master          = new SoemMaster(ECAT_INTERFACE);
+	pipelined       = false;
+	transmitLead    = 0;
+	transmitPending = false;
+	spinMargin      = 0;
+	frameRetries    = 0;
+	slaveRecovery   = true;
+	supervisor.setMaster(master);
+	setControlPeriod(CONTROLLER_LOOP_PERIOD_NS);
 	signal(SIGXCPU, sig_handler);
 }
 
 ConnManager::~ConnManager() {
-	ec_slave[0].state = EC_STATE_INIT;
-	ec_writestate(0);
-	ec_close();
+	supervisor.stop();
+	master->close();
+	delete master;
 }
 
-inline void ConnManager::cycleECat() {
-	ec_send_processdata();
-	ec_receive_processdata(EC_TIMEOUT_US);
+void ConnManager::setMaster(ECatMaster* ecat_master) {
+	master->close();
+	delete master;
+	master = ecat_master;
+	supervisor.setMaster(master);
 }
 
-bool ConnManager::configure() {
-	if (!ec_init("rteth0")) {
-		log(RTT::Error) << "[ECatConn] ConnManager: ec_init() failed!"
-			<< RTT::endlog();
-		return false;
+inline int ConnManager::cycleECat() {
+	master->sendProcessData();
+	int wkc = master->receiveProcessData(EC_TIMEOUT_US);
+	
+	for (int i = 0; i < frameRetries && wkc == EC_NOFRAME; i++) {
+		frameMonitor.recordRetry();
+		master->sendProcessData();
+		wkc = master->receiveProcessData(EC_TIMEOUT_US);
 	}
 	
-	ec_config_init(FALSE);
+	return wkc;
+}
+
+void ConnManager::checkFrame(int wkc, bool compare_inputs) {
+	if (frameMonitor.check(wkc, compare_inputs))
+		supervisor.requestCheck();
+}
+
+void ConnManager::endFrameCycle() {
+	if (!frameMonitor.endCycle())
+		return;
+	
+	uint32_t run = frameMonitor.getConsecutiveBad();
+	shared::RtLog::log(RTT::Error, "[ECatConn] {} cycles in a row with bad EtherCAT frames; halting.",
+	                   run);
+	eCatConn->sendEvent(rtOps::RtOpsEvent::ECAT_FRAME_LOSS,
+	                    (rtOps::RtOpsEventMetadata_t) ((run < 127) ? run : 127));
+}
+
+void ConnManager::recordTransmit(int wkc, int64_t transmit_dc_time) {
+	if (wkc == EC_NOFRAME) {
+		// The outputs never reached the Medullas, and the DC time wasn't
+		// updated, so there's nothing to measure.
+		timingInfo.transmitLatency  = -1;
+		timingInfo.actuationLatency = -1;
+		return;
+	}
+	
+	timingInfo.lastTransmitDCTime = transmit_dc_time;
+	timingInfo.transmitLatency    = transmit_dc_time - timingInfo.receiveDCTime;
+	
+	// The Medullas apply outputs at the first SYNC0 edge after the frame
+	// passes. See the configureSync0() call in initialize() for the edges' phase.
+	int64_t syncShift = controlPeriod - controlOffset;
+	int64_t toSync    = (syncShift - transmit_dc_time % controlPeriod
+	                     + controlPeriod) % controlPeriod;
+	timingInfo.actuationLatency   = timingInfo.transmitLatency + toSync;
+}
+
+void ConnManager::setControlPeriod(RTT::os::TimeService::nsecs control_period) {
+	controlPeriod = control_period;
+	controlOffset = control_period * CONTROLLER_LOOP_OFFSET_NS / CONTROLLER_LOOP_PERIOD_NS;
+	dcSync.setControlPeriod(control_period);
+}
+
+void ConnManager::setPipelined(bool pipelined_transmit) {
+	pipelined = pipelined_transmit;
+}
+
+void ConnManager::setTransmitLead(RTT::os::TimeService::nsecs transmit_lead) {
+	transmitLead = transmit_lead;
+}
+
+void ConnManager::waitForTransmitSlot() {
+	// Where we are in the DC cycle, from the clock we sleep on. Within a
+	// cycle of the receive, the two drift apart by tens of nanoseconds at most.
+	RTT::os::TimeService::nsecs now = getTime();
+	int64_t dcNow     = (int64_t) timingInfo.receiveDCTime + (now - receiveHostTime);
+	int64_t syncShift = controlPeriod - controlOffset;
+	int64_t toSync    = (syncShift - dcNow % controlPeriod + controlPeriod) % controlPeriod;
+	
+	// If we're already inside the lead, send right away; the frame
+	// still has (up to) transmitLead to reach the Medullas.
+	if (toSync > transmitLead)
+		sleepUntil(now + toSync - transmitLead);
+}
+
+void ConnManager::setSpinMargin(RTT::os::TimeService::nsecs spin_margin) {
+	spinMargin = spin_margin;
+}
+
+RTT::os::TimeService::nsecs ConnManager::getTime() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((RTT::os::TimeService::nsecs) now.tv_sec) * SECOND_IN_NANOSECONDS + now.tv_nsec;
+}
+
+RTT::os::TimeService::nsecs ConnManager::sleepUntil(RTT::os::TimeService::nsecs wake_time) {
+	RTT::os::TimeService::nsecs sleepEnd = wake_time - spinMargin;
+	timespec deadline = {
+		(time_t) (sleepEnd / SECOND_IN_NANOSECONDS),
+		(long)   (sleepEnd % SECOND_IN_NANOSECONDS)
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+	
+	RTT::os::TimeService::nsecs now = getTime();
+	if (spinMargin > 0) {
+		while (now < wake_time)
+			now = getTime();
+	}
 	
-	log(RTT::Info) << "[ECatConn] " << ec_slavecount <<
+	return now - wake_time;
+}
+
+void ConnManager::setFrameLossHandling(int retries, int halt_threshold) {
+	frameRetries = (retries > 0) ? retries : 0;
+	frameMonitor.setHaltThreshold((halt_threshold > 0) ? halt_threshold : 0);
+}
+
+void ConnManager::setSlaveRecovery(bool slave_recovery) {
+	slaveRecovery = slave_recovery;
+}
+
+atrias_msgs::ecat_slave_recovery ConnManager::getSlaveRecovery() {
+	return supervisor.getStatus();
+}
+
+atrias_msgs::ecat_bringup ConnManager::getBringup() {
+	RTT::os::MutexLock lock(eCatLock);
+	return bringup;
+}
+
+atrias_msgs::ecat_frame_stats ConnManager::getFrameStats() {
+	RTT::os::MutexLock lock(eCatLock);
+	atrias_msgs::ecat_frame_stats stats;
+	frameMonitor.fillStats(stats);
+	return stats;
+}
+
+void ConnManager::resetFrameStats() {
+	RTT::os::MutexLock lock(eCatLock);
+	frameMonitor.reset();
+}
+
+DCSync* ConnManager::getDCSync() {
+	return &dcSync;
+}
+
+bool ConnManager::settleDC(int64_t first_sync0) {
+	RTT::os::TimeService::nsecs giveUp = getTime() + DC_SETTLE_MAX_NS;
+	int checksInBounds = 0;
+	
+	// Reading every slave's offset takes a frame per slave, so only check
+	// once every few frames; the frames in between keep the drift
+	// compensation going.
+	while (getTime() < giveUp) {
+		for (int i = 0; i < DC_SETTLE_FRAMES; i++)
+			cycleECat();
+		
+		bringup.dcOffset = master->getDCOffset();
+		if (bringup.dcOffset > DC_SETTLE_THRESHOLD_NS || master->getDCTime() < first_sync0 + controlPeriod) {
+			checksInBounds = 0;
+			continue;
+		}
+		
+		if (++checksInBounds >= DC_SETTLE_CHECKS)
+			return true;
+	}
+	
+	return false;
+}
+
+bool ConnManager::configure() {
+	bringup = atrias_msgs::ecat_bringup();
+	bool success = master->configure(IOmap, sizeof(IOmap), bringup);
+	
+	log(RTT::Info) << "[ECatConn] " << master->getSlaveCount() <<
 		" EtherCAT slaves identified." << RTT::endlog();
-	if (ec_slavecount < 1) {
+	if (master->getSlaveCount() < 1) {
 		log(RTT::Error) <<
 			"[ECatConn] Failed to identify any slaves! Failing to init."
 			<< RTT::endlog();
 		return false;
 	}
 	
-	ec_configdc();
-	
-	ec_config_map(IOmap);
-	
-	// Wait for SAFE-OP
-	ec_statecheck(0, EC_STATE_SAFE_OP,  EC_TIMEOUTSTATE * 4);
+	if (success) {
+		frameMonitor.configure(master->getSlaves(), master->getSlaveCount(),
+		                       master->getExpectedWKC());
+		log(RTT::Info) << "[ECatConn] Expected working counter: "
+			<< master->getExpectedWKC() << RTT::endlog();
+		log(RTT::Info) << "[ECatConn] Bus configured: " << bringup.findSlavesMs
+			<< " ms finding slaves, " << bringup.configDCMs << " ms DC setup, "
+			<< bringup.mapMs << " ms mapping ("
+			<< (bringup.topologyCacheHit ? "cached" : "uncached") << "), "
+			<< bringup.safeOpMs << " ms to SAFE-OP." << RTT::endlog();
+	}
 	
-	return true;
+	return success;
 }
 
 bool ConnManager::initialize() {
 	// Send the EtherCAT slaves into OP
-	ec_slave[0].state = EC_STATE_OPERATIONAL;
-	
-	ec_writestate(0);
-	ec_statecheck(0, EC_STATE_OPERATIONAL,  EC_TIMEOUTSTATE);
+	RTT::os::TimeService::nsecs phaseStart = getTime();
+	master->setOperational();
+	bringup.operationalMs = (getTime() - phaseStart) / 1000000.0;
 	
 	// We are now in OP.
-	// Configure the distributed clocks for each slave.
-	for (int i = 1; i <= ec_slavecount; i++) {
-		ec_dcsync0(i, true, CONTROLLER_LOOP_PERIOD_NS,
-		           CONTROLLER_LOOP_PERIOD_NS - CONTROLLER_LOOP_OFFSET_NS);
-	}
+	// Configure the distributed clocks, all slaves at once.
+	phaseStart = getTime();
+	int64_t firstSync0 = master->configureSync0All(controlPeriod, controlPeriod - controlOffset);
+	bringup.sync0Ms = (getTime() - phaseStart) / 1000000.0;
 	
-	// Update ec_DCtime so we can calculate stop time below.
-	cycleECat();
-	// Send a barrage of packets to set up the DC clock.
-	int64_t stoptime = ec_DCtime + 200000000;
-	// SOEM automatically updates ec_DCtime.
-	while (ec_DCtime < stoptime) {
-		cycleECat();
+	// Send packets until the DC clocks settle. Each received frame updates the DC time.
+	phaseStart = getTime();
+	bringup.dcConverged = settleDC(firstSync0);
+	bringup.dcSettleMs  = (getTime() - phaseStart) / 1000000.0;
+	if (!bringup.dcConverged) {
+		log(RTT::Warning) << "[ECatConn] The DC clocks didn't settle; still "
+			<< bringup.dcOffset << " ns off after " << bringup.dcSettleMs
+			<< " ms. Continuing anyway." << RTT::endlog();
 	}
 	
 	// We now have data.
 	
 	// Configure our medullas
-	eCatConn->getMedullaManager()->start(ec_slave, ec_slavecount);
+	phaseStart = getTime();
+	eCatConn->getMedullaManager()->start(master->getSlaves(), master->getSlaveCount());
+	bringup.medullaInitMs = (getTime() - phaseStart) / 1000000.0;
+	
+	bringup.totalMs = bringup.findSlavesMs + bringup.configDCMs + bringup.mapMs
+	                + bringup.safeOpMs + bringup.operationalMs + bringup.sync0Ms
+	                + bringup.dcSettleMs + bringup.medullaInitMs;
+	RTT::os::TimeService::nsecs now = getTime();
+	bringup.header.stamp.sec  = now / SECOND_IN_NANOSECONDS;
+	bringup.header.stamp.nsec = now % SECOND_IN_NANOSECONDS;
+	log(RTT::Info) << "[ECatConn] Bus up: " << bringup.operationalMs << " ms to OP, "
+		<< bringup.sync0Ms << " ms SYNC0 setup, " << bringup.dcSettleMs
+		<< " ms DC settling (" << bringup.dcOffset << " ns), " << bringup.medullaInitMs
+		<< " ms Medulla setup; " << bringup.totalMs << " ms total." << RTT::endlog();
+	eCatConn->bringupOut.write(bringup);
 	
-	targetTime         = RTT::os::TimeService::Instance()->getNSecs();
+	targetTime         = getTime();
 	done               = false;
-	midCycle = false;
+	midCycle           = false;
+	transmitPending    = false;
+	dcSync.reset();
+	
+	// Don't count the frames lost while the bus came up.
+	frameMonitor.reset();
+	
+	supervisor.setSync0(controlPeriod, controlPeriod - controlOffset);
+	if (slaveRecovery && !supervisor.start()) {
+		log(RTT::Warning) << "[ECatConn] Failed to start the slave supervisor; "
+			<< "slaves that drop out of OP won't be brought back." << RTT::endlog();
+	}
 	
 	return !done;
 }
 
 void ConnManager::loop() {
+	// RTT runs initialize() in the thread that starts us, so this is the
+	// first place we're in our own thread. The Medullas may log from here on.
+	shared::RtLog::registerThread("EtherCAT");
+	
 	while (!done) {
 		if (midCycle) {
 			// Missed deadline!
@@ -99,16 +306,35 @@ void ConnManager::loop() {
 		RTT::os::TimeService::nsecs overshoot;
 		
 		int64_t eCatTime;
+		RTT::os::TimeService::nsecs receiveTime;
+		RTT::os::TimeService::nsecs processedTime;
 		{
 			RTT::os::MutexLock lock(eCatLock);
-			overshoot = RTT::os::TimeService::Instance()->getNSecs() - targetTime;
-			cycleECat();
-			eCatTime = ec_DCtime;
+			cycleStartTime = getTime();
+			overshoot = cycleStartTime - targetTime;
+			if (transmitPending) {
+				// Collect last cycle's output frame. It returned long ago,
+				// so this doesn't wait.
+				int wkc = master->receiveProcessData(EC_TIMEOUT_US);
+				checkFrame(wkc, false);
+				recordTransmit(wkc, master->getDCTime());
+				transmitPending = false;
+			}
+			// Last cycle's frames are all in, whether or not it was pipelined.
+			endFrameCycle();
+			checkFrame(cycleECat(), true);
+			receiveTime = getTime();
+			eCatTime = master->getDCTime();
+			receiveHostTime = receiveTime;
 			eCatConn->getMedullaManager()->processReceiveData();
+			processedTime = getTime();
 		}
 
-		timingInfo.controllerTime = (eCatTime + CONTROLLER_LOOP_OFFSET_NS) -
-		                            (eCatTime + CONTROLLER_LOOP_OFFSET_NS) % CONTROLLER_LOOP_PERIOD_NS;
+		eCatConn->reportStageTime(rtOps::CycleStage::ECAT_RECEIVE,    receiveTime - cycleStartTime);
+		eCatConn->reportStageTime(rtOps::CycleStage::PROCESS_RECEIVE, processedTime - receiveTime);
+
+		timingInfo.controllerTime = (eCatTime + controlOffset) -
+		                            (eCatTime + controlOffset) % controlPeriod;
 		timingInfo.receiveDCTime  = eCatTime;
 		timingInfo.overshoot      = overshoot;
 		timingInfo.targetTime     = targetTime;
@@ -119,45 +345,75 @@ void ConnManager::loop() {
 		
 		eCatConn->newStateCallback(eCatConn->getMedullaManager()->getRobotState());
 
-		// The division here functions as an IIR filter on the DC time.
+		// eCatTime - overshoot is (about) the DC time when we meant to wake up.
 		// Since we offset the DC backwards in initialize() above, we try to align
-		// to a phase of 0.
-		timingInfo.dcCorrection =
-			-((eCatTime-overshoot+CONTROLLER_LOOP_PERIOD_NS/2)
-			% CONTROLLER_LOOP_PERIOD_NS - CONTROLLER_LOOP_PERIOD_NS/2)
-			/ TIMING_FILTER_GAIN;
+		// that to a phase of 0.
+		timingInfo.dcCorrection = dcSync.update(eCatTime - overshoot);
+		dcSync.fillTimingInfo(timingInfo);
 
-		RTT::os::TimeService::nsecs cur_time =
-			RTT::os::TimeService::Instance()->getNSecs();
+		RTT::os::TimeService::nsecs cur_time = getTime();
 
+		// The next wakeup is a whole number of periods after the last one
+		// (plus the correction), so the deadline doesn't depend on how long
+		// this cycle ran or how late we woke up. If we've overrun, skip
+		// ahead to the next one in phase.
 		timingInfo.sleepTime =
 			(targetTime + timingInfo.dcCorrection - cur_time)
-			% CONTROLLER_LOOP_PERIOD_NS;
+			% controlPeriod;
 
 		// Correct for the difference between % and modulo
-		timingInfo.sleepTime = (timingInfo.sleepTime + CONTROLLER_LOOP_PERIOD_NS)
-		                       % CONTROLLER_LOOP_PERIOD_NS;
+		timingInfo.sleepTime = (timingInfo.sleepTime + controlPeriod)
+		                       % controlPeriod;
 
 		targetTime = timingInfo.sleepTime + cur_time;
 
-		// The time to sleep. Sleeptime is guaranteed to be less than
-		// SECOND_IN_NANOSECONDS, so this is correct.
-		timespec delay = {
-			0,
-			timingInfo.sleepTime
-		};
-		clock_nanosleep(CLOCK_MONOTONIC, 0, &delay, NULL);
+		if (frameStatsTimer.readyToSend()) {
+			{
+				RTT::os::MutexLock lock(eCatLock);
+				frameMonitor.fillStats(frameStats);
+			}
+			eCatConn->frameStatsOut.write(frameStats);
+		}
+
+		eCatConn->reportStageTime(rtOps::CycleStage::WAKEUP, sleepUntil(targetTime));
 	}
+	
+	supervisor.stop();
+	shared::RtLog::unregisterThread();
 }
 
 void ConnManager::sendControllerOutput(
-                  atrias_msgs::controller_output& controller_output) {
+                  const atrias_msgs::controller_output& controller_output) {
 
-	RTT::os::MutexLock lock(eCatLock);
-	eCatConn->getMedullaManager()->processTransmitData(controller_output);
-	cycleECat();
-	midCycle = false;
-	timingInfo.lastTransmitDCTime = ec_DCtime;
+	RTT::os::TimeService::nsecs startTime;
+	RTT::os::TimeService::nsecs processedTime;
+	RTT::os::TimeService::nsecs endTime;
+	
+	// Don't hold the lock while we wait; loop() may need it to report stats.
+	if (pipelined && transmitLead > 0)
+		waitForTransmitSlot();
+	
+	{
+		RTT::os::MutexLock lock(eCatLock);
+		startTime = getTime();
+		eCatConn->getMedullaManager()->processTransmitData(controller_output);
+		processedTime = getTime();
+		if (pipelined) {
+			// Get the outputs on the wire now; loop() collects the frame.
+			master->sendProcessData();
+			transmitPending = true;
+		} else {
+			int wkc = cycleECat();
+			checkFrame(wkc, false);
+			recordTransmit(wkc, master->getDCTime());
+		}
+		endTime = getTime();
+		midCycle = false;
+	}
+
+	eCatConn->reportStageTime(rtOps::CycleStage::PROCESS_TRANSMIT, processedTime - startTime);
+	eCatConn->reportStageTime(rtOps::CycleStage::ECAT_TRANSMIT,    endTime - processedTime);
+	eCatConn->reportStageTime(rtOps::CycleStage::TOTAL,            endTime - cycleStartTime);
 }
 
 bool ConnManager::breakLoop() {
@@ -0,0 +1,108 @@
+#include "atrias_ecat_conn/DCSync.h"
+
+#include <math.h>
+
+#include <robot_invariant_defs.h>
+#include <atrias_shared/RtLog.hpp>
+
+namespace atrias {
+
+namespace ecatConn {
+
+DCSync::DCSync() {
+	kp            = DC_SYNC_DEFAULT_KP;
+	ki            = DC_SYNC_DEFAULT_KI;
+	lockThreshold = DC_SYNC_DEFAULT_LOCK_THRESHOLD;
+	setControlPeriod(CONTROLLER_LOOP_PERIOD_NS);
+}
+
+void DCSync::setControlPeriod(int64_t control_period) {
+	period = control_period;
+	reset();
+}
+
+void DCSync::setGains(double p_gain, double i_gain) {
+	kp = p_gain;
+	ki = i_gain;
+}
+
+void DCSync::setLockThreshold(int64_t threshold) {
+	lockThreshold = threshold;
+}
+
+void DCSync::reset() {
+	integral        = 0.0;
+	cyclesInLock    = 0;
+	locked          = false;
+	phaseError      = 0;
+	errorMean       = 0.0;
+	errorMeanSquare = 0.0;
+}
+
+int64_t DCSync::update(int64_t dc_time) {
+	// Where we are in the DC cycle, wrapped into [-period/2, period/2).
+	phaseError = ((dc_time + period / 2) % period + period) % period - period / 2;
+
+	// The integrator only needs to cover clock drift, so a 1% (10000 ppm)
+	// limit is plenty and keeps it from winding up while we pull in.
+	integral += ki * phaseError;
+	double maxIntegral = period / 100.0;
+	if (integral > maxIntegral)
+		integral = maxIntegral;
+	else if (integral < -maxIntegral)
+		integral = -maxIntegral;
+
+	double correction = -(kp * phaseError + integral);
+	double maxCorrection = period / 4.0;
+	if (correction > maxCorrection)
+		correction = maxCorrection;
+	else if (correction < -maxCorrection)
+		correction = -maxCorrection;
+
+	errorMean       += DC_SYNC_STATS_ALPHA * (phaseError - errorMean);
+	errorMeanSquare += DC_SYNC_STATS_ALPHA * ((double) phaseError * phaseError - errorMeanSquare);
+
+	int64_t absError = (phaseError < 0) ? -phaseError : phaseError;
+	if (locked) {
+		if (absError > 2 * lockThreshold) {
+			locked       = false;
+			cyclesInLock = 0;
+			shared::RtLog::log(RTT::Warning, "[ECatConn] DC sync lost lock; phase error {} ns.", phaseError);
+		}
+	} else if (absError <= lockThreshold) {
+		if (++cyclesInLock >= DC_SYNC_LOCK_CYCLES) {
+			locked = true;
+
+			// Start the statistics over, so they describe the locked loop
+			// rather than the pull-in.
+			errorMean       = phaseError;
+			errorMeanSquare = (double) phaseError * phaseError;
+			shared::RtLog::log(RTT::Info, "[ECatConn] DC sync locked; drift {} ppm.",
+			                   integral * 1000000.0 / period);
+		}
+	} else {
+		cyclesInLock = 0;
+	}
+
+	return (int64_t) correction;
+}
+
+bool DCSync::isLocked() {
+	return locked;
+}
+
+void DCSync::fillTimingInfo(atrias_msgs::robot_state_timing &timing_info) {
+	double variance = errorMeanSquare - errorMean * errorMean;
+
+	timing_info.phaseError    = phaseError;
+	timing_info.phaseErrorRms = sqrt(errorMeanSquare);
+	timing_info.phaseJitter   = (variance > 0.0) ? sqrt(variance) : 0.0;
+	timing_info.dcDriftPpm    = integral * 1000000.0 / period;
+	timing_info.dcLocked      = locked;
+}
+
+}
+
+}
+
+// vim: noexpandtab
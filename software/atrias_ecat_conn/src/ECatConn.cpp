@@ -1,4 +1,5 @@
 #include "atrias_ecat_conn/ECatConn.h"
+#include "atrias_ecat_conn/SoemMaster.h"
 
 namespace atrias {
 
@@ -6,17 +7,91 @@ namespace ecatConn {
 
 ECatConn::ECatConn(std::string name) :
           RTT::TaskContext(name),
-          newStateCallback("newStateCallback") {
+          newStateCallback("newStateCallback"),
+          getControlPeriod("getControlPeriod"),
+          reportStageTime("reportStageTime"),
+          frameStatsOut("ecat_frame_stats_out"),
+          slaveRecoveryOut("ecat_slave_recovery_out"),
+          bringupOut("ecat_bringup_out") {
 	this->provides("connector")
 	    ->addOperation("sendControllerOutput", &ECatConn::sendControllerOutput, this, RTT::ClientThread);
 	this->provides("disableSafeties")
 	    ->addOperation("disableSafeties", &ECatConn::disableSafeties, this, RTT::ClientThread);
+	this->provides("ecatConn")
+	    ->addOperation("getFrameStats", &ECatConn::getFrameStats, this, RTT::ClientThread);
+	this->provides("ecatConn")
+	    ->addOperation("resetFrameStats", &ECatConn::resetFrameStats, this, RTT::ClientThread);
+	this->provides("ecatConn")
+	    ->addOperation("getSlaveRecovery", &ECatConn::getSlaveRecovery, this, RTT::ClientThread);
+	this->provides("ecatConn")
+	    ->addOperation("getBringup", &ECatConn::getBringup, this, RTT::ClientThread);
+	this->provides("ecatConn")
+	    ->addOperation("dropVirtualSlave", &ECatConn::dropVirtualSlave, this, RTT::ClientThread);
+	this->addPort(frameStatsOut);
+	this->addPort(slaveRecoveryOut);
+	this->addPort(bringupOut);
 	this->requires("rtOps")
 	    ->addOperationCaller(newStateCallback);
 	this->requires("rtOps")
 	    ->addOperationCaller(sendEvent);
+	this->requires("rtOps")
+	    ->addOperationCaller(getControlPeriod);
+	this->requires("rtOps")
+	    ->addOperationCaller(reportStageTime);
+	this->addProperty("pipelinedTransmit", pipelinedTransmit)
+	    .doc("Send output frames without waiting for them to return. Set before starting.");
+	this->addProperty("transmitSyncLead", transmitSyncLead)
+	    .doc("With pipelinedTransmit, send output frames this long (ns) before the SYNC0 edge. 0 sends them right away. Set before starting.");
+	this->addProperty("wakeupSpinMargin", wakeupSpinMargin)
+	    .doc("Stop sleeping this long (ns) before each wakeup and spin on the clock instead. 0 disables. Set before starting.");
+	this->addProperty("frameRetries", frameRetries)
+	    .doc("How many times to re-send a lost EtherCAT frame within a cycle. Set before starting.");
+	this->addProperty("frameLossHaltThreshold", frameLossHaltThreshold)
+	    .doc("Halt the robot after this many cycles in a row with a bad EtherCAT frame; 0 never does. Set before starting.");
+	this->addProperty("slaveRecovery", slaveRecovery)
+	    .doc("Bring back slaves that drop out of OP, from a non-realtime thread. Set before starting.");
+	this->addProperty("topologyCache", topologyCache)
+	    .doc("Where to cache the bus's slaves and PDO sizes between runs, to speed up configuring. Empty disables. Set before configuring.");
+	this->addProperty("dcSyncKp", dcSyncKp)
+	    .doc("Proportional gain of the DC clock synchronization, per cycle.");
+	this->addProperty("dcSyncKi", dcSyncKi)
+	    .doc("Integral gain of the DC clock synchronization, per cycle.");
+	this->addProperty("dcSyncLockThreshold", dcSyncLockThreshold)
+	    .doc("How close to the DC cycle our wakeups must stay to count as locked, in nanoseconds.");
+	this->addProperty("velocityWindow", velocityWindow)
+	    .doc("How many samples encoder velocities are fit over; 2 is a plain difference between cycles. Set before configuring.");
+	this->addProperty("virtualMaster", virtualMaster)
+	    .doc("Emulate the EtherCAT bus and Medullas in software instead of using the robot. Set before configuring.");
+	this->addProperty("virtualSlaves", virtualConfig.slaves)
+	    .doc("The virtual bus's Medullas, in order: any of lLegA, lLegB, lHip, rLegA, rLegB, rHip, boom, imu.");
+	this->addProperty("virtualDriftPpm", virtualConfig.driftPpm)
+	    .doc("How fast the virtual DC reference clock runs relative to ours, in ppm.");
+	this->addProperty("virtualFrameLatency", virtualConfig.frameLatency)
+	    .doc("The virtual bus's frame round-trip time, in nanoseconds.");
+	this->addProperty("virtualFrameJitter", virtualConfig.frameJitter)
+	    .doc("The most random extra round-trip time on the virtual bus, in nanoseconds.");
+	this->addProperty("virtualFrameLossRate", virtualConfig.frameLossRate)
+	    .doc("The fraction of frames the virtual bus loses (0 to 1).");
 	
-	connManager = new ConnManager(this);
+	pipelinedTransmit           = false;
+	transmitSyncLead            = 0;
+	wakeupSpinMargin            = 0;
+	frameRetries                = 0;
+	frameLossHaltThreshold      = 10;
+	slaveRecovery               = true;
+	topologyCache               = "/tmp/atrias_ecat_topology";
+	dcSyncKp                    = DC_SYNC_DEFAULT_KP;
+	dcSyncKi                    = DC_SYNC_DEFAULT_KI;
+	dcSyncLockThreshold         = DC_SYNC_DEFAULT_LOCK_THRESHOLD;
+	velocityWindow              = VELOCITY_ESTIMATOR_DEFAULT_WINDOW;
+	virtualMaster               = false;
+	virtualConfig.slaves        = "lLegA,lLegB,lHip,rLegA,rLegB,rHip,boom";
+	virtualConfig.driftPpm      = 20.0;
+	virtualConfig.frameLatency  = 40000;
+	virtualConfig.frameJitter   = 5000;
+	virtualConfig.frameLossRate = 0.0;
+	virtualBus                  = NULL;
+	connManager       = new ConnManager(this);
 	
 	log(RTT::Info) << "[ECatConn] constructed." << RTT::endlog();
 }
@@ -29,6 +104,24 @@ bool ECatConn::configureHook() {
 	}
 	newStateCallback = peer->provides("rtOps")->getOperation("newStateCallback");
 	sendEvent        = peer->provides("rtOps")->getOperation("sendEvent");
+	reportStageTime  = peer->provides("rtOps")->getOperation("reportStageTime");
+	getControlPeriod = peer->provides("rtOps")->getOperation("getControlPeriod");
+	
+	RTT::os::TimeService::nsecs period = getControlPeriod();
+	connManager->setControlPeriod(period);
+	connManager->getDCSync()->setGains(dcSyncKp, dcSyncKi);
+	connManager->getDCSync()->setLockThreshold(dcSyncLockThreshold);
+	medullaManager.setControlPeriod(period);
+	medullaManager.setVelocityWindow(velocityWindow);
+	
+	if (virtualMaster) {
+		log(RTT::Info) << "[ECatConn] Using the virtual EtherCAT bus." << RTT::endlog();
+		virtualBus = new VirtualMaster(virtualConfig);
+		connManager->setMaster(virtualBus);
+	} else {
+		virtualBus = NULL;
+		connManager->setMaster(new SoemMaster(ECAT_INTERFACE, topologyCache));
+	}
 	
 	if (!connManager->configure()) {
 		log(RTT::Error) << "[ECatConn] ConnManager failed to configure!" << RTT::endlog();
@@ -40,6 +133,11 @@ bool ECatConn::configureHook() {
 }
 
 bool ECatConn::startHook() {
+	connManager->setPipelined(pipelinedTransmit);
+	connManager->setTransmitLead((transmitSyncLead > 0) ? transmitSyncLead : 0);
+	connManager->setSpinMargin((wakeupSpinMargin > 0) ? wakeupSpinMargin : 0);
+	connManager->setFrameLossHandling(frameRetries, frameLossHaltThreshold);
+	connManager->setSlaveRecovery(slaveRecovery);
 	if (!connManager->start()) {
 		log(RTT::Error) << "[ECatConn] ConnManager failed to start!" << RTT::endlog();
 		return false;
@@ -56,7 +154,7 @@ void ECatConn::stopHook() {
 	log(RTT::Info) << "[ECatConn] stopped." << RTT::endlog();
 }
 
-void ECatConn::sendControllerOutput(atrias_msgs::controller_output controller_output) {
+void ECatConn::sendControllerOutput(const atrias_msgs::controller_output &controller_output) {
 	connManager->sendControllerOutput(controller_output);
 	return;
 }
@@ -69,6 +167,31 @@ void ECatConn::disableSafeties() {
 	medullaManager.setRobotConfiguration(rtOps::RobotConfiguration::DISABLE);
 }
 
+atrias_msgs::ecat_frame_stats ECatConn::getFrameStats() {
+	return connManager->getFrameStats();
+}
+
+void ECatConn::resetFrameStats() {
+	connManager->resetFrameStats();
+}
+
+atrias_msgs::ecat_bringup ECatConn::getBringup() {
+	return connManager->getBringup();
+}
+
+atrias_msgs::ecat_slave_recovery ECatConn::getSlaveRecovery() {
+	return connManager->getSlaveRecovery();
+}
+
+void ECatConn::dropVirtualSlave(int slave) {
+	if (!virtualBus) {
+		log(RTT::Warning) << "[ECatConn] dropVirtualSlave: not on the virtual bus." << RTT::endlog();
+		return;
+	}
+	
+	virtualBus->dropSlave(slave);
+}
+
 ORO_CREATE_COMPONENT(ECatConn)
 
 }
@@ -0,0 +1,155 @@
+#include "atrias_ecat_conn/FrameMonitor.h"
+
+#include <string.h>
+
+#include <rtt/os/TimeService.hpp>
+
+#include <atrias_shared/globals.h>
+
+namespace atrias {
+
+namespace ecatConn {
+
+FrameMonitor::FrameMonitor() {
+	haltThreshold = 0;
+	configure(NULL, 0, 0);
+}
+
+void FrameMonitor::configure(ec_slavet* slave_array, int slave_count, int expected_wkc) {
+	slaves      = slave_array;
+	slaveCount  = (slave_count < FRAME_MONITOR_MAX_SLAVES) ? slave_count : FRAME_MONITOR_MAX_SLAVES;
+	expectedWKC = expected_wkc;
+	
+	size_t inputBytes = 0;
+	for (int i = 0; i < slaveCount; i++) {
+		inputOffsets[i] = inputBytes;
+		inputBytes     += slaves[i + 1].Ibytes;
+	}
+	lastInputs.assign(inputBytes, 0);
+	
+	reset();
+}
+
+void FrameMonitor::setHaltThreshold(uint32_t threshold) {
+	haltThreshold = threshold;
+}
+
+void FrameMonitor::reset() {
+	stats.frames            = 0;
+	stats.framesLost        = 0;
+	stats.framesIncomplete  = 0;
+	stats.retries           = 0;
+	stats.expectedWKC       = expectedWKC;
+	stats.lastWKC           = 0;
+	stats.consecutiveBad    = 0;
+	stats.maxConsecutiveBad = 0;
+	stats.numSlaves         = slaveCount;
+	for (size_t i = 0; i < FRAME_MONITOR_RUN_BUCKETS; i++)
+		stats.runLengths[i] = 0;
+	for (size_t i = 0; i < FRAME_MONITOR_MAX_SLAVES; i++) {
+		stats.slaveMissed[i]               = 0;
+		stats.slaveMaxConsecutiveMissed[i] = 0;
+		slaveConsecutive[i]                = 0;
+	}
+	haveInputs = false;
+	cycleBad   = false;
+}
+
+void FrameMonitor::endRun() {
+	uint32_t bucket = (stats.consecutiveBad < FRAME_MONITOR_RUN_BUCKETS) ?
+	                  stats.consecutiveBad : FRAME_MONITOR_RUN_BUCKETS;
+	stats.runLengths[bucket - 1]++;
+	stats.consecutiveBad = 0;
+}
+
+void FrameMonitor::slaveMissed(int slave) {
+	stats.slaveMissed[slave]++;
+	if (++slaveConsecutive[slave] > stats.slaveMaxConsecutiveMissed[slave])
+		stats.slaveMaxConsecutiveMissed[slave] = slaveConsecutive[slave];
+}
+
+bool FrameMonitor::check(int wkc, bool compare_inputs) {
+	stats.frames++;
+	stats.lastWKC = wkc;
+	
+	// A lost frame leaves the IO map alone, so there's nothing new to compare.
+	bool lost = (wkc <= EC_NOFRAME);
+	compare_inputs = compare_inputs && !lost;
+	
+	bool bad = (wkc != expectedWKC);
+	if (!bad) {
+		for (int i = 0; i < slaveCount; i++)
+			slaveConsecutive[i] = 0;
+	} else {
+		cycleBad = true;
+		
+		if (lost)
+			stats.framesLost++;
+		else
+			stats.framesIncomplete++;
+		
+		for (int i = 0; i < slaveCount; i++) {
+			if (lost) {
+				slaveMissed(i);
+				continue;
+			}
+			
+			// A Medulla that processed the frame changed its inputs, since
+			// its timing counter moves every period. One that didn't left
+			// the frame holding the inputs from last time.
+			if (!compare_inputs || !haveInputs || !slaves[i + 1].Ibytes)
+				continue;
+			
+			if (!memcmp(&lastInputs[inputOffsets[i]], slaves[i + 1].inputs, slaves[i + 1].Ibytes))
+				slaveMissed(i);
+			else
+				slaveConsecutive[i] = 0;
+		}
+	}
+	
+	if (compare_inputs) {
+		for (int i = 0; i < slaveCount; i++) {
+			if (slaves[i + 1].Ibytes)
+				memcpy(&lastInputs[inputOffsets[i]], slaves[i + 1].inputs, slaves[i + 1].Ibytes);
+		}
+		haveInputs = true;
+	}
+	
+	return bad;
+}
+
+bool FrameMonitor::endCycle() {
+	if (!cycleBad) {
+		if (stats.consecutiveBad > 0)
+			endRun();
+		return false;
+	}
+	cycleBad = false;
+	
+	if (++stats.consecutiveBad > stats.maxConsecutiveBad)
+		stats.maxConsecutiveBad = stats.consecutiveBad;
+	
+	return haltThreshold > 0 && stats.consecutiveBad == haltThreshold;
+}
+
+void FrameMonitor::recordRetry() {
+	stats.retries++;
+}
+
+uint32_t FrameMonitor::getConsecutiveBad() {
+	return stats.consecutiveBad;
+}
+
+void FrameMonitor::fillStats(atrias_msgs::ecat_frame_stats &frame_stats) {
+	RTT::os::TimeService::nsecs now = RTT::os::TimeService::Instance()->getNSecs();
+	
+	frame_stats = stats;
+	frame_stats.header.stamp.sec  = now / SECOND_IN_NANOSECONDS;
+	frame_stats.header.stamp.nsec = now % SECOND_IN_NANOSECONDS;
+}
+
+}
+
+}
+
+// vim: noexpandtab
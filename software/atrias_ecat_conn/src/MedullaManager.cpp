@@ -4,38 +4,20 @@ namespace atrias {
 
 namespace ecatConn {
 
-void MedullaManager::InputsConfig(uint8_t* slave_inputs, intptr_t* inputs_array, int num_entries) {
-	for (int i = 0; i < num_entries; i++) {
-		inputs_array[i] = (intptr_t) slave_inputs + i;
-	}
+MedullaManager::MedullaManager() {
+	controlPeriod = CONTROLLER_LOOP_PERIOD_NS;
 }
 
-void MedullaManager::OutputsConfig(uint8_t* slave_outputs, intptr_t* outputs_array, int num_entries) {
-	for (int i = 0; i < num_entries; i++) {
-		outputs_array[i] = (intptr_t) slave_outputs + i;
-	}
+void MedullaManager::setControlPeriod(int64_t control_period) {
+	controlPeriod = control_period;
 }
 
-MedullaManager::MedullaManager() {
-	lLegA   = NULL;
-	lLegB   = NULL;
-	rLegA   = NULL;
-	rLegB   = NULL;
-	boom    = NULL;
-	imu     = NULL;
-	lLegHip = NULL;
-	rLegHip = NULL;
+void MedullaManager::setVelocityWindow(int samples) {
+	medullas.setVelocityWindow(samples);
 }
 
 MedullaManager::~MedullaManager() {
-	delete(lLegA);
-	delete(lLegB);
-	delete(rLegA);
-	delete(rLegB);
-	delete(boom);
-	delete(imu);
-	delete(lLegHip);
-	delete(rLegHip);
+	medullas.clear();
 }
 
 void MedullaManager::slaveCardInit(ec_slavet slave) {
@@ -43,15 +25,15 @@ void MedullaManager::slaveCardInit(ec_slavet slave) {
 }
 
 rtOps::RobotConfiguration MedullaManager::calcRobotConfiguration() {
-	if (!lLegA || !lLegB) {
+	if (!medullas.hasLeg(MEDULLA_LEFT_LEG_A_ID) || !medullas.hasLeg(MEDULLA_LEFT_LEG_B_ID)) {
 		return rtOps::RobotConfiguration::UNKNOWN;
 	}
 	
 	// We have at least a left leg.
 	
-	if (!rLegA || !rLegB) {
+	if (!medullas.hasLeg(MEDULLA_RIGHT_LEG_A_ID) || !medullas.hasLeg(MEDULLA_RIGHT_LEG_B_ID)) {
 		// We are a monopod
-		if (lLegHip)
+		if (medullas.hasHip(MEDULLA_LEFT_HIP_ID))
 			return rtOps::RobotConfiguration::LEFT_LEG_HIP;
 		else
 			return rtOps::RobotConfiguration::LEFT_LEG_NOHIP;
@@ -59,111 +41,20 @@ rtOps::RobotConfiguration MedullaManager::calcRobotConfiguration() {
 	
 	// We are a biped
 	
-	if (!lLegHip || !rLegHip)
+	if (!medullas.hasHip(MEDULLA_LEFT_HIP_ID) || !medullas.hasHip(MEDULLA_RIGHT_HIP_ID))
 		return rtOps::RobotConfiguration::BIPED_NOHIP;
 	else
 		return rtOps::RobotConfiguration::BIPED_FULL;
 }
 
-void MedullaManager::initBoomMedulla(ec_slavet slave) {
-	delete(boom);
-	boom = new medullaDrivers::BoomMedulla();
-	fillInPDORegData(boom->getPDORegData(), (uint8_t*) slave.outputs, (uint8_t*) slave.inputs);
-	boom->postOpInit();
-	log(RTT::Info) << "Boom medulla identified. ID: " <<
-		(int) boom->getID() << RTT::endlog();
-}
-
-void MedullaManager::initImuMedulla(ec_slavet slave) {
-	delete(imu);
-	imu = new medullaDrivers::ImuMedulla();
-	fillInPDORegData(imu->getPDORegData(), (uint8_t*) slave.outputs, (uint8_t*) slave.inputs);
-	imu->postOpInit();
-	log(RTT::Info) << "IMU medulla identified. ID: " <<
-		(int) imu->getID() << RTT::endlog();
-}
-
-void MedullaManager::initHipMedulla(ec_slavet slave) {
-	medullaDrivers::HipMedulla* medulla =
-		new medullaDrivers::HipMedulla();
-	fillInPDORegData(medulla->getPDORegData(), (uint8_t*) slave.outputs, (uint8_t*) slave.inputs);
-	medulla->postOpInit();
-	log(RTT::Info) << "Hip medulla detected, ID: " <<
-		(int) medulla->getID() << RTT::endlog();
-	
-	switch (medulla->getID()) {
-		case MEDULLA_LEFT_HIP_ID:
-			log(RTT::Info) << "Left hip medulla identified" <<
-				RTT::endlog();
-			delete(lLegHip);
-			lLegHip = medulla;
-			break;
-		case MEDULLA_RIGHT_HIP_ID:
-			log(RTT::Info) << "Right hip medulla identified" <<
-				RTT::endlog();
-			delete(rLegHip);
-			rLegHip = medulla;
-			break;
-		default:
-			log(RTT::Warning) << "Hip medulla not identified."
-				<< RTT::endlog();
-			delete(medulla);
-			break;
-	}
-}
-
-void MedullaManager::initLegMedulla(ec_slavet slave) {
-	medullaDrivers::LegMedulla* medulla =
-		new medullaDrivers::LegMedulla();
-	fillInPDORegData(medulla->getPDORegData(), (uint8_t*) slave.outputs, (uint8_t*) slave.inputs);
-	medulla->postOpInit();
-	log(RTT::Info) << "Leg medulla detected, ID: " <<
-		(int) medulla->getID() << RTT::endlog();
-	
-	switch (medulla->getID()) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			log(RTT::Info) << "Left leg medulla A identified." << RTT::endlog();
-			delete(lLegA);
-			lLegA = medulla;
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			log(RTT::Info) << "Left leg medulla B identified." << RTT::endlog();
-			delete(lLegB);
-			lLegB = medulla;
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			log(RTT::Info) << "Right leg medulla A identified." << RTT::endlog();
-			delete(rLegA);
-			rLegA = medulla;
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			log(RTT::Info) << "Right leg medulla B identified." << RTT::endlog();
-			delete(rLegB);
-			rLegB = medulla;
-			break;
-		default:
-			log(RTT::Warning) << "Leg medulla not identified." << RTT::endlog();
-			delete(medulla);
-			break;
-	}
-}
-
-void MedullaManager::fillInPDORegData(medullaDrivers::PDORegData pdo_reg_data,
-                                      uint8_t* outputs, uint8_t* inputs) {
-	uint8_t* cur_ptr = outputs;
-	for (int i = 0; i < pdo_reg_data.outputs; i++) {
-		*(pdo_reg_data.pdoEntryDatas[i].data) = cur_ptr;
-		cur_ptr += pdo_reg_data.pdoEntryDatas[i].size;
-	}
-	
-	cur_ptr = inputs;
-	for (int i = pdo_reg_data.outputs; i < pdo_reg_data.outputs + pdo_reg_data.inputs; i++) {
-		*(pdo_reg_data.pdoEntryDatas[i].data) = cur_ptr;
-		cur_ptr += pdo_reg_data.pdoEntryDatas[i].size;
-	}
+bool MedullaManager::reinitMedulla(ec_slavet slave, int position, RTT::os::Mutex &lock) {
+	return medullas.reinit(slave, position, lock);
 }
 
 void MedullaManager::medullasInit(ec_slavet slaves[], int slavecount) {
+	medullas.clear();
+	medullas.setControlPeriod(controlPeriod);
+	
 	// SOEM is 1-indexed.
 	for (int i = 1; i <= slavecount; i++) {
 		if (slaves[i].eep_man != MEDULLA_VENDOR_ID) {
@@ -173,34 +64,14 @@ void MedullaManager::medullasInit(ec_slavet slaves[], int slavecount) {
 			continue;
 		}
 		
-		switch(slaves[i].eep_id) {
-			case MEDULLA_LEG_PRODUCT_CODE: {
-				initLegMedulla(slaves[i]);
-				break;
-			}
-			
-			case MEDULLA_BOOM_PRODUCT_CODE: {
-				initBoomMedulla(slaves[i]);
-				break;
-			}
-
-			case MEDULLA_IMU_PRODUCT_CODE: {
-				initImuMedulla(slaves[i]);
-				break;
-			}
-			
-			case MEDULLA_HIP_PRODUCT_CODE: {
-				initHipMedulla(slaves[i]);
-				break;
-			}
-			
-			default: {
-				log(RTT::Warning) <<
-					"Unrecognized product code at 1-indexed position: "
-					<< i << RTT::endlog();
-			}
+		if (!medullas.add(slaves[i], i)) {
+			log(RTT::Warning) <<
+				"Unrecognized or unused Medulla at 1-indexed position: "
+				<< i << RTT::endlog();
 		}
 	}
+	log(RTT::Info) << "[ECatConn] " << medullas.size() << " Medullas registered; legs decoded with "
+		<< medullaDrivers::LegBatch::getInstructionSet() << "." << RTT::endlog();
 	setRobotConfiguration(calcRobotConfiguration());
 }
 
@@ -215,41 +86,11 @@ void MedullaManager::start(ec_slavet slaves[], int slavecount) {
 }
 
 void MedullaManager::processReceiveData() {
-	if (lLegA)
-		lLegA->processReceiveData(robotState);
-	if (lLegB)
-		lLegB->processReceiveData(robotState);
-	if (rLegA)
-		rLegA->processReceiveData(robotState);
-	if (rLegB)
-		rLegB->processReceiveData(robotState);
-	if (boom)
-		boom->processReceiveData(robotState);
-	if (imu)
-		imu->processReceiveData(robotState);
-	if (lLegHip)
-		lLegHip->processReceiveData(robotState);
-	if (rLegHip)
-		rLegHip->processReceiveData(robotState);
+	medullas.processReceiveData(robotState);
 }
 
-void MedullaManager::processTransmitData(atrias_msgs::controller_output& controller_output) {
-	if (lLegA)
-		lLegA->processTransmitData(controller_output);
-	if (lLegB)
-		lLegB->processTransmitData(controller_output);
-	if (rLegA)
-		rLegA->processTransmitData(controller_output);
-	if (rLegB)
-		rLegB->processTransmitData(controller_output);
-	if (boom)
-		boom->processTransmitData(controller_output);
-	if (imu)
-		imu->processTransmitData(controller_output);
-	if (lLegHip)
-		lLegHip->processTransmitData(controller_output);
-	if (rLegHip)
-		rLegHip->processTransmitData(controller_output);
+void MedullaManager::processTransmitData(const atrias_msgs::controller_output& controller_output) {
+	medullas.processTransmitData(controller_output);
 }
 
 void MedullaManager::setTimingInfo(atrias_msgs::robot_state_timing& timing_info) {
@@ -0,0 +1,198 @@
+#include "atrias_ecat_conn/MedullaRegistry.h"
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief Returns whether a driver found where its data goes.
+  * Only legs and hips look it up from their IDs; the rest always know.
+  */
+template <class Driver>
+static bool isMapped(Driver* medulla) {
+	return true;
+}
+
+static bool isMapped(medullaDrivers::LegMedulla* medulla) {
+	return medulla->isMapped();
+}
+
+static bool isMapped(medullaDrivers::HipMedulla* medulla) {
+	return medulla->isMapped();
+}
+
+/** @brief Returns whether the robot state has room for only one driver of a type.
+  * Legs and hips each have their own place, found from their IDs; the boom
+  * and the IMU always write the same fields.
+  */
+template <class Driver>
+static bool isSingle(Driver* medulla) {
+	return false;
+}
+
+static bool isSingle(medullaDrivers::BoomMedulla* medulla) {
+	return true;
+}
+
+static bool isSingle(medullaDrivers::ImuMedulla* medulla) {
+	return true;
+}
+
+/** @brief Points a driver's PDO entries at a slave's process data.
+  * @param pdo_reg_data The driver's PDO entries.
+  * @param outputs      The slave's outputs.
+  * @param inputs       The slave's inputs.
+  */
+static void fillInPDORegData(medullaDrivers::PDORegData pdo_reg_data,
+                             uint8_t* outputs, uint8_t* inputs) {
+	uint8_t* cur_ptr = outputs;
+	for (int i = 0; i < pdo_reg_data.outputs; i++) {
+		*(pdo_reg_data.pdoEntryDatas[i].data) = cur_ptr;
+		cur_ptr += pdo_reg_data.pdoEntryDatas[i].size;
+	}
+
+	cur_ptr = inputs;
+	for (int i = pdo_reg_data.outputs; i < pdo_reg_data.outputs + pdo_reg_data.inputs; i++) {
+		*(pdo_reg_data.pdoEntryDatas[i].data) = cur_ptr;
+		cur_ptr += pdo_reg_data.pdoEntryDatas[i].size;
+	}
+}
+
+template <class Driver>
+bool MedullaGroup<Driver>::replace(int slave, Driver* medulla, RTT::os::Mutex &lock) {
+	Driver* old = NULL;
+	{
+		RTT::os::MutexLock locked(lock);
+		medulla->postOpInit();
+		for (size_t i = 0; i < slaves.size(); i++) {
+			if (slaves[i] != slave || !isMapped(medulla) || drivers[i]->getID() != medulla->getID())
+				continue;
+
+			old        = drivers[i];
+			drivers[i] = medulla;
+			break;
+		}
+	}
+
+	if (!old) {
+		delete(medulla);
+		return false;
+	}
+
+	delete(old);
+	return true;
+}
+
+MedullaRegistry::MedullaRegistry() {
+	controlPeriod  = CONTROLLER_LOOP_PERIOD_NS;
+	batchLegs      = true;
+	velocityWindow = VELOCITY_ESTIMATOR_DEFAULT_WINDOW;
+}
+
+void MedullaRegistry::setControlPeriod(int64_t control_period) {
+	controlPeriod = control_period;
+}
+
+void MedullaRegistry::setLegBatching(bool batch) {
+	batchLegs = batch;
+}
+
+void MedullaRegistry::setVelocityWindow(int samples) {
+	velocityWindow = samples;
+}
+
+template <class Driver>
+Driver* MedullaRegistry::createMedulla(ec_slavet &slave) {
+	Driver* medulla = new Driver();
+	medulla->setControlPeriod(controlPeriod);
+	medulla->setVelocityWindow(velocityWindow);
+	fillInPDORegData(medulla->getPDORegData(), (uint8_t*) slave.outputs, (uint8_t*) slave.inputs);
+	return medulla;
+}
+
+template <class Driver>
+bool MedullaRegistry::addMedulla(MedullaGroup<Driver> &group, ec_slavet &slave,
+                                 int position, const char* type) {
+	Driver* medulla = createMedulla<Driver>(slave);
+	medulla->postOpInit();
+
+	if (!isMapped(medulla)) {
+		log(RTT::Warning) << type << " medulla at slave " << position
+			<< " not identified. ID: " << (int) medulla->getID() << RTT::endlog();
+		delete(medulla);
+		return false;
+	}
+
+	if (isSingle(medulla) && group.size() > 0) {
+		log(RTT::Warning) << type << " medulla at slave " << position
+			<< " ignored: there's already one, and it would overwrite that one's "
+			<< "robot state." << RTT::endlog();
+		delete(medulla);
+		return false;
+	}
+
+	log(RTT::Info) << type << " medulla identified at slave " << position
+		<< ". ID: " << (int) medulla->getID() << RTT::endlog();
+	group.add(medulla, position);
+	return true;
+}
+
+bool MedullaRegistry::add(ec_slavet slave, int position) {
+	if (slave.eep_man != MEDULLA_VENDOR_ID)
+		return false;
+
+	switch (slave.eep_id) {
+		case MEDULLA_LEG_PRODUCT_CODE:
+			return addMedulla(legs,  slave, position, "Leg");
+		case MEDULLA_HIP_PRODUCT_CODE:
+			return addMedulla(hips,  slave, position, "Hip");
+		case MEDULLA_BOOM_PRODUCT_CODE:
+			return addMedulla(booms, slave, position, "Boom");
+		case MEDULLA_IMU_PRODUCT_CODE:
+			return addMedulla(imus,  slave, position, "IMU");
+	}
+
+	return false;
+}
+
+bool MedullaRegistry::reinit(ec_slavet slave, int position, RTT::os::Mutex &lock) {
+	if (slave.eep_man != MEDULLA_VENDOR_ID)
+		return false;
+
+	switch (slave.eep_id) {
+		case MEDULLA_LEG_PRODUCT_CODE:
+			return legs.replace(position,  createMedulla<medullaDrivers::LegMedulla>(slave),  lock);
+		case MEDULLA_HIP_PRODUCT_CODE:
+			return hips.replace(position,  createMedulla<medullaDrivers::HipMedulla>(slave),  lock);
+		case MEDULLA_BOOM_PRODUCT_CODE:
+			return booms.replace(position, createMedulla<medullaDrivers::BoomMedulla>(slave), lock);
+		case MEDULLA_IMU_PRODUCT_CODE:
+			return imus.replace(position,  createMedulla<medullaDrivers::ImuMedulla>(slave),  lock);
+	}
+
+	return false;
+}
+
+void MedullaRegistry::clear() {
+	legs.clear();
+	hips.clear();
+	booms.clear();
+	imus.clear();
+}
+
+bool MedullaRegistry::hasLeg(uint8_t id) {
+	return legs.hasID(id);
+}
+
+bool MedullaRegistry::hasHip(uint8_t id) {
+	return hips.hasID(id);
+}
+
+size_t MedullaRegistry::size() {
+	return legs.size() + hips.size() + booms.size() + imus.size();
+}
+
+}
+
+}
+
+// vim: noexpandtab
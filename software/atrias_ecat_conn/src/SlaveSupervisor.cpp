@@ -0,0 +1,145 @@
+#include "atrias_ecat_conn/SlaveSupervisor.h"
+#include "atrias_ecat_conn/ECatConn.h"
+
+#include <atrias_shared/globals.h>
+
+namespace atrias {
+
+namespace ecatConn {
+
+SlaveSupervisor::SlaveSupervisor(ECatConn* ecat_conn, RTT::os::Mutex &ecat_lock) :
+                 RTT::Activity(ORO_SCHED_OTHER, 0, SLAVE_SUPERVISOR_PERIOD, 0, "ECatSupervisor"),
+                 eCatLock(ecat_lock) {
+	eCatConn   = ecat_conn;
+	master     = NULL;
+	syncPeriod = 0;
+	syncShift  = 0;
+	checkRequested.store(false);
+}
+
+void SlaveSupervisor::setMaster(ECatMaster* ecat_master) {
+	master = ecat_master;
+}
+
+void SlaveSupervisor::setSync0(int64_t cycle_time, int64_t shift) {
+	syncPeriod = cycle_time;
+	syncShift  = shift;
+}
+
+void SlaveSupervisor::requestCheck() {
+	checkRequested.store(true, std::memory_order_relaxed);
+}
+
+atrias_msgs::ecat_slave_recovery SlaveSupervisor::getStatus() {
+	RTT::os::MutexLock lock(statusLock);
+	return status;
+}
+
+bool SlaveSupervisor::initialize() {
+	if (!master)
+		return false;
+	
+	RTT::os::MutexLock lock(statusLock);
+	int slaveCount   = master->getSlaveCount();
+	status.numSlaves = (slaveCount < SLAVE_SUPERVISOR_MAX_SLAVES) ? slaveCount : SLAVE_SUPERVISOR_MAX_SLAVES;
+	for (size_t i = 0; i < SLAVE_SUPERVISOR_MAX_SLAVES; i++) {
+		status.state[i]          = EC_STATE_OPERATIONAL;
+		status.dropouts[i]       = 0;
+		status.recoveries[i]     = 0;
+		status.lastRecoveryMs[i] = 0.0;
+		status.maxRecoveryMs[i]  = 0.0;
+		recovering[i]            = false;
+	}
+	
+	lastCheck = RTT::os::TimeService::Instance()->getNSecs();
+	checkRequested.store(false);
+	return true;
+}
+
+void SlaveSupervisor::slaveRecovered(int slave, RTT::os::TimeService::nsecs now) {
+	ec_slavet* slaves = master->getSlaves();
+	
+	// Reconfiguring a slave doesn't restore its DC setup.
+	master->configureSync0(slave, syncPeriod, syncShift);
+	
+	if (!eCatConn->getMedullaManager()->reinitMedulla(slaves[slave], slave, eCatLock)) {
+		log(RTT::Warning) << "[ECatConn] Slave " << slave
+			<< " is back in OP, but isn't a Medulla we know." << RTT::endlog();
+	}
+	
+	double recoveryMs = (now - dropTime[slave - 1]) / 1000000.0;
+	{
+		RTT::os::MutexLock lock(statusLock);
+		status.recoveries[slave - 1]++;
+		status.lastRecoveryMs[slave - 1] = recoveryMs;
+		if (recoveryMs > status.maxRecoveryMs[slave - 1])
+			status.maxRecoveryMs[slave - 1] = recoveryMs;
+	}
+	recovering[slave - 1] = false;
+	
+	log(RTT::Info) << "[ECatConn] Slave " << slave << " (" << slaves[slave].name
+		<< ") recovered after " << recoveryMs << " ms." << RTT::endlog();
+}
+
+void SlaveSupervisor::step() {
+	RTT::os::TimeService::nsecs now = RTT::os::TimeService::Instance()->getNSecs();
+	
+	bool anyRecovering = false;
+	for (int i = 0; i < status.numSlaves; i++)
+		anyRecovering = anyRecovering || recovering[i];
+	
+	// Frames only come back short when some slave isn't in OP, so unless
+	// the ECat loop saw one (or we're mid-recovery) an occasional look will do.
+	if (!checkRequested.exchange(false) && !anyRecovering &&
+	    now - lastCheck < SLAVE_SUPERVISOR_CHECK_NS)
+		return;
+	lastCheck = now;
+	
+	if (master->readStates() && !anyRecovering)
+		return;
+	
+	ec_slavet* slaves  = master->getSlaves();
+	bool       changed = false;
+	for (int i = 1; i <= status.numSlaves; i++) {
+		{
+			RTT::os::MutexLock lock(statusLock);
+			status.state[i - 1] = slaves[i].state;
+		}
+		
+		if (slaves[i].state == EC_STATE_OPERATIONAL) {
+			if (recovering[i - 1]) {
+				slaveRecovered(i, now);
+				changed = true;
+			}
+			continue;
+		}
+		
+		if (!recovering[i - 1]) {
+			recovering[i - 1] = true;
+			dropTime[i - 1]   = now;
+			{
+				RTT::os::MutexLock lock(statusLock);
+				status.dropouts[i - 1]++;
+			}
+			changed = true;
+			log(RTT::Warning) << "[ECatConn] Slave " << i << " (" << slaves[i].name
+				<< ") dropped out of OP; state 0x" << std::hex << (int) slaves[i].state
+				<< std::dec << ". Recovering it." << RTT::endlog();
+		}
+		
+		master->recoverSlave(i);
+	}
+	
+	if (changed) {
+		atrias_msgs::ecat_slave_recovery msg = getStatus();
+		msg.header.stamp.sec  = now / SECOND_IN_NANOSECONDS;
+		msg.header.stamp.nsec = now % SECOND_IN_NANOSECONDS;
+		eCatConn->slaveRecoveryOut.write(msg);
+	}
+}
+
+}
+
+}
+
+// vim: noexpandtab
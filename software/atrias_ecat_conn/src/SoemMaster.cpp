@@ -0,0 +1,243 @@
+#include "atrias_ecat_conn/SoemMaster.h"
+
+#include <stdio.h>
+
+#include <rtt/Logger.hpp>
+#include <rtt/os/TimeService.hpp>
+
+// How long to wait on each frame while reconfiguring a slave, in microseconds.
+#define EC_TIMEOUTMON 500
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief Returns the time since an earlier time.
+  * @param start The earlier time, from TimeService.
+  * @return The elapsed time, in milliseconds.
+  */
+static float msSince(RTT::os::TimeService::nsecs start) {
+	return (RTT::os::TimeService::Instance()->getNSecs() - start) / 1000000.0;
+}
+
+SoemMaster::SoemMaster(const std::string &interface_name, const std::string &cache_path) :
+            ifname(interface_name),
+            open(false),
+            topologyCache(cache_path) {
+}
+
+bool SoemMaster::mapBus(char* io_map, size_t io_map_size, bool use_cache,
+                        atrias_msgs::ecat_bringup &bringup) {
+	// This also takes every slave back to INIT and clears out anything a
+	// previous attempt left in ec_slave.
+	RTT::os::TimeService::nsecs phaseStart = RTT::os::TimeService::Instance()->getNSecs();
+	ec_config_init(FALSE);
+	if (ec_slavecount < 1)
+		return false;
+	bringup.findSlavesMs += msSince(phaseStart);
+
+	phaseStart = RTT::os::TimeService::Instance()->getNSecs();
+	ec_configdc();
+	bringup.configDCMs += msSince(phaseStart);
+
+	// With the sizes already filled in, ec_config_map() doesn't read the
+	// slaves' PDO mappings out of their EEPROMs.
+	phaseStart = RTT::os::TimeService::Instance()->getNSecs();
+	bringup.topologyCacheHit = use_cache && topologyCache.load() &&
+	                           topologyCache.matches(ec_slave, ec_slavecount);
+	if (bringup.topologyCacheHit)
+		topologyCache.seed(ec_slave, ec_slavecount);
+
+	if (ec_config_map(io_map) > (int) io_map_size) {
+		log(RTT::Error) << "[ECatConn] SoemMaster: process data overflowed the IO map!"
+			<< RTT::endlog();
+		return false;
+	}
+	bringup.mapMs += msSince(phaseStart);
+
+	// Wait for SAFE-OP
+	phaseStart = RTT::os::TimeService::Instance()->getNSecs();
+	ec_statecheck(0, EC_STATE_SAFE_OP,  EC_TIMEOUTSTATE * 4);
+	bringup.safeOpMs += msSince(phaseStart);
+
+	return true;
+}
+
+bool SoemMaster::configure(char* io_map, size_t io_map_size, atrias_msgs::ecat_bringup &bringup) {
+	RTT::os::TimeService::nsecs phaseStart = RTT::os::TimeService::Instance()->getNSecs();
+
+	// ec_init() wants a non-const string.
+	char ifbuf[64];
+	snprintf(ifbuf, sizeof(ifbuf), "%s", ifname.c_str());
+	if (!ec_init(ifbuf)) {
+		log(RTT::Error) << "[ECatConn] SoemMaster: ec_init() failed on "
+			<< ifname << "!" << RTT::endlog();
+		return false;
+	}
+	open = true;
+
+	bringup.findSlavesMs = msSince(phaseStart);
+	bringup.configDCMs   = 0.0;
+	bringup.mapMs        = 0.0;
+	bringup.safeOpMs     = 0.0;
+	if (!mapBus(io_map, io_map_size, true, bringup))
+		return false;
+
+	// The slaves check their sync manager sizes on the way to SAFE-OP,
+	// which catches a cache that's out of date. Start over without it.
+	if (ec_slave[0].state != EC_STATE_SAFE_OP && bringup.topologyCacheHit) {
+		topologyCache.invalidate();
+		log(RTT::Warning) << "[ECatConn] SoemMaster: the slaves rejected the cached "
+			<< "topology; deleted it and reading their PDO mappings instead." << RTT::endlog();
+		if (!mapBus(io_map, io_map_size, false, bringup))
+			return false;
+	}
+
+	if (ec_slave[0].state != EC_STATE_SAFE_OP) {
+		log(RTT::Warning) << "[ECatConn] SoemMaster: not every slave reached SAFE-OP."
+			<< RTT::endlog();
+	} else if (!bringup.topologyCacheHit) {
+		topologyCache.save(ec_slave, ec_slavecount);
+	}
+
+	return true;
+}
+
+int SoemMaster::getSlaveCount() {
+	return ec_slavecount;
+}
+
+ec_slavet* SoemMaster::getSlaves() {
+	return ec_slave;
+}
+
+void SoemMaster::setOperational() {
+	ec_slave[0].state = EC_STATE_OPERATIONAL;
+
+	ec_writestate(0);
+	ec_statecheck(0, EC_STATE_OPERATIONAL,  EC_TIMEOUTSTATE);
+}
+
+void SoemMaster::configureSync0(int slave, int64_t cycle_time, int64_t shift) {
+	ec_dcsync0(slave, true, cycle_time, shift);
+}
+
+int64_t SoemMaster::configureSync0All(int64_t cycle_time, int64_t shift) {
+	// This is ec_dcsync0() for every slave at once: broadcast writes, with
+	// the start time taken from the reference clock. The slaves' clocks are
+	// all synchronized to it, so they all start on the same edge.
+	uint8_t  activation = 0;
+	uint8_t  control    = 0;
+	int64_t  refTime    = 0;
+	for (int i = 1; i <= ec_slavecount; i++) {
+		if (!ec_slave[i].hasdc)
+			continue;
+
+		ec_FPRD(ec_slave[i].configadr, ECT_REG_DCSYSTIME, sizeof(refTime), &refTime, EC_TIMEOUTRET);
+		refTime = etohll(refTime);
+		break;
+	}
+
+	int64_t start = ((refTime + SYNC0_START_DELAY_NS) / cycle_time) * cycle_time
+	                + cycle_time + shift;
+	int64_t  startLE = htoell(start);
+	uint32_t cycleLE = htoel((uint32_t) cycle_time);
+
+	// Stop SYNC0, give ourselves control of it, and set it up.
+	ec_BWR(0, ECT_REG_DCSYNCACT, sizeof(activation), &activation, EC_TIMEOUTRET);
+	ec_BWR(0, ECT_REG_DCCUC,     sizeof(control),    &control,    EC_TIMEOUTRET);
+	ec_BWR(0, ECT_REG_DCSTART0,  sizeof(startLE),    &startLE,    EC_TIMEOUTRET);
+	ec_BWR(0, ECT_REG_DCCYCLE0,  sizeof(cycleLE),    &cycleLE,    EC_TIMEOUTRET);
+
+	// Cyclic operation, with SYNC0.
+	activation = 1 + 2;
+	ec_BWR(0, ECT_REG_DCSYNCACT, sizeof(activation), &activation, EC_TIMEOUTRET);
+
+	return start;
+}
+
+int64_t SoemMaster::getDCOffset() {
+	int64_t maxOffset = 0;
+	for (int i = 1; i <= ec_slavecount; i++) {
+		if (!ec_slave[i].hasdc)
+			continue;
+
+		// Sign and magnitude: bit 31 is the sign.
+		uint32_t diff = 0;
+		ec_FPRD(ec_slave[i].configadr, ECT_REG_DCSYSDIFF, sizeof(diff), &diff, EC_TIMEOUTRET);
+		int64_t offset = etohl(diff) & 0x7fffffff;
+		if (offset > maxOffset)
+			maxOffset = offset;
+	}
+
+	return maxOffset;
+}
+
+void SoemMaster::sendProcessData() {
+	ec_send_processdata();
+}
+
+int SoemMaster::receiveProcessData(int timeout_us) {
+	return ec_receive_processdata(timeout_us);
+}
+
+int SoemMaster::getExpectedWKC() {
+	// Logical read/writes count 2 for each slave written and 1 for each slave read.
+	return ec_group[0].outputsWKC * 2 + ec_group[0].inputsWKC;
+}
+
+int64_t SoemMaster::getDCTime() {
+	return ec_DCtime;
+}
+
+bool SoemMaster::readStates() {
+	return ec_readstate() == EC_STATE_OPERATIONAL;
+}
+
+void SoemMaster::recoverSlave(int slave) {
+	// This follows ecatcheck() in ethercat/soem_test/simple_test.c.
+	ec_slavet &s = ec_slave[slave];
+	if (s.state == EC_STATE_SAFE_OP + EC_STATE_ERROR) {
+		// Acknowledge the error; it'll come back in SAFE-OP.
+		s.state = EC_STATE_SAFE_OP + EC_STATE_ACK;
+		ec_writestate(slave);
+	} else if (s.state == EC_STATE_SAFE_OP) {
+		s.state = EC_STATE_OPERATIONAL;
+		ec_writestate(slave);
+	} else if (s.state > EC_STATE_NONE) {
+		// It fell back further (e.g. it reset); redo its mailbox and mapping setup.
+		if (ec_reconfig_slave(slave, EC_TIMEOUTMON))
+			s.islost = FALSE;
+	} else if (!s.islost) {
+		// It didn't answer; make sure it's really gone.
+		ec_statecheck(slave, EC_STATE_OPERATIONAL, EC_TIMEOUTRET);
+		if (s.state == EC_STATE_NONE)
+			s.islost = TRUE;
+	}
+
+	if (s.islost) {
+		if (s.state == EC_STATE_NONE) {
+			// Look for it again at its old address.
+			if (ec_recover_slave(slave, EC_TIMEOUTMON))
+				s.islost = FALSE;
+		} else {
+			s.islost = FALSE;
+		}
+	}
+}
+
+void SoemMaster::close() {
+	if (!open)
+		return;
+
+	ec_slave[0].state = EC_STATE_INIT;
+	ec_writestate(0);
+	ec_close();
+	open = false;
+}
+
+}
+
+}
+
+// vim: noexpandtab
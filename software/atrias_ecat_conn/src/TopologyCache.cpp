@@ -0,0 +1,112 @@
+#include "atrias_ecat_conn/TopologyCache.h"
+
+#include <stdio.h>
+
+#include <rtt/Logger.hpp>
+
+namespace atrias {
+
+namespace ecatConn {
+
+TopologyCache::TopologyCache(const std::string &cache_path) :
+               path(cache_path) {
+}
+
+bool TopologyCache::load() {
+	entries.clear();
+	if (path.empty())
+		return false;
+	
+	FILE *file = fopen(path.c_str(), "r");
+	if (!file)
+		return false;
+	
+	unsigned int version;
+	int          count;
+	bool         ok = fscanf(file, "atrias_ecat_topology %u %d", &version, &count) == 2 &&
+	                  version == TOPOLOGY_CACHE_VERSION && count > 0;
+	
+	for (int i = 0; ok && i < count; i++) {
+		Entry entry;
+		ok = fscanf(file, "%x %x %x %u %u", &entry.vendor, &entry.productCode,
+		            &entry.revision, &entry.outputBits, &entry.inputBits) == 5;
+		entries.push_back(entry);
+	}
+	fclose(file);
+	
+	if (!ok) {
+		log(RTT::Warning) << "[ECatConn] Ignoring unreadable topology cache "
+			<< path << "." << RTT::endlog();
+		entries.clear();
+	}
+	
+	return ok;
+}
+
+bool TopologyCache::matches(ec_slavet* slaves, int slave_count) {
+	if ((int) entries.size() != slave_count)
+		return false;
+	
+	for (int i = 0; i < slave_count; i++) {
+		const Entry &entry = entries[i];
+		ec_slavet   &slave = slaves[i + 1];
+		if (entry.vendor      != slave.eep_man ||
+		    entry.productCode != slave.eep_id  ||
+		    entry.revision    != slave.eep_rev)
+			return false;
+	}
+	
+	return true;
+}
+
+void TopologyCache::seed(ec_slavet* slaves, int slave_count) {
+	for (int i = 0; i < slave_count && i < (int) entries.size(); i++) {
+		slaves[i + 1].Obits = entries[i].outputBits;
+		slaves[i + 1].Ibits = entries[i].inputBits;
+		
+		// ec_config_map() only reads the PDO mapping from slaves that
+		// ec_config_init() didn't find in its configuration list. Marking
+		// them as found makes it use the sizes above instead.
+		slaves[i + 1].configindex = TOPOLOGY_CACHE_CONFIG_INDEX;
+	}
+}
+
+void TopologyCache::invalidate() {
+	entries.clear();
+	if (!path.empty())
+		remove(path.c_str());
+}
+
+bool TopologyCache::save(ec_slavet* slaves, int slave_count) {
+	entries.clear();
+	for (int i = 1; i <= slave_count; i++) {
+		Entry entry = {slaves[i].eep_man, slaves[i].eep_id, slaves[i].eep_rev,
+		               slaves[i].Obits, slaves[i].Ibits};
+		entries.push_back(entry);
+	}
+	
+	if (path.empty())
+		return false;
+	
+	FILE *file = fopen(path.c_str(), "w");
+	if (!file) {
+		log(RTT::Warning) << "[ECatConn] Couldn't write topology cache "
+			<< path << "." << RTT::endlog();
+		return false;
+	}
+	
+	bool ok = fprintf(file, "atrias_ecat_topology %u %d\n", TOPOLOGY_CACHE_VERSION, slave_count) > 0;
+	for (size_t i = 0; ok && i < entries.size(); i++) {
+		ok = fprintf(file, "%08x %08x %08x %u %u\n", entries[i].vendor, entries[i].productCode,
+		             entries[i].revision, entries[i].outputBits, entries[i].inputBits) > 0;
+	}
+	ok = (fclose(file) == 0) && ok;
+	
+	return ok;
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -0,0 +1,322 @@
+#include "atrias_ecat_conn/VirtualMaster.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rtt/Logger.hpp>
+
+#include <atrias_shared/globals.h>
+
+// How long each recovery step takes, standing in for mailbox and state
+// transition traffic. In nanoseconds.
+#define VIRTUAL_RECOVERY_STEP_NS 20000000
+
+// The emulated slave clocks start this far (in nanoseconds) from the
+// reference clock, and close the gap with this time constant.
+#define VIRTUAL_DC_INITIAL_OFFSET_NS 20000
+#define VIRTUAL_DC_SETTLE_TAU_NS     30000000
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief The Medullas the virtual bus knows how to emulate.
+  */
+static const struct {
+	const char* name;
+	uint32_t    productCode;
+	uint8_t     id;
+} VIRTUAL_MEDULLAS[] = {
+	{"lLegA", MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_A_ID},
+	{"lLegB", MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_B_ID},
+	{"lHip",  MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_LEFT_HIP_ID},
+	{"rLegA", MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_A_ID},
+	{"rLegB", MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_B_ID},
+	{"rHip",  MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_RIGHT_HIP_ID},
+	{"boom",  MEDULLA_BOOM_PRODUCT_CODE, MEDULLA_BOOM_ID},
+	{"imu",   MEDULLA_IMU_PRODUCT_CODE,  MEDULLA_IMU_ID},
+};
+
+VirtualMaster::VirtualMaster(const VirtualMasterConfig &master_config) :
+               config(master_config) {
+	expectedWKC     = 0;
+	frameWKC        = 0;
+	clockStart      = hostTime();
+	configureTime   = clockStart;
+	dcTime          = clockStart;
+	frameDCTime     = clockStart;
+	frameReturnTime = clockStart;
+	framePending    = false;
+	frameDropped    = false;
+	ioInputs        = NULL;
+	randSeed        = 1;
+}
+
+VirtualMaster::~VirtualMaster() {
+	clearMedullas();
+}
+
+int64_t VirtualMaster::hostTime() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((int64_t) now.tv_sec) * SECOND_IN_NANOSECONDS + now.tv_nsec;
+}
+
+int64_t VirtualMaster::toDCTime(int64_t host_time) {
+	int64_t elapsed = host_time - clockStart;
+	return clockStart + elapsed + (int64_t) (elapsed * config.driftPpm / 1000000.0);
+}
+
+bool VirtualMaster::addMedulla(const std::string &name) {
+	for (size_t i = 0; i < sizeof(VIRTUAL_MEDULLAS) / sizeof(VIRTUAL_MEDULLAS[0]); i++) {
+		if (name != VIRTUAL_MEDULLAS[i].name)
+			continue;
+
+		medullas.push_back(new VirtualMedulla(VIRTUAL_MEDULLAS[i].productCode,
+		                                      VIRTUAL_MEDULLAS[i].id));
+
+		ec_slavet slave;
+		memset(&slave, 0, sizeof(slave));
+		snprintf(slave.name, sizeof(slave.name), "Virtual %s", VIRTUAL_MEDULLAS[i].name);
+		slave.eep_man   = MEDULLA_VENDOR_ID;
+		slave.eep_id    = VIRTUAL_MEDULLAS[i].productCode;
+		slave.configadr = 0x1000 + slaves.size();
+		slaves.push_back(slave);
+		return true;
+	}
+
+	return false;
+}
+
+void VirtualMaster::clearMedullas() {
+	for (size_t i = 0; i < medullas.size(); i++)
+		delete medullas[i];
+	medullas.clear();
+}
+
+bool VirtualMaster::configure(char* io_map, size_t io_map_size, atrias_msgs::ecat_bringup &bringup) {
+	int64_t phaseStart = hostTime();
+	clearMedullas();
+
+	// Slave 0 stands for the whole bus, as in SOEM.
+	slaves.assign(1, ec_slavet());
+
+	size_t start = 0;
+	while (start <= config.slaves.size()) {
+		size_t end = config.slaves.find(',', start);
+		if (end == std::string::npos)
+			end = config.slaves.size();
+
+		std::string name = config.slaves.substr(start, end - start);
+		name.erase(0, name.find_first_not_of(" \t"));
+		name.erase(name.find_last_not_of(" \t") + 1);
+		if (!name.empty() && !addMedulla(name)) {
+			log(RTT::Warning) << "[ECatConn] VirtualMaster: unknown Medulla \""
+				<< name << "\"; skipping it." << RTT::endlog();
+		}
+
+		start = end + 1;
+	}
+
+	if (medullas.empty())
+		return false;
+	bringup.findSlavesMs = (hostTime() - phaseStart) / 1000000.0;
+
+	// There's no DC setup, SII to read, or state change to wait for.
+	phaseStart = hostTime();
+
+	// Lay out the IO map like ec_config_map() does: all the outputs, then all the inputs.
+	size_t outputBytes = 0;
+	size_t inputBytes  = 0;
+	for (size_t i = 0; i < medullas.size(); i++) {
+		outputBytes += medullas[i]->getOutputBytes();
+		inputBytes  += medullas[i]->getInputBytes();
+	}
+	if (outputBytes + inputBytes > io_map_size) {
+		log(RTT::Error) << "[ECatConn] VirtualMaster: process data overflowed the IO map!"
+			<< RTT::endlog();
+		return false;
+	}
+	memset(io_map, 0, outputBytes + inputBytes);
+
+	uint8_t* outputs = (uint8_t*) io_map;
+	ioInputs         = (uint8_t*) io_map + outputBytes;
+	uint8_t* inputs  = ioInputs;
+	expectedWKC      = 0;
+	for (size_t i = 0; i < medullas.size(); i++) {
+		ec_slavet &slave = slaves[i + 1];
+		slave.Obytes  = medullas[i]->getOutputBytes();
+		slave.Obits   = slave.Obytes * 8;
+		slave.outputs = outputs;
+		slave.Ibytes  = medullas[i]->getInputBytes();
+		slave.Ibits   = slave.Ibytes * 8;
+		slave.inputs  = inputs;
+		slave.state   = EC_STATE_SAFE_OP;
+		outputs += slave.Obytes;
+		inputs  += slave.Ibytes;
+
+		// Logical read/writes count 2 for each slave written and 1 for each slave read.
+		expectedWKC += (slave.Obytes ? 2 : 0) + (slave.Ibytes ? 1 : 0);
+	}
+	slaves[0].state = EC_STATE_SAFE_OP;
+
+	frameInputs.assign(inputBytes, 0);
+	framePending  = false;
+	dcTime        = toDCTime(hostTime());
+	configureTime = hostTime();
+
+	bringup.mapMs            = (configureTime - phaseStart) / 1000000.0;
+	bringup.configDCMs       = 0.0;
+	bringup.safeOpMs         = 0.0;
+	bringup.topologyCacheHit = false;
+
+	log(RTT::Info) << "[ECatConn] VirtualMaster: " << medullas.size()
+		<< " virtual Medullas, " << config.driftPpm << " ppm drift, "
+		<< config.frameLatency << " ns frame latency." << RTT::endlog();
+	return true;
+}
+
+int VirtualMaster::getSlaveCount() {
+	return medullas.size();
+}
+
+ec_slavet* VirtualMaster::getSlaves() {
+	return &slaves[0];
+}
+
+void VirtualMaster::setOperational() {
+	for (size_t i = 0; i < slaves.size(); i++)
+		slaves[i].state = EC_STATE_OPERATIONAL;
+}
+
+void VirtualMaster::configureSync0(int slave, int64_t cycle_time, int64_t shift) {
+	if (slave < 1 || slave > (int) medullas.size())
+		return;
+
+	medullas[slave - 1]->setSync0(cycle_time, shift, toDCTime(hostTime()));
+}
+
+int64_t VirtualMaster::configureSync0All(int64_t cycle_time, int64_t shift) {
+	for (size_t i = 1; i <= medullas.size(); i++)
+		configureSync0(i, cycle_time, shift);
+
+	// The virtual slaves start on the next edge, which is within two cycles.
+	int64_t now = toDCTime(hostTime());
+	return now - (now % cycle_time) + shift + cycle_time;
+}
+
+int64_t VirtualMaster::getDCOffset() {
+	double settled = exp(-(double) (hostTime() - configureTime) / VIRTUAL_DC_SETTLE_TAU_NS);
+	return (int64_t) (VIRTUAL_DC_INITIAL_OFFSET_NS * settled);
+}
+
+void VirtualMaster::sendProcessData() {
+	int64_t sendTime = hostTime();
+	int64_t latency  = config.frameLatency;
+	if (config.frameJitter > 0)
+		latency += rand_r(&randSeed) % (config.frameJitter + 1);
+
+	frameReturnTime = sendTime + latency;
+	framePending    = true;
+
+	// A lost frame never reaches the slaves, and never comes back.
+	frameDropped    = config.frameLossRate > 0.0 &&
+	                  rand_r(&randSeed) < config.frameLossRate * RAND_MAX;
+	if (frameDropped)
+		return;
+
+	// The frame goes out and back through the line, so it
+	// reaches the slaves about halfway through its trip.
+	frameDCTime     = toDCTime(sendTime + latency / 2);
+
+	// Slaves that aren't in OP leave the frame (and the working counter) alone.
+	frameWKC        = 0;
+	for (size_t i = 0; i < medullas.size(); i++) {
+		ec_slavet &slave = slaves[i + 1];
+		if (slave.state != EC_STATE_OPERATIONAL)
+			continue;
+
+		medullas[i]->exchange(slave.outputs, &frameInputs[slave.inputs - ioInputs], frameDCTime);
+		frameWKC += (slave.Obytes ? 2 : 0) + (slave.Ibytes ? 1 : 0);
+	}
+}
+
+int VirtualMaster::receiveProcessData(int timeout_us) {
+	if (!framePending)
+		return EC_NOFRAME;
+	framePending = false;
+
+	int64_t waitUntil = frameReturnTime;
+	int64_t timeout   = hostTime() + ((int64_t) timeout_us) * 1000;
+	bool    lost      = frameDropped || waitUntil > timeout;
+	if (lost)
+		waitUntil = timeout;
+
+	timespec wakeup = {
+		(time_t) (waitUntil / SECOND_IN_NANOSECONDS),
+		(long)   (waitUntil % SECOND_IN_NANOSECONDS)
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR);
+
+	if (lost)
+		return EC_NOFRAME;
+
+	if (!frameInputs.empty())
+		memcpy(ioInputs, &frameInputs[0], frameInputs.size());
+	dcTime = frameDCTime;
+
+	return frameWKC;
+}
+
+int VirtualMaster::getExpectedWKC() {
+	return expectedWKC;
+}
+
+int64_t VirtualMaster::getDCTime() {
+	return dcTime;
+}
+
+bool VirtualMaster::readStates() {
+	bool allOperational = true;
+	for (size_t i = 1; i < slaves.size(); i++)
+		allOperational = allOperational && slaves[i].state == EC_STATE_OPERATIONAL;
+
+	return allOperational;
+}
+
+void VirtualMaster::recoverSlave(int slave) {
+	if (slave < 1 || slave >= (int) slaves.size())
+		return;
+
+	timespec delay = {0, VIRTUAL_RECOVERY_STEP_NS};
+	while (clock_nanosleep(CLOCK_MONOTONIC, 0, &delay, &delay) == EINTR);
+
+	// Errors get acknowledged back to SAFE-OP, then we ask for OP.
+	ec_slavet &s = slaves[slave];
+	if (s.state == EC_STATE_SAFE_OP)
+		s.state = EC_STATE_OPERATIONAL;
+	else
+		s.state = EC_STATE_SAFE_OP;
+}
+
+void VirtualMaster::dropSlave(int slave) {
+	if (slave < 1 || slave >= (int) slaves.size())
+		return;
+
+	slaves[slave].state = EC_STATE_SAFE_OP + EC_STATE_ERROR;
+}
+
+void VirtualMaster::close() {
+	for (size_t i = 0; i < slaves.size(); i++)
+		slaves[i].state = EC_STATE_INIT;
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -0,0 +1,137 @@
+#include "atrias_ecat_conn/VirtualMedulla.h"
+
+#include <string.h>
+
+#include <atrias_medulla_drivers/BoomMedulla.h>
+#include <atrias_medulla_drivers/HipMedulla.h>
+#include <atrias_medulla_drivers/ImuMedulla.h>
+#include <atrias_medulla_drivers/LegMedulla.h>
+
+// Offsets of the PDO entries every Medulla has. See the drivers' constructors.
+#define VMEDULLA_OUT_COMMAND        0
+#define VMEDULLA_IN_ID              0
+#define VMEDULLA_IN_STATE           1
+#define VMEDULLA_IN_TIMING_COUNTER  2
+#define VMEDULLA_IN_ERROR_FLAGS     3
+
+namespace atrias {
+
+namespace ecatConn {
+
+/** @brief Sums up the sizes of a driver's PDO entries.
+  * @param outputs Set to the size of the outputs.
+  * @param inputs  Set to the size of the inputs.
+  */
+template <class Driver>
+static void measurePDOs(int &outputs, int &inputs) {
+	Driver driver;
+	medullaDrivers::PDORegData regData = driver.getPDORegData();
+
+	outputs = 0;
+	for (int i = 0; i < regData.outputs; i++)
+		outputs += regData.pdoEntryDatas[i].size;
+
+	inputs = 0;
+	for (int i = regData.outputs; i < regData.outputs + regData.inputs; i++)
+		inputs += regData.pdoEntryDatas[i].size;
+}
+
+VirtualMedulla::VirtualMedulla(uint32_t product_code, uint8_t id) {
+	productCode = product_code;
+	syncPeriod  = 0;
+	nextSync    = 0;
+
+	int outputBytes = 0;
+	int inputBytes  = 0;
+	switch (product_code) {
+		case MEDULLA_LEG_PRODUCT_CODE:
+			measurePDOs<medullaDrivers::LegMedulla>(outputBytes, inputBytes);
+			break;
+		case MEDULLA_HIP_PRODUCT_CODE:
+			measurePDOs<medullaDrivers::HipMedulla>(outputBytes, inputBytes);
+			break;
+		case MEDULLA_BOOM_PRODUCT_CODE:
+			measurePDOs<medullaDrivers::BoomMedulla>(outputBytes, inputBytes);
+			break;
+		case MEDULLA_IMU_PRODUCT_CODE:
+			measurePDOs<medullaDrivers::ImuMedulla>(outputBytes, inputBytes);
+			break;
+	}
+
+	latchedOutputs.assign(outputBytes, 0);
+	pendingOutputs.assign(outputBytes, 0);
+	inputs.assign(inputBytes, 0);
+
+	if (inputBytes > VMEDULLA_IN_ERROR_FLAGS) {
+		inputs[VMEDULLA_IN_ID]    = id;
+		inputs[VMEDULLA_IN_STATE] = medulla_state_idle;
+	}
+}
+
+uint32_t VirtualMedulla::getProductCode() {
+	return productCode;
+}
+
+int VirtualMedulla::getOutputBytes() {
+	return latchedOutputs.size();
+}
+
+int VirtualMedulla::getInputBytes() {
+	return inputs.size();
+}
+
+void VirtualMedulla::setSync0(int64_t cycle_time, int64_t shift, int64_t dc_time) {
+	syncPeriod = cycle_time;
+	if (syncPeriod <= 0)
+		return;
+
+	// The first edge at the requested phase after now.
+	nextSync = dc_time - (dc_time % syncPeriod) + shift;
+	while (nextSync <= dc_time)
+		nextSync += syncPeriod;
+}
+
+void VirtualMedulla::syncEdge() {
+	latchedOutputs = pendingOutputs;
+	if (inputs.size() <= VMEDULLA_IN_ERROR_FLAGS || latchedOutputs.empty())
+		return;
+
+	uint8_t command = latchedOutputs[VMEDULLA_OUT_COMMAND];
+	uint8_t state   = inputs[VMEDULLA_IN_STATE];
+	if (command == medulla_state_reset)
+		state = medulla_state_idle;
+	else if (state != medulla_state_error)
+		state = command;
+
+	inputs[VMEDULLA_IN_STATE] = state;
+	inputs[VMEDULLA_IN_TIMING_COUNTER]++;
+	inputs[VMEDULLA_IN_ERROR_FLAGS] = 0;
+}
+
+void VirtualMedulla::exchange(const uint8_t* outputs, uint8_t* frame_inputs, int64_t dc_time) {
+	if (syncPeriod > 0) {
+		// Run the edges that happened since the last frame.
+		while (nextSync <= dc_time) {
+			syncEdge();
+			nextSync += syncPeriod;
+		}
+	}
+
+	// The frame picks up the inputs latched at the last edge...
+	if (!inputs.empty())
+		memcpy(frame_inputs, &inputs[0], inputs.size());
+
+	// ... and drops off outputs for the next one.
+	if (!pendingOutputs.empty())
+		memcpy(&pendingOutputs[0], outputs, pendingOutputs.size());
+
+	// Without SYNC0, the Medulla acts on each frame as it arrives.
+	if (syncPeriod <= 0)
+		syncEdge();
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include "atrias_medulla_drivers/Encoder.h"
+#include "atrias_medulla_drivers/VelocityEstimator.h"
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <robot_invariant_defs.h>
@@ -69,6 +70,10 @@ class BoomMedulla : public Medulla {
 	  */
 	int16_t   pitchTimestampValue;
 	
+	/** @brief Estimates the body pitch velocity.
+	  */
+	VelocityEstimator pitchVelocityEstimator;
+	
 	/** @brief The last value of the Z encoder, for position delta calculation.
 	  */
 	uint32_t  zEncoderValue;
@@ -82,6 +87,10 @@ class BoomMedulla : public Medulla {
 	  */
 	int16_t   zTimestampValue;
 	
+	/** @brief Estimates the boom angle velocity.
+	  */
+	VelocityEstimator zVelocityEstimator;
+	
 	/** @brief The PDOEntryDatas array.
 	  */
 	PDOEntryData pdoEntryDatas[MEDULLA_BOOM_TX_PDO_COUNT+MEDULLA_BOOM_RX_PDO_COUNT];
@@ -128,7 +137,7 @@ class BoomMedulla : public Medulla {
 		
 		/** @brief Tells this medulla to read in data for transmission.
 		  */
-		void processTransmitData(atrias_msgs::controller_output& controller_output);
+		void processTransmitData(const atrias_msgs::controller_output& controller_output);
 		
 		/** @brief Tells this Medulla to update the robot state.
 		  */
@@ -11,6 +11,7 @@
 // Our stuff
 #include <atrias_shared/globals.h>
 #include <robot_invariant_defs.h>
+#include "atrias_medulla_drivers/VelocityEstimator.h"
 
 // Standard libs
 #include <cstdint>
@@ -40,6 +41,11 @@ class Encoder {
 		  */
 		void init(int bits, uint32_t calibReading, double calibLoc, double scaling);
 
+		/** @brief Sets how many samples the velocity is fit over.
+		  * @param samples The window, in samples. 2 is a plain difference.
+		  */
+		void setVelocityWindow(int samples);
+
 		/** @brief Updates this encoder's position and velocity
 		  * @param reading    This encoder's current reading
 		  * @param delta_time The time between this cycle and the last (just DC differences)
@@ -97,6 +103,10 @@ class Encoder {
 		  */
 		double scalingRatio;
 
+		/** @brief This estimates the velocity from the positions and delta times.
+		  */
+		VelocityEstimator velocityEstimator;
+
 		/** @brief This is an integer modulo function.
 		  * @param a The dividend
 		  * @param b The divisor
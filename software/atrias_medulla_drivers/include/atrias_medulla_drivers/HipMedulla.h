@@ -13,6 +13,7 @@
 #include <robot_variant_defs.h>
 #include <atrias_shared/globals.h>
 #include "atrias_medulla_drivers/Medulla.h"
+#include "atrias_medulla_drivers/VelocityEstimator.h"
 
 namespace atrias {
 
@@ -72,12 +73,32 @@ class HipMedulla : public Medulla {
 	int16_t   incrementalEncoderTimestampValue;
 	bool      incrementalEncoderInitialized;
 	
+	// The incremental encoder's angle, uncorrected by the absolute encoder,
+	// and its velocity estimate.
+	double            incrementalEncoderAngle;
+	VelocityEstimator velocityEstimator;
+	
+	// Where this Medulla's data goes and its calibration, looked up from
+	// its ID once, by mapTargets().
+	atrias_msgs::robot_state_leg       atrias_msgs::robot_state::*       leg;
+	atrias_msgs::controller_output_leg atrias_msgs::controller_output::* legOutput;
+	bool      reportsBusCurrent;
+	bool      mapped;
+	int       motorDirection;
+	int32_t   calibVal;
+	double    calibPos;
+	
+	/** @brief Looks up where this Medulla's data goes from its ID.
+	  * Sets \a mapped; if the ID isn't a hip's, everything else is left alone.
+	  */
+	void    mapTargets();
+	
 	/** @brief Calculate the current command to send to this Medulla.
 	  * @param controllerOutput The controller output from which to pull
 	  * the current command.
 	  * @return The motor current command value.
 	  */
-	int32_t calcMotorCurrentOut(atrias_msgs::controller_output& controllerOutput);
+	int32_t calcMotorCurrentOut(const atrias_msgs::controller_output& controllerOutput);
 	
 	/** @brief Updates the limit switch values in robotState w/ the
 	  * new values from the Medulla.
@@ -117,9 +138,15 @@ class HipMedulla : public Medulla {
 		  */
 		uint8_t getID();
 		
+		/** @brief Returns whether postOpInit() recognized this Medulla's ID.
+		  * Unmapped Medullas don't touch the robot state or command any current.
+		  * @return True if this Medulla knows which hip it is.
+		  */
+		bool    isMapped();
+		
 		/** @brief Tells this medulla to read in data for transmission.
 		  */
-		void processTransmitData(atrias_msgs::controller_output& controller_output);
+		void processTransmitData(const atrias_msgs::controller_output& controller_output);
 		
 		/** @brief Tells this Medulla to update the robot state.
 		  */
@@ -14,6 +14,7 @@
 #include <robot_invariant_defs.h>
 #include <robot_variant_defs.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/RtLog.hpp>
 #include "atrias_medulla_drivers/Medulla.h"
 
 namespace atrias {
@@ -84,7 +85,7 @@ class ImuMedulla : public Medulla {
 
 		/** @brief Tells this medulla to read in data for transmission.
 		  */
-		void processTransmitData(atrias_msgs::controller_output& controller_output);
+		void processTransmitData(const atrias_msgs::controller_output& controller_output);
 
 		/** @brief Tells this Medulla to update the robot state.
 		  */
@@ -0,0 +1,130 @@
+#ifndef LEGBATCH_H
+#define LEGBATCH_H
+
+/** @file
+  * @brief Decodes all the leg Medullas' inputs together.
+  * Every leg Medulla runs the same arithmetic on its encoders and ADCs. This
+  * gathers the raw values from each leg's PDOs into one array per field,
+  * does the arithmetic across all the legs at once with SSE2 (or plain C++
+  * where that's not available), then scatters the results into the robot
+  * state. The voltages and thermistors come from Medulla's lookup tables,
+  * the velocities from each leg's VelocityEstimators, and the limit
+  * switches, toe, and strain gauge stay per-leg, as they're branchy.
+  *
+  * The results are bit-for-bit the same as LegMedulla::processReceiveData()'s:
+  * the same IEEE operations run in the same order. That holds as long as the
+  * compiler isn't allowed to fuse multiplies and adds, so the CMakeLists
+  * builds this, LegMedulla, and Medulla with -ffp-contract=off.
+  */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atrias_msgs/robot_state.h>
+#include "atrias_medulla_drivers/LegMedulla.h"
+
+/** @brief The most legs decoded in one pass. More are handled in several passes.
+  * Must be a multiple of 2 (the SSE2 lane count).
+  */
+#define LEG_BATCH_MAX_LEGS 8
+
+namespace atrias {
+
+namespace medullaDrivers {
+
+class LegBatch {
+	/** @brief The raw inputs, one array per field, one element per leg.
+	  * Everything is converted to double on the way in; every value
+	  * involved fits in a double exactly.
+	  */
+	struct Inputs {
+		double motorTicks[LEG_BATCH_MAX_LEGS]      __attribute__((aligned(16)));
+		double motorCalibVal[LEG_BATCH_MAX_LEGS]   __attribute__((aligned(16)));
+		double motorRadPerCnt[LEG_BATCH_MAX_LEGS]  __attribute__((aligned(16)));
+		double motorTimestamp[LEG_BATCH_MAX_LEGS]  __attribute__((aligned(16)));
+		double motorDt[LEG_BATCH_MAX_LEGS]         __attribute__((aligned(16)));
+		double legTicks[LEG_BATCH_MAX_LEGS]        __attribute__((aligned(16)));
+		double legCalibVal[LEG_BATCH_MAX_LEGS]     __attribute__((aligned(16)));
+		double legRadPerCnt[LEG_BATCH_MAX_LEGS]    __attribute__((aligned(16)));
+		double legTimestamp[LEG_BATCH_MAX_LEGS]    __attribute__((aligned(16)));
+		double legDt[LEG_BATCH_MAX_LEGS]           __attribute__((aligned(16)));
+		double legOffset[LEG_BATCH_MAX_LEGS]       __attribute__((aligned(16)));
+		double calibLoc[LEG_BATCH_MAX_LEGS]        __attribute__((aligned(16)));
+		double deltaTime[LEG_BATCH_MAX_LEGS]       __attribute__((aligned(16)));
+		double incPos[LEG_BATCH_MAX_LEGS]          __attribute__((aligned(16)));
+		double incStart[LEG_BATCH_MAX_LEGS]        __attribute__((aligned(16)));
+		double incTimestamp[LEG_BATCH_MAX_LEGS]    __attribute__((aligned(16)));
+		double direction[LEG_BATCH_MAX_LEGS]       __attribute__((aligned(16)));
+		double amp1Current[LEG_BATCH_MAX_LEGS]     __attribute__((aligned(16)));
+		double amp2Current[LEG_BATCH_MAX_LEGS]     __attribute__((aligned(16)));
+	};
+
+	/** @brief The decoded values, laid out like \a Inputs.
+	  */
+	struct Outputs {
+		double motorAngle[LEG_BATCH_MAX_LEGS]      __attribute__((aligned(16)));
+		double motorDt[LEG_BATCH_MAX_LEGS]         __attribute__((aligned(16)));
+		double legAngle[LEG_BATCH_MAX_LEGS]        __attribute__((aligned(16)));
+		double legDt[LEG_BATCH_MAX_LEGS]           __attribute__((aligned(16)));
+		double rotorAngle[LEG_BATCH_MAX_LEGS]      __attribute__((aligned(16)));
+		double rotorDt[LEG_BATCH_MAX_LEGS]         __attribute__((aligned(16)));
+		double amp1Current[LEG_BATCH_MAX_LEGS]     __attribute__((aligned(16)));
+		double amp2Current[LEG_BATCH_MAX_LEGS]     __attribute__((aligned(16)));
+		double motorCurrent[LEG_BATCH_MAX_LEGS]    __attribute__((aligned(16)));
+	};
+
+	Inputs      in;
+	Outputs     out;
+
+	/** @brief The legs in the current pass, in the order they were gathered.
+	  */
+	LegMedulla* legs[LEG_BATCH_MAX_LEGS];
+
+	/** @brief How many legs are in the current pass.
+	  */
+	size_t      count;
+
+	/** @brief Reads a leg's new inputs into the next free slot.
+	  * Updates the leg's timing counter, encoder error checks, and
+	  * incremental encoder count, just like processReceiveData() does.
+	  * @param leg The leg, which has new data.
+	  */
+	void gather(LegMedulla* leg);
+
+	/** @brief Does the arithmetic for every leg in this pass.
+	  */
+	void compute();
+
+	/** @brief Writes this pass's results into the robot state and the legs,
+	  * and runs the per-leg processing.
+	  * @param robot_state The robot state.
+	  */
+	void scatter(atrias_msgs::robot_state &robot_state);
+
+	public:
+		/** @brief Starts out empty.
+		  */
+		LegBatch();
+
+		/** @brief Decodes the inputs of all the legs with new data.
+		  * Equivalent to calling processReceiveData() on each one, in order.
+		  * @param legs        The leg drivers.
+		  * @param leg_count   How many there are.
+		  * @param robot_state The robot state.
+		  */
+		void processReceiveData(LegMedulla* const* legs, size_t leg_count,
+		                        atrias_msgs::robot_state &robot_state);
+
+		/** @brief Returns which SIMD instructions this build decodes with.
+		  * @return "sse2" or "scalar".
+		  */
+		static const char* getInstructionSet();
+};
+
+}
+
+}
+
+#endif // LEGBATCH_H
+
+// vim: noexpandtab
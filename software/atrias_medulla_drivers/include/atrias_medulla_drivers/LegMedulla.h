@@ -14,9 +14,11 @@
 #include <atrias_msgs/controller_output.h>
 #include <atrias_msgs/robot_state.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/RtLog.hpp>
 #include "robot_invariant_defs.h"
 #include "robot_variant_defs.h"
 #include "atrias_medulla_drivers/Medulla.h"
+#include "atrias_medulla_drivers/VelocityEstimator.h"
 
 namespace atrias {
 
@@ -26,6 +28,9 @@ namespace medullaDrivers {
   * type of Medulla.
   */
 class LegMedulla : public Medulla {
+	// Decodes all the legs' inputs at once; see LegBatch.h.
+	friend class LegBatch;
+	
 	// Stuff sent to the medulla
 	uint8_t*        command;
 	uint16_t*       counter;
@@ -90,10 +95,35 @@ class LegMedulla : public Medulla {
 	double          legEncoderDt;
 	double          motorEncoderDt;
 	
+	// Velocity estimates, from the positions and the times between them.
+	VelocityEstimator motorVelocityEstimator;
+	VelocityEstimator legVelocityEstimator;
+	VelocityEstimator rotorVelocityEstimator;
+	
+	// Where this Medulla's data goes and its calibration, looked up from
+	// its ID once, by mapTargets().
+	atrias_msgs::robot_state_leg       atrias_msgs::robot_state::*         leg;
+	atrias_msgs::robot_state_legHalf   atrias_msgs::robot_state_leg::*     half;
+	atrias_msgs::controller_output_leg atrias_msgs::controller_output::*   legOutput;
+	double                             atrias_msgs::controller_output_leg::* motorCurrentOutput;
+	bool            isHalfA;
+	bool            mapped;
+	uint32_t        motorCalibVal;
+	double          motorRadPerCnt;
+	uint32_t        legCalibVal;
+	double          legRadPerCnt;
+	double          calibLoc;
+	int             motorDirection;
+	
 	/** @brief The PDOEntryDatas array.
 	  */
 	PDOEntryData pdoEntryDatas[MEDULLA_LEG_TX_PDO_COUNT+MEDULLA_LEG_RX_PDO_COUNT];
 	
+	/** @brief Looks up where this Medulla's data goes from its ID.
+	  * Sets \a mapped; if the ID isn't a leg's, everything else is left alone.
+	  */
+	void         mapTargets();
+	
 	/** @brief Check for spikes in the encoder data.
 	  */
 	void         checkErroneousEncoderValues();
@@ -101,7 +131,7 @@ class LegMedulla : public Medulla {
 	/** @brief Calculates the current command to send to the Medulla.
 	  * @return The value that should be sent to this Medulla.
 	  */
-	int32_t      calcMotorCurrentOut(atrias_msgs::controller_output& controllerOutput);
+	int32_t      calcMotorCurrentOut(const atrias_msgs::controller_output& controllerOutput);
 	
 	/** @brief  Converts encoder ticks to radians.
 	  * @param  ticks The encoder's reported position.
@@ -162,6 +192,12 @@ class LegMedulla : public Medulla {
 		  */
 		LegMedulla();
 		
+		/** @brief Returns whether postOpInit() recognized this Medulla's ID.
+		  * Unmapped Medullas don't touch the robot state or command any current.
+		  * @return True if this Medulla knows which leg half it is.
+		  */
+		bool isMapped();
+		
 		/** @brief Returns a \a PDORegData struct for PDO entry location.
 		  * @return A PDORegData struct w/ sizes filled out.
 		  */
@@ -173,7 +209,7 @@ class LegMedulla : public Medulla {
 		
 		/** @brief Tells this medulla to read in data for transmission.
 		  */
-		void processTransmitData(atrias_msgs::controller_output& controller_output);
+		void processTransmitData(const atrias_msgs::controller_output& controller_output);
 		
 		/** @brief Tells this Medulla to update the robot state.
 		  */
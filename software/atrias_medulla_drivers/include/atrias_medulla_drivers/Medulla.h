@@ -10,6 +10,10 @@
 
 #include "robot_invariant_defs.h"
 
+/** @brief How many readings the Medullas' 12-bit ADCs can report.
+  */
+#define MEDULLA_ADC_LUT_SIZE 4096
+
 namespace atrias {
 
 namespace medullaDrivers {
@@ -48,9 +52,38 @@ struct PDORegData {
 
 class Medulla {
 	protected:
+		/** @brief The ADC conversions, worked out for every 12-bit reading.
+		  * Filled in once, when the library loads, by the same code the
+		  * conversions below fall back on, so a lookup gives exactly what
+		  * the formula would.
+		  */
+		struct AdcLuts {
+			double logicVoltage[MEDULLA_ADC_LUT_SIZE];
+			double motorVoltage[MEDULLA_ADC_LUT_SIZE];
+			double thermistor[MEDULLA_ADC_LUT_SIZE];
+
+			/** @brief Fills in the tables.
+			  */
+			AdcLuts();
+		};
+
+		/** @brief The tables, shared by all the Medullas.
+		  */
+		static const AdcLuts adcLuts;
+
 		/** @brief Holds the counter value for feeding the master watchdog.
 		  */
 		uint16_t        local_counter;
+		
+		/** @brief The control loop period, in nanoseconds.
+		  * This is also the time between timing counter increments.
+		  */
+		int64_t         controlPeriod;
+		
+		/** @brief How many samples the encoder velocities are fit over.
+		  * See VelocityEstimator.
+		  */
+		int             velocityWindow;
 			
 		/** @brief Decodes a logic voltage.
 		  * @param adc_value The voltage value from the ADC.
@@ -86,6 +119,17 @@ class Medulla {
 		/** @brief Does a bit of initialization.
 		  */
 		Medulla();
+		
+		/** @brief Sets the control loop period.
+		  * @param control_period The period, in nanoseconds.
+		  */
+		void setControlPeriod(int64_t control_period);
+		
+		/** @brief Sets how many samples the encoder velocities are fit over.
+		  * Must be called before postOpInit().
+		  * @param samples The window, in samples. 2 is a plain difference.
+		  */
+		void setVelocityWindow(int samples);
 };
 
 }
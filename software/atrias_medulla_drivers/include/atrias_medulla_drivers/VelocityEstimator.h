@@ -0,0 +1,108 @@
+#ifndef VELOCITYESTIMATOR_H
+#define VELOCITYESTIMATOR_H
+
+/** @file
+  * @brief Estimates an encoder's velocity from its timestamped positions.
+  * The velocity is the slope of a least-squares line through the last few
+  * samples, each at the time the Medulla actually read the encoder. At 1 kHz
+  * a single tick is a big jump in a two-sample difference; the fit spreads
+  * it out over the window, at the cost of half a window of lag.
+  *
+  * With a window of 2 this is the plain two-sample difference. Updates are
+  * O(1) whatever the window: the sums the fit needs are kept up to date as
+  * samples come and go, relative to the newest sample so they stay small.
+  * Every VELOCITY_ESTIMATOR_RESYNC_PERIOD updates they're recomputed from
+  * the window, so rounding errors can't build up over a long run.
+  */
+
+#include <stdint.h>
+
+/** @brief The largest window the estimator supports, in samples.
+  */
+#define VELOCITY_ESTIMATOR_MAX_WINDOW 32
+
+/** @brief How many updates go by between recomputing the sums from scratch.
+  */
+#define VELOCITY_ESTIMATOR_RESYNC_PERIOD 1024
+
+namespace atrias {
+
+namespace medullaDrivers {
+
+class VelocityEstimator {
+	/** @brief The samples in the window, oldest first starting at \a oldest.
+	  * Times are on our own clock, which starts at the first sample.
+	  */
+	double times[VELOCITY_ESTIMATOR_MAX_WINDOW];
+	double positions[VELOCITY_ESTIMATOR_MAX_WINDOW];
+
+	/** @brief How many samples the fit uses.
+	  */
+	int    window;
+
+	/** @brief How many samples are in the window so far.
+	  */
+	int    count;
+
+	/** @brief Where the oldest and newest samples are in \a times and \a positions.
+	  */
+	int    oldest;
+	int    newest;
+
+	/** @brief The time of the newest sample.
+	  */
+	double now;
+
+	/** @brief How many updates since the sums were last recomputed.
+	  */
+	int    sinceResync;
+
+	// The sums for the fit, with times and positions taken relative to
+	// the newest sample.
+	double sumT;
+	double sumX;
+	double sumTT;
+	double sumTX;
+
+	/** @brief The latest estimate.
+	  */
+	double velocity;
+
+	/** @brief Recomputes the sums from the samples in the window, and
+	  * restarts our clock at the newest one.
+	  */
+	void   resync();
+
+	public:
+		/** @brief Starts out with the default window and no samples.
+		  */
+		VelocityEstimator();
+
+		/** @brief Sets how many samples the fit uses, and forgets the old ones.
+		  * @param samples The window, clamped to [2, VELOCITY_ESTIMATOR_MAX_WINDOW].
+		  */
+		void   setWindow(int samples);
+
+		/** @brief Forgets all the samples. The velocity reads 0 until there are two.
+		  */
+		void   reset();
+
+		/** @brief Adds a sample and updates the estimate. Realtime-safe.
+		  * @param position   The encoder's position, in whatever units the velocity should be in.
+		  * @param delta_time The time since the last sample, in seconds. Ignored for the first one.
+		  */
+		void   update(double position, double delta_time);
+
+		/** @brief Returns the latest estimate.
+		  * @return The velocity, in position units per second.
+		  */
+		double getVel();
+};
+
+}
+
+}
+
+#endif // VELOCITYESTIMATOR_H
+
+// vim: noexpandtab
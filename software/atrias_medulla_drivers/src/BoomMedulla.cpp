@@ -30,6 +30,11 @@ void BoomMedulla::postOpInit() {
     // X angle encoder
     xAngleDecoder.init(BOOM_ENCODER_BITS, *xEncoder, 0.0, -2.0 * M_PI / (1 << BOOM_ENCODER_BITS) / BOOM_X_GEAR_RATIO);
 
+    xEncoderDecoder.setVelocityWindow(velocityWindow);
+    xAngleDecoder.setVelocityWindow(velocityWindow);
+    pitchVelocityEstimator.setWindow(velocityWindow);
+    zVelocityEstimator.setWindow(velocityWindow);
+
     // Body pitch encoder
     pitchEncoderPos =
         (*pitchEncoder - BOOM_PITCH_VERTICAL_VALUE) % (1 << BOOM_ENCODER_BITS);
@@ -97,11 +102,11 @@ void BoomMedulla::processPitchEncoder(RTT::os::TimeService::nsecs deltaTime, atr
     robotState.position.bodyPitch =
         pitchEncoderPos * PITCH_ENCODER_RAD_PER_TICK + 3.0 * M_PI / 2.0;
 
-    robotState.position.bodyPitchVelocity =
-        deltaPos * PITCH_ENCODER_RAD_PER_TICK /
-        (((double) deltaTime) / ((double) SECOND_IN_NANOSECONDS) +
+    pitchVelocityEstimator.update(robotState.position.bodyPitch,
+        ((double) deltaTime) / ((double) SECOND_IN_NANOSECONDS) +
         ((double) (((int16_t) *pitchTimestamp) - pitchTimestampValue)) /
         MEDULLA_TIMER_FREQ);
+    robotState.position.bodyPitchVelocity = pitchVelocityEstimator.getVel();
 
     pitchEncoderValue = *pitchEncoder;
     pitchTimestampValue = *pitchTimestamp;
@@ -159,8 +164,8 @@ void BoomMedulla::processZEncoder(RTT::os::TimeService::nsecs deltaTime, atrias_
     //
 
     // Compute the boom angle velocity (boom pitch velocity)
-    robotState.position.boomAngleVelocity =
-        ((double) deltaPos) * BOOM_Z_ENCODER_RAD_PER_TICK / actualDeltaTime;
+    zVelocityEstimator.update(robotState.position.boomAngle, actualDeltaTime);
+    robotState.position.boomAngleVelocity = zVelocityEstimator.getVel();
 
     // Compute robot x velocity (defined at the center of the hip-torso pivot axis)
     //robotState.position.xVelocity = - TORSO_LENGTH * (sin(BOOM_TORSO_OFFSET) * (cos(robotState.position.bodyPitch - 3.0 * M_PI / 2.0) * sin(robotState.position.xAngle) * robotState.position.bodyPitchVelocity + cos(robotState.position.xAngle) * sin(robotState.position.bodyPitch - 3.0 * M_PI / 2.0) * robotState.position.xAngleVelocity + cos(robotState.position.boomAngle) * cos(robotState.position.xAngle) * cos(robotState.position.bodyPitch - 3.0 * M_PI / 2.0) * robotState.position.boomAngleVelocity - cos(robotState.position.xAngle) * sin(robotState.position.boomAngle) * sin(robotState.position.bodyPitch - 3.0 * M_PI / 2.0) * robotState.position.bodyPitchVelocity - cos(robotState.position.bodyPitch - 3.0 * M_PI / 2.0) * sin(robotState.position.boomAngle) * sin(robotState.position.xAngle) * robotState.position.xAngleVelocity) + cos(robotState.position.xAngle) * sin(robotState.position.boomAngle) * cos(BOOM_TORSO_OFFSET) * robotState.position.boomAngleVelocity + cos(robotState.position.boomAngle) * sin(robotState.position.xAngle) * cos(BOOM_TORSO_OFFSET) * robotState.position.xAngleVelocity) - BOOM_LENGTH * cos(robotState.position.xAngle) * sin(robotState.position.boomAngle) * robotState.position.boomAngleVelocity - BOOM_LENGTH * cos(robotState.position.boomAngle) * sin(robotState.position.xAngle) * robotState.position.xAngleVelocity;
@@ -180,7 +185,7 @@ void BoomMedulla::processZEncoder(RTT::os::TimeService::nsecs deltaTime, atrias_
     robotState.position.zEncoderRaw = *zEncoder;
 }
 
-void BoomMedulla::processTransmitData(atrias_msgs::controller_output& controller_output) {
+void BoomMedulla::processTransmitData(const atrias_msgs::controller_output& controller_output) {
     *counter = ++local_counter;
     *command = controller_output.command;
 }
@@ -195,7 +200,7 @@ void BoomMedulla::processReceiveData(atrias_msgs::robot_state& robot_state) {
     // Note: % isn't actually a modulo, hence the additional 256.
     RTT::os::TimeService::nsecs deltaTime =
         ((((int16_t) *timingCounter) + 256 - ((int16_t) timingCounterValue)) % 256) *
-        CONTROLLER_LOOP_PERIOD_NS;
+        controlPeriod;
     timingCounterValue = *timingCounter;
 
     processPitchEncoder(deltaTime, robot_state);
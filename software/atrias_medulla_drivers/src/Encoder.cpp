@@ -9,7 +9,7 @@ double Encoder::getPos() {
 }
 
 double Encoder::getVel() {
-	return scalingRatio * deltaPos / deltaTime;
+	return velocityEstimator.getVel();
 }
 
 void Encoder::init(int bits, uint32_t calibReading, double calibLoc, double scaling) {
@@ -18,6 +18,11 @@ void Encoder::init(int bits, uint32_t calibReading, double calibLoc, double scal
 	calibPos     = calibLoc;
 	scalingRatio = scaling;
 	calibrated   = false;
+	velocityEstimator.reset();
+}
+
+void Encoder::setVelocityWindow(int samples) {
+	velocityEstimator.setWindow(samples);
 }
 
 void Encoder::update(uint32_t reading, RTT::os::TimeService::nsecs delta_time, uint16_t timestamp) {
@@ -39,6 +44,8 @@ void Encoder::update(uint32_t reading, RTT::os::TimeService::nsecs delta_time, u
 	deltaTime     = ((double) delta_time) / SECOND_IN_NANOSECONDS;
 	deltaTime    += ((int16_t) (timestamp - lastTimestamp)) / MEDULLA_TIMER_FREQ;
 	lastTimestamp = timestamp;
+
+	velocityEstimator.update(scalingRatio * curPos, deltaTime);
 }
 
 intmax_t Encoder::mod(intmax_t a, intmax_t b) {
@@ -7,6 +7,7 @@ namespace atrias {
 namespace medullaDrivers {
 
 HipMedulla::HipMedulla() : Medulla() {
+	mapped = false;
 	pdoEntryDatas[0]  = {1, (void**) &command};
 	pdoEntryDatas[1]  = {2, (void**) &counter};
 	pdoEntryDatas[2]  = {4, (void**) &motorCurrent};
@@ -51,26 +52,50 @@ PDORegData HipMedulla::getPDORegData() {
 }
 
 void HipMedulla::postOpInit() {
+	mapTargets();
 	timingCounterValue               = *timingCounter;
 	incrementalEncoderValue          = *incrementalEncoder;
 	incrementalEncoderTimestampValue = *incrementalEncoderTimestamp;
 	incrementalEncoderInitialized    = false;
+	incrementalEncoderAngle          = 0.0;
+	velocityEstimator.setWindow(velocityWindow);
 }
 
-int32_t HipMedulla::calcMotorCurrentOut(atrias_msgs::controller_output& controllerOutput) {
+void HipMedulla::mapTargets() {
+	mapped = true;
+	switch (*id) {
+		case MEDULLA_LEFT_HIP_ID:
+			leg               = &atrias_msgs::robot_state::lLeg;
+			legOutput         = &atrias_msgs::controller_output::lLeg;
+			reportsBusCurrent = true;
+			motorDirection    = LEFT_MOTOR_HIP_DIRECTION;
+			calibVal          = LEFT_HIP_CALIB_VAL;
+			calibPos          = LEFT_HIP_CALIB_POS;
+			break;
+		case MEDULLA_RIGHT_HIP_ID:
+			leg               = &atrias_msgs::robot_state::rLeg;
+			legOutput         = &atrias_msgs::controller_output::rLeg;
+			reportsBusCurrent = false;
+			motorDirection    = RIGHT_MOTOR_HIP_DIRECTION;
+			calibVal          = RIGHT_HIP_CALIB_VAL;
+			calibPos          = RIGHT_HIP_CALIB_POS;
+			break;
+		default:
+			mapped = false;
+			break;
+	}
+}
+
+bool HipMedulla::isMapped() {
+	return mapped;
+}
+
+int32_t HipMedulla::calcMotorCurrentOut(const atrias_msgs::controller_output& controllerOutput) {
         // If the ID isn't recognized, command 0 torque.
-        double torqueCmd = 0.0;
+        if (!mapped)
+                return 0;
         
-        switch(*id) {
-                case MEDULLA_LEFT_HIP_ID:
-                        torqueCmd = controllerOutput.lLeg.motorCurrentHip *
-                        	LEFT_MOTOR_HIP_DIRECTION;
-                        break;
-                case MEDULLA_RIGHT_HIP_ID:
-                        torqueCmd = controllerOutput.rLeg.motorCurrentHip *
-                        	RIGHT_MOTOR_HIP_DIRECTION;
-                        break;
-        }
+        double torqueCmd = (controllerOutput.*legOutput).motorCurrentHip * motorDirection;
         
         return (int32_t) (((double) MTR_MAX_COUNT) * torqueCmd / MTR_HIP_MAX_CURRENT);
 }
@@ -96,18 +121,15 @@ void HipMedulla::updateEncoderValues(RTT::os::TimeService::nsecs delta_time,
 	incrementalEncoderValue         += deltaPos;
 	incrementalEncoderTimestampValue = *incrementalEncoderTimestamp;
 	
-	int dir = (*id == MEDULLA_LEFT_HIP_ID) ? LEFT_MOTOR_HIP_DIRECTION
-	          : RIGHT_MOTOR_HIP_DIRECTION;
-	int32_t calib_val = (*id == MEDULLA_LEFT_HIP_ID) ? LEFT_HIP_CALIB_VAL
-	                    : RIGHT_HIP_CALIB_VAL;
-	double  calib_pos = (*id == MEDULLA_LEFT_HIP_ID) ? LEFT_HIP_CALIB_POS
-	                    : RIGHT_HIP_CALIB_POS;
+	// The velocity comes from the incremental encoder alone, so the slow
+	// correction toward the absolute encoder below doesn't show up in it.
+	incrementalEncoderAngle += motorDirection * HIP_INC_ENCODER_RAD_PER_TICK * deltaPos;
+	velocityEstimator.update(incrementalEncoderAngle, actualDeltaTime);
 	
-	hip.legBodyVelocity   = dir * HIP_INC_ENCODER_RAD_PER_TICK * deltaPos /
-	                        actualDeltaTime;
-	hip.legBodyAngle     += dir * HIP_INC_ENCODER_RAD_PER_TICK * deltaPos;
-	hip.absoluteBodyAngle = (((int32_t) *hipEncoder) - calib_val) *
-	                        HIP_ABS_ENCODER_RAD_PER_TICK * -dir + calib_pos;
+	hip.legBodyVelocity   = velocityEstimator.getVel();
+	hip.legBodyAngle     += motorDirection * HIP_INC_ENCODER_RAD_PER_TICK * deltaPos;
+	hip.absoluteBodyAngle = (((int32_t) *hipEncoder) - calibVal) *
+	                        HIP_ABS_ENCODER_RAD_PER_TICK * -motorDirection + calibPos;
     // Compensate for rollover
     hip.absoluteBodyAngle = fmod(hip.absoluteBodyAngle, M_PI);
     // Compensate for the difference between % and modulo.
@@ -126,7 +148,7 @@ uint8_t HipMedulla::getID() {
 	return *id;
 }
 
-void HipMedulla::processTransmitData(atrias_msgs::controller_output& controller_output) {
+void HipMedulla::processTransmitData(const atrias_msgs::controller_output& controller_output) {
 	*counter      = ++local_counter;
 	*command      = controller_output.command;
 	*motorCurrent = calcMotorCurrentOut(controller_output);
@@ -136,30 +158,22 @@ void HipMedulla::processReceiveData(atrias_msgs::robot_state& robot_state) {
     //log(RTT::Info) << "ID: " << (int) *id << " Counts: " << *hipEncoder << RTT::endlog();
 	// If we don't have new data, don't run. It's pointless, and results in
 	// NaN velocities.
-	if (*timingCounter == timingCounterValue)
+	if (!mapped || *timingCounter == timingCounterValue)
 		return;
 	// Calculate how much time has elapsed since the previous sensor readings.
 	// Note: % isn't actually a modulo, hence the additional 256.
 	RTT::os::TimeService::nsecs deltaTime =
 		((((int16_t) *timingCounter) + 256 - ((int16_t) timingCounterValue)) % 256)
-		* CONTROLLER_LOOP_PERIOD_NS;
+		* controlPeriod;
 	timingCounterValue = *timingCounter;
 	
-	atrias_msgs::robot_state_hip* hip_ptr;
-	switch(*id) {
-		case MEDULLA_LEFT_HIP_ID:
-			hip_ptr = &(robot_state.lLeg.hip);
-			robot_state.currentPositive = ((double)(*currentPositive - ROBOT_CURRENT_POS_50A_OFFSET))*ROBOT_CURRENT_50A_GAIN;
-			robot_state.currentNegative = ((double)(*currentNegative - ROBOT_CURRENT_NEG_50A_OFFSET))*ROBOT_CURRENT_50A_GAIN;
-			break;
-		case MEDULLA_RIGHT_HIP_ID:
-			hip_ptr = &(robot_state.rLeg.hip);
-			break;
-		default:
-			return;
+	// Only the left hip has the robot's current sensors.
+	if (reportsBusCurrent) {
+		robot_state.currentPositive = ((double)(*currentPositive - ROBOT_CURRENT_POS_50A_OFFSET))*ROBOT_CURRENT_50A_GAIN;
+		robot_state.currentNegative = ((double)(*currentNegative - ROBOT_CURRENT_NEG_50A_OFFSET))*ROBOT_CURRENT_50A_GAIN;
 	}
 	
-	atrias_msgs::robot_state_hip& hip = *hip_ptr;
+	atrias_msgs::robot_state_hip& hip = (robot_state.*leg).hip;
 	
 	updateLimitSwitches(hip, *state == medulla_state_idle);
 	updateEncoderValues(deltaTime, hip);
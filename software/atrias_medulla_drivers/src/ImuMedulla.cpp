@@ -42,7 +42,7 @@ void ImuMedulla::processIMU(RTT::os::TimeService::nsecs deltaTime, atrias_msgs::
 	// TODO: Update this with Ryan's kinemagics.
 
     // DEBUG
-    log(RTT::Info) << "IMU pitch: " << pitch << RTT::endlog();
+    shared::RtLog::log(RTT::Info, "IMU pitch: {}", pitch);
 
 	// Update pitch with negative of gyro Z because pitch vector points in the
 	// opposite direction of the IMU Z vector.
@@ -53,7 +53,7 @@ void ImuMedulla::processIMU(RTT::os::TimeService::nsecs deltaTime, atrias_msgs::
 	robotState.position.imuPitchVelocity = pitch / (((double) deltaTime) / ((double) SECOND_IN_NANOSECONDS));
 }
 
-void ImuMedulla::processTransmitData(atrias_msgs::controller_output& controller_output) {
+void ImuMedulla::processTransmitData(const atrias_msgs::controller_output& controller_output) {
     *counter = ++local_counter;
     *command = controller_output.command;
 }
@@ -68,7 +68,7 @@ void ImuMedulla::processReceiveData(atrias_msgs::robot_state& robot_state) {
     // Note: % isn't actually a modulo, hence the additional 256.
     RTT::os::TimeService::nsecs deltaTime =
         ((((int16_t) *timingCounter) + 256 - ((int16_t) timingCounterValue)) % 256) *
-        CONTROLLER_LOOP_PERIOD_NS;
+        controlPeriod;
     timingCounterValue = *timingCounter;
 
     processIMU(deltaTime, robot_state);
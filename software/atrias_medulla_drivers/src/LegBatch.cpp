@@ -0,0 +1,230 @@
+#include "atrias_medulla_drivers/LegBatch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace atrias {
+
+namespace medullaDrivers {
+
+// The vector type and operations compute() is written in. SSE2 is part of
+// x86-64, so every build we run has it; there are too few legs for wider
+// vectors to pay for a separately built and dispatched variant.
+#if defined(__SSE2__)
+
+#define LEG_BATCH_LANES 2
+typedef __m128d LegVec;
+static inline LegVec vecLoad(const double* p)          { return _mm_load_pd(p); }
+static inline void   vecStore(double* p, LegVec v)     { _mm_store_pd(p, v); }
+static inline LegVec vecSet(double x)                  { return _mm_set1_pd(x); }
+static inline LegVec vecAdd(LegVec a, LegVec b)        { return _mm_add_pd(a, b); }
+static inline LegVec vecSub(LegVec a, LegVec b)        { return _mm_sub_pd(a, b); }
+static inline LegVec vecMul(LegVec a, LegVec b)        { return _mm_mul_pd(a, b); }
+static inline LegVec vecDiv(LegVec a, LegVec b)        { return _mm_div_pd(a, b); }
+
+#else
+
+#define LEG_BATCH_LANES 1
+typedef double LegVec;
+static inline LegVec vecLoad(const double* p)          { return *p; }
+static inline void   vecStore(double* p, LegVec v)     { *p = v; }
+static inline LegVec vecSet(double x)                  { return x; }
+static inline LegVec vecAdd(LegVec a, LegVec b)        { return a + b; }
+static inline LegVec vecSub(LegVec a, LegVec b)        { return a - b; }
+static inline LegVec vecMul(LegVec a, LegVec b)        { return a * b; }
+static inline LegVec vecDiv(LegVec a, LegVec b)        { return a / b; }
+
+#endif
+
+LegBatch::LegBatch() {
+	count = 0;
+
+	// The lanes past the last leg get computed too; start them off as
+	// harmless numbers.
+	double* inFields = (double*) &in;
+	for (size_t i = 0; i < sizeof(in) / sizeof(double); i++)
+		inFields[i] = 1.0;
+}
+
+const char* LegBatch::getInstructionSet() {
+#if defined(__SSE2__)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+void LegBatch::gather(LegMedulla* leg) {
+	size_t i = count++;
+	legs[i]  = leg;
+
+	// Note: % isn't actually a modulo, hence the additional 256.
+	in.deltaTime[i] = (double) (((((int16_t) *leg->timingCounter) + 256 -
+	                              ((int16_t) leg->timingCounterValue)) % 256) * leg->controlPeriod);
+	leg->timingCounterValue = *leg->timingCounter;
+
+	leg->checkErroneousEncoderValues();
+
+	// The absolute encoders. The difference LegMedulla takes in integers
+	// comes out the same when taken in doubles, as every value is under 2^53.
+	in.motorTicks[i]     = (double) *leg->motorEncoder;
+	in.motorCalibVal[i]  = (double) leg->motorCalibVal;
+	in.motorRadPerCnt[i] = leg->motorRadPerCnt;
+	in.motorTimestamp[i] = (double) (*leg->motorEncoderTimestamp - leg->motorEncoderTimestampValue);
+	in.motorDt[i]        = leg->motorEncoderDt;
+	in.legTicks[i]       = (double) *leg->legEncoder;
+	in.legCalibVal[i]    = (double) leg->legCalibVal;
+	in.legRadPerCnt[i]   = leg->legRadPerCnt;
+	in.legTimestamp[i]   = (double) (*leg->legEncoderTimestamp - leg->legEncoderTimestampValue);
+	in.legDt[i]          = leg->legEncoderDt;
+	in.legOffset[i]      = leg->legPositionOffset;
+	in.calibLoc[i]       = leg->calibLoc;
+
+	leg->motorEncoderValue          = (int64_t) *leg->motorEncoder;
+	leg->motorEncoderTimestampValue = *leg->motorEncoderTimestamp;
+	leg->legEncoderValue            = (int64_t) *leg->legEncoder;
+	leg->legEncoderTimestampValue   = *leg->legEncoderTimestamp;
+
+	// The incremental encoder. This compensates for wraparound.
+	int16_t deltaPos = ((int32_t) *leg->incrementalEncoder + (1 << 15) - leg->incrementalEncoderValue) % (1 << 16) - (1 << 15);
+	leg->incrementalEncoderValue += deltaPos;
+	leg->incrementalEncoderPos   += deltaPos;
+
+	in.incPos[i]       = (double) leg->incrementalEncoderPos;
+	in.incStart[i]     = leg->incrementalEncoderStart;
+	in.incTimestamp[i] = (double) (*leg->incrementalEncoderTimestamp - leg->incrementalEncoderTimestampValue);
+	in.direction[i]    = (double) leg->motorDirection;
+	leg->incrementalEncoderTimestampValue = *leg->incrementalEncoderTimestamp;
+
+	// The amplifier currents. The voltages are table lookups, done in scatter().
+	in.amp1Current[i]  = (double) *leg->amp1MeasuredCurrent;
+	in.amp2Current[i]  = (double) *leg->amp2MeasuredCurrent;
+}
+
+void LegBatch::compute() {
+	// Each expression matches the one in LegMedulla or Medulla, operation for operation.
+	const LegVec nsPerSec    = vecSet(1000000000.0);
+	const LegVec timerFreq   = vecSet(MEDULLA_TIMER_FREQ);
+	const LegVec incRadTick  = vecSet(INC_ENC_RAD_PER_TICK);
+	const LegVec ampScale    = vecSet(60.0);
+	const LegVec ampRange    = vecSet(8192);
+
+	for (size_t i = 0; i < count; i += LEG_BATCH_LANES) {
+		LegVec calibLoc  = vecLoad(&in.calibLoc[i]);
+		LegVec seconds   = vecDiv(vecLoad(&in.deltaTime[i]), nsPerSec);
+
+		// encTicksToRad()
+		LegVec motorTicks = vecLoad(&in.motorTicks[i]);
+		LegVec motorRpc   = vecLoad(&in.motorRadPerCnt[i]);
+		vecStore(&out.motorAngle[i],
+			vecAdd(calibLoc, vecMul(vecSub(motorTicks, vecLoad(&in.motorCalibVal[i])), motorRpc)));
+
+		LegVec legTicks   = vecLoad(&in.legTicks[i]);
+		LegVec legRpc     = vecLoad(&in.legRadPerCnt[i]);
+		vecStore(&out.legAngle[i],
+			vecAdd(vecAdd(calibLoc, vecMul(vecSub(legTicks, vecLoad(&in.legCalibVal[i])), legRpc)),
+			       vecLoad(&in.legOffset[i])));
+
+		// processVelocities()
+		LegVec motorDt = vecAdd(vecLoad(&in.motorDt[i]),
+			vecAdd(seconds, vecDiv(vecLoad(&in.motorTimestamp[i]), timerFreq)));
+		LegVec legDt   = vecAdd(vecLoad(&in.legDt[i]),
+			vecAdd(seconds, vecDiv(vecLoad(&in.legTimestamp[i]), timerFreq)));
+		vecStore(&out.motorDt[i], motorDt);
+		vecStore(&out.legDt[i],   legDt);
+
+		// processIncrementalEncoders()
+		vecStore(&out.rotorDt[i], vecAdd(seconds, vecDiv(vecLoad(&in.incTimestamp[i]), timerFreq)));
+		vecStore(&out.rotorAngle[i],
+			vecSub(vecLoad(&in.incStart[i]),
+			       vecMul(vecMul(incRadTick, vecLoad(&in.incPos[i])), vecLoad(&in.direction[i]))));
+
+		// processCurrents()
+		LegVec amp1 = vecDiv(vecMul(vecLoad(&in.amp1Current[i]), ampScale), ampRange);
+		LegVec amp2 = vecDiv(vecMul(vecLoad(&in.amp2Current[i]), ampScale), ampRange);
+		vecStore(&out.amp1Current[i],  amp1);
+		vecStore(&out.amp2Current[i],  amp2);
+		vecStore(&out.motorCurrent[i], vecAdd(amp1, amp2));
+	}
+}
+
+void LegBatch::scatter(atrias_msgs::robot_state &robot_state) {
+	for (size_t i = 0; i < count; i++) {
+		LegMedulla* leg = legs[i];
+		atrias_msgs::robot_state_leg     &legState = robot_state.*(leg->leg);
+		atrias_msgs::robot_state_legHalf &legHalf  = legState.*(leg->half);
+
+		// Encoders that jumped (or didn't move) keep their old values, and
+		// their velocities get measured over the following cycles instead.
+		if (!leg->skipMotorEncoder) {
+			legHalf.motorAngle    = out.motorAngle[i];
+			leg->motorVelocityEstimator.update(out.motorAngle[i], out.motorDt[i]);
+			legHalf.motorVelocity = leg->motorVelocityEstimator.getVel();
+			leg->motorEncoderDt   = 0;
+		} else {
+			leg->motorEncoderDt   = out.motorDt[i];
+		}
+		if (!leg->skipLegEncoder) {
+			legHalf.legAngle      = out.legAngle[i];
+			leg->legVelocityEstimator.update(out.legAngle[i], out.legDt[i]);
+			legHalf.legVelocity   = leg->legVelocityEstimator.getVel();
+			leg->legEncoderDt     = 0;
+		} else {
+			leg->legEncoderDt     = out.legDt[i];
+		}
+
+		legHalf.rotorAngle    = out.rotorAngle[i];
+		leg->rotorVelocityEstimator.update(out.rotorAngle[i], out.rotorDt[i]);
+		legHalf.rotorVelocity = leg->rotorVelocityEstimator.getVel();
+
+		leg->processThermistors(robot_state);
+		leg->processLimitSwitches(robot_state, *leg->state == medulla_state_idle);
+
+		leg->processVoltages(robot_state);
+
+		legHalf.amp1Current  = out.amp1Current[i];
+		legHalf.amp2Current  = out.amp2Current[i];
+		legHalf.motorCurrent = out.motorCurrent[i];
+
+		leg->processStrainGauges(robot_state);
+
+		legHalf.medullaState = *leg->state;
+		legHalf.errorFlags   = *leg->errorFlags;
+		if (!leg->isHalfA) {
+			legState.toeSwitch = *leg->toeSensor;
+			legState.onGround  = leg->toeDetect();
+		}
+	}
+}
+
+void LegBatch::processReceiveData(LegMedulla* const* leg_drivers, size_t leg_count,
+                                  atrias_msgs::robot_state &robot_state) {
+	count = 0;
+	for (size_t i = 0; i < leg_count; i++) {
+		LegMedulla* leg = leg_drivers[i];
+
+		// As in LegMedulla::processReceiveData(), skip legs without new data.
+		if (!leg->mapped || *leg->timingCounter == leg->timingCounterValue)
+			continue;
+
+		gather(leg);
+		if (count == LEG_BATCH_MAX_LEGS) {
+			compute();
+			scatter(robot_state);
+			count = 0;
+		}
+	}
+
+	if (count) {
+		compute();
+		scatter(robot_state);
+		count = 0;
+	}
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -5,6 +5,7 @@ namespace atrias {
 namespace medullaDrivers {
 
 LegMedulla::LegMedulla() : Medulla() {
+	mapped = false;
 	pdoEntryDatas[0]  = {1, (void**) &command};
 	pdoEntryDatas[1]  = {2, (void**) &counter};
 	pdoEntryDatas[2]  = {4, (void**) &motorCurrent};
@@ -40,6 +41,7 @@ PDORegData LegMedulla::getPDORegData() {
 };
 
 void LegMedulla::postOpInit() {
+	mapTargets();
 	motorEncoderValue                = (int64_t) *motorEncoder;
 	motorEncoderTimestampValue       =           *motorEncoderTimestamp;
 	legEncoderValue                  = (int64_t) *legEncoder;
@@ -53,41 +55,93 @@ void LegMedulla::postOpInit() {
 	toeCounter                       =           0;
 	legEncoderDt                     =           0;
 	motorEncoderDt                   =           0;
+	motorVelocityEstimator.setWindow(velocityWindow);
+	legVelocityEstimator.setWindow(velocityWindow);
+	rotorVelocityEstimator.setWindow(velocityWindow);
 	updatePositionOffsets();
 }
 
-void LegMedulla::updatePositionOffsets() {
-	skipMotorEncoder      = false;
-	skipLegEncoder        = false;
-	legPositionOffset     = 0.0;
-    incrementalEncoderPos = 0.0;
-	atrias_msgs::robot_state robotState;
-	processPositions(robotState);
+void LegMedulla::mapTargets() {
+	mapped = true;
 	switch (*id) {
 		case MEDULLA_LEFT_LEG_A_ID:
-			legPositionOffset = robotState.lLeg.halfA.motorAngle -
-			                    robotState.lLeg.halfA.legAngle;
-			incrementalEncoderStart = robotState.lLeg.halfA.motorAngle;
+			leg                = &atrias_msgs::robot_state::lLeg;
+			half               = &atrias_msgs::robot_state_leg::halfA;
+			legOutput          = &atrias_msgs::controller_output::lLeg;
+			motorCurrentOutput = &atrias_msgs::controller_output_leg::motorCurrentA;
+			isHalfA            = true;
+			motorCalibVal      = LEFT_TRAN_A_CALIB_VAL;
+			motorRadPerCnt     = LEFT_TRAN_A_RAD_PER_CNT;
+			legCalibVal        = LEFT_LEG_A_CALIB_VAL;
+			legRadPerCnt       = LEFT_LEG_A_RAD_PER_CNT;
+			calibLoc           = LEG_A_CALIB_LOC;
+			motorDirection     = LEFT_MOTOR_A_DIRECTION;
 			break;
 		case MEDULLA_LEFT_LEG_B_ID:
-			legPositionOffset = robotState.lLeg.halfB.motorAngle -
-			                    robotState.lLeg.halfB.legAngle;
-			incrementalEncoderStart = robotState.lLeg.halfB.motorAngle;
+			leg                = &atrias_msgs::robot_state::lLeg;
+			half               = &atrias_msgs::robot_state_leg::halfB;
+			legOutput          = &atrias_msgs::controller_output::lLeg;
+			motorCurrentOutput = &atrias_msgs::controller_output_leg::motorCurrentB;
+			isHalfA            = false;
+			motorCalibVal      = LEFT_TRAN_B_CALIB_VAL;
+			motorRadPerCnt     = LEFT_TRAN_B_RAD_PER_CNT;
+			legCalibVal        = LEFT_LEG_B_CALIB_VAL;
+			legRadPerCnt       = LEFT_LEG_B_RAD_PER_CNT;
+			calibLoc           = LEG_B_CALIB_LOC;
+			motorDirection     = LEFT_MOTOR_B_DIRECTION;
 			break;
 		case MEDULLA_RIGHT_LEG_A_ID:
-			legPositionOffset = robotState.rLeg.halfA.motorAngle -
-			                    robotState.rLeg.halfA.legAngle;
-			incrementalEncoderStart = robotState.rLeg.halfA.motorAngle;
+			leg                = &atrias_msgs::robot_state::rLeg;
+			half               = &atrias_msgs::robot_state_leg::halfA;
+			legOutput          = &atrias_msgs::controller_output::rLeg;
+			motorCurrentOutput = &atrias_msgs::controller_output_leg::motorCurrentA;
+			isHalfA            = true;
+			motorCalibVal      = RIGHT_TRAN_A_CALIB_VAL;
+			motorRadPerCnt     = RIGHT_TRAN_A_RAD_PER_CNT;
+			legCalibVal        = RIGHT_LEG_A_CALIB_VAL;
+			legRadPerCnt       = RIGHT_LEG_A_RAD_PER_CNT;
+			calibLoc           = LEG_A_CALIB_LOC;
+			motorDirection     = RIGHT_MOTOR_A_DIRECTION;
 			break;
 		case MEDULLA_RIGHT_LEG_B_ID:
-			legPositionOffset = robotState.rLeg.halfB.motorAngle -
-			                    robotState.rLeg.halfB.legAngle;
-			incrementalEncoderStart = robotState.rLeg.halfB.motorAngle;
+			leg                = &atrias_msgs::robot_state::rLeg;
+			half               = &atrias_msgs::robot_state_leg::halfB;
+			legOutput          = &atrias_msgs::controller_output::rLeg;
+			motorCurrentOutput = &atrias_msgs::controller_output_leg::motorCurrentB;
+			isHalfA            = false;
+			motorCalibVal      = RIGHT_TRAN_B_CALIB_VAL;
+			motorRadPerCnt     = RIGHT_TRAN_B_RAD_PER_CNT;
+			legCalibVal        = RIGHT_LEG_B_CALIB_VAL;
+			legRadPerCnt       = RIGHT_LEG_B_RAD_PER_CNT;
+			calibLoc           = LEG_B_CALIB_LOC;
+			motorDirection     = RIGHT_MOTOR_B_DIRECTION;
+			break;
+		default:
+			mapped = false;
 			break;
 	}
+}
+
+bool LegMedulla::isMapped() {
+	return mapped;
+}
+
+void LegMedulla::updatePositionOffsets() {
+	skipMotorEncoder      = false;
+	skipLegEncoder        = false;
+	legPositionOffset     = 0.0;
+    incrementalEncoderPos = 0.0;
+	if (!mapped)
+		return;
+	
+	atrias_msgs::robot_state robotState;
+	processPositions(robotState);
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	legPositionOffset       = legHalf.motorAngle - legHalf.legAngle;
+	incrementalEncoderStart = legHalf.motorAngle;
 	if (fabs(legPositionOffset) > MAX_LEG_POS_ADJUSTMENT) {
-		log(RTT::Warning) << "Leg position adjustment limit exceeded! ID: "
-		                  << getID() << RTT::endlog();
+		shared::RtLog::log(RTT::Warning, "Leg position adjustment limit exceeded! ID: {}",
+		                   getID());
 		legPositionOffset *= MAX_LEG_POS_ADJUSTMENT / fabs(legPositionOffset);
 	}
 }
@@ -129,51 +183,24 @@ void LegMedulla::processIncrementalEncoders(RTT::os::TimeService::nsecs deltaTim
 	
 	incrementalEncoderTimestampValue = *incrementalEncoderTimestamp;
 	
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robotState.lLeg.halfA.rotorAngle    =
-				incrementalEncoderStart -
-				INC_ENC_RAD_PER_TICK * incrementalEncoderPos * LEFT_MOTOR_A_DIRECTION;
-			robotState.lLeg.halfA.rotorVelocity =
-				((double) deltaPos) * INC_ENC_RAD_PER_TICK * -LEFT_MOTOR_A_DIRECTION / adjustedTime;
-			break;
-			
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.halfB.rotorAngle    =
-				incrementalEncoderStart -
-				INC_ENC_RAD_PER_TICK * incrementalEncoderPos * LEFT_MOTOR_B_DIRECTION;
-			robotState.lLeg.halfB.rotorVelocity =
-				((double) deltaPos) * INC_ENC_RAD_PER_TICK * -LEFT_MOTOR_B_DIRECTION / adjustedTime;
-			break;
-			
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robotState.rLeg.halfA.rotorAngle    =
-				incrementalEncoderStart -
-				INC_ENC_RAD_PER_TICK * incrementalEncoderPos * RIGHT_MOTOR_A_DIRECTION;
-			robotState.rLeg.halfA.rotorVelocity =
-				((double) deltaPos) * INC_ENC_RAD_PER_TICK * -RIGHT_MOTOR_A_DIRECTION / adjustedTime;
-			break;
-			
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.halfB.rotorAngle    =
-				incrementalEncoderStart -
-				INC_ENC_RAD_PER_TICK * incrementalEncoderPos * RIGHT_MOTOR_B_DIRECTION;
-			robotState.rLeg.halfB.rotorVelocity =
-				((double) deltaPos) * INC_ENC_RAD_PER_TICK * -RIGHT_MOTOR_B_DIRECTION / adjustedTime;
-			break;
-	}
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	legHalf.rotorAngle    =
+		incrementalEncoderStart -
+		INC_ENC_RAD_PER_TICK * incrementalEncoderPos * motorDirection;
+	rotorVelocityEstimator.update(legHalf.rotorAngle, adjustedTime);
+	legHalf.rotorVelocity = rotorVelocityEstimator.getVel();
 }
 
 void LegMedulla::processReceiveData(atrias_msgs::robot_state& robot_state) {
 	// If we don't have new data, don't run. It's pointless, and results in
 	// NaN velocities.
-	if (*timingCounter == timingCounterValue)
+	if (!mapped || *timingCounter == timingCounterValue)
 		return;
 	// Calculate how much time has elapsed since the previous sensor readings.
 	// Note: % isn't actually a modulo, hence the additional 256.
 	RTT::os::TimeService::nsecs deltaTime =
 		((((int16_t) *timingCounter) + 256 - ((int16_t) timingCounterValue)) % 256)
-		* CONTROLLER_LOOP_PERIOD_NS;
+		* controlPeriod;
 	timingCounterValue = *timingCounter;
 	
 	checkErroneousEncoderValues();
@@ -186,51 +213,26 @@ void LegMedulla::processReceiveData(atrias_msgs::robot_state& robot_state) {
 	processVoltages(robot_state);
 	processCurrents(robot_state);
 	processStrainGauges(robot_state);
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robot_state.lLeg.halfA.medullaState = *state;
-			robot_state.lLeg.halfA.errorFlags   = *errorFlags;
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			robot_state.lLeg.halfB.medullaState = *state;
-			robot_state.lLeg.halfB.errorFlags   = *errorFlags;
-			robot_state.lLeg.toeSwitch          = *toeSensor;
-			robot_state.lLeg.onGround           = toeDetect();
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robot_state.rLeg.halfA.medullaState = *state;
-			robot_state.rLeg.halfA.errorFlags   = *errorFlags;
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robot_state.rLeg.halfB.medullaState = *state;
-			robot_state.rLeg.halfB.errorFlags   = *errorFlags;
-			robot_state.rLeg.toeSwitch          = *toeSensor;
-			robot_state.rLeg.onGround           = toeDetect();
-			break;
+	
+	atrias_msgs::robot_state_leg     &legState = robot_state.*leg;
+	atrias_msgs::robot_state_legHalf &legHalf  = legState.*half;
+	legHalf.medullaState = *state;
+	legHalf.errorFlags   = *errorFlags;
+	if (!isHalfA) {
+		legState.toeSwitch = *toeSensor;
+		legState.onGround  = toeDetect();
 	}
 }
 
-int32_t LegMedulla::calcMotorCurrentOut(atrias_msgs::controller_output& controllerOutput) {
+int32_t LegMedulla::calcMotorCurrentOut(const atrias_msgs::controller_output& controllerOutput) {
 	// Don't command any amount of torque if we're not enabled.
 	if (controllerOutput.command != medulla_state_run) return 0;
 	
 	// If the ID isn't recognized, command 0 torque.
-	double torqueCmd = 0.0;
+	if (!mapped)
+		return 0;
 	
-	switch(*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			torqueCmd = controllerOutput.lLeg.motorCurrentA * LEFT_MOTOR_A_DIRECTION;
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			torqueCmd = controllerOutput.lLeg.motorCurrentB * LEFT_MOTOR_B_DIRECTION;
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			torqueCmd = controllerOutput.rLeg.motorCurrentA * RIGHT_MOTOR_A_DIRECTION;
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			torqueCmd = controllerOutput.rLeg.motorCurrentB * RIGHT_MOTOR_B_DIRECTION;
-			break;
-	}
+	double torqueCmd = (controllerOutput.*legOutput).*motorCurrentOutput * motorDirection;
 	
 	return (int32_t) (((double) MTR_MAX_COUNT) * torqueCmd / MTR_MAX_CURRENT);
 }
@@ -241,56 +243,11 @@ inline double LegMedulla::encTicksToRad(uint32_t ticks, uint32_t calib_val, doub
 }
 
 void LegMedulla::processPositions(atrias_msgs::robot_state& robotState) {
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			if (!skipMotorEncoder) {
-				//log(RTT::Info) << "Left leg A motor encoder counts: " << *motorEncoder << RTT::endlog();
-				robotState.lLeg.halfA.motorAngle =
-					encTicksToRad(*motorEncoder, LEFT_TRAN_A_CALIB_VAL,  LEFT_TRAN_A_RAD_PER_CNT, LEG_A_CALIB_LOC);
-			}
-			if (!skipLegEncoder) {
-				//log(RTT::Info) << "Left leg A leg encoder counts: " << *legEncoder << RTT::endlog();
-				robotState.lLeg.halfA.legAngle   =
-					encTicksToRad(*legEncoder,   LEFT_LEG_A_CALIB_VAL,   LEFT_LEG_A_RAD_PER_CNT,  LEG_A_CALIB_LOC) + legPositionOffset;
-			}
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			if (!skipMotorEncoder) {
-				//log(RTT::Info) << "Left leg B motor encoder counts: " << *motorEncoder << RTT::endlog();
-				robotState.lLeg.halfB.motorAngle =
-					encTicksToRad(*motorEncoder, LEFT_TRAN_B_CALIB_VAL,  LEFT_TRAN_B_RAD_PER_CNT, LEG_B_CALIB_LOC);
-			}
-			if (!skipLegEncoder) {
-				//log(RTT::Info) << "Left leg B leg encoder counts: " << *legEncoder << RTT::endlog();
-				robotState.lLeg.halfB.legAngle   =
-					encTicksToRad(*legEncoder,   LEFT_LEG_B_CALIB_VAL,   LEFT_LEG_B_RAD_PER_CNT,  LEG_B_CALIB_LOC) + legPositionOffset;
-			}
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			if (!skipMotorEncoder) {
-				//log(RTT::Info) << "Right leg A motor encoder counts: " << *motorEncoder << RTT::endlog();
-				robotState.rLeg.halfA.motorAngle =
-					encTicksToRad(*motorEncoder, RIGHT_TRAN_A_CALIB_VAL, RIGHT_TRAN_A_RAD_PER_CNT, LEG_A_CALIB_LOC);
-			}
-			if (!skipLegEncoder) {
-				//log(RTT::Info) << "Right leg A leg encoder counts: " << *legEncoder << RTT::endlog();
-				robotState.rLeg.halfA.legAngle   =
-					encTicksToRad(*legEncoder,   RIGHT_LEG_A_CALIB_VAL,  RIGHT_LEG_A_RAD_PER_CNT,  LEG_A_CALIB_LOC) + legPositionOffset;
-			}
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			if (!skipMotorEncoder) {
-				//log(RTT::Info) << "Right leg B motor encoder counts: " << *motorEncoder << RTT::endlog();
-				robotState.rLeg.halfB.motorAngle =
-					encTicksToRad(*motorEncoder, RIGHT_TRAN_B_CALIB_VAL, RIGHT_TRAN_B_RAD_PER_CNT, LEG_B_CALIB_LOC);
-			}
-			if (!skipLegEncoder) {
-				//log(RTT::Info) << "Right leg B leg encoder counts: " << *legEncoder << RTT::endlog();
-				robotState.rLeg.halfB.legAngle   =
-					encTicksToRad(*legEncoder,   RIGHT_LEG_B_CALIB_VAL,  RIGHT_LEG_B_RAD_PER_CNT,  LEG_B_CALIB_LOC) + legPositionOffset;
-			}
-			break;
-	}
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	if (!skipMotorEncoder)
+		legHalf.motorAngle = encTicksToRad(*motorEncoder, motorCalibVal, motorRadPerCnt, calibLoc);
+	if (!skipLegEncoder)
+		legHalf.legAngle   = encTicksToRad(*legEncoder,   legCalibVal,   legRadPerCnt,   calibLoc) + legPositionOffset;
 }
 
 void LegMedulla::processVelocities(RTT::os::TimeService::nsecs deltaTime, atrias_msgs::robot_state& robotState) {
@@ -298,48 +255,16 @@ void LegMedulla::processVelocities(RTT::os::TimeService::nsecs deltaTime, atrias
 	motorEncoderDt += (((double) deltaTime) / 1000000000.0 + ((double) (*motorEncoderTimestamp - motorEncoderTimestampValue)) / MEDULLA_TIMER_FREQ);
 	legEncoderDt += (((double) deltaTime) / 1000000000.0 + ((double) (*legEncoderTimestamp   - legEncoderTimestampValue))   / MEDULLA_TIMER_FREQ);
 
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			if (!skipMotorEncoder) {
-				// The division by 32 million translates timer ticks from the microcontroller into seconds
-				robotState.lLeg.halfA.motorVelocity =
-					((double) (((int64_t) *motorEncoder) - motorEncoderValue)) * LEFT_TRAN_A_RAD_PER_CNT  / motorEncoderDt;
-			}
-			if (!skipLegEncoder) {
-				robotState.lLeg.halfA.legVelocity   =
-					((double) (((int64_t) *legEncoder)   - legEncoderValue))   * LEFT_LEG_A_RAD_PER_CNT   / legEncoderDt;
-			}
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			if (!skipMotorEncoder) {
-				robotState.lLeg.halfB.motorVelocity =
-					((double) (((int64_t) *motorEncoder) - motorEncoderValue)) * LEFT_TRAN_B_RAD_PER_CNT  / motorEncoderDt;
-			}
-			if (!skipLegEncoder) {
-				robotState.lLeg.halfB.legVelocity   =
-					((double) (((int64_t) *legEncoder)   - legEncoderValue))   * LEFT_LEG_B_RAD_PER_CNT   / legEncoderDt;
-			}
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			if (!skipMotorEncoder) {
-				robotState.rLeg.halfA.motorVelocity =
-					((double) (((int64_t) *motorEncoder) - motorEncoderValue)) * RIGHT_TRAN_A_RAD_PER_CNT / motorEncoderDt;
-			}
-			if (!skipLegEncoder) {
-				robotState.rLeg.halfA.legVelocity   =
-					((double) (((int64_t) *legEncoder)   - legEncoderValue))   * RIGHT_LEG_A_RAD_PER_CNT  / legEncoderDt;
-			}
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			if (!skipMotorEncoder) {
-				robotState.rLeg.halfB.motorVelocity =
-					((double) (((int64_t) *motorEncoder) - motorEncoderValue)) * RIGHT_TRAN_B_RAD_PER_CNT / motorEncoderDt;
-			}
-			if (!skipLegEncoder) {
-				robotState.rLeg.halfB.legVelocity   =
-					((double) (((int64_t) *legEncoder)   - legEncoderValue))   * RIGHT_LEG_B_RAD_PER_CNT  / legEncoderDt;
-			}
-			break;
+	// Skipped readings leave the estimates alone; the next good one is
+	// fit over the whole time since the last good one.
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	if (!skipMotorEncoder) {
+		motorVelocityEstimator.update(legHalf.motorAngle, motorEncoderDt);
+		legHalf.motorVelocity = motorVelocityEstimator.getVel();
+	}
+	if (!skipLegEncoder) {
+		legVelocityEstimator.update(legHalf.legAngle, legEncoderDt);
+		legHalf.legVelocity   = legVelocityEstimator.getVel();
 	}
 
 	motorEncoderValue          = (int64_t) *motorEncoder;
@@ -359,168 +284,62 @@ void LegMedulla::processVelocities(RTT::os::TimeService::nsecs deltaTime, atrias
 }
 
 void LegMedulla::processThermistors(atrias_msgs::robot_state& robotState) {
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robotState.lLeg.halfA.motorTherms[0] = processThermistorValue(*thermistor0);
-			robotState.lLeg.halfA.motorTherms[1] = processThermistorValue(*thermistor1);
-			robotState.lLeg.halfA.motorTherms[2] = processThermistorValue(*thermistor2);
-			robotState.lLeg.halfA.motorTherms[3] = processThermistorValue(*thermistor3);
-			robotState.lLeg.halfA.motorTherms[4] = processThermistorValue(*thermistor4);
-			robotState.lLeg.halfA.motorTherms[5] = processThermistorValue(*thermistor5);
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.halfB.motorTherms[0] = processThermistorValue(*thermistor0);
-			robotState.lLeg.halfB.motorTherms[1] = processThermistorValue(*thermistor1);
-			robotState.lLeg.halfB.motorTherms[2] = processThermistorValue(*thermistor2);
-			robotState.lLeg.halfB.motorTherms[3] = processThermistorValue(*thermistor3);
-			robotState.lLeg.halfB.motorTherms[4] = processThermistorValue(*thermistor4);
-			robotState.lLeg.halfB.motorTherms[5] = processThermistorValue(*thermistor5);
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robotState.rLeg.halfA.motorTherms[0] = processThermistorValue(*thermistor0);
-			robotState.rLeg.halfA.motorTherms[1] = processThermistorValue(*thermistor1);
-			robotState.rLeg.halfA.motorTherms[2] = processThermistorValue(*thermistor2);
-			robotState.rLeg.halfA.motorTherms[3] = processThermistorValue(*thermistor3);
-			robotState.rLeg.halfA.motorTherms[4] = processThermistorValue(*thermistor4);
-			robotState.rLeg.halfA.motorTherms[5] = processThermistorValue(*thermistor5);
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.halfB.motorTherms[0] = processThermistorValue(*thermistor0);
-			robotState.rLeg.halfB.motorTherms[1] = processThermistorValue(*thermistor1);
-			robotState.rLeg.halfB.motorTherms[2] = processThermistorValue(*thermistor2);
-			robotState.rLeg.halfB.motorTherms[3] = processThermistorValue(*thermistor3);
-			robotState.rLeg.halfB.motorTherms[4] = processThermistorValue(*thermistor4);
-			robotState.rLeg.halfB.motorTherms[5] = processThermistorValue(*thermistor5);
-			break;
-	}
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	legHalf.motorTherms[0] = processThermistorValue(*thermistor0);
+	legHalf.motorTherms[1] = processThermistorValue(*thermistor1);
+	legHalf.motorTherms[2] = processThermistorValue(*thermistor2);
+	legHalf.motorTherms[3] = processThermistorValue(*thermistor3);
+	legHalf.motorTherms[4] = processThermistorValue(*thermistor4);
+	legHalf.motorTherms[5] = processThermistorValue(*thermistor5);
 }
 
 void LegMedulla::processCurrents(atrias_msgs::robot_state& robotState) {
 	double current1 = processAmplifierCurrent(*amp1MeasuredCurrent);
 	double current2 = processAmplifierCurrent(*amp2MeasuredCurrent);
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robotState.lLeg.halfA.amp1Current  = current1;
-			robotState.lLeg.halfA.amp2Current  = current2;
-			robotState.lLeg.halfA.motorCurrent = current1 + current2;
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.halfB.amp1Current  = current1;
-			robotState.lLeg.halfB.amp2Current  = current2;
-			robotState.lLeg.halfB.motorCurrent = current1 + current2;
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robotState.rLeg.halfA.amp1Current  = current1;
-			robotState.rLeg.halfA.amp2Current  = current2;
-			robotState.rLeg.halfA.motorCurrent = current1 + current2;
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.halfB.amp1Current  = current1;
-			robotState.rLeg.halfB.amp2Current  = current2;
-			robotState.rLeg.halfB.motorCurrent = current1 + current2;
-			break;
-	}
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	legHalf.amp1Current  = current1;
+	legHalf.amp2Current  = current2;
+	legHalf.motorCurrent = current1 + current2;
 }
 
 void LegMedulla::processLimitSwitches(atrias_msgs::robot_state& robotState, bool reset) {
-	atrias_msgs::robot_state_leg* leg;
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			// Fallthrough
-		case MEDULLA_LEFT_LEG_B_ID:
-			leg = &(robotState.lLeg);
-			break;
-			
-		case MEDULLA_RIGHT_LEG_A_ID:
-			// Fallthrough
-		case MEDULLA_RIGHT_LEG_B_ID:
-			leg = &(robotState.rLeg);
-			break;
-			
-		default:
-			return;
-	}
-
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			// Fallthrough
-		case MEDULLA_RIGHT_LEG_A_ID:
-			if (reset)
-				leg->halfA.limitSwitches = 0;
-			leg->halfA.limitSwitches |= *limitSwitch;
-			leg->halfA.motorNegLimitSwitch = (leg->halfA.limitSwitches) & (1 << 0);
-			leg->halfA.motorPosLimitSwitch = (leg->halfA.limitSwitches) & (1 << 1);
-			leg->halfA.negDeflectSwitch    = (leg->halfA.limitSwitches) & (1 << 2);
-			leg->halfA.posDeflectSwitch    = (leg->halfA.limitSwitches) & (1 << 3);
-			leg->legExtendSwitch           = (leg->halfA.limitSwitches) & (1 << 4);
-			leg->legRetractSwitch          = (leg->halfA.limitSwitches) & (1 << 5);
-			break;
-			
-		case MEDULLA_LEFT_LEG_B_ID:
-			// Fallthrough
-		case MEDULLA_RIGHT_LEG_B_ID:
-			if (reset)
-				leg->halfB.limitSwitches = 0;
-			leg->halfB.limitSwitches |= *limitSwitch;
-			leg->halfB.motorNegLimitSwitch = (leg->halfB.limitSwitches) & (1 << 0);
-			leg->halfB.motorPosLimitSwitch = (leg->halfB.limitSwitches) & (1 << 1);
-			leg->halfB.negDeflectSwitch    = (leg->halfB.limitSwitches) & (1 << 2);
-			leg->halfB.posDeflectSwitch    = (leg->halfB.limitSwitches) & (1 << 3);
-			leg->motorRetractSwitch        = (leg->halfB.limitSwitches) & (1 << 4);
-			break;
+	atrias_msgs::robot_state_leg* legState = &(robotState.*leg);
+
+	if (isHalfA) {
+		if (reset)
+			legState->halfA.limitSwitches = 0;
+		legState->halfA.limitSwitches |= *limitSwitch;
+		legState->halfA.motorNegLimitSwitch = (legState->halfA.limitSwitches) & (1 << 0);
+		legState->halfA.motorPosLimitSwitch = (legState->halfA.limitSwitches) & (1 << 1);
+		legState->halfA.negDeflectSwitch    = (legState->halfA.limitSwitches) & (1 << 2);
+		legState->halfA.posDeflectSwitch    = (legState->halfA.limitSwitches) & (1 << 3);
+		legState->legExtendSwitch           = (legState->halfA.limitSwitches) & (1 << 4);
+		legState->legRetractSwitch          = (legState->halfA.limitSwitches) & (1 << 5);
+	} else {
+		if (reset)
+			legState->halfB.limitSwitches = 0;
+		legState->halfB.limitSwitches |= *limitSwitch;
+		legState->halfB.motorNegLimitSwitch = (legState->halfB.limitSwitches) & (1 << 0);
+		legState->halfB.motorPosLimitSwitch = (legState->halfB.limitSwitches) & (1 << 1);
+		legState->halfB.negDeflectSwitch    = (legState->halfB.limitSwitches) & (1 << 2);
+		legState->halfB.posDeflectSwitch    = (legState->halfB.limitSwitches) & (1 << 3);
+		legState->motorRetractSwitch        = (legState->halfB.limitSwitches) & (1 << 4);
 	}
 }
 
 void LegMedulla::processStrainGauges(atrias_msgs::robot_state& robotState) {
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robotState.lLeg.halfA.kneeForce = ((int32_t) *kneeForce1);// - ((int32_t) *kneeForce2);
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.halfB.kneeForce = ((int32_t) *kneeForce1);// - ((int32_t) *kneeForce2);
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robotState.rLeg.halfA.kneeForce = ((int32_t) *kneeForce1);// - ((int32_t) *kneeForce2);
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.halfB.kneeForce = ((int32_t) *kneeForce1);// - ((int32_t) *kneeForce2);
-			break;
-	}
-
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID: // Fallthrough
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.kneeForce = robotState.lLeg.halfA.kneeForce + robotState.lLeg.halfB.kneeForce;
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID: // Fallthrough
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.kneeForce = robotState.rLeg.halfA.kneeForce + robotState.rLeg.halfB.kneeForce;
-			break;
-	}
+	atrias_msgs::robot_state_leg &legState = robotState.*leg;
+	(legState.*half).kneeForce = ((int32_t) *kneeForce1);// - ((int32_t) *kneeForce2);
+	legState.kneeForce = legState.halfA.kneeForce + legState.halfB.kneeForce;
 }
 
 void LegMedulla::processVoltages(atrias_msgs::robot_state& robotState) {
-	switch (*id) {
-		case MEDULLA_LEFT_LEG_A_ID:
-			robotState.lLeg.halfA.motorVoltage = decodeMotorVoltage(*motorVoltage);
-			robotState.lLeg.halfA.logicVoltage = processADCValue(*logicVoltage) *  6.0;
-			break;
-		case MEDULLA_LEFT_LEG_B_ID:
-			robotState.lLeg.halfB.motorVoltage = decodeMotorVoltage(*motorVoltage);
-			robotState.lLeg.halfB.logicVoltage = processADCValue(*logicVoltage) *  6.0;
-			break;
-		case MEDULLA_RIGHT_LEG_A_ID:
-			robotState.rLeg.halfA.motorVoltage = decodeMotorVoltage(*motorVoltage);
-			robotState.rLeg.halfA.logicVoltage = processADCValue(*logicVoltage) *  6.0;
-			break;
-		case MEDULLA_RIGHT_LEG_B_ID:
-			robotState.rLeg.halfB.motorVoltage = decodeMotorVoltage(*motorVoltage);
-			robotState.rLeg.halfB.logicVoltage = processADCValue(*logicVoltage) *  6.0;
-			break;
-	}
+	atrias_msgs::robot_state_legHalf &legHalf = (robotState.*leg).*half;
+	legHalf.motorVoltage = decodeMotorVoltage(*motorVoltage);
+	legHalf.logicVoltage = decodeLogicVoltage(*logicVoltage);
 }
 
-void LegMedulla::processTransmitData(atrias_msgs::controller_output& controller_output) {
+void LegMedulla::processTransmitData(const atrias_msgs::controller_output& controller_output) {
 	*counter      = ++local_counter;
 	*command      = controller_output.command;
 	*motorCurrent = calcMotorCurrentOut(controller_output);
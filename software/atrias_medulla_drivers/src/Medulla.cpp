@@ -4,26 +4,71 @@ namespace atrias {
 
 namespace medullaDrivers {
 
+// The conversions themselves. These fill in the lookup tables, and handle
+// any readings too big for them.
+
+static double adcToVolts(uint16_t adc_value) {
+	return ((double) adc_value - MEDULLA_ADC_OFFSET_COUNTS) * (MEDULLA_ADC_MAX_VOLTS/(4095.0));
+}
+
+static double adcToLogicVoltage(uint16_t adc_value) {
+	return adcToVolts(adc_value) * 6.0;
+}
+
+static double adcToMotorVoltage(uint16_t adc_value) {
+	return (adc_value-MOTOR_VOLTAGE_C_OFFSET)*MOTOR_VOLTAGE_V_CAL/(MOTOR_VOLTAGE_C_CAL-MOTOR_VOLTAGE_C_OFFSET);
+}
+
+static double adcToThermistorTemp(uint16_t adc_value) {
+	// Whoa...
+	// (Copied directly from the old ucontroller.h).
+	return ((1.0/( (1.0/298.15) + (1.0/3988.0)*log(4700.0/((3.26/adcToVolts(adc_value)) - 1.0)/10000))) - 273.15);
+}
+
+Medulla::AdcLuts::AdcLuts() {
+	for (int i = 0; i < MEDULLA_ADC_LUT_SIZE; i++) {
+		logicVoltage[i] = adcToLogicVoltage(i);
+		motorVoltage[i] = adcToMotorVoltage(i);
+		thermistor[i]   = adcToThermistorTemp(i);
+	}
+}
+
+const Medulla::AdcLuts Medulla::adcLuts;
+
 Medulla::Medulla() {
 	local_counter = 0;
+	controlPeriod  = CONTROLLER_LOOP_PERIOD_NS;
+	velocityWindow = VELOCITY_ESTIMATOR_DEFAULT_WINDOW;
+}
+
+void Medulla::setControlPeriod(int64_t control_period) {
+	controlPeriod = control_period;
+}
+
+void Medulla::setVelocityWindow(int samples) {
+	velocityWindow = samples;
 }
 
 double Medulla::decodeLogicVoltage(uint16_t adc_value) {
-	return processADCValue(adc_value) * 6.0;
+	if (adc_value < MEDULLA_ADC_LUT_SIZE)
+		return adcLuts.logicVoltage[adc_value];
+	return adcToLogicVoltage(adc_value);
 }
 
 double Medulla::decodeMotorVoltage(uint16_t adc_value) {
-	return (adc_value-MOTOR_VOLTAGE_C_OFFSET)*MOTOR_VOLTAGE_V_CAL/(MOTOR_VOLTAGE_C_CAL-MOTOR_VOLTAGE_C_OFFSET);
+	if (adc_value < MEDULLA_ADC_LUT_SIZE)
+		return adcLuts.motorVoltage[adc_value];
+	return adcToMotorVoltage(adc_value);
 }
 
 double Medulla::processADCValue(uint16_t adc_value) {
-	return ((double) adc_value - MEDULLA_ADC_OFFSET_COUNTS) * (MEDULLA_ADC_MAX_VOLTS/(4095.0));
+	return adcToVolts(adc_value);
 }
 
 double Medulla::processThermistorValue(uint16_t adc_value) {
-	// Whoa...
-	// (Copied directly from the old ucontroller.h).
-	return ((1.0/( (1.0/298.15) + (1.0/3988.0)*log(4700.0/((3.26/processADCValue(adc_value)) - 1.0)/10000))) - 273.15);
+	if (adc_value < MEDULLA_ADC_LUT_SIZE)
+		return adcLuts.thermistor[adc_value];
+	return adcToThermistorTemp(adc_value);
 }
 
 double Medulla::processAmplifierCurrent(int16_t value) {
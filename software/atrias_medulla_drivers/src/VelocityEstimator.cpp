@@ -0,0 +1,111 @@
+#include "atrias_medulla_drivers/VelocityEstimator.h"
+
+#include <robot_invariant_defs.h>
+
+namespace atrias {
+
+namespace medullaDrivers {
+
+VelocityEstimator::VelocityEstimator() {
+	setWindow(VELOCITY_ESTIMATOR_DEFAULT_WINDOW);
+}
+
+void VelocityEstimator::setWindow(int samples) {
+	if (samples < 2)
+		samples = 2;
+	if (samples > VELOCITY_ESTIMATOR_MAX_WINDOW)
+		samples = VELOCITY_ESTIMATOR_MAX_WINDOW;
+
+	window = samples;
+	reset();
+}
+
+void VelocityEstimator::reset() {
+	count       = 0;
+	oldest      = 0;
+	newest      = -1;
+	now         = 0.0;
+	sinceResync = 0;
+	sumT        = 0.0;
+	sumX        = 0.0;
+	sumTT       = 0.0;
+	sumTX       = 0.0;
+	velocity    = 0.0;
+}
+
+void VelocityEstimator::update(double position, double delta_time) {
+	if (count) {
+		// Move the origin from the last sample to this one. This keeps
+		// the sums small, so the fit doesn't lose precision over a run.
+		double dt = delta_time;
+		double dx = position - positions[newest];
+		sumTX    += count * dt * dx - dt * sumX - dx * sumT;
+		sumTT    += count * dt * dt - 2.0 * dt * sumT;
+		sumT     -= count * dt;
+		sumX     -= count * dx;
+		now      += dt;
+	}
+
+	// Drop the oldest sample if the window's full.
+	if (count == window) {
+		double t = times[oldest] - now;
+		double x = positions[oldest] - position;
+		sumT    -= t;
+		sumX    -= x;
+		sumTT   -= t * t;
+		sumTX   -= t * x;
+		if (++oldest == window)
+			oldest = 0;
+		count--;
+	}
+
+	// The new sample is the origin, so it adds nothing to the sums but the count.
+	if (++newest == window)
+		newest = 0;
+	times[newest]     = now;
+	positions[newest] = position;
+	count++;
+
+	if (++sinceResync == VELOCITY_ESTIMATOR_RESYNC_PERIOD)
+		resync();
+
+	if (count < 2)
+		return;
+
+	double denominator = count * sumTT - sumT * sumT;
+	if (denominator > 0.0)
+		velocity = (count * sumTX - sumT * sumX) / denominator;
+}
+
+void VelocityEstimator::resync() {
+	sumT  = 0.0;
+	sumX  = 0.0;
+	sumTT = 0.0;
+	sumTX = 0.0;
+	for (int i = 0, j = oldest; i < count; i++) {
+		times[j] -= now;
+
+		double t = times[j];
+		double x = positions[j] - positions[newest];
+		sumT    += t;
+		sumX    += x;
+		sumTT   += t * t;
+		sumTX   += t * x;
+
+		if (++j == window)
+			j = 0;
+	}
+
+	now         = 0.0;
+	sinceResync = 0;
+}
+
+double VelocityEstimator::getVel() {
+	return velocity;
+}
+
+}
+
+}
+
+// vim: noexpandtab
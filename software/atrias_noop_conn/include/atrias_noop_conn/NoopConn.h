@@ -3,7 +3,7 @@
 
 /** @file
   * @brief This is the main class for the no-op connector.
-  * This cycles RT Ops at 1 kHz.
+  * This cycles RT Ops at its control rate (1 kHz by default).
   */
 
 // Orocos
@@ -18,12 +18,13 @@
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/ConnectorInterface.hpp>
 
 namespace atrias {
 
 namespace noopConn {
 
-class NoopConn : public RTT::TaskContext {
+class NoopConn : public RTT::TaskContext, public shared::ConnectorInterface {
 	private:
 		/** @brief By calling this, we cycle RT Ops.
 		  */
@@ -35,6 +36,16 @@ class NoopConn : public RTT::TaskContext {
 		RTT::OperationCaller<void(rtOps::RtOpsEvent, rtOps::RtOpsEventMetadata_t)>
 			sendEvent;
 		
+		/** @brief Gets the control loop period from RT Ops.
+		  */
+		RTT::OperationCaller<RTT::os::TimeService::nsecs(void)>
+			getControlPeriod;
+		
+		/** @brief Lets us report our input-to-output latency.
+		  */
+		RTT::OperationCaller<void(rtOps::CycleStage, RTT::os::TimeService::nsecs)>
+			reportStageTime;
+		
 		/** @brief Holds the robot state to be passed to RT Ops.
 		  */
 		atrias_msgs::robot_state robotState;
@@ -43,6 +54,15 @@ class NoopConn : public RTT::TaskContext {
 		  */
 		bool                     waitingForResponse;
 		
+		/** @brief When we last cycled RT Ops. Used to time the whole cycle.
+		  */
+		RTT::os::TimeService::nsecs cycleStartTime;
+		
+		/** @brief When the last controller output came in. Used for the
+		  * latencies in robot_state_timing.
+		  */
+		RTT::os::TimeService::nsecs transmitTime;
+		
 	public:
 		/** @brief Initializes the Noop Connector
 		  * @param name The name for this component.
@@ -52,7 +72,7 @@ class NoopConn : public RTT::TaskContext {
 		/** @brief Called by RT Ops w/ update controller torques.
 		  * @param controller_output The new controller output.
 		  */
-		void sendControllerOutput(atrias_msgs::controller_output controller_output);
+		void sendControllerOutput(const atrias_msgs::controller_output &controller_output);
 		
 		/** @brief Configures this component.
 		  * Run by Orocos.
@@ -60,7 +80,7 @@ class NoopConn : public RTT::TaskContext {
 		bool configureHook();
 		
 		/** @brief Runs RTOps.
-		  * This is run at 1 kHz by Orocos.
+		  * This is run at RT Ops's control rate by Orocos.
 		  */
 		void updateHook();
 };
@@ -6,15 +6,22 @@ namespace noopConn {
 
 NoopConn::NoopConn(std::string name) :
           RTT::TaskContext(name),
-          newStateCallback("newStateCallback") {
+          newStateCallback("newStateCallback"),
+          getControlPeriod("getControlPeriod"),
+          reportStageTime("reportStageTime") {
 	this->provides("connector")
 	    ->addOperation("sendControllerOutput", &NoopConn::sendControllerOutput, this, RTT::ClientThread);
 	this->requires("atrias_rt")
 	    ->addOperationCaller(newStateCallback);
 	this->requires("atrias_rt")
 	    ->addOperationCaller(sendEvent);
+	this->requires("atrias_rt")
+	    ->addOperationCaller(getControlPeriod);
+	this->requires("atrias_rt")
+	    ->addOperationCaller(reportStageTime);
 	
 	waitingForResponse = false;
+	transmitTime       = 0;
 }
 
 bool NoopConn::configureHook() {
@@ -25,24 +32,43 @@ bool NoopConn::configureHook() {
 	}
 	newStateCallback = peer->provides("rtOps")->getOperation("newStateCallback");
 	sendEvent        = peer->provides("rtOps")->getOperation("sendEvent");
+	reportStageTime  = peer->provides("rtOps")->getOperation("reportStageTime");
+	getControlPeriod = peer->provides("rtOps")->getOperation("getControlPeriod");
+	
+	// Cycle RT Ops at its configured rate.
+	this->setPeriod(((double) getControlPeriod()) / SECOND_IN_NANOSECONDS);
 	log(RTT::Info) << "[NoopConn] configured!" << RTT::endlog();
 	return true;
 }
 
-void NoopConn::sendControllerOutput(atrias_msgs::controller_output controller_output) {
+void NoopConn::sendControllerOutput(const atrias_msgs::controller_output &controller_output) {
+	transmitTime = RTT::os::TimeService::Instance()->getNSecs();
 	waitingForResponse = false;
+	reportStageTime(rtOps::CycleStage::TOTAL, transmitTime - cycleStartTime);
 	return;
 }
 
 void NoopConn::updateHook() {
 	// Check for missed deadlines.
-	if (waitingForResponse)
+	atrias_msgs::robot_state_timing &timing = robotState.timing;
+	if (waitingForResponse) {
 		sendEvent(rtOps::RtOpsEvent::MISSED_DEADLINE, 0);
+		timing.transmitLatency  = -1;
+		timing.actuationLatency = -1;
+	} else if (transmitTime) {
+		// There's nothing to apply the outputs to, so they count as
+		// applied when they arrive. We have no DC clock, so use ours.
+		timing.lastTransmitDCTime = transmitTime;
+		timing.transmitLatency    = transmitTime - cycleStartTime;
+		timing.actuationLatency   = timing.transmitLatency;
+	}
 	waitingForResponse = true;
 	
 	RTT::os::TimeService::nsecs timestamp = RTT::os::TimeService::Instance()->getNSecs();
 	robotState.header.stamp.sec  = timestamp / SECOND_IN_NANOSECONDS;
 	robotState.header.stamp.nsec = timestamp % SECOND_IN_NANOSECONDS;
+	cycleStartTime = RTT::os::TimeService::Instance()->getNSecs();
+	timing.receiveDCTime = cycleStartTime;
 	newStateCallback(robotState);
 }
 
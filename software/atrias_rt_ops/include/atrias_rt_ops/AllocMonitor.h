@@ -0,0 +1,108 @@
+#ifndef ALLOCMONITOR_H
+#define ALLOCMONITOR_H
+
+/** @file
+  * @brief Counts heap allocations and page faults on RT Ops's realtime threads.
+  */
+
+#include <atomic>
+#include <stdint.h>
+
+// Orocos
+#include <rtt/OutputPort.hpp>
+#include <rtt/os/TimeService.hpp>
+
+#include <atrias_shared/globals.h>
+#include <atrias_shared/GuiPublishTimer.h>
+#include <atrias_msgs/rt_ops_alloc.h>
+
+#include "atrias_rt_ops/RTAllocHooks.h"
+
+// How often to send the counts, in milliseconds.
+#define ALLOC_MONITOR_PERIOD_MS 1000
+
+namespace atrias {
+
+namespace rtOps {
+
+class AllocMonitor {
+	/** @brief The port over which we send the counts.
+	  */
+	RTT::OutputPort<atrias_msgs::rt_ops_alloc>* allocOut;
+	
+	/** @brief The preload library's functions, or NULL if it isn't loaded.
+	  */
+	RtAllocSetStageFn  setStageFn;
+	RtAllocGetCountsFn getCountsFn;
+	
+	/** @brief The preload library's counts as of the last message.
+	  */
+	uint64_t           lastAllocs[RT_ALLOC_HOOKS_NUM_SLOTS];
+	uint64_t           lastFrees[RT_ALLOC_HOOKS_NUM_SLOTS];
+	
+	/** @brief Page faults reported by \a sampleFaults(), from every RT thread.
+	  */
+	std::atomic<uint64_t> minorFaults;
+	std::atomic<uint64_t> majorFaults;
+	
+	/** @brief The fault counts as of the last message.
+	  */
+	uint64_t           lastMinorFaults;
+	uint64_t           lastMajorFaults;
+	
+	/** @brief The total counts as of the last cycle, to spot cycles that
+	  * allocated or faulted.
+	  */
+	uint64_t           cycleAllocs;
+	uint64_t           cycleFaults;
+	
+	/** @brief Paces the messages, so this isn't a stream at the control rate.
+	  */
+	shared::GuiPublishTimer publishTimer;
+	
+	/** @brief The message, kept here so sending it doesn't allocate. Its
+	  * cycle counts build up between sends.
+	  */
+	atrias_msgs::rt_ops_alloc allocMsg;
+	
+	public:
+		/** @brief Initializes the AllocMonitor. It starts out disabled.
+		  * @param alloc_out A pointer to the port for the counts.
+		  */
+		AllocMonitor(RTT::OutputPort<atrias_msgs::rt_ops_alloc> *alloc_out);
+		
+		/** @brief Looks for the preload library and enables monitoring if it's there.
+		  * @return Whether monitoring is enabled.
+		  * Not realtime safe.
+		  */
+		bool enable();
+		
+		/** @brief Returns whether monitoring is enabled.
+		  * @return True if librt_alloc_hooks.so is loaded.
+		  */
+		bool isEnabled() const;
+		
+		/** @brief Attributes the calling thread's allocations to a stage from now on.
+		  * @param stage The stage, or CycleStage::NUM_STAGES for "other".
+		  * This also marks the calling thread as realtime.
+		  */
+		void setStage(CycleStage stage);
+		
+		/** @brief Adds the page faults the calling thread took since its last
+		  * call to the counts. Call on each RT thread once per cycle.
+		  */
+		void sampleFaults();
+		
+		/** @brief Ends a cycle, sending the counts since the last message
+		  * every ALLOC_MONITOR_PERIOD_MS. Call once per cycle.
+		  */
+		void endCycle();
+};
+
+}
+
+}
+
+#endif // ALLOCMONITOR_H
+
+// vim: noexpandtab
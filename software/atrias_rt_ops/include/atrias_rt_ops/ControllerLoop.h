@@ -20,9 +20,13 @@ class ControllerLoop;
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <atrias_shared/drl_math.h>
+#include <atrias_shared/RtLog.hpp>
 
 #include "atrias_rt_ops/RTOps.h"
 #include "atrias_rt_ops/StateMachine.h"
+#include "atrias_rt_ops/CycleProfiler.h"
+#include "atrias_rt_ops/AllocMonitor.h"
+#include "atrias_rt_ops/RTHandler.h"
 
 namespace atrias {
 
@@ -53,12 +57,10 @@ class ControllerLoop : public RTT::Activity {
 	  */
 	volatile bool      controllerLoaded;
 	
-	/** @brief Clamps the controller output.
-	  * @param controller_output The un-clamped outputs.
-	  * @return The clamped outputs.
+	/** @brief Clamps the controller output in place.
+	  * @param controller_output The outputs to clamp.
 	  */
-	atrias_msgs::controller_output
-		clampControllerOutput(atrias_msgs::controller_output controller_output);
+	void clampControllerOutput(atrias_msgs::controller_output &controller_output);
 	
 	public:
 		/** @brief Initializes this ControllerLoop.
@@ -75,6 +77,12 @@ class ControllerLoop : public RTT::Activity {
 		  */
 		void setControllerUnloaded();
 		
+		/** @brief Runs the controller, state machine, and output transmission once.
+		  * Called by \a loop() in threaded mode, or directly from the
+		  * connector's thread in inline mode.
+		  */
+		void runCycle();
+		
 		/** @brief Run by Orocos. Is the main loop for the controllers..
 		  */
 		void loop();
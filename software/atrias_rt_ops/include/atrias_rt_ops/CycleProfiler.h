@@ -0,0 +1,90 @@
+#ifndef CYCLEPROFILER_H
+#define CYCLEPROFILER_H
+
+/** @file
+  * @brief Keeps per-stage latency histograms for the RT Ops cycle.
+  */
+
+#include <atomic>
+#include <stdint.h>
+
+// Orocos
+#include <rtt/OutputPort.hpp>
+#include <rtt/os/TimeService.hpp>
+
+#include <atrias_shared/globals.h>
+#include <atrias_shared/GuiPublishTimer.h>
+#include <atrias_shared/LatencyHistogram.hpp>
+#include <atrias_msgs/rt_ops_timing.h>
+
+namespace atrias {
+
+namespace rtOps {
+
+class CycleProfiler {
+	/** @brief One histogram per CycleStage.
+	  * Each stage is only ever recorded by a single thread.
+	  */
+	shared::LatencyHistogram                     histograms[(size_t) CycleStage::NUM_STAGES];
+	
+	/** @brief The most recent duration of each stage, for the flight recorder.
+	  */
+	std::atomic<int32_t>                         lastStageTimes[(size_t) CycleStage::NUM_STAGES];
+	
+	/** @brief The port over which we periodically send the statistics.
+	  */
+	RTT::OutputPort<atrias_msgs::rt_ops_timing>* timingOut;
+	
+	/** @brief Does the timing for the low-rate stream.
+	  */
+	shared::GuiPublishTimer                      publishTimer;
+	
+	/** @brief The message sent by \a publishIfReady(), kept here so sending
+	  * it doesn't allocate.
+	  */
+	atrias_msgs::rt_ops_timing                   timingMsg;
+	
+	/** @brief Fills in a timing message from the histograms.
+	  * @param timing The message to fill in.
+	  */
+	void fillTimingMsg(atrias_msgs::rt_ops_timing &timing);
+	
+	public:
+		/** @brief Initializes the CycleProfiler.
+		  * @param timing_out A pointer to the port for the low-rate statistics.
+		  */
+		CycleProfiler(RTT::OutputPort<atrias_msgs::rt_ops_timing> *timing_out);
+		
+		/** @brief Records how long one stage took this cycle.
+		  * @param stage    The stage.
+		  * @param duration The stage's duration, in nanoseconds.
+		  */
+		void recordStage(CycleStage stage, RTT::os::TimeService::nsecs duration);
+		
+		/** @brief Returns the most recently recorded duration of a stage.
+		  * @param stage The stage.
+		  * @return The duration, in nanoseconds.
+		  */
+		int32_t getLastStageTime(CycleStage stage);
+		
+		/** @brief Sends the statistics if it's time to. Call once per cycle.
+		  */
+		void publishIfReady();
+		
+		/** @brief Returns the current statistics.
+		  * @return The statistics for every stage.
+		  */
+		atrias_msgs::rt_ops_timing getTiming();
+		
+		/** @brief Clears all the histograms.
+		  */
+		void reset();
+};
+
+}
+
+}
+
+#endif // CYCLEPROFILER_H
+
+// vim: noexpandtab
@@ -0,0 +1,192 @@
+#ifndef FLIGHTRECORD_H
+#define FLIGHTRECORD_H
+
+/** @file
+  * @brief The on-disk layout of a flight recorder dump.
+  * A dump is one FlightRecordFileHeader followed by \a numRecords
+  * FlightRecords, oldest first. Both are packed and little-endian.
+  * atrias/scripts/flight2mat.py reads these; keep the two in sync and bump
+  * FLIGHT_RECORD_VERSION whenever this layout changes.
+  */
+
+#include <stdint.h>
+
+// ROS
+#include <std_msgs/Header.h>
+
+#include <atrias_shared/globals.h>
+
+#define FLIGHT_RECORD_MAGIC   "ATRFLTR"
+#define FLIGHT_RECORD_VERSION 3
+
+namespace atrias {
+
+namespace rtOps {
+
+struct __attribute__((packed)) FlightRecordFileHeader {
+	char     magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t numRecords;
+	
+	// The RtOpsEvent that caused this dump, and its metadata
+	int32_t  event;
+	int32_t  metadata;
+	
+	// When the dump was triggered
+	uint64_t triggerTime;
+};
+
+/** @brief One cycle's worth of data.
+  * The fields through rHipMotorVoltage have the same names, types, and
+  * meanings as the ones in atrias_msgs/log_data, so OpsLogger fills both in
+  * with the same code.
+  */
+struct __attribute__((packed)) FlightRecord {
+	struct __attribute__((packed)) Header {
+		uint32_t seq;
+		uint32_t sec;
+		uint32_t nsec;
+		
+		Header& operator=(const std_msgs::Header &header) {
+			seq  = header.seq;
+			sec  = header.stamp.sec;
+			nsec = header.stamp.nsec;
+			return *this;
+		}
+	} header;
+	
+	float    currentPositive;
+	float    currentNegative;
+	
+	float    lAClampedCmd;
+	float    lBClampedCmd;
+	float    lHipClampedCmd;
+	float    rAClampedCmd;
+	float    rBClampedCmd;
+	float    rHipClampedCmd;
+	
+	float    lARawCmd;
+	float    lBRawCmd;
+	float    lHipRawCmd;
+	float    rARawCmd;
+	float    rBRawCmd;
+	float    rHipRawCmd;
+	
+	int32_t  lKneeForce;
+	int32_t  rKneeForce;
+	
+	double   lALegAngle;
+	double   lBLegAngle;
+	double   rALegAngle;
+	double   rBLegAngle;
+	
+	float    lALegVelocity;
+	float    lBLegVelocity;
+	float    rALegVelocity;
+	float    rBLegVelocity;
+	
+	double   lAMotorAngle;
+	double   lBMotorAngle;
+	double   rAMotorAngle;
+	double   rBMotorAngle;
+	
+	float    lAMotorVelocity;
+	float    lBMotorVelocity;
+	float    rAMotorVelocity;
+	float    rBMotorVelocity;
+	
+	double   lARotorAngle;
+	double   lBRotorAngle;
+	double   rARotorAngle;
+	double   rBRotorAngle;
+	
+	float    lARotorVelocity;
+	float    lBRotorVelocity;
+	float    rARotorVelocity;
+	float    rBRotorVelocity;
+	
+	float    lLegBodyAngle;
+	float    rLegBodyAngle;
+	
+	float    lLegBodyVelocity;
+	float    rLegBodyVelocity;
+	
+	float    xPosition;
+	float    xVelocity;
+	float    yPosition;
+	float    yVelocity;
+	float    zPosition;
+	float    zVelocity;
+	float    xAngle;
+	float    xAngleVelocity;
+	
+	float    bodyPitch;
+	float    bodyPitchVelocity;
+	
+	float    boomAngle;
+	float    boomAngleVelocity;
+	
+	uint16_t lToeSwitch;
+	uint16_t rToeSwitch;
+	
+	uint8_t  rtOpsState;
+	
+	uint64_t controllerTime;
+	
+	float    lAMotorTherm0;
+	float    lAMotorTherm1;
+	float    lAMotorTherm2;
+	float    lAMotorTherm3;
+	float    lAMotorTherm4;
+	float    lAMotorTherm5;
+	float    lBMotorTherm0;
+	float    lBMotorTherm1;
+	float    lBMotorTherm2;
+	float    lBMotorTherm3;
+	float    lBMotorTherm4;
+	float    lBMotorTherm5;
+	float    rAMotorTherm0;
+	float    rAMotorTherm1;
+	float    rAMotorTherm2;
+	float    rAMotorTherm3;
+	float    rAMotorTherm4;
+	float    rAMotorTherm5;
+	float    rBMotorTherm0;
+	float    rBMotorTherm1;
+	float    rBMotorTherm2;
+	float    rBMotorTherm3;
+	float    rBMotorTherm4;
+	float    rBMotorTherm5;
+	
+	float    lAMotorVoltage;
+	float    lBMotorVoltage;
+	float    lHipMotorVoltage;
+	float    rAMotorVoltage;
+	float    rBMotorVoltage;
+	float    rHipMotorVoltage;
+	
+	// The rest of the robot_state_timing message
+	uint64_t receiveDCTime;
+	uint64_t lastTransmitDCTime;
+	int32_t  transmitLatency;
+	int32_t  actuationLatency;
+	int32_t  overshoot;
+	int32_t  dcCorrection;
+	int32_t  sleepTime;
+	uint64_t targetTime;
+	int32_t  phaseError;
+	int32_t  phaseJitter;
+	uint8_t  dcLocked;
+	
+	// The most recent duration of each CycleStage, in nanoseconds
+	int32_t  stageTimes[(size_t) CycleStage::NUM_STAGES];
+};
+
+}
+
+}
+
+#endif // FLIGHTRECORD_H
+
+// vim: noexpandtab
@@ -0,0 +1,131 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+/** @file
+  * @brief Keeps the last few seconds of cycles in memory and dumps them to
+  * disk when something goes wrong.
+  */
+
+namespace atrias {
+namespace rtOps {
+class FlightRecorder;
+}
+}
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Orocos
+#include <rtt/OperationCaller.hpp>
+#include <rtt/os/TimeService.hpp>
+
+#include <atrias_shared/globals.h>
+
+#include "atrias_rt_ops/RTOps.h"
+#include "atrias_rt_ops/FlightRecord.h"
+
+namespace atrias {
+
+namespace rtOps {
+
+class FlightRecorder {
+	/** @brief A pointer to RT Ops so we can access its methods.
+	  */
+	RTOps*                        rtOps;
+	
+	/** @brief The ring of records. Sized in \a configure(), never resized while running.
+	  */
+	std::vector<FlightRecord>     records;
+	
+	/** @brief How many records have been committed since configuration.
+	  * The newest record is at (recordCount - 1) % records.size().
+	  */
+	std::atomic<uint64_t>         recordCount;
+	
+	/** @brief Set while the writer is filling in a record.
+	  */
+	std::atomic<bool>             writing;
+	
+	/** @brief Set by \a trigger(); stops recording until the dump is written.
+	  */
+	std::atomic<bool>             frozen;
+	
+	/** @brief What caused the freeze, and when.
+	  */
+	RtOpsEvent                    triggerEvent;
+	RtOpsEventMetadata_t          triggerMetadata;
+	RTT::os::TimeService::nsecs   triggerTime;
+	
+	/** @brief Property: how many cycles to keep.
+	  */
+	int                           capacity;
+	
+	/** @brief Property: the directory dumps are written to.
+	  */
+	std::string                   dumpDir;
+	
+	/** @brief Property: the most dumps we'll write before disarming, so a
+	  * flood of missed deadlines can't fill the disk.
+	  */
+	int                           maxDumps;
+	
+	/** @brief How many dumps we've written. Written by the dump thread and
+	  * read by \a trigger() in the realtime thread.
+	  */
+	std::atomic<int>              dumpCount;
+	
+	/** @brief Writes out the frozen records, then re-arms the recorder.
+	  * Runs in RT Ops's own (non-realtime) thread.
+	  */
+	void dumpBackend();
+	
+	/** @brief Asynchronously runs \a dumpBackend().
+	  */
+	RTT::OperationCaller<void(void)> dumpCaller;
+	
+	public:
+		/** @brief Initializes the FlightRecorder and registers its
+		  * properties and operations with RT Ops.
+		  * @param rt_ops A pointer to RT Ops.
+		  */
+		FlightRecorder(RTOps* rt_ops);
+		
+		/** @brief Allocates the ring. Not realtime safe.
+		  * @return Success.
+		  */
+		bool configure();
+		
+		/** @brief Starts filling in the next record.
+		  * @return The record to fill in, or NULL if the recorder is frozen.
+		  * Only one thread may record. Every non-NULL return must be
+		  * followed by \a commitRecord().
+		  */
+		FlightRecord* beginRecord();
+		
+		/** @brief Finishes the record from \a beginRecord().
+		  * This fills in the stage timings.
+		  */
+		void commitRecord();
+		
+		/** @brief Freezes the recorder and asks for a dump. Realtime safe.
+		  * @param event    What happened.
+		  * @param metadata The event's metadata.
+		  * Does nothing if a dump is already pending.
+		  */
+		void trigger(RtOpsEvent event, RtOpsEventMetadata_t metadata = 0);
+		
+		/** @brief Dumps the recorder now. Meant for the deployer.
+		  */
+		void triggerManual();
+};
+
+}
+
+}
+
+#endif // FLIGHTRECORDER_H
+
+// vim: noexpandtab
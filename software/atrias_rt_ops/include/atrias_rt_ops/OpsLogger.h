@@ -18,10 +18,14 @@
 #include <atrias_msgs/rt_ops_cycle.h>
 #include <atrias_msgs/rt_ops_event.h>
 
+#include "atrias_rt_ops/FlightRecord.h"
+
 namespace atrias {
 
 namespace rtOps {
 
+class FlightRecorder;
+
 class OpsLogger {
 	/** @brief A pointer to the port used to log RT Ops's cyclic data.
 	  */
@@ -42,14 +46,24 @@ class OpsLogger {
 	/** @brief Stores this cycle's RT Ops Cycle message.
 	  */
 	atrias_msgs::rt_ops_cycle                   rtOpsCycle;
+	
+	/** @brief Keeps recent cycles for post-mortems. May be NULL.
+	  */
+	FlightRecorder*                             flightRecorder;
 
 	/**
 	  * @brief Stuffs the robot state data into a log_data message.
 	  * The messages are passed by reference to avoid copies
 	  * (to improve performance).
 	  * @param log_data    The log data into which to stuff the data.
+	  * This also fills in a FlightRecord, which has the same fields.
 	  */
-	void packLogData(atrias_msgs::log_data &log_data);
+	template <class LogData>
+	void packLogData(LogData &log_data);
+	
+	/** @brief Records the cycle being logged in the flight recorder.
+	  */
+	void recordFlightData();
 	
 	public:
 		/** @brief Initializes the OpsLogger.
@@ -60,6 +74,11 @@ class OpsLogger {
 		          RTT::OutputPort<atrias_msgs::rt_ops_cycle> *gui_cyclic_out,
 		          RTT::OutputPort<atrias_msgs::rt_ops_event> *event_out);
 		
+		/** @brief Sets the flight recorder each logged cycle is also written to.
+		  * @param flight_recorder The FlightRecorder.
+		  */
+		void setFlightRecorder(FlightRecorder *flight_recorder);
+		
 		/** @brief Begins a new cycle. This will send out the rt ops cycle message.
 		  */
 		void beginCycle();
@@ -0,0 +1,40 @@
+#ifndef RTALLOCHOOKS_H
+#define RTALLOCHOOKS_H
+
+/** @file
+  * @brief The interface to the optional allocation-tracking preload library.
+  * librt_alloc_hooks.so interposes malloc(), calloc(), realloc(), the
+  * aligned allocators and free() (and therefore new and delete) and counts calls made by threads that marked themselves
+  * realtime. It is opt-in: run the deployer with
+  *   LD_PRELOAD=`rospack find atrias_rt_ops`/lib/librt_alloc_hooks.so
+  * RT Ops looks these functions up at runtime, so it works with or without it.
+  */
+
+#include <stdint.h>
+
+/** @brief The number of stage slots: one per CycleStage, plus one for
+  * allocations outside any RT Ops stage.
+  */
+#define RT_ALLOC_HOOKS_NUM_SLOTS 16
+
+extern "C" {
+
+/** @brief Attributes the calling thread's allocations to a slot.
+  * @param slot The slot (a CycleStage, or NUM_STAGES for "other"), or
+  *             -1 to stop counting this thread.
+  */
+typedef void (*RtAllocSetStageFn)(int slot);
+void atrias_rt_alloc_set_stage(int slot);
+
+/** @brief Reads the running allocation and free counts.
+  * @param allocs Filled with RT_ALLOC_HOOKS_NUM_SLOTS allocation counts.
+  * @param frees  Filled with RT_ALLOC_HOOKS_NUM_SLOTS free counts.
+  */
+typedef void (*RtAllocGetCountsFn)(uint64_t *allocs, uint64_t *frees);
+void atrias_rt_alloc_get_counts(uint64_t *allocs, uint64_t *frees);
+
+}
+
+#endif // RTALLOCHOOKS_H
+
+// vim: noexpandtab
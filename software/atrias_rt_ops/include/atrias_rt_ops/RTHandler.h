@@ -8,8 +8,12 @@
 // Orocos
 #include <rtt/Logger.hpp>
 
+#include <alloca.h>
+#include <malloc.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 namespace atrias {
 
@@ -22,9 +26,20 @@ class RTHandler {
 		RTHandler();
 		
 		/** @brief Enters realtime execution.
-		  * Not realtime safe itself.
+		  * @param heapReserve How many bytes of heap to fault in now, so
+		  *                    allocations made while running don't page fault.
+		  *                    0 leaves the heap alone.
+		  * With a reserve, this also keeps malloc from handing memory back to
+		  * the kernel or using mmap(), either of which would undo the
+		  * prefaulting. Not realtime safe itself.
+		  */
+		void beginRT(size_t heapReserve);
+		
+		/** @brief Faults in the calling thread's stack.
+		  * @param size How many bytes of stack to touch.
+		  * Call once from each realtime thread before it starts cycling.
 		  */
-		void beginRT();
+		static void prefaultStack(size_t size);
 		
 		/** @brief Leaves realtime execution.
 		  * Not realtime safe itself.
@@ -12,6 +12,7 @@ class RTOps;
 }
 
 
+#include <math.h>
 #include <sys/mman.h>
 
 // Orocos
@@ -25,8 +26,13 @@ class RTOps;
 
 #include <atrias_msgs/log_data.h>
 #include <atrias_msgs/robot_state.h>
+#include <atrias_msgs/rt_ops_alloc.h>
 #include <atrias_msgs/rt_ops_event.h>
+#include <atrias_msgs/rt_ops_timing.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/ConnectorInterface.hpp>
+#include <atrias_shared/ControllerInterface.hpp>
+#include <robot_invariant_defs.h>
 
 // This component (RT Ops)'s includes
 #include "atrias_rt_ops/EStopDiags.hpp"
@@ -37,6 +43,9 @@ class RTOps;
 #include "atrias_rt_ops/StateMachine.h"
 #include "atrias_rt_ops/RTHandler.h"
 #include "atrias_rt_ops/Safety.h"
+#include "atrias_rt_ops/CycleProfiler.h"
+#include "atrias_rt_ops/AllocMonitor.h"
+#include "atrias_rt_ops/FlightRecorder.h"
 
 namespace atrias {
 
@@ -58,6 +67,15 @@ class RTOps : public RTT::TaskContext {
 		/** @brief This is the port over which events are sent.
 		  */
 		RTT::OutputPort<atrias_msgs::rt_ops_event>  eventOut;
+		
+		/** @brief This is our low-rate cycle timing statistics output.
+		  */
+		RTT::OutputPort<atrias_msgs::rt_ops_timing> timingOut;
+		
+		/** @brief This is our per-cycle allocation and page fault output.
+		  * Only written when the allocation hooks are preloaded.
+		  */
+		RTT::OutputPort<atrias_msgs::rt_ops_alloc>  allocOut;
 
 		/** @brief This prints out diagnostic information when estops occur
 		  */
@@ -90,6 +108,65 @@ class RTOps : public RTT::TaskContext {
 		/** @brief Implements our safety features.
 		  */
 		Safety*                                     safety;
+		
+		/** @brief Keeps our per-stage cycle timing statistics.
+		  */
+		CycleProfiler                               cycleProfiler;
+		
+		/** @brief Counts allocations and page faults in our RT threads.
+		  */
+		AllocMonitor                                allocMonitor;
+		
+		/** @brief Keeps the last few seconds of cycles for post-mortems.
+		  */
+		FlightRecorder*                             flightRecorder;
+		
+		/** @brief Property: run the controller in the connector's thread.
+		  * When false (the default), newStateCallback() wakes up the separate
+		  * ControllerLoop thread. Only read in startHook().
+		  */
+		bool                                        inlineMode;
+		
+		/** @brief Whether we're actually running in inline mode.
+		  * Latched from \a inlineMode when we start.
+		  */
+		bool                                        runInline;
+		
+		/** @brief Property: the control loop period, in seconds.
+		  * Only read in configureHook().
+		  */
+		double                                      controlPeriod;
+		
+		/** @brief The validated control loop period, in nanoseconds.
+		  */
+		RTT::os::TimeService::nsecs                 controlPeriodNs;
+		
+		/** @brief Property: how much of each RT thread's stack to prefault, in bytes.
+		  */
+		int                                         prefaultStackBytes;
+		
+		/** @brief Property: how much heap to prefault, in bytes. 0 turns
+		  * the heap tuning off. See RTHandler::beginRT().
+		  * Only read in configureHook().
+		  */
+		int                                         prefaultHeapBytes;
+		
+		/** @brief Whether the connector's thread has prefaulted its stack yet.
+		  */
+		bool                                        connStackPrefaulted;
+		
+		/** @brief Property: call the controller and connector directly when
+		  * they're in this process, rather than through RTT operations.
+		  */
+		bool                                        directCalls;
+		
+		/** @brief The controller, if it can be called directly. NULL otherwise.
+		  */
+		shared::ControllerInterface*                directController;
+		
+		/** @brief The connector, if it can be called directly. NULL otherwise.
+		  */
+		shared::ConnectorInterface*                 directConnector;
 
 	public:
 		// Constructor
@@ -98,16 +175,34 @@ class RTOps : public RTT::TaskContext {
 		// Grab timestamp.
 		uint64_t           getTimestamp();
 		
+		/** @brief Returns the control loop period.
+		  * @return The period, in nanoseconds.
+		  * This is the one source of the loop period for the connectors,
+		  * controllers, and RT Ops itself. It is fixed once RT Ops is configured.
+		  */
+		RTT::os::TimeService::nsecs getControlPeriod();
+		
 		/** @brief Lets us run the controllers.
 		  */
-		RTT::OperationCaller<atrias_msgs::controller_output&(atrias_msgs::robot_state&)>
+		RTT::OperationCaller<atrias_msgs::controller_output&(const atrias_msgs::robot_state&)>
 			runController;
 		
 		/** @brief Lets us send the new controller outputs to the Connector.
 		  */
-		RTT::OperationCaller<void(atrias_msgs::controller_output)>
+		RTT::OperationCaller<void(const atrias_msgs::controller_output&)>
 			sendControllerOutput;
 		
+		/** @brief Runs the controller, directly if possible.
+		  * @param robotState The robot state for this cycle.
+		  * @return The controller's output, valid until the next call.
+		  */
+		atrias_msgs::controller_output& callController(const atrias_msgs::robot_state &robotState);
+		
+		/** @brief Sends the controller output to the Connector, directly if possible.
+		  * @param controllerOutput The output to send.
+		  */
+		void               transmitControllerOutput(const atrias_msgs::controller_output &controllerOutput);
+		
 		/** @brief Connects \a runController w/ the top level controller.
 		  */
 		void connectToController();
@@ -163,6 +258,41 @@ class RTOps : public RTT::TaskContext {
 		  */
 		Safety*            getSafety();
 		
+		/** @brief Allows other classes to access the CycleProfiler.
+		  * @return A pointer to the CycleProfiler.
+		  */
+		CycleProfiler*     getCycleProfiler();
+		
+		/** @brief Allows other classes to access the AllocMonitor.
+		  * @return A pointer to the AllocMonitor.
+		  */
+		AllocMonitor*      getAllocMonitor();
+		
+		/** @brief Allows other classes to access the FlightRecorder.
+		  * @return A pointer to the FlightRecorder.
+		  */
+		FlightRecorder*    getFlightRecorder();
+		
+		/** @brief Returns how much of each RT thread's stack to prefault.
+		  * @return The size, in bytes.
+		  */
+		size_t             getPrefaultStackBytes();
+		
+		/** @brief Lets Connectors report how long one of their cycle stages took.
+		  * @param stage    The stage that was timed.
+		  * @param duration The stage's duration, in nanoseconds.
+		  */
+		void               reportStageTime(CycleStage stage, RTT::os::TimeService::nsecs duration);
+		
+		/** @brief Returns the per-stage cycle timing statistics.
+		  * @return The statistics for every stage.
+		  */
+		atrias_msgs::rt_ops_timing getCycleTiming();
+		
+		/** @brief Clears the per-stage cycle timing statistics.
+		  */
+		void               resetCycleTiming();
+		
 		/** @brief Lets Connectors report RT Ops Events.
 		  * @param event    The event to be reported.
 		  * @param metadata The metadata for this event
@@ -7,11 +7,11 @@
 
 class RobotStateHandler;
 
-// Orocos
 #include <rtt/os/Mutex.hpp>
 #include <rtt/os/MutexLock.hpp>
 
 #include <atrias_msgs/robot_state.h>
+#include <atrias_shared/TripleBuffer.hpp>
 #include <robot_invariant_defs.h>
 
 #include "atrias_rt_ops/RTOps.h"
@@ -23,15 +23,21 @@ namespace rtOps {
 class RobotStateHandler {
 	/** @brief Holds a pointer to the main RTOps class.
 	  */
-	RTOps*                   rtOps;
+	RTOps*                                     rtOps;
 	
-	/** @brief Holds the current robot state.
+	/** @brief Passes the robot state from the Connector's thread to the
+	  * controller thread without locking or copying on the reader's side.
 	  */
-	atrias_msgs::robot_state robotState;
+	shared::TripleBuffer<atrias_msgs::robot_state> robotState;
 	
-	/** @brief Protects access to \a robotState. For thread safety.
+	/** @brief A copy of the robot state for other threads, which can't
+	  * read \a robotState's slots. Protected by \a snapshotLock.
 	  */
-	RTT::os::Mutex           robotStateLock;
+	atrias_msgs::robot_state                   snapshot;
+	
+	/** @brief Protects \a snapshot. The Connector's thread only tries it.
+	  */
+	RTT::os::Mutex                             snapshotLock;
 	
 	/** @brief Checks if any Medullas are in error.
 	  */
@@ -43,15 +49,31 @@ class RobotStateHandler {
 		  */
 		RobotStateHandler(RTOps* rt_ops);
 		
-		/** @brief Returns the current robot state (threadsafe).
+		/** @brief Latches the newest robot state for the controller thread.
+		  * Call once at the top of each controller cycle. Wait-free.
+		  */
+		void                            updateRobotState();
+		
+		/** @brief Returns the robot state latched by \a updateRobotState().
 		  * @return The current robot state.
+		  * Only the controller thread may call this. The reference stays valid
+		  * until the next \a updateRobotState().
+		  */
+		const atrias_msgs::robot_state& getRobotState() const;
+		
+		/** @brief Copies out a recent robot state from any other thread.
+		  * @param out Where to store the robot state.
+		  * This may be a cycle or so old, since the Connector skips updating
+		  * the copy while someone's reading it. Not realtime safe; use
+		  * \a getRobotState() in the controller thread.
 		  */
-		atrias_msgs::robot_state getRobotState();
+		void                            copyRobotState(atrias_msgs::robot_state &out);
 		
-		/** @brief Sets the robot state (threadsafe).
-		  * @param newState The new robot state.
+		/** @brief Sets the robot state. Wait-free.
+		  * @param newState The new robot state. Its rtOpsState is filled in.
+		  * Only the Connector's thread may call this.
 		  */
-		void setRobotState(atrias_msgs::robot_state &newState);
+		void                            setRobotState(atrias_msgs::robot_state &newState);
 };
 
 }
@@ -52,6 +52,7 @@ class Safety {
 
 	/**
 	  * @brief This checks for a collision given motor stopping position
+	  * @param robotState The robot state the predictions were made from
 	  * @param lLegAPred The predicted stop location for left A motor
 	  * @param lLegBPred The predicted stop location for left B motor
 	  * @param rLegAPred The predicted stop location for right A motor
@@ -59,7 +60,8 @@ class Safety {
 	  * @return true if there's a collision, false otherwise.
 	  * This function will also send the correct event to report the collision detected
 	  */
-	bool checkCollision(double lLegAPred, double lLegBPred, double rLegAPred, double rLegBPred);
+	bool checkCollision(const atrias_msgs::robot_state &robotState,
+	                    double lLegAPred, double lLegBPred, double rLegAPred, double rLegBPred);
 
 	public:
 		/** @brief Initializes this Safety.
@@ -71,12 +73,13 @@ class Safety {
 		  * @param co The current controller output.
 		  * @return True if an estop is necessary, false otherwise
 		  */
-		bool shouldEStop(atrias_msgs::controller_output &co);
+		bool shouldEStop(const atrias_msgs::controller_output &co);
 		
 		/** @brief Does the halt safety check.
+		  * @param robotState The robot state to check.
 		  * @return Whether or not the robot should halt.
 		  */
-		bool shouldHalt();
+		bool shouldHalt(const atrias_msgs::robot_state &robotState);
 };
 
 }
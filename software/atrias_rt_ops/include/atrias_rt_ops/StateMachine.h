@@ -13,6 +13,7 @@ class StateMachine;
 #include <rtt/os/MutexLock.hpp>
 
 #include <atrias_shared/globals.h>
+#include <atrias_shared/RtLog.hpp>
 #include <robot_invariant_defs.h>
 #include <atrias_msgs/controller_output.h>
 
@@ -65,10 +66,17 @@ class StateMachine {
 		  */
 		void eStop(RtOpsEvent event);
 		
+		/** @brief Halts the robot, if it's enabled.
+		  * Used when the connector can't reliably reach the Medullas; the halt
+		  * takes effect as soon as it can.
+		  */
+		void halt();
+		
 		/** @brief Computes a new state.
+		  * @param controllerOutput This cycle's controller output.
 		  * @return The new desired Medulla state.
 		  */
-		medulla_state_t calcState(atrias_msgs::controller_output controllerOutput);
+		medulla_state_t calcState(const atrias_msgs::controller_output &controllerOutput);
 		
 		/** @brief Sets a new state for the state machine.
 		  * @param new_state The new state.
@@ -36,7 +36,7 @@ class TimestampHandler {
 		/** @brief Sets the timestamp value (threadsafe).
 		  * @param newTimestamp A ROS header w/ the new timestamp.
 		  */
-		void setTimestamp(std_msgs::Header &newTimestamp);
+		void setTimestamp(const std_msgs::Header &newTimestamp);
 		
 		/** @brief Gets the timestamp value (threadsafe).
 		  */
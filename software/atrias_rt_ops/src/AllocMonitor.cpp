@@ -0,0 +1,136 @@
+#include "atrias_rt_ops/AllocMonitor.h"
+
+#include <dlfcn.h>
+#include <sys/resource.h>
+
+namespace atrias {
+
+namespace rtOps {
+
+// Each thread's fault counts as of its last sampleFaults()
+static __thread long threadMinorFaults = -1;
+static __thread long threadMajorFaults = -1;
+
+AllocMonitor::AllocMonitor(RTT::OutputPort<atrias_msgs::rt_ops_alloc> *alloc_out) :
+                           minorFaults(0),
+                           majorFaults(0),
+                           publishTimer(ALLOC_MONITOR_PERIOD_MS) {
+	allocOut        = alloc_out;
+	setStageFn      = NULL;
+	getCountsFn     = NULL;
+	lastMinorFaults = 0;
+	lastMajorFaults = 0;
+	cycleAllocs     = 0;
+	cycleFaults     = 0;
+	allocMsg.cycles                = 0;
+	allocMsg.cyclesWithAllocations = 0;
+	allocMsg.cyclesWithFaults      = 0;
+	
+	for (int i = 0; i < RT_ALLOC_HOOKS_NUM_SLOTS; i++)
+		lastAllocs[i] = lastFrees[i] = 0;
+}
+
+bool AllocMonitor::enable() {
+	setStageFn  = (RtAllocSetStageFn)  dlsym(RTLD_DEFAULT, "atrias_rt_alloc_set_stage");
+	getCountsFn = (RtAllocGetCountsFn) dlsym(RTLD_DEFAULT, "atrias_rt_alloc_get_counts");
+	
+	if (!setStageFn || !getCountsFn) {
+		setStageFn  = NULL;
+		getCountsFn = NULL;
+		return false;
+	}
+	
+	getCountsFn(lastAllocs, lastFrees);
+	for (int i = 0; i < RT_ALLOC_HOOKS_NUM_SLOTS; i++)
+		cycleAllocs += lastAllocs[i];
+	return true;
+}
+
+bool AllocMonitor::isEnabled() const {
+	return setStageFn != NULL;
+}
+
+void AllocMonitor::setStage(CycleStage stage) {
+	if (setStageFn)
+		setStageFn((int) stage);
+}
+
+void AllocMonitor::sampleFaults() {
+	if (!setStageFn)
+		return;
+	
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage))
+		return;
+	
+	// The first sample just sets this thread's baseline.
+	if (threadMinorFaults >= 0) {
+		minorFaults.fetch_add(usage.ru_minflt - threadMinorFaults, std::memory_order_relaxed);
+		majorFaults.fetch_add(usage.ru_majflt - threadMajorFaults, std::memory_order_relaxed);
+	}
+	threadMinorFaults = usage.ru_minflt;
+	threadMajorFaults = usage.ru_majflt;
+}
+
+void AllocMonitor::endCycle() {
+	if (!getCountsFn)
+		return;
+	
+	uint64_t allocs[RT_ALLOC_HOOKS_NUM_SLOTS];
+	uint64_t frees[RT_ALLOC_HOOKS_NUM_SLOTS];
+	getCountsFn(allocs, frees);
+	
+	uint64_t total = 0;
+	for (size_t i = 0; i < RT_ALLOC_HOOKS_NUM_SLOTS; i++)
+		total += allocs[i];
+	
+	uint64_t minor = minorFaults.load(std::memory_order_relaxed);
+	uint64_t major = majorFaults.load(std::memory_order_relaxed);
+	
+	// Count the cycles that allocated or faulted, since a burst in one
+	// cycle and a trickle over many look alike in the totals.
+	allocMsg.cycles++;
+	if (total != cycleAllocs)
+		allocMsg.cyclesWithAllocations++;
+	if (minor + major != cycleFaults)
+		allocMsg.cyclesWithFaults++;
+	cycleAllocs = total;
+	cycleFaults = minor + major;
+	
+	if (!publishTimer.readyToSend())
+		return;
+	
+	for (size_t i = 0; i < RT_ALLOC_HOOKS_NUM_SLOTS; i++) {
+		if (i < allocMsg.allocations.size()) {
+			allocMsg.allocations[i] = allocs[i] - lastAllocs[i];
+			allocMsg.frees[i]       = frees[i]  - lastFrees[i];
+		}
+		lastAllocs[i] = allocs[i];
+		lastFrees[i]  = frees[i];
+	}
+	
+	allocMsg.minorFaults      = minor - lastMinorFaults;
+	allocMsg.majorFaults      = major - lastMajorFaults;
+	lastMinorFaults           = minor;
+	lastMajorFaults           = major;
+	
+	allocMsg.totalAllocations = total;
+	allocMsg.totalMinorFaults = minor;
+	allocMsg.totalMajorFaults = major;
+	
+	RTT::os::TimeService::nsecs now = RTT::os::TimeService::Instance()->getNSecs();
+	allocMsg.header.stamp.sec  = now / SECOND_IN_NANOSECONDS;
+	allocMsg.header.stamp.nsec = now % SECOND_IN_NANOSECONDS;
+	
+	allocOut->write(allocMsg);
+	
+	allocMsg.cycles                = 0;
+	allocMsg.cyclesWithAllocations = 0;
+	allocMsg.cyclesWithFaults      = 0;
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -32,10 +32,7 @@ void ControllerLoop::setControllerUnloaded() {
 	rtOps->disconnectController();
 }
 
-atrias_msgs::controller_output
-	ControllerLoop::clampControllerOutput(
-	atrias_msgs::controller_output controller_output) {
-	
+void ControllerLoop::clampControllerOutput(atrias_msgs::controller_output &controller_output) {
 	controller_output.lLeg.motorCurrentA =
 		CLAMP(controller_output.lLeg.motorCurrentA, MIN_MTR_CURRENT_CMD, MAX_MTR_CURRENT_CMD);
 	controller_output.lLeg.motorCurrentB =
@@ -49,45 +46,75 @@ atrias_msgs::controller_output
 		CLAMP(controller_output.rLeg.motorCurrentB, MIN_MTR_CURRENT_CMD, MAX_MTR_CURRENT_CMD);
 	controller_output.rLeg.motorCurrentHip =
 		CLAMP(controller_output.rLeg.motorCurrentHip, MIN_HIP_MTR_CURRENT_CMD, MAX_HIP_MTR_CURRENT_CMD);
+}
+
+void ControllerLoop::runCycle() {
+	rtOps->getRobotStateHandler()->updateRobotState();
+	const atrias_msgs::robot_state &robotState = rtOps->getRobotStateHandler()->getRobotState();
+	rtOps->getTimestampHandler()->setTimestamp(robotState.header);
+	
+	atrias_msgs::controller_output controllerOutput;
+	
+	CycleProfiler* profiler = rtOps->getCycleProfiler();
+	AllocMonitor*  allocMon = rtOps->getAllocMonitor();
+	RTT::os::TimeService::nsecs stageStart = RTT::os::TimeService::Instance()->getNSecs();
+	RTT::os::TimeService::nsecs stageEnd;
+	
+	allocMon->setStage(CycleStage::CONTROLLER);
+	{
+		RTT::os::MutexLock lock(controllerLock);
+		if (controllerLoaded) {
+			controllerOutput = rtOps->callController(robotState);
+		}
+	}
+	
+	stageEnd = RTT::os::TimeService::Instance()->getNSecs();
+	profiler->recordStage(CycleStage::CONTROLLER, stageEnd - stageStart);
+	stageStart = stageEnd;
+	allocMon->setStage(CycleStage::STATE_MACHINE);
+	
+	controllerOutput.command = rtOps->getStateMachine()->calcState(controllerOutput);
 	
-	return controller_output;
+	stageEnd = RTT::os::TimeService::Instance()->getNSecs();
+	profiler->recordStage(CycleStage::STATE_MACHINE, stageEnd - stageStart);
+	stageStart = stageEnd;
+	allocMon->setStage(CycleStage::CLAMP);
+	
+	rtOps->getOpsLogger()->logControllerOutput(controllerOutput);
+	clampControllerOutput(controllerOutput);
+	rtOps->getOpsLogger()->logClampedControllerOutput(controllerOutput);
+	
+	profiler->recordStage(CycleStage::CLAMP,
+		RTT::os::TimeService::Instance()->getNSecs() - stageStart);
+	allocMon->setStage(CycleStage::NUM_STAGES);
+	
+	if (controllerOutput.command != medulla_state_run) {
+		// Robot should be disabled, so zero current commands.
+		controllerOutput.lLeg.motorCurrentA   = 0.0;
+		controllerOutput.lLeg.motorCurrentB   = 0.0;
+		controllerOutput.lLeg.motorCurrentHip = 0.0;
+		controllerOutput.rLeg.motorCurrentA   = 0.0;
+		controllerOutput.rLeg.motorCurrentB   = 0.0;
+		controllerOutput.rLeg.motorCurrentHip = 0.0;
+	}
+	
+	rtOps->transmitControllerOutput(controllerOutput);
+	rtOps->getOpsLogger()->endCycle();
+	
+	allocMon->sampleFaults();
+	allocMon->endCycle();
 }
 
 void ControllerLoop::loop() {
+	RTHandler::prefaultStack(rtOps->getPrefaultStackBytes());
+	shared::RtLog::registerThread("ControllerLoop");
+	
 	while (!done) {
-		atrias_msgs::robot_state robotState = rtOps->getRobotStateHandler()->getRobotState();
-		rtOps->getTimestampHandler()->setTimestamp(robotState.header);
-		
-		atrias_msgs::controller_output controllerOutput;
-		
-		{
-			RTT::os::MutexLock lock(controllerLock);
-			if (controllerLoaded) {
-				controllerOutput = rtOps->runController(robotState);
-			}
-		}
-		
-		controllerOutput.command = rtOps->getStateMachine()->calcState(controllerOutput);
-		
-		rtOps->getOpsLogger()->logControllerOutput(controllerOutput);
-		controllerOutput = clampControllerOutput(controllerOutput);
-		rtOps->getOpsLogger()->logClampedControllerOutput(controllerOutput);
-		
-		if (controllerOutput.command != medulla_state_run) {
-			// Robot should be disabled, so zero current commands.
-			controllerOutput.lLeg.motorCurrentA   = 0.0;
-			controllerOutput.lLeg.motorCurrentB   = 0.0;
-			controllerOutput.lLeg.motorCurrentHip = 0.0;
-			controllerOutput.rLeg.motorCurrentA   = 0.0;
-			controllerOutput.rLeg.motorCurrentB   = 0.0;
-			controllerOutput.rLeg.motorCurrentHip = 0.0;
-		}
-		
-		rtOps->sendControllerOutput(controllerOutput);
-		rtOps->getOpsLogger()->endCycle();
-		
+		runCycle();
 		signal.wait();
 	}
+	
+	shared::RtLog::unregisterThread();
 }
 
 void ControllerLoop::cycleLoop() {
@@ -0,0 +1,70 @@
+#include "atrias_rt_ops/CycleProfiler.h"
+
+namespace atrias {
+
+namespace rtOps {
+
+CycleProfiler::CycleProfiler(RTT::OutputPort<atrias_msgs::rt_ops_timing> *timing_out) :
+                             publishTimer(1000) {
+	timingOut = timing_out;
+	
+	for (size_t i = 0; i < (size_t) CycleStage::NUM_STAGES; i++)
+		lastStageTimes[i] = 0;
+}
+
+void CycleProfiler::recordStage(CycleStage stage, RTT::os::TimeService::nsecs duration) {
+	if (stage >= CycleStage::NUM_STAGES)
+		return;
+	
+	histograms[(size_t) stage].record(duration);
+	lastStageTimes[(size_t) stage].store(duration, std::memory_order_relaxed);
+}
+
+int32_t CycleProfiler::getLastStageTime(CycleStage stage) {
+	if (stage >= CycleStage::NUM_STAGES)
+		return 0;
+	
+	return lastStageTimes[(size_t) stage].load(std::memory_order_relaxed);
+}
+
+void CycleProfiler::publishIfReady() {
+	if (!publishTimer.readyToSend())
+		return;
+	
+	fillTimingMsg(timingMsg);
+	timingOut->write(timingMsg);
+}
+
+atrias_msgs::rt_ops_timing CycleProfiler::getTiming() {
+	atrias_msgs::rt_ops_timing timing;
+	fillTimingMsg(timing);
+	return timing;
+}
+
+void CycleProfiler::reset() {
+	for (size_t i = 0; i < (size_t) CycleStage::NUM_STAGES; i++)
+		histograms[i].reset();
+}
+
+void CycleProfiler::fillTimingMsg(atrias_msgs::rt_ops_timing &timing) {
+	RTT::os::TimeService::nsecs now = RTT::os::TimeService::Instance()->getNSecs();
+	timing.header.stamp.sec  = now / SECOND_IN_NANOSECONDS;
+	timing.header.stamp.nsec = now % SECOND_IN_NANOSECONDS;
+	
+	for (size_t i = 0; i < (size_t) CycleStage::NUM_STAGES && i < timing.stages.size(); i++) {
+		shared::LatencyHistogram &hist = histograms[i];
+		
+		timing.stages[i].stage = (CycleStage_t) i;
+		timing.stages[i].count = hist.getCount();
+		timing.stages[i].p50   = hist.getPercentile(0.5);
+		timing.stages[i].p99   = hist.getPercentile(0.99);
+		timing.stages[i].p999  = hist.getPercentile(0.999);
+		timing.stages[i].max   = hist.getMax();
+	}
+}
+
+}
+
+}
+
+// vim: noexpandtab
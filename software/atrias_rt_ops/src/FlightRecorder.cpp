@@ -0,0 +1,150 @@
+#include "atrias_rt_ops/FlightRecorder.h"
+
+#include <string.h>
+#include <unistd.h>
+
+namespace atrias {
+
+namespace rtOps {
+
+FlightRecorder::FlightRecorder(RTOps* rt_ops) :
+                               recordCount(0),
+                               writing(false),
+                               frozen(true),
+                               dumpCount(0) {
+	rtOps           = rt_ops;
+	triggerEvent    = RtOpsEvent::NO_EVENT;
+	triggerMetadata = 0;
+	triggerTime     = 0;
+	capacity        = 5000;
+	dumpDir         = "/tmp";
+	maxDumps        = 10;
+	
+	rtOps->addProperty("flightRecorderCycles", capacity)
+	     .doc("How many cycles the flight recorder keeps. Set before configuring.");
+	rtOps->addProperty("flightRecorderDir", dumpDir)
+	     .doc("The directory flight recorder dumps are written to.");
+	rtOps->addProperty("flightRecorderMaxDumps", maxDumps)
+	     .doc("How many flight recorder dumps to write before giving up.");
+	
+	rtOps->addOperation("dumpFlightRecorder", &FlightRecorder::dumpBackend, this, RTT::OwnThread)
+	     .doc("Write the frozen flight recorder out in an asynchronous manner.");
+	dumpCaller = rtOps->getOperation("dumpFlightRecorder");
+	
+	rtOps->provides("flightRecorder")
+	     ->addOperation("dump", &FlightRecorder::triggerManual, this, RTT::ClientThread)
+	     .doc("Dump the last flightRecorderCycles cycles to flightRecorderDir.");
+}
+
+bool FlightRecorder::configure() {
+	if (capacity < 1) {
+		log(RTT::Error) << "[RTOps] flightRecorderCycles must be positive." << RTT::endlog();
+		return false;
+	}
+	
+	// Only resize while frozen, so the writer never sees the vector move.
+	frozen = true;
+	while (writing)
+		usleep(1000);
+	
+	records.assign(capacity, FlightRecord());
+	recordCount = 0;
+	dumpCount   = 0;
+	frozen      = false;
+	
+	log(RTT::Info) << "[RTOps] Flight recorder holds " << capacity << " cycles ("
+	               << capacity * sizeof(FlightRecord) / 1024 << " KiB)." << RTT::endlog();
+	return true;
+}
+
+FlightRecord* FlightRecorder::beginRecord() {
+	writing = true;
+	if (frozen) {
+		writing = false;
+		return NULL;
+	}
+	
+	return &records[recordCount.load(std::memory_order_relaxed) % records.size()];
+}
+
+void FlightRecorder::commitRecord() {
+	FlightRecord  &record   = records[recordCount.load(std::memory_order_relaxed) % records.size()];
+	CycleProfiler *profiler = rtOps->getCycleProfiler();
+	for (size_t i = 0; i < (size_t) CycleStage::NUM_STAGES; i++)
+		record.stageTimes[i] = profiler->getLastStageTime((CycleStage) i);
+	
+	recordCount.fetch_add(1, std::memory_order_release);
+	writing = false;
+}
+
+void FlightRecorder::trigger(RtOpsEvent event, RtOpsEventMetadata_t metadata) {
+	if (dumpCount >= maxDumps || frozen.exchange(true))
+		return;
+	
+	triggerEvent    = event;
+	triggerMetadata = metadata;
+	triggerTime     = RTT::os::TimeService::Instance()->getNSecs();
+	dumpCaller.send();
+}
+
+void FlightRecorder::triggerManual() {
+	trigger(RtOpsEvent::NO_EVENT);
+}
+
+void FlightRecorder::dumpBackend() {
+	// Let the writer finish whatever record it was in the middle of.
+	while (writing)
+		usleep(1000);
+	
+	uint64_t count = recordCount.load(std::memory_order_acquire);
+	size_t   size  = records.size();
+	uint32_t num   = (count < size) ? count : size;
+	
+	// Name the dump by the trigger time to the nanosecond, so two dumps
+	// of the same event within one second don't overwrite each other.
+	char path[256];
+	snprintf(path, sizeof(path), "%s/flight_%llu.%09llu_%d.bin", dumpDir.c_str(),
+	         (unsigned long long) (triggerTime / SECOND_IN_NANOSECONDS),
+	         (unsigned long long) (triggerTime % SECOND_IN_NANOSECONDS), (int) triggerEvent);
+	
+	FlightRecordFileHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, FLIGHT_RECORD_MAGIC, sizeof(header.magic));
+	header.version     = FLIGHT_RECORD_VERSION;
+	header.recordSize  = sizeof(FlightRecord);
+	header.numRecords  = num;
+	header.event       = (int32_t) triggerEvent;
+	header.metadata    = triggerMetadata;
+	header.triggerTime = triggerTime;
+	
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		log(RTT::Error) << "[RTOps] Could not open flight recorder dump " << path << RTT::endlog();
+	} else {
+		// Oldest first. The ring may have wrapped, so this takes up to two writes.
+		size_t first = (count - num) % size;
+		size_t part  = (first + num > size) ? size - first : num;
+		bool   ok    = fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = ok && fwrite(&records[first], sizeof(FlightRecord), part, file) == part;
+		ok = ok && fwrite(&records[0], sizeof(FlightRecord), num - part, file) == num - part;
+		ok = !fclose(file) && ok;
+		
+		if (ok)
+			log(RTT::Info) << "[RTOps] Wrote " << num << " cycles to " << path << RTT::endlog();
+		else
+			log(RTT::Error) << "[RTOps] Failed writing flight recorder dump " << path << RTT::endlog();
+	}
+	
+	if (++dumpCount >= maxDumps)
+		log(RTT::Warning) << "[RTOps] Flight recorder reached flightRecorderMaxDumps; "
+		                  << "no more dumps will be written." << RTT::endlog();
+	
+	// Re-arm. Recording picks up where it left off.
+	frozen = false;
+}
+
+}
+
+}
+
+// vim: noexpandtab
@@ -1,4 +1,5 @@
 #include "atrias_rt_ops/OpsLogger.h"
+#include "atrias_rt_ops/FlightRecorder.h"
 
 namespace atrias {
 
@@ -8,9 +9,14 @@ OpsLogger::OpsLogger(RTT::OutputPort<atrias_msgs::log_data>     *log_cyclic_out,
                      RTT::OutputPort<atrias_msgs::rt_ops_cycle> *gui_cyclic_out,
                      RTT::OutputPort<atrias_msgs::rt_ops_event> *event_out) :
                      guiPublishTimer(50) {
-	logCyclicOut = log_cyclic_out;
-	guiCyclicOut = gui_cyclic_out;
-	eventOut     = event_out;
+	logCyclicOut   = log_cyclic_out;
+	guiCyclicOut   = gui_cyclic_out;
+	eventOut       = event_out;
+	flightRecorder = NULL;
+}
+
+void OpsLogger::setFlightRecorder(FlightRecorder *flight_recorder) {
+	flightRecorder = flight_recorder;
 }
 
 void OpsLogger::beginCycle() {
@@ -41,6 +47,7 @@ void OpsLogger::logRobotState(atrias_msgs::robot_state& state) {
 	atrias_msgs::log_data log_data;
 	packLogData(log_data);
 	logCyclicOut->write(log_data);
+	recordFlightData();
 	rtOpsCycle.header     = state.header;
 	rtOpsCycle.robotState = state;
 }
@@ -52,7 +59,34 @@ void OpsLogger::sendEvent(RtOpsEvent event, RtOpsEventMetadata_t metadata) {
 	eventOut->write(event_msg);
 }
 
-void OpsLogger::packLogData(atrias_msgs::log_data &ld) {
+void OpsLogger::recordFlightData() {
+	if (!flightRecorder)
+		return;
+	
+	FlightRecord *record = flightRecorder->beginRecord();
+	if (!record)
+		return;
+	
+	packLogData(*record);
+	
+	atrias_msgs::robot_state_timing &timing = this->rtOpsCycle.robotState.timing;
+	record->receiveDCTime      = timing.receiveDCTime;
+	record->lastTransmitDCTime = timing.lastTransmitDCTime;
+	record->transmitLatency    = timing.transmitLatency;
+	record->actuationLatency   = timing.actuationLatency;
+	record->overshoot          = timing.overshoot;
+	record->dcCorrection       = timing.dcCorrection;
+	record->sleepTime          = timing.sleepTime;
+	record->targetTime         = timing.targetTime;
+	record->phaseError         = timing.phaseError;
+	record->phaseJitter        = timing.phaseJitter;
+	record->dcLocked           = timing.dcLocked;
+	
+	flightRecorder->commitRecord();
+}
+
+template <class LogData>
+void OpsLogger::packLogData(LogData &ld) {
 	atrias_msgs::robot_state &rs               = this->rtOpsCycle.robotState;
 	atrias_msgs::controller_output &co_raw     = this->rtOpsCycle.controllerOutput;
 	atrias_msgs::controller_output &co_clamped = this->rtOpsCycle.commandedOutput;
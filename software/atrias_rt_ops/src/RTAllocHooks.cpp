@@ -0,0 +1,110 @@
+/** @file
+  * @brief The allocation-tracking preload library. See RTAllocHooks.h.
+  * This is built as its own library and is never linked into RT Ops.
+  */
+
+#include <atomic>
+#include <errno.h>
+#include <stddef.h>
+
+#include "atrias_rt_ops/RTAllocHooks.h"
+
+// glibc's real allocator entry points
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nmemb, size_t size);
+void* __libc_realloc(void *ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void  __libc_free(void *ptr);
+}
+
+namespace {
+
+// Which slot this thread's allocations count towards; -1 if it isn't RT.
+__thread int threadSlot = -1;
+
+std::atomic<uint64_t> allocCounts[RT_ALLOC_HOOKS_NUM_SLOTS];
+std::atomic<uint64_t> freeCounts[RT_ALLOC_HOOKS_NUM_SLOTS];
+
+inline void countAlloc() {
+	if (threadSlot >= 0)
+		allocCounts[threadSlot].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void countFree() {
+	if (threadSlot >= 0)
+		freeCounts[threadSlot].fetch_add(1, std::memory_order_relaxed);
+}
+
+}
+
+extern "C" {
+
+void atrias_rt_alloc_set_stage(int slot) {
+	threadSlot = (slot < RT_ALLOC_HOOKS_NUM_SLOTS) ? slot : RT_ALLOC_HOOKS_NUM_SLOTS - 1;
+}
+
+void atrias_rt_alloc_get_counts(uint64_t *allocs, uint64_t *frees) {
+	for (int i = 0; i < RT_ALLOC_HOOKS_NUM_SLOTS; i++) {
+		allocs[i] = allocCounts[i].load(std::memory_order_relaxed);
+		frees[i]  = freeCounts[i].load(std::memory_order_relaxed);
+	}
+}
+
+// operator new and delete in libstdc++ go through these, so they're counted too.
+
+void* malloc(size_t size) {
+	countAlloc();
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+	countAlloc();
+	return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void *ptr, size_t size) {
+	countAlloc();
+	return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+	countAlloc();
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	countAlloc();
+	return __libc_memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+	countAlloc();
+	return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size) {
+	countAlloc();
+	return __libc_pvalloc(size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+	countAlloc();
+	void *ptr = __libc_memalign(alignment, size);
+	if (!ptr)
+		return ENOMEM;
+	*memptr = ptr;
+	return 0;
+}
+
+void free(void *ptr) {
+	if (ptr)
+		countFree();
+	__libc_free(ptr);
+}
+
+}
+
+// vim: noexpandtab
@@ -12,10 +12,36 @@ RTHandler::RTHandler() {
 	signal(SIGXCPU, signal_handler);
 }
 
-void RTHandler::beginRT() {
+void RTHandler::beginRT(size_t heapReserve) {
 	if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
 		log(RTT::Warning) << "[RTOps] Failed to lock memory!" << RTT::endlog();
 	}
+	
+	if (!heapReserve)
+		return;
+	
+	// Keep freed memory in the heap and serve large blocks from it too.
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+	
+	// Grow the heap once and touch every page. Since trimming is off, the
+	// pages stay mapped (and locked) after the free().
+	char *reserve = (char*) malloc(heapReserve);
+	if (!reserve) {
+		log(RTT::Warning) << "[RTOps] Failed to reserve heap!" << RTT::endlog();
+		return;
+	}
+	long pageSize = sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < heapReserve; i += pageSize)
+		((volatile char*) reserve)[i] = 0;
+	free(reserve);
+}
+
+void RTHandler::prefaultStack(size_t size) {
+	volatile char *stack = (volatile char*) alloca(size);
+	long pageSize = sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < size; i += pageSize)
+		stack[i] = 0;
 }
 
 void RTHandler::endRT() {
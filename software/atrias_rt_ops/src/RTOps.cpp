@@ -10,9 +10,23 @@ RTOps::RTOps(std::string name) :
        logCyclicOut("rt_ops_log_out"),
        guiCyclicOut("rt_ops_gui_out"),
        eventOut("rt_ops_event_out"),
+       timingOut("rt_ops_timing_out"),
+       allocOut("rt_ops_alloc_out"),
        timestampHandler(),
        opsLogger(&logCyclicOut, &guiCyclicOut, &eventOut),
        rtHandler(),
+       cycleProfiler(&timingOut),
+       allocMonitor(&allocOut),
+       inlineMode(false),
+       runInline(false),
+       controlPeriod(((double) CONTROLLER_LOOP_PERIOD_NS) / SECOND_IN_NANOSECONDS),
+       controlPeriodNs(CONTROLLER_LOOP_PERIOD_NS),
+       prefaultStackBytes(128 * 1024),
+       prefaultHeapBytes(0),
+       connStackPrefaulted(false),
+       directCalls(true),
+       directController(NULL),
+       directConnector(NULL),
        runController("runController"),
        sendControllerOutput()
 {
@@ -21,6 +35,9 @@ RTOps::RTOps(std::string name) :
 	    .doc("Get timestamp.");
 	this->provides("timestamps")
 	    ->addOperation("getROSHeader", &RTOps::getROSHeader, this, RTT::ClientThread);
+	this->provides("rtOps")
+	    ->addOperation("getControlPeriod", &RTOps::getControlPeriod, this, RTT::ClientThread)
+	    .doc("Get the control loop period, in nanoseconds.");
 	this->requires("atc")
 	    ->addOperationCaller(runController);
 	this->provides("rtOps")
@@ -29,17 +46,44 @@ RTOps::RTOps(std::string name) :
 	    ->addOperationCaller(sendControllerOutput);
 	this->provides("rtOps")
 	    ->addOperation("sendEvent", &RTOps::sendEvent, this, RTT::ClientThread);
+	this->provides("rtOps")
+	    ->addOperation("reportStageTime", &RTOps::reportStageTime, this, RTT::ClientThread);
+	this->provides("timing")
+	    ->addOperation("getCycleTiming", &RTOps::getCycleTiming, this, RTT::ClientThread)
+	    .doc("Get the p50/p99/p99.9/max latency of each cycle stage.");
+	this->provides("timing")
+	    ->addOperation("resetCycleTiming", &RTOps::resetCycleTiming, this, RTT::ClientThread)
+	    .doc("Clear the cycle timing statistics.");
+	this->provides("rtOps")
+	    ->addOperation("getRtLogDropped", &shared::RtLog::getDropped, RTT::ClientThread)
+	    .doc("Get how many realtime log records have been dropped because a queue was full.");
+	    
+	this->addProperty("controlPeriod", controlPeriod)
+	    .doc("The control loop period, in seconds. Set before configuring.");
+	this->addProperty("inlineMode", inlineMode)
+	    .doc("Run the controller in the connector's thread rather than in its own. Set before starting.");
+	this->addProperty("directCalls", directCalls)
+	    .doc("Call the controller and connector directly, bypassing RTT operations, when possible.");
+	this->addProperty("prefaultStackBytes", prefaultStackBytes)
+	    .doc("How much of each realtime thread's stack to fault in before running, in bytes.");
+	this->addProperty("prefaultHeapBytes", prefaultHeapBytes)
+	    .doc("How much heap to fault in when configuring, in bytes. Also stops malloc from trimming the heap or using mmap(). 0 (the default) leaves malloc alone. Set before configuring.");
 	    
 	addEventPort(cManagerDataIn);
 	addPort(logCyclicOut);
 	addPort(guiCyclicOut);
 	addPort(eventOut);
+	addPort(timingOut);
+	addPort(allocOut);
 
 	eStopDiags        = new EStopDiags(this);
 	controllerLoop    = new ControllerLoop(this);
 	stateMachine      = new StateMachine(this);
 	robotStateHandler = new RobotStateHandler(this);
 	safety            = new Safety(this);
+	flightRecorder    = new FlightRecorder(this);
+	
+	opsLogger.setFlightRecorder(flightRecorder);
 
 	log(RTT::Info) << "[RTOps] constructed!" << RTT::endlog();
 }
@@ -60,12 +104,39 @@ void RTOps::connectToController() {
 		log(RTT::Info) << "runController ready." << RTT::endlog();
 	else
 		log(RTT::Warning) << "runController not ready!" << RTT::endlog();
+	
+	// Only local components can be cast to the interface, so this fails
+	// (and we fall back to the operation) for remote controllers.
+	directController = directCalls ? dynamic_cast<shared::ControllerInterface*>(peer) : NULL;
+	if (directController)
+		log(RTT::Info) << "[RTOps] Calling the controller directly." << RTT::endlog();
 }
 
 void RTOps::disconnectController() {
+	directController = NULL;
 	runController.disconnect();
 }
 
+atrias_msgs::controller_output& RTOps::callController(const atrias_msgs::robot_state &robotState) {
+	if (directController)
+		return directController->runController(robotState);
+	
+	return runController(robotState);
+}
+
+void RTOps::transmitControllerOutput(const atrias_msgs::controller_output &controllerOutput) {
+	if (directConnector) {
+		directConnector->sendControllerOutput(controllerOutput);
+		return;
+	}
+	
+	sendControllerOutput(controllerOutput);
+}
+
+RTT::os::TimeService::nsecs RTOps::getControlPeriod() {
+	return controlPeriodNs;
+}
+
 uint64_t RTOps::getTimestamp() {
 	return timestampHandler.getTimestamp();
 }
@@ -75,12 +146,40 @@ std_msgs::Header RTOps::getROSHeader() {
 }
 
 void RTOps::newStateCallback(atrias_msgs::robot_state state) {
+	RTT::os::TimeService::nsecs startTime = RTT::os::TimeService::Instance()->getNSecs();
+	
+	if (!connStackPrefaulted) {
+		// This is our first call from the connector's thread.
+		RTHandler::prefaultStack(getPrefaultStackBytes());
+		connStackPrefaulted = true;
+	}
+	allocMonitor.setStage(CycleStage::STATE_CALLBACK);
+	
 	opsLogger.beginCycle();
+	cycleProfiler.publishIfReady();
 	robotStateHandler->setRobotState(state);
 	
+	if (runInline) {
+		// Log before running the controller, so the log entry pairs this state
+		// with last cycle's outputs just like it does in threaded mode.
+		opsLogger.logRobotState(state);
+		cycleProfiler.recordStage(CycleStage::STATE_CALLBACK,
+			RTT::os::TimeService::Instance()->getNSecs() - startTime);
+		
+		controllerLoop->runCycle();
+		return;
+	}
+	
 	controllerLoop->cycleLoop();
 	
 	opsLogger.logRobotState(state);
+	
+	cycleProfiler.recordStage(CycleStage::STATE_CALLBACK,
+		RTT::os::TimeService::Instance()->getNSecs() - startTime);
+	
+	// Anything the connector does until its next callback counts as "other".
+	allocMonitor.setStage(CycleStage::NUM_STAGES);
+	allocMonitor.sampleFaults();
 }
 
 EStopDiags* RTOps::getEStopDiags() const {
@@ -111,12 +210,63 @@ Safety* RTOps::getSafety() {
 	return safety;
 }
 
+CycleProfiler* RTOps::getCycleProfiler() {
+	return &cycleProfiler;
+}
+
+AllocMonitor* RTOps::getAllocMonitor() {
+	return &allocMonitor;
+}
+
+FlightRecorder* RTOps::getFlightRecorder() {
+	return flightRecorder;
+}
+
+size_t RTOps::getPrefaultStackBytes() {
+	return (prefaultStackBytes > 0) ? prefaultStackBytes : 0;
+}
+
+void RTOps::reportStageTime(CycleStage stage, RTT::os::TimeService::nsecs duration) {
+	cycleProfiler.recordStage(stage, duration);
+}
+
+atrias_msgs::rt_ops_timing RTOps::getCycleTiming() {
+	return cycleProfiler.getTiming();
+}
+
+void RTOps::resetCycleTiming() {
+	cycleProfiler.reset();
+}
+
 void RTOps::sendEvent(RtOpsEvent event, RtOpsEventMetadata_t metadata) {
 	opsLogger.sendEvent(event, metadata);
+	
+	if (event == RtOpsEvent::MISSED_DEADLINE || event == RtOpsEvent::ECAT_FRAME_LOSS)
+		flightRecorder->trigger(event, metadata);
+	
+	if (event == RtOpsEvent::ECAT_FRAME_LOSS)
+		stateMachine->halt();
 }
 
 bool RTOps::configureHook() {
-	rtHandler.beginRT();
+	RTT::os::TimeService::nsecs period = llround(controlPeriod * SECOND_IN_NANOSECONDS);
+	if (period < MIN_CONTROLLER_LOOP_PERIOD_NS || period > MAX_CONTROLLER_LOOP_PERIOD_NS ||
+	    SECOND_IN_NANOSECONDS % period)
+	{
+		log(RTT::Error) << "[RTOps] Invalid control period " << controlPeriod
+		                << " s; it must evenly divide one second." << RTT::endlog();
+		return false;
+	}
+	controlPeriodNs = period;
+	log(RTT::Info) << "[RTOps] Control period: " << controlPeriodNs << " ns." << RTT::endlog();
+	
+	if (!flightRecorder->configure())
+		return false;
+	
+	rtHandler.beginRT((prefaultHeapBytes > 0) ? prefaultHeapBytes : 0);
+	
+	if (allocMonitor.enable())
+		log(RTT::Info) << "[RTOps] Allocation monitoring enabled." << RTT::endlog();
 	
 	// Connect with the connector.
 	RTT::TaskContext *peer = this->getPeer("atrias_connector");
@@ -126,10 +276,21 @@ bool RTOps::configureHook() {
 	}
 	sendControllerOutput = peer->provides("connector")->getOperation("sendControllerOutput");
 	
+	directConnector = directCalls ? dynamic_cast<shared::ConnectorInterface*>(peer) : NULL;
+	if (directConnector)
+		log(RTT::Info) << "[RTOps] Calling the connector directly." << RTT::endlog();
+	
 	return true;
 }
 
 bool RTOps::startHook() {
+	runInline = inlineMode;
+	if (runInline) {
+		// The connector's thread will run the controller for us.
+		log(RTT::Info) << "[RTOps] started in inline mode." << RTT::endlog();
+		return true;
+	}
+	
 	// Start the main control loop.
 	if (!controllerLoop->start()) {
 		log(RTT::Error) << "[RTOps] Controller loop failed to start!" << RTT::endlog();
@@ -148,7 +309,7 @@ void RTOps::updateHook() {
 
 void RTOps::stopHook() {
 	// Stop the control loop.
-	if (!controllerLoop->stop())
+	if (!runInline && !controllerLoop->stop())
 		log(RTT::Error) << "[RTOps] Controller loop failed to stop! Continuing shutdown" << RTT::endlog();
 	
 	rtHandler.endRT();
@@ -8,9 +8,17 @@ RobotStateHandler::RobotStateHandler(RTOps* rt_ops) {
 	rtOps = rt_ops;
 }
 
-atrias_msgs::robot_state RobotStateHandler::getRobotState() {
-	RTT::os::MutexLock lock(robotStateLock);
-	return robotState;
+void RobotStateHandler::updateRobotState() {
+	robotState.update();
+}
+
+const atrias_msgs::robot_state& RobotStateHandler::getRobotState() const {
+	return robotState.read();
+}
+
+void RobotStateHandler::copyRobotState(atrias_msgs::robot_state &out) {
+	RTT::os::MutexLock lock(snapshotLock);
+	out = snapshot;
 }
 
 void RobotStateHandler::setRobotState(atrias_msgs::robot_state &newState) {
@@ -18,8 +26,14 @@ void RobotStateHandler::setRobotState(atrias_msgs::robot_state &newState) {
 		(RtOpsState_t) rtOps->getStateMachine()->getRtOpsState();
 	checkForNewErrors(newState);
 	
-	RTT::os::MutexLock lock(robotStateLock);
-	robotState = newState;
+	robotState.getWriteBuffer() = newState;
+	robotState.publish();
+	
+	// Don't wait on a reader; it'll get the next one.
+	if (snapshotLock.trylock()) {
+		snapshot = newState;
+		snapshotLock.unlock();
+	}
 }
 
 void RobotStateHandler::checkForNewErrors(atrias_msgs::robot_state &state) {
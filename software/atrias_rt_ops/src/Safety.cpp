@@ -11,7 +11,7 @@ Safety::Safety(RTOps* rt_ops) {
 
 bool Safety::motorHaltCheck(double vel, double &minVel, double &maxVel) {
 	// The rate at which we should be decelerating (rad/s/tick)
-	double decelRate = AVAIL_HALT_AMPS * ACCEL_PER_AMP * CONTROLLER_LOOP_PERIOD_NS / SECOND_IN_NANOSECONDS;
+	double decelRate = AVAIL_HALT_AMPS * ACCEL_PER_AMP * rtOps->getControlPeriod() / SECOND_IN_NANOSECONDS;
 
 	// Update velocity interval
 	minVel = std::min(minVel + decelRate, -MOTOR_VEL_MRGN);
@@ -32,8 +32,8 @@ double Safety::predictStop(double pos, double vel) {
 	return pos + vel * abs(vel) / (2.0 * ACCEL_PER_AMP * AVAIL_HALT_AMPS);
 }
 
-bool Safety::shouldEStop(atrias_msgs::controller_output &co) {
-	atrias_msgs::robot_state robotState = rtOps->getRobotStateHandler()->getRobotState();
+bool Safety::shouldEStop(const atrias_msgs::controller_output &co) {
+	const atrias_msgs::robot_state &robotState = rtOps->getRobotStateHandler()->getRobotState();
 
 	// Check if there are any NaN or Inf values in co. If so, estop
 	if (!std::isfinite(co.lLeg.motorCurrentA)   ||
@@ -79,9 +79,7 @@ bool Safety::shouldEStop(atrias_msgs::controller_output &co) {
 	       motorHaltCheck(robotState.rLeg.halfB.rotorVelocity, rBMinVel, rBMaxVel);
 }
 
-bool Safety::shouldHalt() {
-	atrias_msgs::robot_state robotState = rtOps->getRobotStateHandler()->getRobotState();
-	
+bool Safety::shouldHalt(const atrias_msgs::robot_state &robotState) {
 	// Check for medullas in halt state.
 	if (robotState.boomMedullaState        == medulla_state_halt) {
 		rtOps->getOpsLogger()->sendEvent(RtOpsEvent::SAFETY, (RtOpsEventMetadata_t) RtOpsEventSafetyMetadata::BOOM_MEDULLA_HALT);
@@ -131,7 +129,7 @@ bool Safety::shouldHalt() {
 	double rLegBPred = predictStop(robotState.rLeg.halfB.motorAngle, robotState.rLeg.halfB.rotorVelocity);
 
 	// Check for a collision given this combination of sensor input
-	if (checkCollision(lLegAPred, lLegBPred, rLegAPred, rLegBPred))
+	if (checkCollision(robotState, lLegAPred, lLegBPred, rLegAPred, rLegBPred))
 		return true;
 
 	// Let's also check based purely off the (more reliable) rotor encoders
@@ -140,16 +138,15 @@ bool Safety::shouldHalt() {
 	rLegAPred = predictStop(robotState.rLeg.halfA.rotorAngle, robotState.rLeg.halfA.rotorVelocity);
 	rLegBPred = predictStop(robotState.rLeg.halfB.rotorAngle, robotState.rLeg.halfB.rotorVelocity);
 
-	if (checkCollision(lLegAPred, lLegBPred, rLegAPred, rLegBPred))
+	if (checkCollision(robotState, lLegAPred, lLegBPred, rLegAPred, rLegBPred))
 		return true;
 
 	// If we've made it this far, then we're fine
 	return false;
 }
 
-bool Safety::checkCollision(double lLegAPred, double lLegBPred, double rLegAPred, double rLegBPred) {
-	atrias_msgs::robot_state robotState = rtOps->getRobotStateHandler()->getRobotState();
-
+bool Safety::checkCollision(const atrias_msgs::robot_state &robotState,
+                            double lLegAPred, double lLegBPred, double rLegAPred, double rLegBPred) {
 	// Check if a single motor has exceeded its limits.
 	if (lLegAPred < LEG_A_MOTOR_MIN_LOC + LEG_LOC_SAFETY_DISTANCE) {
 		rtOps->getOpsLogger()->sendEvent(RtOpsEvent::SAFETY, (RtOpsEventMetadata_t) RtOpsEventSafetyMetadata::LEFT_LEG_A_TOO_SMALL);
@@ -14,6 +14,22 @@ void StateMachine::eStop(RtOpsEvent event) {
 	setState(RtOpsState::E_STOP);
 	rtOps->getOpsLogger()->sendEvent(event);
 	rtOps->getEStopDiags()->printEStop(event);
+	rtOps->getFlightRecorder()->trigger(event);
+}
+
+void StateMachine::halt() {
+	{
+		// Hold the lock across the check, so an EStop or controller manager
+		// command can't land in between and get overwritten. This means we
+		// can't go through setState(); since we're leaving ENABLED, its
+		// EStop check doesn't apply anyway.
+		RTT::os::MutexLock lock(currentStateLock);
+		if (currentState != RtOpsState::ENABLED)
+			return;
+		
+		currentState = RtOpsState::HALT;
+	}
+	shared::RtLog::log(RTT::Warning, "Connector halt");
 }
 
 void StateMachine::setState(RtOpsState new_state) {
@@ -63,7 +79,7 @@ void StateMachine::ackCMState(RtOpsState state) {
 	}
 }
 
-medulla_state_t StateMachine::calcState(atrias_msgs::controller_output controllerOutput) {
+medulla_state_t StateMachine::calcState(const atrias_msgs::controller_output &controllerOutput) {
 	switch (getRtOpsState()) {
 		case RtOpsState::E_STOP:
 			return medulla_state_error;
@@ -91,13 +107,13 @@ medulla_state_t StateMachine::calcState(atrias_msgs::controller_output controlle
 				// This is a bit of a kludge -- send the MEDULLA_ESTOP event to tell the GUI and CM that
 				// it's enterinng ESTOP state.
 				eStop(RtOpsEvent::MEDULLA_ESTOP);
-				printf("Software safety estop\n");
+				shared::RtLog::log(RTT::Warning, "Software safety estop");
 				return medulla_state_error;
 			}
 			
-			if (rtOps->getSafety()->shouldHalt()) {
+			if (rtOps->getSafety()->shouldHalt(rtOps->getRobotStateHandler()->getRobotState())) {
 				setState(RtOpsState::HALT);
-				printf("Software safety halt\n");
+				shared::RtLog::log(RTT::Warning, "Software safety halt");
 				return medulla_state_halt;
 			}
 			
@@ -122,13 +138,17 @@ void StateMachine::newCMState(RtOpsState new_state) {
 			rtOps->getControllerLoop()->setControllerLoaded();
 			break;
 			
-		case RtOpsState::ENABLED:
-			if (rtOps->getSafety()->shouldHalt()) {
+		case RtOpsState::ENABLED: {
+			// We're not in the controller thread, so we need our own copy.
+			atrias_msgs::robot_state robotState;
+			rtOps->getRobotStateHandler()->copyRobotState(robotState);
+			if (rtOps->getSafety()->shouldHalt(robotState)) {
 				new_state = RtOpsState::DISABLED;
-				printf("Software safety halt\n");
+				shared::RtLog::log(RTT::Warning, "Software safety halt");
 			}
 			
 			break;
+		}
 			
 		case RtOpsState::RESET:
 			rtOps->getControllerLoop()->setControllerUnloaded();
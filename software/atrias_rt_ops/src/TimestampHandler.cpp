@@ -8,7 +8,7 @@ TimestampHandler::TimestampHandler() {
 	timestamp = 0;
 }
 
-void TimestampHandler::setTimestamp(std_msgs::Header &newTimestamp) {
+void TimestampHandler::setTimestamp(const std_msgs::Header &newTimestamp) {
 	RTT::os::MutexLock lock(timestampLock);
 	timestamp = SECOND_IN_NANOSECONDS * newTimestamp.stamp.sec +
 	                                    newTimestamp.stamp.nsec;
@@ -0,0 +1,39 @@
+#ifndef CONNECTORINTERFACE_HPP
+#define CONNECTORINTERFACE_HPP
+
+/**
+  * @file ConnectorInterface.hpp
+  * @brief The direct-call interface between RT Ops and a Connector.
+  * A Connector that implements this receives controller outputs through a
+  * plain virtual call instead of an RTT operation, when it's loaded into the
+  * same deployer as RT Ops. The "connector" service's sendControllerOutput
+  * operation remains the fallback.
+  */
+
+#include <atrias_msgs/controller_output.h>
+
+// Namespaces we're inside
+namespace atrias {
+namespace shared {
+
+class ConnectorInterface {
+	public:
+		/**
+		  * @brief Sends out this cycle's (clamped) controller output.
+		  * @param controller_output The output. Only valid during the call.
+		  */
+		virtual void sendControllerOutput(const atrias_msgs::controller_output &controller_output) = 0;
+
+	protected:
+		// Not deletable through this interface
+		~ConnectorInterface() {}
+};
+
+// End namespaces
+}
+}
+
+#endif // CONNECTORINTERFACE_HPP
+
+// Tab-based indentation
+// vim: noexpandtab
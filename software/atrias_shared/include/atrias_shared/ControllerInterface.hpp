@@ -0,0 +1,41 @@
+#ifndef CONTROLLERINTERFACE_HPP
+#define CONTROLLERINTERFACE_HPP
+
+/**
+  * @file ControllerInterface.hpp
+  * @brief The direct-call interface between RT Ops and a top-level controller.
+  * A top-level controller that implements this can be called by RT Ops
+  * through a plain virtual call instead of an RTT operation, when both are
+  * loaded into the same deployer. The "atc" service's runController
+  * operation remains the fallback.
+  */
+
+#include <atrias_msgs/controller_output.h>
+#include <atrias_msgs/robot_state.h>
+
+// Namespaces we're inside
+namespace atrias {
+namespace shared {
+
+class ControllerInterface {
+	public:
+		/**
+		  * @brief Runs the controller once.
+		  * @param robotState The new robot state.
+		  * @return The controller's output. This stays valid until the next call.
+		  */
+		virtual atrias_msgs::controller_output& runController(const atrias_msgs::robot_state &robotState) = 0;
+
+	protected:
+		// Not deletable through this interface
+		~ControllerInterface() {}
+};
+
+// End namespaces
+}
+}
+
+#endif // CONTROLLERINTERFACE_HPP
+
+// Tab-based indentation
+// vim: noexpandtab
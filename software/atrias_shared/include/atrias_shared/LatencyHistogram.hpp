@@ -0,0 +1,187 @@
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+/**
+  * @file LatencyHistogram.hpp
+  * @brief A fixed-size, log-linear (HDR-style) histogram of durations.
+  * Recording is O(1) and never allocates, so it is safe to use from
+  * realtime code. Buckets are 1 ns wide below 16 ns; above that, each power
+  * of two is split into 16 buckets, for about 6% resolution up to ~33 ms.
+  */
+
+// Standard library
+#include <atomic>
+#include <stdint.h>
+
+// Namespaces we're inside
+namespace atrias {
+namespace shared {
+
+class LatencyHistogram {
+	public:
+		/**
+		  * @brief Initializes an empty histogram.
+		  */
+		LatencyHistogram();
+
+		/**
+		  * @brief Adds one sample to the histogram.
+		  * @param duration The duration, in nanoseconds. Negative values count as 0.
+		  * Only one thread may record into a given histogram.
+		  */
+		void     record(int64_t duration);
+
+		/**
+		  * @brief Clears the histogram.
+		  * This may be called from any thread; the clear is done by the
+		  * recording thread at its next \a record().
+		  */
+		void     reset();
+
+		/**
+		  * @brief Returns the number of recorded samples.
+		  * @return The sample count.
+		  */
+		uint32_t getCount() const;
+
+		/**
+		  * @brief Returns the largest recorded sample, exactly.
+		  * @return The maximum, in nanoseconds.
+		  */
+		int64_t  getMax() const;
+
+		/**
+		  * @brief Returns an upper bound on the given percentile.
+		  * @param fraction The percentile, from 0 to 1 (e.g. 0.999).
+		  * @return The upper edge of the bucket holding that percentile, in nanoseconds.
+		  * Readers on other threads may see a slightly stale view; that's
+		  * fine for statistics.
+		  */
+		int64_t  getPercentile(double fraction) const;
+
+	private:
+		// The number of linear sub-buckets per power of two, as a power of two
+		static const int SUB_BUCKET_BITS = 4;
+		static const int SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+
+		// Samples at or above 2^(MAX_EXPONENT+1) ns land in the last bucket
+		static const int MAX_EXPONENT    = 24;
+		static const int NUM_BUCKETS     = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+		/**
+		  * @brief Zeroes all the buckets. Only run by the recording thread.
+		  */
+		void           clear();
+
+		/**
+		  * @brief Finds the bucket a sample belongs in.
+		  * @param value The sample.
+		  * @return The bucket's index.
+		  */
+		static int     bucketIndex(uint64_t value);
+
+		/**
+		  * @brief Finds the largest value that falls in a bucket.
+		  * @param index The bucket's index.
+		  * @return The bucket's upper edge.
+		  */
+		static int64_t bucketUpperBound(int index);
+
+		uint32_t          buckets[NUM_BUCKETS];
+		uint32_t          count;
+		int64_t           max;
+		std::atomic<bool> resetRequested;
+};
+
+inline LatencyHistogram::LatencyHistogram() :
+	resetRequested(false)
+{
+	this->clear();
+}
+
+inline void LatencyHistogram::record(int64_t duration) {
+	if (this->resetRequested.load(std::memory_order_acquire)) {
+		this->clear();
+		this->resetRequested.store(false, std::memory_order_release);
+	}
+
+	if (duration < 0)
+		duration = 0;
+
+	this->buckets[bucketIndex(duration)]++;
+	this->count++;
+	if (duration > this->max)
+		this->max = duration;
+}
+
+inline void LatencyHistogram::clear() {
+	for (int i = 0; i < NUM_BUCKETS; i++)
+		this->buckets[i] = 0;
+	this->count = 0;
+	this->max   = 0;
+}
+
+inline void LatencyHistogram::reset() {
+	this->resetRequested.store(true, std::memory_order_release);
+}
+
+inline uint32_t LatencyHistogram::getCount() const {
+	return this->count;
+}
+
+inline int64_t LatencyHistogram::getMax() const {
+	return this->max;
+}
+
+inline int64_t LatencyHistogram::getPercentile(double fraction) const {
+	uint32_t total = this->count;
+	if (!total)
+		return 0;
+
+	// The 1-based rank of the sample we're looking for.
+	uint32_t rank = (uint32_t) (fraction * total + 0.5);
+	if (rank < 1)
+		rank = 1;
+
+	uint32_t seen = 0;
+	for (int i = 0; i < NUM_BUCKETS; i++) {
+		seen += this->buckets[i];
+		if (seen >= rank) {
+			int64_t bound = bucketUpperBound(i);
+			return (bound < this->max) ? bound : this->max;
+		}
+	}
+
+	return this->max;
+}
+
+inline int LatencyHistogram::bucketIndex(uint64_t value) {
+	if (value < (uint64_t) SUB_BUCKETS)
+		return (int) value;
+
+	// Position of the highest set bit
+	int exponent = 63 - __builtin_clzll(value);
+	if (exponent > MAX_EXPONENT)
+		return NUM_BUCKETS - 1;
+
+	int shift = exponent - SUB_BUCKET_BITS;
+	return (shift + 1) * SUB_BUCKETS + (int) ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+inline int64_t LatencyHistogram::bucketUpperBound(int index) {
+	if (index < SUB_BUCKETS)
+		return index;
+
+	int shift = index / SUB_BUCKETS - 1;
+	int64_t lower = ((int64_t) (SUB_BUCKETS + index % SUB_BUCKETS)) << shift;
+	return lower + (((int64_t) 1) << shift) - 1;
+}
+
+// End namespaces
+}
+}
+
+#endif // LATENCYHISTOGRAM_HPP
+
+// Tab-based indentation
+// vim: noexpandtab
@@ -0,0 +1,339 @@
+#ifndef RTLOG_HPP
+#define RTLOG_HPP
+
+/**
+  * @file RtLog.hpp
+  * @brief Realtime-safe logging.
+  * Each registered realtime thread gets its own lock-free single-producer,
+  * single-consumer queue of fixed-size binary records: a format string,
+  * its arguments, and a timestamp. A low-priority thread drains the queues
+  * and does the actual formatting and output through the Orocos logger.
+  *
+  * Usage:
+  *   RtLog::log(RTT::Warning, "Leg position adjustment limit exceeded! ID: {}", id);
+  *
+  * Each {} in the format is replaced by the next argument. Arguments may be
+  * integers, floating point numbers, or string literals (only the pointer is
+  * queued, so the string must outlive the record). Threads that haven't
+  * registered log straight to the Orocos logger, so non-RT code can use this
+  * freely too.
+  */
+
+// Standard library
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Orocos
+#include <rtt/Activity.hpp>
+#include <rtt/Logger.hpp>
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/TimeService.hpp>
+
+// The most arguments a single record can hold
+#define RTLOG_MAX_ARGS      4
+
+// Records per thread. Must be a power of two.
+#define RTLOG_QUEUE_SIZE    512
+
+// How often the queues are drained, in seconds.
+#define RTLOG_FORMAT_PERIOD 0.01
+
+// Namespaces we're inside
+namespace atrias {
+namespace shared {
+
+/**
+  * @brief One queued log message.
+  */
+struct RtLogRecord {
+	enum ArgType {
+		INT,
+		UINT,
+		DOUBLE,
+		STRING
+	};
+
+	union Arg {
+		int64_t     i;
+		uint64_t    u;
+		double      d;
+		const char *s;
+	};
+
+	// When the message was logged
+	RTT::os::TimeService::nsecs time;
+
+	// The format string. Its address doubles as the message's ID.
+	const char                 *format;
+
+	RTT::Logger::LogLevel       level;
+	uint8_t                     numArgs;
+	uint8_t                     argTypes[RTLOG_MAX_ARGS];
+	Arg                         args[RTLOG_MAX_ARGS];
+};
+
+/**
+  * @brief A wait-free single-producer, single-consumer ring of log records.
+  */
+class RtLogQueue {
+	public:
+		/**
+		  * @brief Initializes an empty queue.
+		  * @param name The name of the thread that owns this queue.
+		  */
+		RtLogQueue(const std::string &name);
+
+		/**
+		  * @brief Adds a record, or counts it as dropped if the queue is full.
+		  * @param record The record.
+		  * @return True if the record was queued.
+		  * Only the owning thread may call this. Wait-free.
+		  */
+		bool               push(const RtLogRecord &record);
+
+		/**
+		  * @brief Removes the oldest record.
+		  * @param record Where to store the record.
+		  * @return True if there was a record.
+		  * Only the formatting thread may call this.
+		  */
+		bool               pop(RtLogRecord &record);
+
+		/**
+		  * @brief Returns the owning thread's name.
+		  * @return The name.
+		  */
+		const std::string& getName() const;
+
+		/**
+		  * @brief Returns how many records have been dropped because the queue was full.
+		  * @return The drop count.
+		  */
+		uint32_t           getDropped() const;
+
+		// How many drops the formatting thread has already reported
+		uint32_t           reportedDrops;
+
+	private:
+		RtLogRecord           records[RTLOG_QUEUE_SIZE];
+		std::string           name;
+
+		// The next slot to write. Only written by the owning thread.
+		std::atomic<uint32_t> head;
+
+		// Keep the two indices on separate cache lines.
+		char                  pad[64];
+
+		// The next slot to read. Only written by the formatting thread.
+		std::atomic<uint32_t> tail;
+
+		std::atomic<uint32_t> dropped;
+};
+
+class RtLog {
+	public:
+		/**
+		  * @brief Gives the calling thread its own queue, and starts the
+		  * formatting thread if it's not already running.
+		  * @param name The name to tag this thread's messages with.
+		  * Not realtime safe; call before entering the thread's loop.
+		  */
+		static void     registerThread(const std::string &name);
+
+		/**
+		  * @brief Flushes and frees the calling thread's queue. The formatting
+		  * thread stops once no thread is registered.
+		  * Not realtime safe; call after leaving the thread's loop.
+		  */
+		static void     unregisterThread();
+
+		/**
+		  * @brief Logs a message. Realtime safe from a registered thread.
+		  * @param level  The log level.
+		  * @param format The message, with a {} for each argument. Must be a string literal.
+		  * @param args   Up to RTLOG_MAX_ARGS arguments.
+		  */
+		template <typename... Args>
+		static void     log(RTT::Logger::LogLevel level, const char *format, Args... args);
+
+		/**
+		  * @brief Returns how many records have been dropped, over all threads.
+		  * @return The drop count.
+		  */
+		static uint64_t getDropped();
+
+		/**
+		  * @brief Formats and outputs everything queued so far.
+		  * Not realtime safe.
+		  */
+		static void     flush();
+
+	private:
+		// Drains the queues periodically.
+		struct Formatter : public RTT::Activity {
+			Formatter();
+			void step();
+		};
+
+		/**
+		  * @brief Returns the calling thread's queue.
+		  * @return The queue, or NULL if this thread hasn't registered.
+		  */
+		static RtLogQueue* getThreadQueue();
+
+		/**
+		  * @brief Queues a record, or outputs it now if this thread has no queue.
+		  * @param record The record.
+		  */
+		static void        submit(const RtLogRecord &record);
+
+		/**
+		  * @brief Formats and outputs one record.
+		  * @param record The record.
+		  * @param name   The name of the thread that logged it.
+		  */
+		static void        output(const RtLogRecord &record, const std::string &name);
+
+		/**
+		  * @brief Outputs everything in a queue, then reports any new drops.
+		  * The caller must hold \a lock.
+		  * @param queue The queue.
+		  */
+		static void        drain(RtLogQueue *queue);
+
+		// Argument packing. Each stores one argument into the record.
+		template <typename T>
+		static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+		                   packArg(RtLogRecord &record, T arg);
+
+		template <typename T>
+		static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+		                   packArg(RtLogRecord &record, T arg);
+
+		template <typename T>
+		static typename std::enable_if<std::is_floating_point<T>::value>::type
+		                   packArg(RtLogRecord &record, T arg);
+
+		static void        packArg(RtLogRecord &record, const char *arg);
+
+		static void        packArgs(RtLogRecord &record);
+
+		template <typename T, typename... Rest>
+		static void        packArgs(RtLogRecord &record, T arg, Rest... rest);
+
+		// Protects the list of queues. Never taken by a realtime thread.
+		static RTT::os::Mutex           lock;
+
+		// The registered threads' queues
+		static std::vector<RtLogQueue*> queues;
+
+		// Drops from threads that have since unregistered
+		static uint64_t                 retiredDrops;
+
+		static Formatter               *formatter;
+};
+
+inline RtLogQueue::RtLogQueue(const std::string &name) :
+	reportedDrops(0),
+	name(name),
+	head(0),
+	tail(0),
+	dropped(0)
+{
+	// Nothing else to do.
+}
+
+inline bool RtLogQueue::push(const RtLogRecord &record) {
+	uint32_t curHead = this->head.load(std::memory_order_relaxed);
+	if (curHead - this->tail.load(std::memory_order_acquire) >= RTLOG_QUEUE_SIZE) {
+		this->dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	this->records[curHead & (RTLOG_QUEUE_SIZE - 1)] = record;
+	this->head.store(curHead + 1, std::memory_order_release);
+	return true;
+}
+
+inline bool RtLogQueue::pop(RtLogRecord &record) {
+	uint32_t curTail = this->tail.load(std::memory_order_relaxed);
+	if (curTail == this->head.load(std::memory_order_acquire))
+		return false;
+
+	record = this->records[curTail & (RTLOG_QUEUE_SIZE - 1)];
+	this->tail.store(curTail + 1, std::memory_order_release);
+	return true;
+}
+
+inline const std::string& RtLogQueue::getName() const {
+	return this->name;
+}
+
+inline uint32_t RtLogQueue::getDropped() const {
+	return this->dropped.load(std::memory_order_relaxed);
+}
+
+template <typename... Args>
+void RtLog::log(RTT::Logger::LogLevel level, const char *format, Args... args) {
+	static_assert(sizeof...(Args) <= RTLOG_MAX_ARGS, "Too many arguments for one RtLog record.");
+
+	// Don't bother queueing what the logger would throw away.
+	if (level > RTT::Logger::Instance()->getLogLevel())
+		return;
+
+	RtLogRecord record;
+	record.time    = RTT::os::TimeService::Instance()->getNSecs();
+	record.format  = format;
+	record.level   = level;
+	record.numArgs = 0;
+	packArgs(record, args...);
+
+	submit(record);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+RtLog::packArg(RtLogRecord &record, T arg) {
+	record.argTypes[record.numArgs] = RtLogRecord::INT;
+	record.args[record.numArgs++].i = arg;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+RtLog::packArg(RtLogRecord &record, T arg) {
+	record.argTypes[record.numArgs] = RtLogRecord::UINT;
+	record.args[record.numArgs++].u = arg;
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+RtLog::packArg(RtLogRecord &record, T arg) {
+	record.argTypes[record.numArgs] = RtLogRecord::DOUBLE;
+	record.args[record.numArgs++].d = arg;
+}
+
+inline void RtLog::packArg(RtLogRecord &record, const char *arg) {
+	record.argTypes[record.numArgs] = RtLogRecord::STRING;
+	record.args[record.numArgs++].s = arg;
+}
+
+inline void RtLog::packArgs(RtLogRecord &record) {
+	// Nothing left to pack.
+}
+
+template <typename T, typename... Rest>
+void RtLog::packArgs(RtLogRecord &record, T arg, Rest... rest) {
+	packArg(record, arg);
+	packArgs(record, rest...);
+}
+
+// End namespaces
+}
+}
+
+#endif // RTLOG_HPP
+
+// vim: noexpandtab
@@ -16,6 +16,9 @@
 #include <rtt/os/oro_allocator.hpp>       // For the realtime-safe allocator
 #include <rtt/types/TemplateTypeInfo.hpp> // Allows us to create typekitsa
 
+// ROS
+#include <ros/message_traits.h>           // For the default type names
+
 // Namespaces we're inside
 namespace atrias {
 namespace shared {
@@ -23,36 +26,44 @@ namespace shared {
 class RtMsgTypekits {
 	public:
 		/**
-		  * @brief This registers the typekit for a given ROS type.
-		  * @param name A unique name for this type, such as "rt_ops_event_"
+		  * @brief This registers the typekit for a given ROS type, with a given allocator,
+		  * so ports of that type can be connected to ROS topics.
+		  * Registering a type twice does nothing, so every instance of a controller can call this.
+		  * @param name A unique name for this type. By default, this is the ROS datatype
+		  *             with "_rt" appended, such as "/atc_demo/controller_log_data_rt".
 		  */
-		template <template<class> class msgType>
-		static void registerType(const std::string &name);
+		template <template<class> class msgType, class Allocator = RTT::os::rt_allocator<uint8_t>>
+		static void registerType(std::string name = "");
 };
 
 // Template definitions
-template <template<class> class msgType>
-void RtMsgTypekits::registerType(const std::string &name) {
+template <template<class> class msgType, class Allocator>
+void RtMsgTypekits::registerType(std::string name) {
 	// This is taken partially off the Orocos mailinglist
 	// http://www.orocos.org/forum/orocos/orocos-users/cannot-transport-ros-message-rttosrtallocator
 	// The steps that check if this type's already been added are custom, however.
+	typedef msgType<Allocator> Msg;
 
-	log(RTT::Info) << "Got type info: " << RTT::types::Types()->getTypeInfo<msgType<RTT::os::rt_allocator<uint8_t>>>() << RTT::endlog();
 	// Check if this type has already been registered. If it has been, then we'll be able to obtain
 	// a pointer to the type info
-	if (RTT::types::Types()->getTypeInfo<msgType<RTT::os::rt_allocator<uint8_t>>>()) {
+	if (RTT::types::Types()->getTypeInfo<Msg>()) {
 		// It's already been registered, so return immediately.
 		return;
 	}
 
+	if (name.empty())
+		name = std::string("/") + ros::message_traits::datatype<Msg>() + "_rt";
+
 	// Instantiate the TemplateTypeInfo
-	auto typeInfo = new RTT::types::TemplateTypeInfo<msgType<RTT::os::rt_allocator<uint8_t>>, false>(name);
-	
-	// Time to register the type
-	log(RTT::Info) << "Registering type " << name << ": " << RTT::types::Types()->addType(typeInfo) << RTT::endlog();
-	
-	log(RTT::Info) << "Adding protocol" << RTT::endlog();
-	RTT::types::Types()->type(name)->addProtocol(3, new ros_integration::RosMsgTransporter<msgType<RTT::os::rt_allocator<uint8_t>>>());
+	auto typeInfo = new RTT::types::TemplateTypeInfo<Msg, false>(name);
+
+	// Time to register the type, and let it be sent over ROS
+	if (!RTT::types::Types()->addType(typeInfo)) {
+		log(RTT::Error) << "[RtMsgTypekits] Failed to register type " << name << RTT::endlog();
+		return;
+	}
+	RTT::types::Types()->type(name)->addProtocol(3, new ros_integration::RosMsgTransporter<Msg>());
+	log(RTT::Info) << "[RtMsgTypekits] Registered type " << name << RTT::endlog();
 }
 
 // End namespaces
@@ -0,0 +1,118 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+/**
+  * @file TripleBuffer.hpp
+  * @brief A wait-free single-producer triple buffer.
+  * This lets one thread publish a large structure every cycle while another
+  * thread reads the newest copy by reference, with no locks and no copies.
+  * There's exactly one consumer: a slot the consumer hasn't latched can be
+  * handed back to the producer and rewritten at any time, so no other
+  * thread may look at the slots.
+  */
+
+// Standard library
+#include <atomic>  // For the index exchange
+#include <stdint.h>
+
+// Namespaces we're inside
+namespace atrias {
+namespace shared {
+
+template <class T>
+class TripleBuffer {
+	public:
+		/**
+		  * @brief Initializes all three slots with the default-constructed T.
+		  */
+		TripleBuffer();
+
+		/**
+		  * @brief Returns the slot the producer may fill in.
+		  * @return A reference to the back buffer.
+		  * Only the producer thread may call this.
+		  */
+		T&       getWriteBuffer();
+
+		/**
+		  * @brief Makes the back buffer the newest published value.
+		  * Only the producer thread may call this. Wait-free.
+		  */
+		void     publish();
+
+		/**
+		  * @brief Latches the newest published value for the consumer.
+		  * @return True if a new value was latched, false otherwise.
+		  * Only the consumer thread may call this. Wait-free.
+		  */
+		bool     update();
+
+		/**
+		  * @brief Returns the value latched by the last \a update().
+		  * @return A reference that stays valid until the next \a update().
+		  * Only the consumer thread may call this.
+		  */
+		const T& read() const;
+
+	private:
+		// The dirty bit on the shared index, set by publish() and cleared by update()
+		static const uint8_t DIRTY = 0x4;
+
+		// The three slots
+		T                    buffers[3];
+
+		// The index of the slot the producer is filling in
+		uint8_t              backIndex;
+
+		// The index (and dirty bit) of the slot handed between the threads
+		std::atomic<uint8_t> middleIndex;
+
+		// The index of the slot the consumer is reading
+		uint8_t              frontIndex;
+};
+
+template <class T>
+TripleBuffer<T>::TripleBuffer() :
+	backIndex(0),
+	middleIndex(1),
+	frontIndex(2)
+{
+	// Nothing else to do.
+}
+
+template <class T>
+T& TripleBuffer<T>::getWriteBuffer() {
+	return this->buffers[this->backIndex];
+}
+
+template <class T>
+void TripleBuffer<T>::publish() {
+	// Hand our filled-in slot over and take back whatever was in the middle.
+	uint8_t old = this->middleIndex.exchange(this->backIndex | DIRTY, std::memory_order_acq_rel);
+	this->backIndex = old & ~DIRTY;
+}
+
+template <class T>
+bool TripleBuffer<T>::update() {
+	// Cheap check first, so an idle cycle doesn't need the exchange.
+	if (!(this->middleIndex.load(std::memory_order_relaxed) & DIRTY))
+		return false;
+
+	uint8_t old = this->middleIndex.exchange(this->frontIndex, std::memory_order_acq_rel);
+	this->frontIndex = old & ~DIRTY;
+	return true;
+}
+
+template <class T>
+const T& TripleBuffer<T>::read() const {
+	return this->buffers[this->frontIndex];
+}
+
+// End namespaces
+}
+}
+
+#endif // TRIPLEBUFFER_HPP
+
+// Tab-based indentation
+// vim: noexpandtab
@@ -104,7 +104,8 @@ enum class RtOpsEvent: RtOpsEvent_t {
     CONTROLLER_ESTOP,         // The controller commanded an estop.
     MEDULLA_ESTOP,            // Sent when any Medulla goes into error mode. Note: As a kludge, this is also sent when a halt failure is detected.
     SAFETY,                   // Sent whenever RT Ops's safety engages. Has metadata of type RtOpsEventSafetyMetadata
-    CONTROLLER_CUSTOM         // This one may be sent by controllers -- they fill in their own metadata
+    CONTROLLER_CUSTOM,        // This one may be sent by controllers -- they fill in their own metadata
+    ECAT_FRAME_LOSS           // The connector lost too many EtherCAT frames in a row; RT Ops halts. Metadata: the run length (capped at 127)
 };
 
 /** @brief The type for RT Ops event metadata.
@@ -138,6 +139,26 @@ enum class RtOpsEventSafetyMetadata: RtOpsEventMetadata_t {
     RIGHT_LEG_TOO_SHORT
 };
 
+/** @brief Identifies one timed stage of an RT Ops cycle.
+  * Connectors report their stages to RT Ops, which keeps a latency
+  * histogram for each one.
+  */
+typedef uint8_t CycleStage_t;
+
+enum class CycleStage: CycleStage_t {
+    ECAT_RECEIVE = 0, // Connector: sending/receiving the frame carrying the new inputs
+    PROCESS_RECEIVE,  // Connector: decoding the inputs into the robot state
+    STATE_CALLBACK,   // RT Ops: newStateCallback()
+    CONTROLLER,       // The controller's runController()
+    STATE_MACHINE,    // RT Ops: the state machine, including the safeties
+    CLAMP,            // RT Ops: clamping and logging the controller output
+    PROCESS_TRANSMIT, // Connector: encoding the controller output
+    ECAT_TRANSMIT,    // Connector: sending/receiving the frame carrying the outputs
+    TOTAL,            // Connector: start of ECAT_RECEIVE through end of ECAT_TRANSMIT
+    WAKEUP,           // Connector: how late the loop woke up (not a duration)
+    NUM_STAGES        // Not a stage; this is the number of stages above.
+};
+
 /** @brief The type for robot configuration data
   */
 typedef uint8_t RobotConfiguration_t;
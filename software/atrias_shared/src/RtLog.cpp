@@ -0,0 +1,151 @@
+#include "atrias_shared/RtLog.hpp"
+
+#include <algorithm>
+
+#include <rtt/os/MutexLock.hpp>
+
+#include "atrias_shared/globals.h"
+
+namespace atrias {
+namespace shared {
+
+// The calling thread's queue, if it has registered
+static __thread RtLogQueue *threadQueue = NULL;
+
+RTT::os::Mutex           RtLog::lock;
+std::vector<RtLogQueue*> RtLog::queues;
+uint64_t                 RtLog::retiredDrops = 0;
+RtLog::Formatter        *RtLog::formatter    = NULL;
+
+RtLog::Formatter::Formatter() :
+	RTT::Activity(ORO_SCHED_OTHER, 0, RTLOG_FORMAT_PERIOD, 0, "RtLog")
+{
+	// Nothing else to do.
+}
+
+void RtLog::Formatter::step() {
+	RtLog::flush();
+}
+
+void RtLog::registerThread(const std::string &name) {
+	if (threadQueue)
+		return;
+
+	threadQueue = new RtLogQueue(name);
+
+	RTT::os::MutexLock lock(RtLog::lock);
+	queues.push_back(threadQueue);
+
+	if (!formatter)
+		formatter = new Formatter();
+	if (!formatter->isActive())
+		formatter->start();
+}
+
+void RtLog::unregisterThread() {
+	RtLogQueue *queue = threadQueue;
+	if (!queue)
+		return;
+
+	// Anything we log from here on goes straight to the logger.
+	threadQueue = NULL;
+
+	bool last;
+	{
+		RTT::os::MutexLock lock(RtLog::lock);
+		drain(queue);
+		retiredDrops += queue->getDropped();
+		queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+		last = queues.empty();
+	}
+	delete queue;
+
+	// Don't hold the lock here; the formatter may be waiting for it.
+	if (last && formatter)
+		formatter->stop();
+}
+
+uint64_t RtLog::getDropped() {
+	RTT::os::MutexLock lock(RtLog::lock);
+	uint64_t dropped = retiredDrops;
+	for (size_t i = 0; i < queues.size(); i++)
+		dropped += queues[i]->getDropped();
+
+	return dropped;
+}
+
+void RtLog::flush() {
+	RTT::os::MutexLock lock(RtLog::lock);
+	for (size_t i = 0; i < queues.size(); i++)
+		drain(queues[i]);
+}
+
+RtLogQueue* RtLog::getThreadQueue() {
+	return threadQueue;
+}
+
+void RtLog::submit(const RtLogRecord &record) {
+	RtLogQueue *queue = getThreadQueue();
+	if (queue) {
+		queue->push(record);
+		return;
+	}
+
+	output(record, "non-RT");
+}
+
+void RtLog::drain(RtLogQueue *queue) {
+	RtLogRecord record;
+	while (queue->pop(record))
+		output(record, queue->getName());
+
+	uint32_t dropped = queue->getDropped();
+	if (dropped != queue->reportedDrops) {
+		RTT::log(RTT::Warning) << "[RtLog] Dropped " << (dropped - queue->reportedDrops)
+		                       << " records from " << queue->getName() << " ("
+		                       << dropped << " total); its queue was full." << RTT::endlog();
+		queue->reportedDrops = dropped;
+	}
+}
+
+void RtLog::output(const RtLogRecord &record, const std::string &name) {
+	RTT::Logger &logger = RTT::log(record.level);
+	logger << "[" << name << " @ " << (long long) (record.time / (SECOND_IN_NANOSECONDS / 1000)) << " ms] ";
+
+	const char *start = record.format;
+	const char *cur   = start;
+	int         arg   = 0;
+	for (; *cur; cur++) {
+		if (cur[0] != '{' || cur[1] != '}' || arg >= record.numArgs)
+			continue;
+
+		logger << std::string(start, cur - start);
+		switch (record.argTypes[arg]) {
+			case RtLogRecord::INT:
+				logger << (long long) record.args[arg].i;
+				break;
+			case RtLogRecord::UINT:
+				logger << (unsigned long long) record.args[arg].u;
+				break;
+			case RtLogRecord::DOUBLE:
+				logger << record.args[arg].d;
+				break;
+			case RtLogRecord::STRING:
+				logger << record.args[arg].s;
+				break;
+		}
+		arg++;
+
+		// Skip the closing brace.
+		cur++;
+		start = cur + 1;
+	}
+
+	logger << start << RTT::endlog();
+}
+
+// End namespaces
+}
+}
+
+// vim: noexpandtab
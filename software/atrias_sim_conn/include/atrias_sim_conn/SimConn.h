@@ -15,12 +15,13 @@
 #include <atrias_msgs/robot_state.h>
 #include <atrias_msgs/controller_output.h>
 #include <atrias_shared/globals.h>
+#include <atrias_shared/ConnectorInterface.hpp>
 
 namespace atrias {
 
 namespace simConn {
 
-class SimConn : public RTT::TaskContext {
+class SimConn : public RTT::TaskContext, public shared::ConnectorInterface {
 	private:
 	/** @brief By calling this, we cycle RT Ops.
 	  */
@@ -44,7 +45,7 @@ class SimConn : public RTT::TaskContext {
 		/** @brief Called by RT Ops w/ update controller torques.
 		  * @param controller_output The new controller output.
 		  */
-		void sendControllerOutput(atrias_msgs::controller_output controller_output);
+		void sendControllerOutput(const atrias_msgs::controller_output &controller_output);
 		
 		/** @brief Configures this component.
 		  * Run by Orocos.
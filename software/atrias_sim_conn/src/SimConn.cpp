@@ -30,7 +30,7 @@ bool SimConn::configureHook() {
 	return true;
 }
 
-void SimConn::sendControllerOutput(atrias_msgs::controller_output controller_output) {
+void SimConn::sendControllerOutput(const atrias_msgs::controller_output &controller_output) {
 	gazeboDataOut.write(controller_output);
 	return;
 }
@@ -0,0 +1,393 @@
+/*
+ * ascfilterstest.cpp
+ *
+ * Checks asc_filters against plain implementations and the toe filter
+ * it replaced, and times the toe filter each way.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <math.h>
+#include <numeric>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <asc_filters/Biquad.hpp>
+#include <asc_filters/DebouncedThreshold.hpp>
+#include <asc_filters/MedianFilter.hpp>
+#include <asc_filters/MovingAverage.hpp>
+#include <asc_filters/SpikeFilter.hpp>
+
+using namespace atrias::controller;
+
+// The stance threshold over the baseline, as in ATCDeadbeatControl.
+#define STANCE_THRESHOLD 500.0
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// A small, repeatable random number generator (xorshift64).
+static uint64_t randomState = 88172645463325252ULL;
+static uint32_t randomInt() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 7;
+	randomState ^= randomState << 17;
+	return (uint32_t) (randomState >> 32);
+}
+
+static double randomDouble(double low, double high) {
+	return low + (high - low) * (randomInt() / 4294967296.0);
+}
+
+static bool report(const char *name, size_t checked, size_t mismatches, double maxError) {
+	printf("%-21s %8zu samples  %zu mismatched  max error %g\n", name, checked, mismatches, maxError);
+	return !mismatches;
+}
+
+// The toe filter and stance detection as the controllers had them.
+class DequeToeFilter {
+	public:
+		DequeToeFilter() {
+			filteredToe.assign(120, 5000.0);
+		}
+
+		void update(uint16_t newToe) {
+			double toe = (double) newToe;
+
+			double prevToe = filteredToe.front();
+			if ((newToe == 4095) || (newToe == 0)) {
+				toe = prevToe;
+			}
+
+			if ((fabs(prevToe - toe) > 1500.0) && (filteredToe.back() != 5000.0)) {
+				toe = prevToe;
+			}
+
+			filteredToe.pop_back();
+			int nSamples = 3;
+			double average = (std::accumulate(filteredToe.begin(), filteredToe.begin()+nSamples-1, 0.0) + toe)/((double)nSamples);
+			filteredToe.push_front(average);
+		}
+
+		double baseline() const {
+			return std::accumulate(filteredToe.begin()+20.0, filteredToe.end(), 0.0)/(filteredToe.size()-20.0);
+		}
+
+		bool detectStance(uint16_t toeSwitch) const {
+			return toeSwitch > STANCE_THRESHOLD + baseline();
+		}
+
+		double newest() const {
+			return filteredToe.front();
+		}
+
+	private:
+		std::deque<double> filteredToe;
+};
+
+// The toe filter and stance detection as the controllers have them now.
+class AscToeFilter {
+	public:
+		AscToeFilter() :
+			toeSpikeFilter(0.0, 4095.0, 1500.0)
+		{
+			filteredToe.fill(5000.0);
+		}
+
+		void update(uint16_t newToe) {
+			const RingBuffer<double, 120> &history = filteredToe.history();
+
+			double prevToe = history.newest();
+			double toe = toeSpikeFilter((double) newToe, prevToe, history.oldest() != 5000.0);
+
+			double average = (history[0] + history[1] + toe)/3.0;
+			filteredToe.push(average);
+		}
+
+		double baseline() const {
+			return filteredToe.average();
+		}
+
+		bool detectStance(uint16_t toeSwitch) const {
+			return toeSwitch > STANCE_THRESHOLD + baseline();
+		}
+
+		double newest() const {
+			return filteredToe.history().newest();
+		}
+
+	private:
+		MovingAverage<100, 20> filteredToe;
+		SpikeFilter            toeSpikeFilter;
+};
+
+// A toe switch trace: a resting level that drifts, with steps up for
+// stance, noise, the occasional rail reading, and the occasional spike.
+static std::vector<uint16_t> makeToeTrace(size_t length) {
+	std::vector<uint16_t> trace(length);
+	double rest    = randomDouble(1000.0, 2500.0);
+	bool   stance  = false;
+	for (size_t i = 0; i < length; i++) {
+		rest += randomDouble(-2.0, 2.0);
+		if (randomInt() % 200 == 0)
+			stance = !stance;
+
+		double reading = rest + (stance ? 900.0 : 0.0) + randomDouble(-30.0, 30.0);
+		uint32_t r = randomInt() % 1000;
+		if (r < 5)
+			reading = 4095.0;
+		else if (r < 10)
+			reading = 0.0;
+		else if (r < 15)
+			reading += randomDouble(-2500.0, 2500.0);
+
+		trace[i] = (uint16_t) std::min(4095.0, std::max(0.0, reading));
+	}
+	return trace;
+}
+
+static bool checkToeFilter() {
+	size_t checked = 0, mismatches = 0, baselineMismatches = 0;
+	double maxError = 0.0;
+
+	for (int t = 0; t < 50; t++) {
+		std::vector<uint16_t> trace = makeToeTrace(5000);
+		DequeToeFilter reference;
+		AscToeFilter   filter;
+
+		for (size_t i = 0; i < trace.size(); i++) {
+			reference.update(trace[i]);
+			filter.update(trace[i]);
+			checked++;
+
+			double got = filter.newest(), wanted = reference.newest();
+			if (memcmp(&got, &wanted, sizeof(double))) {
+				if (mismatches++ < 5)
+					printf("  toe filter, trace %d sample %zu: got %.17g, wanted %.17g\n", t, i, got, wanted);
+			}
+
+			double error = fabs(filter.baseline() - reference.baseline());
+			maxError = std::max(maxError, error);
+
+			// The stance checks may only differ if the reading sits right
+			// on the (slightly differently rounded) threshold.
+			bool stanceDiffers = filter.detectStance(trace[i]) != reference.detectStance(trace[i]) &&
+			                     fabs(trace[i] - STANCE_THRESHOLD - reference.baseline()) > 1e-9;
+			if (error > 1e-9 || stanceDiffers) {
+				if (baselineMismatches++ < 5)
+					printf("  stance, trace %d sample %zu: baseline %.17g, wanted %.17g\n", t, i,
+						filter.baseline(), reference.baseline());
+			}
+		}
+	}
+
+	bool same = report("toe filter", checked, mismatches, 0.0);
+	return report("stance baseline", checked, baselineMismatches, maxError) && same;
+}
+
+template <size_t N, size_t Delay>
+static bool checkMovingAverage(const char *name) {
+	MovingAverage<N, Delay> filter(3.0);
+	std::deque<double>      window(N + Delay, 3.0);
+	size_t checked = 0, mismatches = 0;
+	double maxError = 0.0;
+
+	for (int i = 0; i < 100000; i++) {
+		// Large offsets make the running sum's rounding show.
+		double value = randomDouble(-1.0, 1.0) + ((i / 1000) % 2 ? 1e6 : 0.0);
+		filter.push(value);
+		window.pop_back();
+		window.push_front(value);
+		checked++;
+
+		double wanted = std::accumulate(window.begin() + Delay, window.end(), 0.0) / N;
+		double error  = fabs(filter.average() - wanted);
+		maxError = std::max(maxError, error);
+		if (error > 1e-9 * std::max(1.0, fabs(wanted)))
+			mismatches++;
+	}
+
+	return report(name, checked, mismatches, maxError);
+}
+
+template <size_t N>
+static bool checkMedianFilter(const char *name) {
+	MedianFilter<N>    filter;
+	std::deque<double> window(N, 0.0);
+	size_t checked = 0, mismatches = 0;
+
+	for (int i = 0; i < 100000; i++) {
+		// Repeat values now and then, since ties are the tricky case.
+		double value = (randomInt() % 4) ? randomDouble(-10.0, 10.0) : (double) (randomInt() % 3);
+		filter.push(value);
+		window.pop_back();
+		window.push_front(value);
+		checked++;
+
+		std::vector<double> sorted(window.begin(), window.end());
+		std::nth_element(sorted.begin(), sorted.begin() + N / 2, sorted.end());
+		if (filter.median() != sorted[N / 2])
+			mismatches++;
+	}
+
+	// NaNs are ignored.
+	double before = filter.median();
+	if (filter.push(NAN) != before || filter.history().newest() != window.front())
+		mismatches++;
+
+	return report(name, checked, mismatches, 0.0);
+}
+
+static bool checkBiquad(const char *name, Biquad filter, double b0, double b1, double b2, double a1, double a2) {
+	double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+	size_t checked = 0, mismatches = 0;
+	double maxError = 0.0;
+
+	for (int i = 0; i < 100000; i++) {
+		double x = randomDouble(-1.0, 1.0) + ((i / 5000) % 2 ? 1.0 : 0.0);
+		double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+		x2 = x1; x1 = x;
+		y2 = y1; y1 = y;
+		checked++;
+
+		double error = fabs(filter(x) - y);
+		maxError = std::max(maxError, error);
+		if (error > 1e-9)
+			mismatches++;
+	}
+
+	return report(name, checked, mismatches, maxError);
+}
+
+static bool checkBiquads() {
+	// 1 kHz, like the control loop.
+	double w = 2.0 * M_PI * 50.0 / 1000.0, alpha = sin(w) / (2.0 * M_SQRT1_2), c = cos(w), a0 = 1.0 + alpha;
+	bool same = checkBiquad("Biquad lowPass", Biquad::lowPass(50.0, 1000.0),
+		(1.0 - c) / 2.0 / a0, (1.0 - c) / a0, (1.0 - c) / 2.0 / a0, -2.0 * c / a0, (1.0 - alpha) / a0);
+	same = checkBiquad("Biquad highPass", Biquad::highPass(50.0, 1000.0),
+		(1.0 + c) / 2.0 / a0, -(1.0 + c) / a0, (1.0 + c) / 2.0 / a0, -2.0 * c / a0, (1.0 - alpha) / a0) && same;
+
+	// Once reset, a constant input should stay put.
+	Biquad filter = Biquad::lowPass(50.0, 1000.0);
+	filter.reset(2.5);
+	size_t mismatches = 0;
+	double maxError   = 0.0;
+	for (int i = 0; i < 1000; i++) {
+		double error = fabs(filter(2.5) - 2.5);
+		maxError = std::max(maxError, error);
+		if (error > 1e-9)
+			mismatches++;
+	}
+	return report("Biquad reset", 1000, mismatches, maxError) && same;
+}
+
+static bool checkSpikeFilter() {
+	SpikeFilter filter(0.0, 4095.0, 1500.0);
+	size_t checked = 0, mismatches = 0;
+
+	for (int i = 0; i < 100000; i++) {
+		double x         = (double) (randomInt() % 4096);
+		double reference = (double) (randomInt() % 4096);
+		bool   checkJump = randomInt() % 2;
+		checked++;
+
+		double wanted = x;
+		if (x == 0.0 || x == 4095.0)
+			wanted = reference;
+		if (checkJump && fabs(reference - x) > 1500.0)
+			wanted = reference;
+
+		if (filter(x, reference, checkJump) != wanted)
+			mismatches++;
+	}
+
+	return report("SpikeFilter", checked, mismatches, 0.0);
+}
+
+static bool checkDebouncedThreshold() {
+	DebouncedThreshold filter(10.0, 5.0, 3, 2);
+	bool   on = false;
+	int    count = 0;
+	size_t checked = 0, mismatches = 0;
+
+	for (int i = 0; i < 100000; i++) {
+		double x = randomDouble(0.0, 15.0);
+		checked++;
+
+		// Count samples past the threshold in a row, and switch once
+		// there are enough.
+		bool past = on ? (x < 5.0) : (x > 10.0);
+		count = past ? count + 1 : 0;
+		if (count >= (on ? 2 : 3)) {
+			on    = !on;
+			count = 0;
+		}
+
+		if (filter(x) != on)
+			mismatches++;
+	}
+
+	return report("DebouncedThreshold", checked, mismatches, 0.0);
+}
+
+static void reportTime(const char *name, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-8s mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n", name,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+// Times one cycle of the controllers' toe handling: both legs' filters
+// updated, and a stance check on one.
+template <class ToeFilter>
+static void timeToeFilter(const char *name, const std::vector<uint16_t> &trace, size_t cycles) {
+	ToeFilter rFilteredToe, lFilteredToe;
+	std::vector<int64_t> samples(cycles);
+	volatile bool sink = false;
+
+	for (size_t i = 0; i < cycles; i++) {
+		uint16_t toe = trace[i % trace.size()];
+		int64_t start = getNanoSecs();
+		rFilteredToe.update(toe);
+		lFilteredToe.update(toe);
+		bool stance = rFilteredToe.detectStance(toe);
+		samples[i] = getNanoSecs() - start;
+		sink = sink ^ stance;
+	}
+	reportTime(name, samples);
+}
+
+int main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+	bool same = checkToeFilter();
+	same = checkMovingAverage<100, 20>("MovingAverage<100,20>") && same;
+	same = checkMovingAverage<7, 0>("MovingAverage<7>") && same;
+	same = checkMedianFilter<1>("MedianFilter<1>") && same;
+	same = checkMedianFilter<9>("MedianFilter<9>") && same;
+	same = checkBiquads() && same;
+	same = checkSpikeFilter() && same;
+	same = checkDebouncedThreshold() && same;
+
+	std::vector<uint16_t> trace = makeToeTrace(10000);
+	timeToeFilter<DequeToeFilter>("deque", trace, cycles);
+	timeToeFilter<AscToeFilter>("filters", trace, cycles);
+
+	return same ? 0 : 1;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
@@ -0,0 +1,169 @@
+/*
+ * dispatchbench.cpp
+ *
+ * Times RT Ops's per-cycle controller call and output hand-off:
+ * RTT OperationCallers (by value and by reference) versus the
+ * ControllerInterface/ConnectorInterface direct calls.
+ */
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#include <rtt/os/main.h>
+#include <rtt/OperationCaller.hpp>
+#include <rtt/TaskContext.hpp>
+
+#include <atrias_msgs/controller_output.h>
+#include <atrias_msgs/robot_state.h>
+#include <atrias_shared/ConnectorInterface.hpp>
+#include <atrias_shared/ControllerInterface.hpp>
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Stands in for an ATC: saves the state and returns its output by reference.
+class BenchController : public RTT::TaskContext, public atrias::shared::ControllerInterface {
+	public:
+		BenchController() : RTT::TaskContext("controller") {
+			this->provides("atc")
+			    ->addOperation("runController", &BenchController::runController, this, RTT::ClientThread);
+		}
+
+		atrias_msgs::controller_output& runController(const atrias_msgs::robot_state &robotState) {
+			rs = robotState;
+			co.lLeg.motorCurrentA = rs.lLeg.halfA.motorAngle;
+			return co;
+		}
+
+	private:
+		atrias_msgs::robot_state       rs;
+		atrias_msgs::controller_output co;
+};
+
+// Stands in for a Connector, with both the old and the new operation signatures.
+class BenchConnector : public RTT::TaskContext, public atrias::shared::ConnectorInterface {
+	public:
+		BenchConnector() : RTT::TaskContext("atrias_connector"), sink(0.0) {
+			this->provides("connector")
+			    ->addOperation("sendControllerOutput", &BenchConnector::sendControllerOutput, this, RTT::ClientThread);
+			this->provides("connector")
+			    ->addOperation("sendControllerOutputByValue", &BenchConnector::sendByValue, this, RTT::ClientThread);
+		}
+
+		void sendControllerOutput(const atrias_msgs::controller_output &controller_output) {
+			sink = sink + controller_output.lLeg.motorCurrentA;
+		}
+
+		void sendByValue(atrias_msgs::controller_output controller_output) {
+			sink = sink + controller_output.lLeg.motorCurrentA;
+		}
+
+	private:
+		volatile double sink;
+};
+
+// The old StateMachine::calcState() and ControllerLoop::clampControllerOutput() signatures
+__attribute__((noinline)) static uint8_t calcStateByValue(atrias_msgs::controller_output co) {
+	return co.command;
+}
+
+__attribute__((noinline)) static atrias_msgs::controller_output clampByValue(atrias_msgs::controller_output co) {
+	co.lLeg.motorCurrentA = std::min(co.lLeg.motorCurrentA, 10.0);
+	return co;
+}
+
+// And the current ones
+__attribute__((noinline)) static uint8_t calcStateByRef(const atrias_msgs::controller_output &co) {
+	return co.command;
+}
+
+__attribute__((noinline)) static void clampByRef(atrias_msgs::controller_output &co) {
+	co.lLeg.motorCurrentA = std::min(co.lLeg.motorCurrentA, 10.0);
+}
+
+static void report(const char *name, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-10s mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n", name,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+int ORO_main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+	std::vector<int64_t> samples(cycles);
+
+	BenchController controller;
+	BenchConnector  connector;
+
+	RTT::OperationCaller<atrias_msgs::controller_output&(const atrias_msgs::robot_state&)>
+		runController = controller.provides("atc")->getOperation("runController");
+	RTT::OperationCaller<void(atrias_msgs::controller_output)>
+		sendByValue = connector.provides("connector")->getOperation("sendControllerOutputByValue");
+	RTT::OperationCaller<void(const atrias_msgs::controller_output&)>
+		sendByRef = connector.provides("connector")->getOperation("sendControllerOutput");
+
+	if (!runController.ready() || !sendByValue.ready() || !sendByRef.ready()) {
+		fprintf(stderr, "Failed to connect the operations.\n");
+		return 1;
+	}
+
+	atrias::shared::ControllerInterface *directController = &controller;
+	atrias::shared::ConnectorInterface  *directConnector  = &connector;
+
+	// Fill in the variable-length parts so the copies cost what they do on the robot.
+	atrias_msgs::robot_state robotState;
+	robotState.header.frame_id = "robot_state";
+	robotState.lLeg.halfA.motorAngle = 1.0;
+
+	atrias_msgs::controller_output controllerOutput;
+	volatile uint8_t command = 0;
+
+	for (size_t i = 0; i < cycles; i++) {
+		int64_t start = getNanoSecs();
+		controllerOutput = runController(robotState);
+		command = calcStateByValue(controllerOutput);
+		controllerOutput = clampByValue(controllerOutput);
+		sendByValue(controllerOutput);
+		samples[i] = getNanoSecs() - start;
+	}
+	report("rtt-value", samples);
+
+	for (size_t i = 0; i < cycles; i++) {
+		int64_t start = getNanoSecs();
+		controllerOutput = runController(robotState);
+		command = calcStateByRef(controllerOutput);
+		clampByRef(controllerOutput);
+		sendByRef(controllerOutput);
+		samples[i] = getNanoSecs() - start;
+	}
+	report("rtt-ref", samples);
+
+	for (size_t i = 0; i < cycles; i++) {
+		int64_t start = getNanoSecs();
+		controllerOutput = directController->runController(robotState);
+		command = calcStateByRef(controllerOutput);
+		clampByRef(controllerOutput);
+		directConnector->sendControllerOutput(controllerOutput);
+		samples[i] = getNanoSecs() - start;
+	}
+	report("direct", samples);
+
+	(void) command;
+	return 0;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
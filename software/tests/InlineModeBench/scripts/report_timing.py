@@ -0,0 +1,45 @@
+#!/usr/bin/env python2
+
+# Waits a while, then prints the latest per-stage timing RT Ops published.
+# Usage: report_timing.py <label> <seconds>
+
+import roslib; roslib.load_manifest("InlineModeBench")
+import rospy
+import sys
+from atrias_msgs.msg import rt_ops_timing
+
+# Must match CycleStage in atrias_shared/globals.h
+STAGE_NAMES = ["ECAT_RECEIVE", "PROCESS_RECEIVE", "STATE_CALLBACK", "CONTROLLER",
+               "STATE_MACHINE", "CLAMP", "PROCESS_TRANSMIT", "ECAT_TRANSMIT", "TOTAL",
+               "WAKEUP"]
+
+latest = None
+
+
+def timingCallback (msg):
+    global latest
+    latest = msg
+
+
+if __name__ == "__main__":
+    label   = sys.argv[1]
+    seconds = float(sys.argv[2])
+
+    rospy.init_node("inline_mode_bench", anonymous=True)
+    sub = rospy.Subscriber("rt_ops_timing", rt_ops_timing, timingCallback, queue_size=1)
+    rospy.sleep(seconds)
+
+    if latest is None:
+        print "%s: no timing received" % label
+        sys.exit(1)
+
+    print "%s (ns)" % label
+    print "%-17s %8s %8s %8s %8s %8s" % ("stage", "count", "p50", "p99", "p99.9", "max")
+    for stage in latest.stages:
+        if stage.count == 0:
+            continue
+        print "%-17s %8d %8d %8d %8d %8d" % (STAGE_NAMES[stage.stage], stage.count,
+                                            stage.p50, stage.p99, stage.p999, stage.max)
+    print
+
+# vim: expandtab:sts=4
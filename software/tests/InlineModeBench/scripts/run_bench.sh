@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# Runs RT Ops behind each connector in each mode and reports the latencies.
+# Usage: run_bench.sh [seconds per run]
+# Set DEPLOYER=deployer-xenomai to run on the robot's kernel.
+
+SECONDS_PER_RUN=${1:-30}
+DEPLOYER=${DEPLOYER:-deployer-gnulinux}
+PKG_DIR=$(rospack find InlineModeBench)
+
+for config in noop_threaded noop_inline csim_threaded csim_inline; do
+	rosrun ocl ${DEPLOYER} -s ${PKG_DIR}/ops/${config}.ops > /dev/null 2>&1 &
+	DEPLOYER_PID=$!
+
+	${PKG_DIR}/scripts/report_timing.py ${config} ${SECONDS_PER_RUN}
+
+	kill -INT ${DEPLOYER_PID}
+	wait ${DEPLOYER_PID}
+done
+
+exit 0
@@ -0,0 +1,275 @@
+/*
+ * logframebench.cpp
+ *
+ * Times a controller cycle's subcontroller logging: one RTT port write per
+ * LogPort (the old LogPort) versus packing into the LogFrame and writing it
+ * once, with every port logging everything, decimated, limited to a few
+ * fields, and switched off. Also checks each frame against what the
+ * LogPorts sent.
+ */
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <rtt/os/main.h>
+#include <rtt/ConnPolicy.hpp>
+#include <rtt/InputPort.hpp>
+#include <rtt/OutputPort.hpp>
+#include <rtt/TaskContext.hpp>
+
+#include <ros/serialization.h>
+
+#include <asc_pd/controller_log_data.h>
+#include <atrias_control_lib/AtriasController.hpp>
+#include <atrias_control_lib/LogFrame.hpp>
+#include <atrias_control_lib/LogPort.hpp>
+#include <atrias_msgs/log_frame.h>
+#include <atrias_msgs/log_frame_layout.h>
+
+using namespace atrias::controller;
+
+typedef asc_pd::controller_log_data_<std::allocator<void>> LogData;
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// Stands in for an ATC: owns the TaskContext, header, and log frame.
+class BenchController : public RTT::TaskContext, public AtriasController {
+	public:
+		BenchController() :
+			RTT::TaskContext("bench"),
+			AtriasController("bench")
+		{ }
+
+		const std_msgs::Header& getROSHeader() const {
+			return this->header;
+		}
+
+		double getPeriod() const {
+			return 0.001;
+		}
+
+		RTT::TaskContext& getTaskContext() const {
+			return const_cast<BenchController&>(*this);
+		}
+
+		LogFrame& getLogFrame() const {
+			return const_cast<LogFrame&>(this->logFrame);
+		}
+
+		std_msgs::Header header;
+		LogFrame         logFrame;
+};
+
+// A subcontroller with both kinds of logging: a LogPort, and a port the
+// way the old LogPort did it, read by the bench instead of ROS.
+class BenchSubcontroller : public AtriasController {
+	public:
+		BenchSubcontroller(const AtriasController *parent, const std::string &name) :
+			AtriasController(parent, name),
+			logOut(this),
+			port(AtriasController::getName() + "_log"),
+			reader(AtriasController::getName() + "_log_reader")
+		{
+			this->getTaskContext().addPort(this->port);
+			this->port.connectTo(&this->reader, RTT::ConnPolicy::buffer(10000));
+		}
+
+		void run(double x) {
+			this->logOut.data.P          = 1.0;
+			this->logOut.data.D          = 0.1;
+			this->logOut.data.targetPos  = x;
+			this->logOut.data.currentPos = x - 0.01;
+			this->logOut.data.targetVel  = 2.0 * x;
+			this->logOut.data.currentVel = 2.0 * x - 0.02;
+			this->logOut.data.output     = 0.01 - 0.02 * 0.1;
+		}
+
+		// The old LogPort::send()
+		void sendToPort() {
+			this->logOut.data.header = this->getROSHeader();
+			this->port.write(this->logOut.data);
+		}
+
+		LogPort<asc_pd::controller_log_data_> logOut;
+		RTT::OutputPort<LogData>              port;
+		RTT::InputPort<LogData>               reader;
+};
+
+static void report(const char *name, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-10s mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n", name,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+int ORO_main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+	size_t count  = (argc > 2) ? strtoul(argv[2], NULL, 10) : 19;
+	std::vector<int64_t> samples(cycles);
+
+	BenchController controller;
+	std::vector<BenchSubcontroller*> subcontrollers;
+	for (size_t i = 0; i < count; i++) {
+		char name[24];
+		snprintf(name, sizeof(name), "asc%zu", i);
+		subcontrollers.push_back(new BenchSubcontroller(&controller, name));
+	}
+
+	// How big a frame with every slot in it is
+	uint32_t frameSize = 0;
+	for (size_t i = 0; i < count; i++)
+		frameSize += ros::serialization::serializationLength(subcontrollers[i]->logOut.data);
+
+	LogData sample;
+	for (size_t i = 0; i < cycles; i++) {
+		controller.header.seq = i;
+		for (size_t j = 0; j < count; j++)
+			subcontrollers[j]->run(i * 0.001 + j);
+
+		int64_t start = getNanoSecs();
+		for (size_t j = 0; j < count; j++)
+			subcontrollers[j]->sendToPort();
+		samples[i] = getNanoSecs() - start;
+
+		for (size_t j = 0; j < count; j++)
+			while (subcontrollers[j]->reader.read(sample) == RTT::NewData);
+	}
+	report("ports", samples);
+
+	controller.logFrame.addPorts(controller, controller.getPeriod());
+	RTT::InputPort<atrias_msgs::log_frame>        frameReader("frameReader");
+	RTT::InputPort<atrias_msgs::log_frame_layout> layoutReader("layoutReader");
+	controller.ports()->getPort("logFrame")->connectTo(&frameReader, RTT::ConnPolicy::buffer(10000));
+	controller.ports()->getPort("logFrameLayout")->connectTo(&layoutReader, RTT::ConnPolicy::buffer(10));
+
+	// The settings to time the frame with: everything, decimated, a couple
+	// of fields, and switched off.
+	struct Mode {
+		const char *name;
+		bool        enabled;
+		uint32_t    divisor;
+		const char *fields;
+		uint64_t    mask;
+	} modes[] = {
+		{"frame",     true,  1,  "",                  LOG_FRAME_ALL_FIELDS},
+		{"frame/10",  true,  10, "",                  LOG_FRAME_ALL_FIELDS},
+		{"frame-2of7", true, 1,  "targetPos,output",  (1 << 2) | (1 << 6)},
+		{"frame-off", false, 1,  "",                  LOG_FRAME_ALL_FIELDS}
+	};
+
+	atrias_msgs::log_frame        frame;
+	atrias_msgs::log_frame_layout layout;
+	std::vector<uint8_t>          full(frameSize);
+	size_t                        mismatches = 0;
+	size_t                        layouts    = 0;
+	for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+		const Mode &mode = modes[m];
+		if (!controller.logFrame.configureSlot("*", mode.enabled, mode.divisor, mode.fields)) {
+			fprintf(stderr, "Failed to configure the slots for %s.\n", mode.name);
+			return 1;
+		}
+
+		// Let the new settings take effect.
+		controller.logFrame.send(controller.header);
+		while (frameReader.read(frame) == RTT::NewData);
+
+		size_t messages = 0;
+		for (size_t i = 0; i < cycles; i++) {
+			controller.header.seq = i;
+			for (size_t j = 0; j < count; j++)
+				subcontrollers[j]->run(i * 0.001 + j);
+
+			bool due = controller.logFrame.due(0);
+
+			int64_t start = getNanoSecs();
+			for (size_t j = 0; j < count; j++)
+				subcontrollers[j]->logOut.send();
+			controller.logFrame.send(controller.header);
+			samples[i] = getNanoSecs() - start;
+
+			while (layoutReader.read(layout) == RTT::NewData) {
+				layouts++;
+				if (layout.version != LOG_FRAME_VERSION || layout.sizes.size() != count)
+					mismatches++;
+			}
+
+			if (!due) {
+				if (frameReader.read(frame) == RTT::NewData)
+					mismatches++;
+				continue;
+			}
+
+			if (frameReader.read(frame) != RTT::NewData || frame.version != LOG_FRAME_VERSION ||
+			    frame.slots.size() != count || frame.masks.size() != count)
+			{
+				mismatches++;
+				continue;
+			}
+
+			// Pack what the LogPorts had the way the splitter unpacks it: the
+			// header, then the selected fields, each message after the last.
+			uint32_t offset = 0;
+			for (size_t j = 0; j < count; j++) {
+				LogData &data = subcontrollers[j]->logOut.data;
+				uint32_t length = ros::serialization::serializationLength(data);
+				uint32_t header = ros::serialization::serializationLength(data.header);
+				ros::serialization::OStream stream(&full[0], length);
+				ros::serialization::serialize(stream, data);
+
+				uint32_t packed = header;
+				for (uint32_t field = 0; field < 7; field++) {
+					if ((mode.mask >> field) & 1)
+						packed += 8;
+				}
+
+				if (frame.slots[j] != j || frame.lengths[j] != packed || frame.masks[j] != mode.mask ||
+				    offset + packed > frame.data.size() || memcmp(&frame.data[offset], &full[0], header))
+				{
+					mismatches++;
+					break;
+				}
+
+				uint32_t out = offset + header;
+				for (uint32_t field = 0; field < 7; field++) {
+					if (!((mode.mask >> field) & 1))
+						continue;
+					if (memcmp(&frame.data[out], &full[header + 8 * field], 8))
+						mismatches++;
+					out += 8;
+				}
+				offset   += packed;
+				messages += 1;
+			}
+			if (offset != frame.data.size())
+				mismatches++;
+		}
+		report(mode.name, samples);
+		printf("%-10s %zu messages logged\n", "", messages);
+	}
+
+	printf("%zu subcontrollers, %u byte frames at most, %zu layouts sent, %llu dropped, %zu mismatches\n",
+		count, frameSize, layouts, (unsigned long long) controller.logFrame.getDropped(), mismatches);
+
+	for (size_t i = 0; i < count; i++)
+		delete subcontrollers[i];
+
+	return (mismatches || controller.logFrame.getDropped()) ? 1 : 0;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
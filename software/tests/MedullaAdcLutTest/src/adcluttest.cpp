@@ -0,0 +1,150 @@
+/*
+ * adcluttest.cpp
+ *
+ * Checks Medulla's ADC lookup tables against the formulas they replaced,
+ * and times a cycle's worth of conversions each way.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <rtt/os/main.h>
+
+#include <atrias_medulla_drivers/Medulla.h>
+
+// How many of each conversion the biped does per cycle.
+#define THERMISTORS_PER_CYCLE    30
+#define MOTOR_VOLTAGES_PER_CYCLE  6
+#define LOGIC_VOLTAGES_PER_CYCLE  7
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// The conversions as Medulla computed them before the tables.
+static double refADCValue(uint16_t adc_value) {
+	return ((double) adc_value - MEDULLA_ADC_OFFSET_COUNTS) * (MEDULLA_ADC_MAX_VOLTS/(4095.0));
+}
+
+static double refLogicVoltage(uint16_t adc_value) {
+	return refADCValue(adc_value) * 6.0;
+}
+
+static double refMotorVoltage(uint16_t adc_value) {
+	return (adc_value-MOTOR_VOLTAGE_C_OFFSET)*MOTOR_VOLTAGE_V_CAL/(MOTOR_VOLTAGE_C_CAL-MOTOR_VOLTAGE_C_OFFSET);
+}
+
+static double refThermistorValue(uint16_t adc_value) {
+	return ((1.0/( (1.0/298.15) + (1.0/3988.0)*log(4700.0/((3.26/refADCValue(adc_value)) - 1.0)/10000))) - 273.15);
+}
+
+// Exposes Medulla's conversions.
+class TestMedulla : public atrias::medullaDrivers::Medulla {
+	public:
+		double logicVoltage(uint16_t adc_value) { return decodeLogicVoltage(adc_value);     }
+		double motorVoltage(uint16_t adc_value) { return decodeMotorVoltage(adc_value);     }
+		double thermistor(uint16_t adc_value)   { return processThermistorValue(adc_value); }
+};
+
+// Compares one conversion against its formula for every reading in
+// the tables and a few past them.
+static bool check(const char* name, double (TestMedulla::*convert)(uint16_t),
+                  double (*reference)(uint16_t)) {
+	static const uint16_t PAST_TABLE[] = {MEDULLA_ADC_LUT_SIZE, MEDULLA_ADC_LUT_SIZE + 1, 40000, 65535};
+
+	TestMedulla medulla;
+	std::vector<uint16_t> readings;
+	for (int i = 0; i < MEDULLA_ADC_LUT_SIZE; i++)
+		readings.push_back(i);
+	readings.insert(readings.end(), PAST_TABLE, PAST_TABLE + sizeof(PAST_TABLE) / sizeof(PAST_TABLE[0]));
+
+	size_t mismatches = 0;
+	double maxError   = 0.0;
+	for (size_t i = 0; i < readings.size(); i++) {
+		double got    = (medulla.*convert)(readings[i]);
+		double wanted = reference(readings[i]);
+		if (!memcmp(&got, &wanted, sizeof(double)))
+			continue;
+
+		if (mismatches++ < 5)
+			printf("  %s(%u): got %.17g, wanted %.17g\n", name, readings[i], got, wanted);
+		if (fabs(got - wanted) > maxError)
+			maxError = fabs(got - wanted);
+	}
+
+	printf("%-13s %5zu readings  %zu mismatched  max error %g\n", name, readings.size(), mismatches, maxError);
+	return !mismatches;
+}
+
+static void report(const char *name, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-8s mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n", name,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+int ORO_main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+	bool same = check("thermistor",   &TestMedulla::thermistor,   refThermistorValue);
+	same = check("motorVoltage", &TestMedulla::motorVoltage, refMotorVoltage) && same;
+	same = check("logicVoltage", &TestMedulla::logicVoltage, refLogicVoltage) && same;
+
+	// Readings that wander like a live ADC's, around room temperature and 48 V.
+	std::vector<uint16_t> readings(cycles + THERMISTORS_PER_CYCLE);
+	for (size_t i = 0; i < readings.size(); i++)
+		readings[i] = 2000 + (i * 2654435761u >> 20) % 256;
+
+	TestMedulla medulla;
+	std::vector<int64_t> samples(cycles);
+	volatile double sink = 0.0;
+
+	for (size_t i = 0; i < cycles; i++) {
+		const uint16_t* adc = &readings[i];
+		double sum = 0.0;
+		int64_t start = getNanoSecs();
+		for (int j = 0; j < THERMISTORS_PER_CYCLE; j++)
+			sum += refThermistorValue(adc[j]);
+		for (int j = 0; j < MOTOR_VOLTAGES_PER_CYCLE; j++)
+			sum += refMotorVoltage(adc[j]);
+		for (int j = 0; j < LOGIC_VOLTAGES_PER_CYCLE; j++)
+			sum += refLogicVoltage(adc[j]);
+		samples[i] = getNanoSecs() - start;
+		sink = sink + sum;
+	}
+	report("formula", samples);
+
+	for (size_t i = 0; i < cycles; i++) {
+		const uint16_t* adc = &readings[i];
+		double sum = 0.0;
+		int64_t start = getNanoSecs();
+		for (int j = 0; j < THERMISTORS_PER_CYCLE; j++)
+			sum += medulla.thermistor(adc[j]);
+		for (int j = 0; j < MOTOR_VOLTAGES_PER_CYCLE; j++)
+			sum += medulla.motorVoltage(adc[j]);
+		for (int j = 0; j < LOGIC_VOLTAGES_PER_CYCLE; j++)
+			sum += medulla.logicVoltage(adc[j]);
+		samples[i] = getNanoSecs() - start;
+		sink = sink + sum;
+	}
+	report("table", samples);
+
+	return same ? 0 : 1;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
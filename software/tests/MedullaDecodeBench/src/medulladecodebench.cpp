@@ -0,0 +1,255 @@
+/*
+ * medulladecodebench.cpp
+ *
+ * Times one EtherCAT cycle's worth of Medulla decoding and encoding
+ * through MedullaRegistry, on a bus of virtual Medullas, with the leg
+ * Medullas decoded one at a time and together (LegBatch).
+ */
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include <rtt/os/main.h>
+#include <rtt/Logger.hpp>
+
+#include <atrias_msgs/controller_output.h>
+#include <atrias_msgs/robot_state.h>
+#include <atrias_ecat_conn/MedullaRegistry.h>
+#include <atrias_ecat_conn/VirtualMedulla.h>
+#include <atrias_medulla_drivers/LegBatch.h>
+#include <robot_invariant_defs.h>
+
+using namespace atrias::ecatConn;
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+struct BenchMedulla {
+	uint32_t productCode;
+	uint8_t  id;
+};
+
+static const BenchMedulla BIPED_BUS[] = {
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_B_ID},
+	{MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_LEFT_HIP_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_B_ID},
+	{MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_RIGHT_HIP_ID},
+	{MEDULLA_BOOM_PRODUCT_CODE, MEDULLA_BOOM_ID},
+	{MEDULLA_IMU_PRODUCT_CODE,  MEDULLA_IMU_ID},
+};
+
+// Enough legs for a full LegBatch pass. The registry only takes one boom
+// and one IMU, so there's no point adding more of those.
+static const BenchMedulla EXTENDED_BUS[] = {
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_B_ID},
+	{MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_LEFT_HIP_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_B_ID},
+	{MEDULLA_HIP_PRODUCT_CODE,  MEDULLA_RIGHT_HIP_ID},
+	{MEDULLA_BOOM_PRODUCT_CODE, MEDULLA_BOOM_ID},
+	{MEDULLA_IMU_PRODUCT_CODE,  MEDULLA_IMU_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_LEFT_LEG_B_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_A_ID},
+	{MEDULLA_LEG_PRODUCT_CODE,  MEDULLA_RIGHT_LEG_B_ID},
+};
+
+// Offsets of the leg Medulla's sensor inputs. See LegMedulla's constructor.
+#define LEG_IN_MOTOR_ENCODER      7
+#define LEG_IN_MOTOR_TIMESTAMP   11
+#define LEG_IN_LEG_ENCODER       13
+#define LEG_IN_LEG_TIMESTAMP     17
+#define LEG_IN_INC_ENCODER       19
+#define LEG_IN_INC_TIMESTAMP     21
+#define LEG_IN_MOTOR_VOLTAGE     23
+#define LEG_IN_LOGIC_VOLTAGE     25
+#define LEG_IN_AMP1_CURRENT      39
+#define LEG_IN_AMP2_CURRENT      41
+
+// A bus of virtual Medullas, laid out like ec_config_map() would.
+class BenchBus {
+	public:
+		BenchBus(const BenchMedulla* bus, size_t count, bool batch_legs) {
+			size_t outputBytes = 0;
+			size_t inputBytes  = 0;
+			for (size_t i = 0; i < count; i++) {
+				medullas.push_back(new VirtualMedulla(bus[i].productCode, bus[i].id));
+				outputBytes += medullas[i]->getOutputBytes();
+				inputBytes  += medullas[i]->getInputBytes();
+			}
+			ioMap.assign(outputBytes + inputBytes, 0);
+
+			uint8_t* outputs = &ioMap[0];
+			uint8_t* inputs  = &ioMap[outputBytes];
+			slaves.assign(count + 1, ec_slavet());
+			for (size_t i = 0; i < count; i++) {
+				ec_slavet &slave = slaves[i + 1];
+				memset(&slave, 0, sizeof(slave));
+				slave.eep_man = MEDULLA_VENDOR_ID;
+				slave.eep_id  = bus[i].productCode;
+				slave.outputs = outputs;
+				slave.inputs  = inputs;
+				slave.Obytes  = medullas[i]->getOutputBytes();
+				slave.Ibytes  = medullas[i]->getInputBytes();
+				outputs += slave.Obytes;
+				inputs  += slave.Ibytes;
+			}
+
+			// The drivers read their IDs in postOpInit(), so the inputs need to be there first.
+			exchange(0);
+			registry.setLegBatching(batch_legs);
+			for (size_t i = 1; i < slaves.size(); i++)
+				registry.add(slaves[i], i);
+		}
+
+		~BenchBus() {
+			registry.clear();
+			for (size_t i = 0; i < medullas.size(); i++)
+				delete medullas[i];
+		}
+
+		// Stands in for the frame: outputs out, fresh inputs back. The
+		// virtual Medullas' sensors read zero, so the legs' get filled in
+		// with moving encoders (some of them stuck or jumping) and noisy ADCs.
+		void exchange(uint32_t cycle) {
+			for (size_t i = 0; i < medullas.size(); i++) {
+				ec_slavet &slave = slaves[i + 1];
+				medullas[i]->exchange(slave.outputs, slave.inputs, 0);
+				if (slave.eep_id != MEDULLA_LEG_PRODUCT_CODE)
+					continue;
+
+				uint32_t seed   = cycle * 2654435761u + i * 40503u;
+				uint32_t motor  = 1000000 + cycle * (37 + i);
+				uint32_t legPos = 2000000 + cycle * (29 + i);
+				if (seed % 97 == 0)
+					motor += 3000000;  // A spike
+				if (seed % 89 == 0)
+					legPos = 2000000;  // A stuck reading
+				put<uint32_t>(slave, LEG_IN_MOTOR_ENCODER,   motor);
+				put<int16_t> (slave, LEG_IN_MOTOR_TIMESTAMP, seed >> 16);
+				put<uint32_t>(slave, LEG_IN_LEG_ENCODER,     legPos);
+				put<int16_t> (slave, LEG_IN_LEG_TIMESTAMP,   seed >> 8);
+				put<uint16_t>(slave, LEG_IN_INC_ENCODER,     cycle * 301);
+				put<uint16_t>(slave, LEG_IN_INC_TIMESTAMP,   seed >> 4);
+				put<uint16_t>(slave, LEG_IN_MOTOR_VOLTAGE,   seed % 4096);
+				put<uint16_t>(slave, LEG_IN_LOGIC_VOLTAGE,   (seed >> 12) % 4096);
+				put<int16_t> (slave, LEG_IN_AMP1_CURRENT,    seed >> 3);
+				put<int16_t> (slave, LEG_IN_AMP2_CURRENT,    seed >> 5);
+			}
+		}
+
+		MedullaRegistry registry;
+
+	private:
+		template <class T>
+		static void put(ec_slavet &slave, int offset, T value) {
+			memcpy(slave.inputs + offset, &value, sizeof(value));
+		}
+
+		std::vector<VirtualMedulla*> medullas;
+		std::vector<ec_slavet>       slaves;
+		std::vector<uint8_t>         ioMap;
+};
+
+static bool sameDouble(double a, double b) {
+	return !memcmp(&a, &b, sizeof(double));
+}
+
+// Checks the batched decode against the one-at-a-time decode, bit for bit.
+static bool sameLegHalf(const atrias_msgs::robot_state_legHalf &a, const atrias_msgs::robot_state_legHalf &b) {
+	bool same = sameDouble(a.legAngle,      b.legAngle)      && sameDouble(a.legVelocity,   b.legVelocity)   &&
+	            sameDouble(a.motorAngle,    b.motorAngle)    && sameDouble(a.motorVelocity, b.motorVelocity) &&
+	            sameDouble(a.rotorAngle,    b.rotorAngle)    && sameDouble(a.rotorVelocity, b.rotorVelocity) &&
+	            sameDouble(a.motorCurrent,  b.motorCurrent)  && sameDouble(a.amp1Current,   b.amp1Current)   &&
+	            sameDouble(a.amp2Current,   b.amp2Current)   && sameDouble(a.logicVoltage,  b.logicVoltage)  &&
+	            sameDouble(a.motorVoltage,  b.motorVoltage)  && a.kneeForce == b.kneeForce                   &&
+	            a.medullaState == b.medullaState && a.limitSwitches == b.limitSwitches;
+	for (int i = 0; i < 6; i++)
+		same = same && sameDouble(a.motorTherms[i], b.motorTherms[i]);
+	return same;
+}
+
+static bool sameLegs(const atrias_msgs::robot_state &a, const atrias_msgs::robot_state &b) {
+	return sameLegHalf(a.lLeg.halfA, b.lLeg.halfA) && sameLegHalf(a.lLeg.halfB, b.lLeg.halfB) &&
+	       sameLegHalf(a.rLeg.halfA, b.rLeg.halfA) && sameLegHalf(a.rLeg.halfB, b.rLeg.halfB) &&
+	       a.lLeg.onGround == b.lLeg.onGround && a.rLeg.onGround == b.rLeg.onGround;
+}
+
+static void report(const char *name, const char *mode, size_t medullas, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-9s %-7s %2zu Medullas  mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n",
+		name, mode, medullas,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+// Runs the one-at-a-time and batched decoders side by side on the same inputs.
+static bool runBench(const char* name, const BenchMedulla* medullas, size_t count, size_t cycles) {
+	BenchBus eachBus(medullas, count, false);
+	BenchBus batchBus(medullas, count, true);
+	std::vector<int64_t> eachSamples(cycles);
+	std::vector<int64_t> batchSamples(cycles);
+
+	atrias_msgs::robot_state        eachState;
+	atrias_msgs::robot_state        batchState;
+	atrias_msgs::controller_output  controllerOutput;
+	controllerOutput.command = medulla_state_run;
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < cycles; i++) {
+		eachBus.exchange(i + 1);
+		batchBus.exchange(i + 1);
+
+		int64_t start = getNanoSecs();
+		eachBus.registry.processReceiveData(eachState);
+		eachBus.registry.processTransmitData(controllerOutput);
+		eachSamples[i] = getNanoSecs() - start;
+
+		start = getNanoSecs();
+		batchBus.registry.processReceiveData(batchState);
+		batchBus.registry.processTransmitData(controllerOutput);
+		batchSamples[i] = getNanoSecs() - start;
+
+		if (!sameLegs(eachState, batchState))
+			mismatches++;
+	}
+
+	report(name, "each",  eachBus.registry.size(),  eachSamples);
+	report(name, "batch", batchBus.registry.size(), batchSamples);
+	if (mismatches)
+		printf("%-9s batched legs differed on %zu of %zu cycles!\n", name, mismatches, cycles);
+
+	return !mismatches;
+}
+
+int ORO_main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+	// The registry logs each Medulla it finds; that's not what we're here for.
+	RTT::Logger::Instance()->setLogLevel(RTT::Logger::Warning);
+
+	printf("Legs batched with %s.\n", atrias::medullaDrivers::LegBatch::getInstructionSet());
+	bool same = runBench("biped",    BIPED_BUS,    sizeof(BIPED_BUS)    / sizeof(BIPED_BUS[0]),    cycles);
+	same = runBench("extended", EXTENDED_BUS, sizeof(EXTENDED_BUS) / sizeof(EXTENDED_BUS[0]), cycles) && same;
+	return same ? 0 : 1;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
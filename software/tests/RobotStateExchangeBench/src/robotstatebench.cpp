@@ -0,0 +1,122 @@
+/*
+ * robotstatebench.cpp
+ *
+ * Times the robot state exchange done in one controller cycle:
+ * the old mutex + copy-per-access scheme versus the triple buffer.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <vector>
+
+#include <atrias_msgs/robot_state.h>
+#include <atrias_shared/TripleBuffer.hpp>
+
+// How many times the controller side reads the state per cycle
+// (ControllerLoop, shouldEStop, shouldHalt, checkCollision)
+#define READS_PER_CYCLE 4
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// The old RobotStateHandler: everything under one lock, copies out.
+class MutexExchange {
+	public:
+		MutexExchange() { pthread_mutex_init(&lock, NULL); }
+
+		void set(const atrias_msgs::robot_state &newState) {
+			pthread_mutex_lock(&lock);
+			state = newState;
+			pthread_mutex_unlock(&lock);
+		}
+
+		atrias_msgs::robot_state get() {
+			pthread_mutex_lock(&lock);
+			atrias_msgs::robot_state out = state;
+			pthread_mutex_unlock(&lock);
+			return out;
+		}
+
+	private:
+		pthread_mutex_t          lock;
+		atrias_msgs::robot_state state;
+};
+
+static MutexExchange                                     mutexExchange;
+static atrias::shared::TripleBuffer<atrias_msgs::robot_state> tripleBuffer;
+static atrias_msgs::robot_state                          sampleState;
+static std::atomic<bool>                                 contend(false);
+static std::atomic<bool>                                 done(false);
+
+// Keeps the mutex busy the way the EtherCAT thread would, roughly.
+static void* contender(void*) {
+	while (!done) {
+		if (contend)
+			mutexExchange.set(sampleState);
+	}
+	return NULL;
+}
+
+static void report(const char *name, std::vector<int64_t> &samples) {
+	std::sort(samples.begin(), samples.end());
+	int64_t sum = 0;
+	for (size_t i = 0; i < samples.size(); i++)
+		sum += samples[i];
+
+	printf("%-8s mean %6lld ns  p50 %6lld ns  p99 %6lld ns  max %7lld ns\n", name,
+		(long long) (sum / (int64_t) samples.size()),
+		(long long) samples[samples.size() / 2],
+		(long long) samples[samples.size() * 99 / 100],
+		(long long) samples.back());
+}
+
+int main(int argc, char **argv) {
+	size_t cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+	std::vector<int64_t> samples(cycles);
+
+	// Fill in the variable-length parts so the copies cost what they do on the robot.
+	sampleState.header.frame_id = "robot_state";
+	sampleState.lLeg.halfA.motorAngle = 1.0;
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, contender, NULL);
+
+	volatile double sink = 0.0;
+
+	contend = true;
+	for (size_t i = 0; i < cycles; i++) {
+		int64_t start = getNanoSecs();
+		mutexExchange.set(sampleState);
+		for (int j = 0; j < READS_PER_CYCLE; j++)
+			sink = sink + mutexExchange.get().lLeg.halfA.motorAngle;
+		samples[i] = getNanoSecs() - start;
+	}
+	contend = false;
+	report("mutex", samples);
+
+	for (size_t i = 0; i < cycles; i++) {
+		int64_t start = getNanoSecs();
+		tripleBuffer.getWriteBuffer() = sampleState;
+		tripleBuffer.publish();
+		tripleBuffer.update();
+		for (int j = 0; j < READS_PER_CYCLE; j++)
+			sink = sink + tripleBuffer.read().lLeg.halfA.motorAngle;
+		samples[i] = getNanoSecs() - start;
+	}
+	report("triple", samples);
+
+	done = true;
+	pthread_join(thread, NULL);
+	return 0;
+}
+
+// Tab-based indentation
+// vim: noexpandtab
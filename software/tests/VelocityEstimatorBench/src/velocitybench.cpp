@@ -0,0 +1,340 @@
+/*
+ * velocitybench.cpp
+ *
+ * Compares encoder velocity estimates for noise, lag, and CPU time, on
+ * synthetic encoders or a position column from a recorded robot_state.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include <rtt/os/main.h>
+
+#include <atrias_shared/globals.h>
+#include <atrias_medulla_drivers/VelocityEstimator.h>
+#include <robot_invariant_defs.h>
+
+using atrias::medullaDrivers::VelocityEstimator;
+
+// The low-pass filter's time constant, in seconds.
+#define LPF_TIME_CONSTANT 0.002
+
+// The reference for recorded data is a centered difference over this many
+// samples on each side.
+#define REFERENCE_HALF_SPAN 8
+
+// The most lag searched for, in samples.
+#define MAX_LAG 20
+
+// Updates are timed in blocks of this many.
+#define TIMING_BLOCK 1000
+
+static int64_t getNanoSecs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// One encoder's samples.
+struct Series {
+	std::string         name;
+	std::vector<double> positions;
+	std::vector<double> clean;       // Unquantized positions, for synthetic data.
+	std::vector<double> deltaTimes;  // Since the previous sample, in seconds.
+	std::vector<double> reference;   // The velocity to compare against.
+	double              period;      // The mean sample period, in seconds.
+};
+
+// An estimator as the drivers run it: one update per sample.
+class Method {
+	public:
+		virtual ~Method() {}
+		virtual const char* getName() = 0;
+		virtual void        reset() = 0;
+		virtual double      update(double position, double delta_time) = 0;
+};
+
+class LsqMethod : public Method {
+	VelocityEstimator estimator;
+	int               window;
+	char              name[32];
+
+	public:
+		LsqMethod(int samples) {
+			window = samples;
+			if (samples == 2)
+				snprintf(name, sizeof(name), "diff%s",
+				         (samples == VELOCITY_ESTIMATOR_DEFAULT_WINDOW) ? " (default)" : "");
+			else
+				snprintf(name, sizeof(name), "lsq %d%s", samples,
+				         (samples == VELOCITY_ESTIMATOR_DEFAULT_WINDOW) ? " (default)" : "");
+		}
+		const char* getName() { return name; }
+		void        reset()   { estimator.setWindow(window); }
+		double      update(double position, double delta_time) {
+			estimator.update(position, delta_time);
+			return estimator.getVel();
+		}
+};
+
+class LpfMethod : public Method {
+	VelocityEstimator estimator;
+	double            filtered;
+
+	public:
+		const char* getName() { return "diff+lpf"; }
+		void        reset()   { estimator.setWindow(2); filtered = 0.0; }
+		double      update(double position, double delta_time) {
+			estimator.update(position, delta_time);
+			filtered += delta_time / (LPF_TIME_CONSTANT + delta_time) * (estimator.getVel() - filtered);
+			return filtered;
+		}
+};
+
+// A leg swing, quantized to an encoder's resolution and sampled at 1 kHz.
+// The Medulla reads the encoder up to 50 us into each cycle, and every
+// 997th cycle's data is missed, so the next sample spans two cycles.
+static Series makeSynthetic(const char* name, double rad_per_tick, size_t samples) {
+	const double period = ((double) CONTROLLER_LOOP_PERIOD_NS) / SECOND_IN_NANOSECONDS;
+
+	Series series;
+	series.name   = name;
+	series.period = period;
+
+	double   lastTime = 0.0;
+	uint32_t seed     = 12345;
+	for (size_t i = 0, cycle = 0; i < samples; i++, cycle++) {
+		if (cycle % 997 == 996)
+			cycle++;
+
+		seed = seed * 1664525u + 1013904223u;
+		double jitter = 50e-6 * (seed >> 8) / (double) (1 << 24);
+		double t      = cycle * period + jitter;
+
+		double position = 0.4 * sin(2.0 * M_PI * 1.5 * t) + 0.05 * sin(2.0 * M_PI * 9.0 * t);
+		double velocity = 0.4 * 2.0 * M_PI * 1.5 * cos(2.0 * M_PI * 1.5 * t) +
+		                  0.05 * 2.0 * M_PI * 9.0 * cos(2.0 * M_PI * 9.0 * t);
+
+		series.positions.push_back(floor(position / rad_per_tick) * rad_per_tick);
+		series.clean.push_back(position);
+		series.deltaTimes.push_back(i ? t - lastTime : 0.0);
+		series.reference.push_back(velocity);
+		lastTime = t;
+	}
+
+	return series;
+}
+
+static std::vector<std::string> splitCsv(const std::string &line) {
+	std::vector<std::string> fields;
+	size_t start = 0;
+	while (true) {
+		size_t end = line.find(',', start);
+		fields.push_back(line.substr(start, end - start));
+		if (end == std::string::npos)
+			return fields;
+		start = end + 1;
+	}
+}
+
+// Reads a position column from `rostopic echo -p` output.
+static bool loadCsv(const char* path, const char* column, const char* time_column, Series &series) {
+	FILE* file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "Can't open %s\n", path);
+		return false;
+	}
+
+	std::vector<std::string> rows;
+	char buffer[65536];
+	while (fgets(buffer, sizeof(buffer), file)) {
+		std::string row(buffer);
+		while (!row.empty() && (row[row.size() - 1] == '\n' || row[row.size() - 1] == '\r'))
+			row.erase(row.size() - 1);
+		rows.push_back(row);
+	}
+	fclose(file);
+
+	if (rows.empty()) {
+		fprintf(stderr, "%s is empty\n", path);
+		return false;
+	}
+
+	std::vector<std::string> header = splitCsv(rows[0]);
+	int positionIndex = -1;
+	int timeIndex     = -1;
+	for (size_t i = 0; i < header.size(); i++) {
+		if (header[i] == column)
+			positionIndex = i;
+		if (header[i] == time_column)
+			timeIndex = i;
+	}
+	if (positionIndex < 0 || timeIndex < 0) {
+		fprintf(stderr, "%s has no column %s\n", path, (positionIndex < 0) ? column : time_column);
+		return false;
+	}
+
+	// The times are nanoseconds since some epoch; too big for a double to
+	// hold exactly, so they're differenced as integers.
+	series.name = column;
+	uint64_t lastTime = 0;
+	for (size_t i = 1; i < rows.size(); i++) {
+		std::vector<std::string> fields = splitCsv(rows[i]);
+		if (fields.size() != header.size())
+			continue;
+
+		uint64_t time = strtoull(fields[timeIndex].c_str(), NULL, 10);
+		if (!series.positions.empty() && time <= lastTime)
+			continue;
+
+		series.positions.push_back(strtod(fields[positionIndex].c_str(), NULL));
+		series.deltaTimes.push_back(series.positions.size() > 1 ?
+			((double) (time - lastTime)) / SECOND_IN_NANOSECONDS : 0.0);
+		lastTime = time;
+	}
+
+	size_t count = series.positions.size();
+	if (count < 2 * (REFERENCE_HALF_SPAN + MAX_LAG) + 1) {
+		fprintf(stderr, "%s has only %zu usable rows\n", path, count);
+		return false;
+	}
+
+	// A centered difference has no lag, which is all the reference needs.
+	std::vector<double> times(count, 0.0);
+	for (size_t i = 1; i < count; i++)
+		times[i] = times[i - 1] + series.deltaTimes[i];
+
+	series.reference.assign(count, NAN);
+	for (size_t i = REFERENCE_HALF_SPAN; i + REFERENCE_HALF_SPAN < count; i++) {
+		series.reference[i] =
+			(series.positions[i + REFERENCE_HALF_SPAN] - series.positions[i - REFERENCE_HALF_SPAN]) /
+			(times[i + REFERENCE_HALF_SPAN] - times[i - REFERENCE_HALF_SPAN]);
+	}
+	series.period = times[count - 1] / (count - 1);
+
+	return true;
+}
+
+// Finds the delay that best lines the estimate up with the reference, to
+// a tenth of a sample, and the RMS error that's left. The reference is
+// interpolated linearly between samples.
+static void measure(const Series &series, const std::vector<double> &estimates,
+                    double &lag, double &error) {
+	size_t start = REFERENCE_HALF_SPAN + MAX_LAG + 2 * VELOCITY_ESTIMATOR_MAX_WINDOW;
+	size_t end   = series.positions.size() - REFERENCE_HALF_SPAN;
+
+	lag   = 0.0;
+	error = INFINITY;
+	for (int tenths = 0; tenths <= 10 * MAX_LAG; tenths++) {
+		size_t whole    = tenths / 10;
+		double fraction = (tenths % 10) / 10.0;
+
+		double sum   = 0.0;
+		size_t count = 0;
+		for (size_t i = start; i < end; i++) {
+			double reference  = (1.0 - fraction) * series.reference[i - whole] +
+			                    fraction * series.reference[i - whole - 1];
+			double difference = estimates[i] - reference;
+			if (isnan(difference))
+				continue;
+			sum += difference * difference;
+			count++;
+		}
+		if (count && sqrt(sum / count) < error) {
+			error = sqrt(sum / count);
+			lag   = tenths / 10.0;
+		}
+	}
+}
+
+static void run(const Series &series, std::vector<Method*> &methods) {
+	printf("%s: %zu samples\n", series.name.c_str(), series.positions.size());
+
+	size_t count = series.positions.size();
+	std::vector<double> estimates(count);
+	std::vector<double> cleanEstimates;
+	std::vector<double> blockTimes;
+
+	for (size_t m = 0; m < methods.size(); m++) {
+		Method* method = methods[m];
+		method->reset();
+		blockTimes.clear();
+
+		for (size_t i = 0; i < count; i += TIMING_BLOCK) {
+			size_t  blockEnd = std::min(count, i + TIMING_BLOCK);
+			int64_t start    = getNanoSecs();
+			for (size_t j = i; j < blockEnd; j++)
+				estimates[j] = method->update(series.positions[j], series.deltaTimes[j]);
+			blockTimes.push_back(((double) (getNanoSecs() - start)) / (blockEnd - i));
+		}
+
+		// The tracking error, after taking out the lag.
+		double lag;
+		double error;
+		measure(series, estimates, lag, error);
+
+		// With synthetic data, the noise is what quantization adds to the
+		// estimate; with recorded data it's all lumped into the error.
+		char noise[32] = "-";
+		if (!series.clean.empty()) {
+			method->reset();
+			cleanEstimates.resize(count);
+			for (size_t i = 0; i < count; i++)
+				cleanEstimates[i] = method->update(series.clean[i], series.deltaTimes[i]);
+
+			double sum = 0.0;
+			for (size_t i = 2 * VELOCITY_ESTIMATOR_MAX_WINDOW; i < count; i++)
+				sum += (estimates[i] - cleanEstimates[i]) * (estimates[i] - cleanEstimates[i]);
+			snprintf(noise, sizeof(noise), "%9.4g", sqrt(sum / (count - 2 * VELOCITY_ESTIMATOR_MAX_WINDOW)));
+		}
+
+		std::sort(blockTimes.begin(), blockTimes.end());
+		printf("  %-16s noise %9s  error %9.4g rad/s  lag %5.2f ms  p50 %5.1f ns/update  max %6.1f ns/update\n",
+			method->getName(), noise, error, lag * series.period * 1000.0,
+			blockTimes[blockTimes.size() / 2], blockTimes.back());
+	}
+}
+
+int ORO_main(int argc, char **argv) {
+	std::vector<Method*> methods;
+	methods.push_back(new LsqMethod(2));
+	methods.push_back(new LpfMethod());
+	methods.push_back(new LsqMethod(4));
+	if (VELOCITY_ESTIMATOR_DEFAULT_WINDOW != 2 && VELOCITY_ESTIMATOR_DEFAULT_WINDOW != 4 &&
+	    VELOCITY_ESTIMATOR_DEFAULT_WINDOW != 8 && VELOCITY_ESTIMATOR_DEFAULT_WINDOW != 16)
+		methods.push_back(new LsqMethod(VELOCITY_ESTIMATOR_DEFAULT_WINDOW));
+	methods.push_back(new LsqMethod(8));
+	methods.push_back(new LsqMethod(16));
+
+	int status = 0;
+	if (argc > 2) {
+		Series series;
+		if (loadCsv(argv[1], argv[2], (argc > 3) ? argv[3] : "field.timing.receiveDCTime", series))
+			run(series, methods);
+		else
+			status = 1;
+	} else {
+		size_t samples = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+		if (samples < 1000)
+			samples = 1000;
+
+		run(makeSynthetic("rotor", INC_ENC_RAD_PER_TICK,         samples), methods);
+		run(makeSynthetic("hip",   HIP_INC_ENCODER_RAD_PER_TICK, samples), methods);
+		run(makeSynthetic("pitch", PITCH_ENCODER_RAD_PER_TICK,   samples), methods);
+	}
+
+	for (size_t i = 0; i < methods.size(); i++)
+		delete methods[i];
+
+	return status;
+}
+
+// Tab-based indentation
+// vim: noexpandtab